@@ -0,0 +1,85 @@
+//
+// Ensures that inserts written as a group in one unit of work still report errors against the
+// right documents, for both ordered and unordered batches
+//
+
+var coll = db.getCollection( "batch_write_insert_group" );
+
+assert(coll.getDB().getMongo().useWriteCommands(), "test is not running with write commands");
+
+function makeDocs( n ) {
+    var docs = [];
+    for ( var i = 0; i < n; i++ ) {
+        docs.push( { _id: i, a: i } );
+    }
+    return docs;
+}
+
+var request;
+var result;
+var docs;
+
+//
+// Large batch without errors
+coll.drop();
+coll.ensureIndex( { a: 1 } );
+request = { insert: coll.getName(), documents: makeDocs( 500 ), ordered: true };
+result = coll.runCommand( request );
+assert( result.ok, tojson( result ) );
+assert.eq( 500, result.n );
+assert.eq( 500, coll.count() );
+assert.eq( 500, coll.find().hint( { a: 1 } ).itcount() );
+
+//
+// Unordered batch with a duplicate key in the middle of a group
+coll.drop();
+docs = makeDocs( 200 );
+docs[100]._id = 99;
+request = { insert: coll.getName(), documents: docs, ordered: false };
+result = coll.runCommand( request );
+assert( result.ok, tojson( result ) );
+assert.eq( 199, result.n );
+assert.eq( 1, result.writeErrors.length );
+assert.eq( 100, result.writeErrors[0].index );
+assert.eq( 199, coll.count() );
+
+//
+// Ordered batch with a duplicate key in the middle of a group stops at the error
+coll.drop();
+request = { insert: coll.getName(), documents: docs, ordered: true };
+result = coll.runCommand( request );
+assert( result.ok, tojson( result ) );
+assert.eq( 100, result.n );
+assert.eq( 1, result.writeErrors.length );
+assert.eq( 100, result.writeErrors[0].index );
+assert.eq( 100, coll.count() );
+
+//
+// Unique secondary index violations inside a group
+coll.drop();
+coll.ensureIndex( { a: 1 }, { unique: true } );
+docs = makeDocs( 50 );
+docs[10].a = 5;
+docs[40].a = 5;
+request = { insert: coll.getName(), documents: docs, ordered: false };
+result = coll.runCommand( request );
+assert( result.ok, tojson( result ) );
+assert.eq( 48, result.n );
+assert.eq( 2, result.writeErrors.length );
+assert.eq( 10, result.writeErrors[0].index );
+assert.eq( 40, result.writeErrors[1].index );
+assert.eq( 48, coll.count() );
+assert.eq( 48, coll.find().hint( { a: 1 } ).itcount() );
+
+//
+// Documents which fail to normalize split the batch into groups around them
+coll.drop();
+docs = makeDocs( 30 );
+docs[15] = { _id: 15, $bad: 1 };
+request = { insert: coll.getName(), documents: docs, ordered: false };
+result = coll.runCommand( request );
+assert( result.ok, tojson( result ) );
+assert.eq( 29, result.n );
+assert.eq( 1, result.writeErrors.length );
+assert.eq( 15, result.writeErrors[0].index );
+assert.eq( 29, coll.count() );
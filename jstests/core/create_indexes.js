@@ -126,4 +126,22 @@
         }
     }
 
+    //
+    // Test that v2 (prefix compressed) indexes can only be created with mmapv1
+    //
+    res = t.runCommand('createIndexes',
+                       {indexes: [{key: {e: 1}, name: 'e_1', v: 2}]});
+
+    if (!isMongos) {
+        if (status.storageEngine.name === 'mmapv1') {
+            assert.commandWorked(res, 'v2 index creation should work for mmapv1');
+        } else {
+            assert.commandFailed(res, 'v2 index creation should fail for non-mmapv1 storage engines');
+        }
+    }
+
+    res = t.runCommand('createIndexes',
+                       {indexes: [{key: {f: 1}, name: 'f_1', v: 3}]});
+    assert.commandFailed(res, 'v3 index creation should fail');
+
 }());
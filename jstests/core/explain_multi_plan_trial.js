@@ -0,0 +1,36 @@
+// Check that explain reports the cost of the trial period when several candidate plans are ranked.
+
+(function() {
+    'use strict';
+
+    // mongos does not merge the per-shard trial period reports.
+    if (db.isMaster().msg === "isdbgrid") {
+        return;
+    }
+
+    var t = db.jstests_explain_multi_plan_trial;
+    t.drop();
+
+    assert.commandWorked(t.ensureIndex({a: 1}));
+    assert.commandWorked(t.ensureIndex({b: 1}));
+    for (var i = 0; i < 200; ++i) {
+        assert.writeOK(t.insert({a: i, b: i % 5}));
+    }
+
+    // Two indexed candidates are raced against each other.
+    var explain = t.find({a: {$gte: 0}, b: 2}).explain("executionStats");
+    assert.eq(40, explain.executionStats.nReturned, tojson(explain));
+    var trial = explain.executionStats.trialPeriod;
+    assert(trial, "expected a trialPeriod section: " + tojson(explain));
+    assert.gte(trial.rounds, 1, tojson(trial));
+    assert.gte(trial.wallMicros, 0, tojson(trial));
+    assert.gte(trial.cpuMicros, 0, tojson(trial));
+
+    // The section is reported at the allPlansExecution verbosity as well.
+    explain = t.find({a: {$gte: 0}, b: 2}).explain("allPlansExecution");
+    assert(explain.executionStats.trialPeriod, tojson(explain));
+
+    // A hinted query has a single candidate, so there is no trial period to report.
+    explain = t.find({a: {$gte: 0}, b: 2}).hint({a: 1}).explain("executionStats");
+    assert(!explain.executionStats.trialPeriod, tojson(explain));
+})();
@@ -0,0 +1,45 @@
+// Check the working set allocation counters reported by explain.
+
+(function() {
+    'use strict';
+
+    // mongos does not merge the per-shard working set reports.
+    if (db.isMaster().msg === "isdbgrid") {
+        return;
+    }
+
+    var t = db.jstests_explain_working_set_stats;
+    t.drop();
+
+    assert.commandWorked(t.ensureIndex({a: 1}));
+    for (var i = 0; i < 100; ++i) {
+        assert.writeOK(t.insert({a: i}));
+    }
+
+    var workingSetStats = function(explain) {
+        var ws = explain.executionStats.workingSet;
+        assert(ws, "expected a workingSet section: " + tojson(explain));
+        return ws;
+    };
+
+    // Each result is freed once it has been returned, so later results reuse its member.
+    var explain = t.find({a: {$gte: 0}}).explain("executionStats");
+    assert.eq(100, explain.executionStats.nReturned, tojson(explain));
+    var ws = workingSetStats(explain);
+    assert.gte(ws.membersCreated, 1, tojson(ws));
+    assert.lt(ws.membersCreated, 100, tojson(ws));
+    assert.gte(ws.membersCreated + ws.membersRecycled, 100, tojson(ws));
+    assert.lt(ws.allocationsPerDocument, 1, tojson(ws));
+
+    // Storage engines that hand out unowned index keys have them copied into the arena, many keys
+    // to a chunk.
+    if (ws.arenaCopies > 0) {
+        assert.lt(ws.arenaChunks, ws.arenaCopies, tojson(ws));
+    }
+
+    // A query that returns nothing still reports the section.
+    explain = t.find({a: -1}).explain("executionStats");
+    assert.eq(0, explain.executionStats.nReturned, tojson(explain));
+    ws = workingSetStats(explain);
+    assert.eq(0, ws.arenaCopies, tojson(ws));
+})();
@@ -0,0 +1,92 @@
+// Check that a text search finds the documents with negated terms from the index, and returns the
+// same results as when it looks for the negated terms in each document.
+
+(function() {
+    'use strict';
+
+    // mongos does not merge the per-shard explain stats, and setParameter only reaches mongos.
+    if (db.isMaster().msg === "isdbgrid") {
+        return;
+    }
+
+    var t = db.jstests_fts_negated_terms_index;
+    t.drop();
+
+    var bulk = t.initializeUnorderedBulkOp();
+    for (var i = 0; i < 200; ++i) {
+        var text = "apple";
+        if (i % 2 === 0) {
+            text += " banana";
+        }
+        if (i % 5 === 0) {
+            text += " Cherries";
+        }
+        bulk.insert({_id: i, a: text});
+    }
+    // A stop word counts as a negated term, though it isn't in the index.
+    bulk.insert({_id: 200, a: "apple does"});
+    // Keys for the negated terms which point to documents that aren't results.
+    for (var i = 1000; i < 1300; ++i) {
+        bulk.insert({_id: i, a: "banana split"});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(t.ensureIndex({a: "text"}));
+
+    var setKeysPerCandidate = function(value) {
+        var res = assert.commandWorked(db.adminCommand(
+            {setParameter: 1, internalQueryTextNegatedKeysPerCandidate: value}));
+        return res.was;
+    };
+
+    var run = function(search) {
+        var query = {$text: {$search: search}};
+        var ids = t.find(query, {_id: 1}).sort({_id: 1}).toArray().map(function(doc) {
+            return doc._id;
+        });
+        var explain = t.find(query).explain("executionStats");
+        return {ids: ids, stats: explain.executionStats};
+    };
+
+    var getTextStage = function(stats) {
+        var stage = stats.executionStages;
+        while (stage.stage !== "TEXT") {
+            stage = stage.inputStage;
+        }
+        return stage;
+    };
+
+    var original = setKeysPerCandidate(0);
+    try {
+        var searches = ["apple -banana", "apple -cherry", "apple -banana -cherry", "apple -doe",
+                        "apple -banana \"apple\"", "apple -BANANA"];
+        searches.forEach(function(search) {
+            setKeysPerCandidate(0);
+            var fromMatcher = run(search);
+            assert.eq(0, getTextStage(fromMatcher.stats).negatedKeysExamined);
+
+            setKeysPerCandidate(10);
+            var fromIndex = run(search);
+            assert.eq(fromMatcher.ids, fromIndex.ids, search);
+            assert.lte(fromIndex.stats.totalDocsExamined,
+                       fromMatcher.stats.totalDocsExamined,
+                       search);
+        });
+
+        // The documents with the negated term are never fetched.
+        var withoutBanana = run("apple -banana");
+        assert.eq(101, withoutBanana.ids.length, tojson(withoutBanana.ids));
+        assert.eq(101, withoutBanana.stats.totalDocsExamined, tojson(withoutBanana.stats));
+        assert.eq(400, getTextStage(withoutBanana.stats).negatedKeysExamined);
+
+        // With too small a budget the stage leaves the rest of the negated terms to the matcher.
+        setKeysPerCandidate(1);
+        var partial = run("apple -banana -cherry");
+        assert.eq(201, getTextStage(partial.stats).negatedKeysExamined);
+        assert.eq(withoutBanana.ids.filter(function(id) {
+            return id % 5 !== 0;
+        }), partial.ids);
+    }
+    finally {
+        setKeysPerCandidate(original);
+    }
+})();
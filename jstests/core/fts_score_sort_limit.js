@@ -0,0 +1,66 @@
+// Check that a text search sorted on the text score with a limit returns the best results, and
+// reads fewer index keys to find them.
+
+(function() {
+    'use strict';
+
+    // mongos does not merge the per-shard explain stats.
+    if (db.isMaster().msg === "isdbgrid") {
+        return;
+    }
+
+    var t = db.jstests_fts_score_sort_limit;
+    t.drop();
+
+    var words = ["apple", "banana", "cherry", "date", "elder"];
+    var bulk = t.initializeUnorderedBulkOp();
+    for (var i = 0; i < 500; ++i) {
+        var text = [];
+        for (var j = 0; j < words.length; ++j) {
+            // Give each document its own mix of repeated terms so that the scores vary.
+            for (var k = 0; k < (i * (j + 3)) % 7; ++k) {
+                text.push(words[j]);
+            }
+        }
+        text.push("filler");
+        bulk.insert({_id: i, a: text.join(" ")});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(t.ensureIndex({a: "text"}));
+
+    var query = {$text: {$search: "apple cherry elder -date"}};
+    var proj = {score: {$meta: "textScore"}};
+    var sort = {score: {$meta: "textScore"}};
+
+    var all = t.find(query, proj).sort(sort).toArray();
+    assert.gt(all.length, 10);
+
+    [1, 5, 10].forEach(function(limit) {
+        var top = t.find(query, proj).sort(sort).limit(limit).toArray();
+        assert.eq(limit, top.length, tojson(top));
+        for (var i = 0; i < limit; ++i) {
+            assert.eq(all[i].score, top[i].score, tojson(top));
+        }
+    });
+
+    // The limit is passed down to the text stage, which stops early.
+    var getTextStage = function(explain) {
+        var stage = explain.executionStats.executionStages;
+        while (stage.stage !== "TEXT") {
+            stage = stage.inputStage;
+        }
+        return stage;
+    };
+
+    var unlimited = getTextStage(t.find(query, proj).sort(sort).explain("executionStats"));
+    var limited =
+        getTextStage(t.find(query, proj).sort(sort).limit(5).explain("executionStats"));
+    assert.eq(5, limited.limitAmount, tojson(limited));
+    assert.lt(limited.keysExamined, unlimited.keysExamined, tojson(limited));
+
+    // A sort on anything more than the text score still has to see every result.
+    var compound =
+        getTextStage(t.find(query, proj).sort({score: {$meta: "textScore"}, _id: 1})
+                         .limit(5).explain("executionStats"));
+    assert(!compound.limitAmount, tojson(compound));
+})();
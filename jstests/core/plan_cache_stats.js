@@ -0,0 +1,40 @@
+// Check the plan cache hit and miss counters reported by collStats.
+
+(function() {
+    'use strict';
+
+    // mongos does not roll up the per-shard plan cache counters.
+    if (db.isMaster().msg === "isdbgrid") {
+        return;
+    }
+
+    var t = db.jstests_plan_cache_stats;
+    t.drop();
+
+    assert.commandWorked(t.ensureIndex({a: 1}));
+    assert.commandWorked(t.ensureIndex({b: 1}));
+    for (var i = 0; i < 20; ++i) {
+        assert.writeOK(t.insert({a: i, b: i}));
+    }
+
+    var planCacheStats = function() {
+        var stats = assert.commandWorked(t.stats());
+        assert(stats.planCache, tojson(stats));
+        return stats.planCache;
+    };
+
+    var before = planCacheStats();
+    assert.eq(0, before.size, tojson(before));
+
+    // The first run of a query with several candidate plans misses and populates the cache.
+    assert.eq(1, t.find({a: 5, b: 5}).itcount());
+    var afterMiss = planCacheStats();
+    assert.eq(1, afterMiss.size, tojson(afterMiss));
+    assert.eq(before.misses + 1, afterMiss.misses, tojson(afterMiss));
+
+    // Later runs of the same shape hit it.
+    assert.eq(1, t.find({a: 6, b: 6}).itcount());
+    var afterHit = planCacheStats();
+    assert.eq(afterMiss.hits + 1, afterHit.hits, tojson(afterHit));
+    assert.eq(afterMiss.misses, afterHit.misses, tojson(afterHit));
+})();
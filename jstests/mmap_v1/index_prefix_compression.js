@@ -0,0 +1,65 @@
+// Check that v2 indexes, whose btree buckets store the prefix their keys share once, index the
+// same keys as v1 ones in less space, and that compact keeps them v2.
+
+var t = db.jstests_index_prefix_compression;
+t.drop();
+
+var prefix = new Array(201).join('x');
+var bulk = t.initializeUnorderedBulkOp();
+for (var i = 0; i < 5000; i++) {
+    bulk.insert({a: prefix + (i % 100), b: prefix + i, c: prefix + i});
+}
+assert.writeOK(bulk.execute());
+
+assert.commandWorked(t.ensureIndex({a: 1, b: 1}, {v: 2}));
+assert.commandWorked(t.ensureIndex({a: 1, c: 1}, {v: 1}));
+
+var indexVersion = function(name) {
+    var indexes = t.getIndexes();
+    for (var i = 0; i < indexes.length; i++) {
+        if (indexes[i].name === name) {
+            return indexes[i].v;
+        }
+    }
+    assert(false, "no index " + name + ": " + tojson(indexes));
+};
+assert.eq(2, indexVersion('a_1_b_1'));
+
+var checkQueries = function() {
+    assert.eq(50, t.find({a: prefix + 7}).hint({a: 1, b: 1}).itcount());
+    assert.eq(1, t.find({a: prefix + 7, b: prefix + 4907}).hint({a: 1, b: 1}).itcount());
+    assert.eq(0, t.find({a: prefix + 7, b: prefix + 4908}).hint({a: 1, b: 1}).itcount());
+    assert.eq(5000, t.find({a: {$gte: ''}}).hint({a: 1, b: 1}).itcount());
+
+    var sorted = t.find({a: prefix + 3}, {_id: 0, a: 1, b: 1}).sort({a: 1, b: -1})
+                  .hint({a: 1, b: 1}).toArray();
+    assert.eq(50, sorted.length);
+    for (var i = 1; i < sorted.length; i++) {
+        assert.gt(sorted[i - 1].b, sorted[i].b);
+    }
+
+    var res = t.validate(true);
+    assert(res.valid, tojson(res));
+};
+
+// Built in bulk.
+checkQueries();
+var sizes = t.stats().indexSizes;
+assert.lt(sizes.a_1_b_1 * 2, sizes.a_1_c_1, tojson(sizes));
+
+// Built by inserts, removes included.
+assert.commandWorked(t.dropIndex({a: 1, b: 1}));
+t.remove({});
+var bulk = t.initializeUnorderedBulkOp();
+for (var i = 0; i < 5000; i++) {
+    bulk.insert({a: prefix + (i % 100), b: prefix + i, c: prefix + i});
+}
+assert.commandWorked(t.ensureIndex({a: 1, b: 1}, {v: 2}));
+assert.writeOK(bulk.execute());
+assert.writeOK(t.insert({a: prefix + 'gone', b: prefix + 'gone'}));
+assert.writeOK(t.remove({a: prefix + 'gone'}));
+checkQueries();
+
+assert.commandWorked(t.runCommand('compact'));
+assert.eq(2, indexVersion('a_1_b_1'));
+checkQueries();
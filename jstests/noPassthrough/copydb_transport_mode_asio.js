@@ -0,0 +1,62 @@
+// Runs copydbgetnonce followed by copydb against a mongod using the asio transport. The connection
+// that copydbgetnonce opens to the source host must still be found by copydb when the two commands
+// are serviced by different worker threads.
+
+(function() {
+    'use strict';
+
+    var source = MongoRunner.runMongod({});
+    assert.neq(null, source, "source mongod failed to start");
+
+    // The user needs MONGODB-CR credentials, which are only created under auth schema version 3.
+    var sourceAdmin = source.getDB('admin');
+    assert.writeOK(sourceAdmin.system.version.save({_id: "authSchema", currentVersion: 3}));
+    var sourceDB = source.getDB('copydb_asio_source');
+    sourceDB.createUser({user: "copier", pwd: "secret", roles: ["read"]});
+    for (var i = 0; i < 10; i++) {
+        assert.writeOK(sourceDB.coll.insert({_id: i}));
+    }
+
+    var target = MongoRunner.runMongod({transportMode: "asio", asioWorkerThreads: 4});
+    assert.neq(null, target, "target mongod failed to start with --transportMode=asio");
+
+    var admin = target.getDB('admin');
+    var others = [];
+    for (var i = 0; i < 8; i++) {
+        others.push(new Mongo(target.host));
+    }
+
+    for (var round = 0; round < 5; round++) {
+        var todb = 'copydb_asio_target' + round;
+        var n = assert.commandWorked(admin.runCommand({copydbgetnonce: 1,
+                                                       fromhost: source.host}));
+
+        // Keep the other workers busy so that copydb is likely to run on another thread.
+        others.forEach(function(conn) {
+            assert.commandWorked(conn.getDB('admin').runCommand({ping: 1}));
+        });
+
+        assert.commandWorked(admin.runCommand({copydb: 1,
+                                               fromhost: source.host,
+                                               fromdb: sourceDB.getName(),
+                                               todb: todb,
+                                               username: "copier",
+                                               nonce: n.nonce,
+                                               key: admin.__pwHash(n.nonce, "copier", "secret")}));
+        assert.eq(10, target.getDB(todb).coll.count());
+    }
+
+    // copydb without a preceding copydbgetnonce on the same connection still fails.
+    var other = others[0].getDB('admin');
+    var n = assert.commandWorked(admin.runCommand({copydbgetnonce: 1, fromhost: source.host}));
+    assert.commandFailed(other.runCommand({copydb: 1,
+                                           fromhost: source.host,
+                                           fromdb: sourceDB.getName(),
+                                           todb: 'copydb_asio_other',
+                                           username: "copier",
+                                           nonce: n.nonce,
+                                           key: other.__pwHash(n.nonce, "copier", "secret")}));
+
+    MongoRunner.stopMongod(target);
+    MongoRunner.stopMongod(source);
+}());
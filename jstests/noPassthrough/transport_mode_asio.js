@@ -0,0 +1,43 @@
+// Runs basic operations against a mongod using the asio transport and checks that its worker pool
+// counters are reported in db.serverStatus().network.transport.
+
+(function() {
+    'use strict';
+
+    var mongo = MongoRunner.runMongod({transportMode: "asio", asioWorkerThreads: 4});
+    assert.neq(null, mongo, "mongod failed to start with --transportMode=asio");
+
+    var testDB = mongo.getDB('test');
+    var coll = testDB.transport_mode_asio;
+    coll.drop();
+
+    // More concurrent connections than worker threads, each issuing several requests.
+    var conns = [];
+    for (var i = 0; i < 10; i++) {
+        conns.push(new Mongo(mongo.host));
+    }
+    for (var round = 0; round < 5; round++) {
+        conns.forEach(function(conn, i) {
+            assert.writeOK(conn.getDB('test').transport_mode_asio.insert({conn: i, round: round}));
+        });
+    }
+    assert.eq(50, coll.count());
+
+    // Cursors survive their getMores being run by different worker threads.
+    assert.eq(50, coll.find().batchSize(2).itcount());
+
+    var transport = assert.commandWorked(testDB.serverStatus()).network.transport;
+    assert(transport, "serverStatus is missing network.transport: " + tojson(transport));
+    assert.eq("asio", transport.mode, tojson(transport));
+    assert.eq(4, transport.workerThreads, tojson(transport));
+    assert.gte(transport.completed, 50, tojson(transport));
+    assert.gte(transport.running, 1, tojson(transport));
+
+    MongoRunner.stopMongod(mongo);
+
+    // The default transport does not report the section.
+    mongo = MongoRunner.runMongod({});
+    var serverStatus = assert.commandWorked(mongo.getDB('test').serverStatus());
+    assert(!serverStatus.network.transport, tojson(serverStatus.network));
+    MongoRunner.stopMongod(mongo);
+}());
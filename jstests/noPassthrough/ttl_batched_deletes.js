@@ -0,0 +1,100 @@
+// Test that the TTL monitor deletes in batches, keeps to its rate limit, runs passes over several
+// databases at once, and reports what it did for each index in serverStatus.
+(function() {
+    "use strict";
+
+    var runner = MongoRunner.runMongod({setParameter: "ttlMonitorSleepSecs=1"});
+    var admin = runner.getDB("admin");
+
+    var setParameter = function(params) {
+        var cmd = {setParameter: 1};
+        for (var name in params) {
+            cmd[name] = params[name];
+        }
+        assert.commandWorked(admin.runCommand(cmd));
+    };
+
+    var indexMetrics = function(coll) {
+        var ttl = admin.serverStatus().metrics.ttl;
+        assert(ttl.indexes, tojson(ttl));
+        var forNs = ttl.indexes[coll.getFullName()];
+        return forNs ? forNs["x_1"] : undefined;
+    };
+
+    // Stop the monitor while the collections are filled in.
+    setParameter({ttlMonitorEnabled: false});
+
+    var fill = function(coll, n) {
+        coll.drop();
+        var expired = new Date(new Date().getTime() - 60 * 60 * 1000);
+        var bulk = coll.initializeUnorderedBulkOp();
+        for (var i = 0; i < n; ++i) {
+            bulk.insert({x: expired, i: i});
+        }
+        // This one hasn't expired.
+        bulk.insert({x: new Date(new Date().getTime() + 60 * 60 * 1000)});
+        assert.writeOK(bulk.execute());
+        assert.commandWorked(coll.ensureIndex({x: 1}, {expireAfterSeconds: 60}));
+    };
+
+    // Small batches over two databases at once.
+    var collA = runner.getDB("ttl_batched_a").coll;
+    var collB = runner.getDB("ttl_batched_b").coll;
+    fill(collA, 250);
+    fill(collB, 250);
+
+    setParameter({ttlMonitorBatchSize: 10, ttlMonitorThreads: 2, ttlMonitorEnabled: true});
+    assert.soon(function() {
+        return collA.count() == 1 && collB.count() == 1;
+    }, "TTL monitor didn't delete the expired documents");
+
+    [collA, collB].forEach(function(coll) {
+        assert.soon(function() {
+            var metrics = indexMetrics(coll);
+            return metrics && metrics.deletedDocuments == 250 && metrics.lagSecs == 0;
+        }, "wrong TTL metrics: " + tojson(admin.serverStatus().metrics.ttl));
+    });
+
+    // The metrics of an index go away with it.
+    collB.drop();
+    var passes = admin.serverStatus().metrics.ttl.passes;
+    assert.soon(function() {
+        return admin.serverStatus().metrics.ttl.passes >= passes + 2;
+    });
+    assert.eq(undefined, indexMetrics(collB), tojson(admin.serverStatus().metrics.ttl));
+
+    // Deleting 100 documents at 50 a second takes about two seconds.
+    setParameter({ttlMonitorEnabled: false, ttlMonitorThreads: 1});
+    fill(collA, 100);
+    var start = new Date();
+    setParameter({ttlMonitorMaxDocsPerSecond: 50, ttlMonitorEnabled: true});
+    assert.soon(function() {
+        return collA.count() == 1;
+    }, "TTL monitor didn't delete the expired documents");
+    assert.gte(new Date() - start, 1000);
+
+    // A pass out of time leaves the rest to the next one, but does at least one batch.
+    setParameter({ttlMonitorEnabled: false, ttlMonitorMaxDocsPerSecond: 0});
+    fill(collA, 5);
+    passes = admin.serverStatus().metrics.ttl.passes;
+    setParameter({ttlMonitorBatchSize: 1, ttlMonitorMaxPassMillis: 1, ttlMonitorEnabled: true});
+    assert.soon(function() {
+        return collA.count() == 1;
+    }, "TTL monitor didn't delete the expired documents");
+    assert.gt(admin.serverStatus().metrics.ttl.passes, passes + 1);
+
+    // A pass out of time still does a batch for each of the TTL indexes of a database, rather than
+    // leaving the others until the first has nothing left to delete.
+    setParameter({ttlMonitorEnabled: false});
+    var sameDB = runner.getDB("ttl_batched_c");
+    var first = sameDB.first;
+    var second = sameDB.second;
+    fill(first, 100);
+    fill(second, 100);
+    setParameter({ttlMonitorEnabled: true});
+    assert.soon(function() {
+        return first.count() < 101 && second.count() < 101;
+    }, "TTL monitor didn't delete from both collections");
+
+    MongoRunner.stopMongod(runner);
+})();
@@ -0,0 +1,63 @@
+/**
+ * This test is only for WiredTiger storageEngine
+ * Check that j:true writes wait on the journal group commit, and that serverStatus reports the
+ * flushes done and the wait times.
+ */
+(function() {
+    'use strict';
+
+    // This test can only be run if the storageEngine is wiredTiger
+    if (jsTest.options().storageEngine && jsTest.options().storageEngine !== "wiredTiger") {
+        jsTestLog("Skipping test because storageEngine is not wiredTiger");
+        return;
+    }
+
+    var conn = MongoRunner.runMongod({storageEngine: "wiredTiger"});
+    var coll = conn.getDB("test").wt_group_commit;
+
+    var groupCommitStats = function() {
+        var status = assert.commandWorked(conn.getDB("admin").runCommand({serverStatus: 1}));
+        assert(status.wiredTiger.groupCommit, tojson(status.wiredTiger));
+        return status.wiredTiger.groupCommit;
+    };
+
+    var checkHistogram = function(stats) {
+        var total = 0;
+        for (var bucket in stats.waitTimeHistogram) {
+            total += stats.waitTimeHistogram[bucket];
+        }
+        assert.eq(stats.waits, total, tojson(stats));
+    };
+
+    var before = groupCommitStats();
+    checkHistogram(before);
+
+    // A single journaled write waits for a flush of its own.
+    assert.writeOK(coll.insert({_id: 0}, {writeConcern: {j: true}}));
+    var afterOne = groupCommitStats();
+    assert.eq(before.waits + 1, afterOne.waits, tojson(afterOne));
+    assert.eq(before.flushes + 1, afterOne.flushes, tojson(afterOne));
+    checkHistogram(afterOne);
+
+    // Concurrent journaled writers share flushes.
+    var writers = [];
+    for (var i = 0; i < 4; i++) {
+        writers.push(startParallelShell(
+            "for (var j = 0; j < 50; j++) {" +
+            "    assert.writeOK(db.getSiblingDB('test').wt_group_commit.insert(" +
+            "        {w: " + i + ", j: j}, {writeConcern: {j: true}}));" +
+            "}", conn.port));
+    }
+    writers.forEach(function(join) {
+        join();
+    });
+
+    var afterMany = groupCommitStats();
+    assert.eq(afterOne.waits + 200, afterMany.waits, tojson(afterMany));
+    assert.lte(afterMany.flushes - afterOne.flushes, 200, tojson(afterMany));
+    assert.gte(afterMany.flushTimeMicros, afterOne.flushTimeMicros, tojson(afterMany));
+    checkHistogram(afterMany);
+    assert.eq(201, coll.count());
+
+    MongoRunner.stopMongod(conn);
+})();
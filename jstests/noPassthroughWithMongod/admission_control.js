@@ -0,0 +1,58 @@
+// Tests that operations are admitted through the admission controller and that its queueing
+// statistics are reported in serverStatus.
+//
+// Note that this test sets the server parameter "admissionControlMaxConcurrentOperations", and
+// restores the original value of the parameter before exiting.  As a result, this test cannot run
+// in the sharding passthrough (because mongos does not have this parameter), and cannot run in the
+// parallel suite (because the change of the parameter value would interfere with other tests).
+
+var coll = db.admission_control;
+coll.drop();
+
+var result = db.adminCommand({getParameter: 1, admissionControlMaxConcurrentOperations: 1});
+assert.commandWorked(result);
+var oldMax = result.admissionControlMaxConcurrentOperations;
+
+assert.commandFailed(db.adminCommand({setParameter: 1,
+                                      admissionControlMaxConcurrentOperations: -1}));
+assert.commandWorked(db.adminCommand({setParameter: 1,
+                                      admissionControlMaxConcurrentOperations: 2}));
+
+try {
+    var before = db.serverStatus().admissionControl;
+    assert.eq(2, before.maxConcurrentOperations, tojson(before));
+
+    // More concurrent clients than admission slots, so some of them have to queue.
+    var awaitShells = [];
+    for (var i = 0; i < 4; i++) {
+        awaitShells.push(startParallelShell(
+            'for (var i = 0; i < 200; i++) {' +
+            '    db.admission_control.insert({x: i});' +
+            '    db.admission_control.find({x: i}).itcount();' +
+            '}'));
+    }
+    awaitShells.forEach(function(awaitShell) {
+        awaitShell();
+    });
+    assert.eq(800, coll.count());
+
+    var after = db.serverStatus().admissionControl;
+    assert.gte(after.userWrite.admitted - before.userWrite.admitted, 800, tojson(after));
+    assert.gte(after.userRead.admitted - before.userRead.admitted, 800, tojson(after));
+    assert.eq(0, after.userWrite.currentQueue, tojson(after));
+    assert.eq(0, after.userRead.currentQueue, tojson(after));
+
+    // Every admission which is no longer queued lands in exactly one queue time bucket.
+    ["userRead", "userWrite", "replication", "internal"].forEach(function(className) {
+        var stats = after[className];
+        var total = 0;
+        for (var bucket in stats.queueTimeHistogram) {
+            total += stats.queueTimeHistogram[bucket];
+        }
+        assert.eq(stats.admitted - stats.currentQueue, total, tojson(stats));
+    });
+}
+finally {
+    assert.commandWorked(db.adminCommand({setParameter: 1,
+                                          admissionControlMaxConcurrentOperations: oldMax}));
+}
@@ -0,0 +1,63 @@
+// Test that $group gives the same results when its accumulators run on worker threads.
+//
+// Note that this test sets the server parameter "internalDocumentSourceGroupWorkerThreads", and
+// restores the original value of the parameter before exiting.  As a result, this test cannot run
+// in the sharding passthrough (because mongos does not have this parameter), and cannot run in the
+// parallel suite (because the change of the parameter value would interfere with other tests).
+
+var coll = db.group_worker_threads;
+coll.drop();
+
+var result = db.adminCommand({getParameter: 1, internalDocumentSourceGroupWorkerThreads: 1});
+assert.commandWorked(result);
+var oldWorkerThreads = result.internalDocumentSourceGroupWorkerThreads;
+
+function setWorkerThreads(n) {
+    assert.commandWorked(db.adminCommand({setParameter: 1,
+                                          internalDocumentSourceGroupWorkerThreads: n}));
+}
+
+function sortedResults(pipeline) {
+    var results = coll.aggregate(pipeline).toArray();
+    results.sort(function(a, b) {
+        return bsonWoCompare({x: a._id}, {x: b._id});
+    });
+    return results;
+}
+
+try {
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 20000; ++i) {
+        bulk.insert({a: i % 1000, b: i % 7, c: i, s: "str" + (i % 13)});
+    }
+    assert.writeOK(bulk.execute());
+
+    var pipelines = [
+        [{$group: {_id: "$a", total: {$sum: "$c"}, avg: {$avg: "$c"}, n: {$sum: 1}}}],
+        [{$group: {_id: {a: "$a", b: "$b"}, max: {$max: "$c"}, min: {$min: "$c"}}}],
+        [{$group: {_id: "$b", strs: {$addToSet: "$s"}}}],
+        [{$sort: {c: 1}}, {$group: {_id: "$b", first: {$first: "$c"}, last: {$last: "$c"}}}],
+        [{$sort: {c: 1}}, {$group: {_id: "$b", cs: {$push: "$c"}}}],
+        [{$group: {_id: "$missing", n: {$sum: 1}}}],
+        [{$limit: 10}, {$group: {_id: "$a", cs: {$push: "$c"}}}],
+        [{$match: {a: {$gt: 5000}}}, {$group: {_id: "$a"}}],
+    ];
+
+    pipelines.forEach(function(pipeline) {
+        setWorkerThreads(1);
+        var expected = sortedResults(pipeline);
+        setWorkerThreads(4);
+        assert.eq(expected, sortedResults(pipeline), tojson(pipeline));
+    });
+
+    // Errors raised on a worker thread fail the aggregation.
+    setWorkerThreads(4);
+    assert.commandFailed(db.runCommand({aggregate: coll.getName(),
+                                        pipeline: [{$group: {_id: "$a",
+                                                             n: {$sum: {$add: ["$s", 1]}}}}]}));
+    assert.commandFailed(db.runCommand({aggregate: coll.getName(),
+                                        pipeline: [{$group: {_id: {$add: ["$s", 1]}}}]}));
+}
+finally {
+    setWorkerThreads(oldWorkerThreads);
+}
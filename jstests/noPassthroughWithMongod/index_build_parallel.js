@@ -0,0 +1,88 @@
+// Test foreground index builds which generate their keys on several threads.
+//
+// Note that this test sets the server parameter "indexBuildWorkerThreads", and restores the
+// original value of the parameter before exiting.  As a result, this test cannot run in the
+// sharding passthrough (because mongos does not have this parameter), and cannot run in the
+// parallel suite (because the change of the parameter value would interfere with other tests).
+
+var coll = db.index_build_parallel;
+coll.drop();
+
+var result = db.adminCommand({getParameter: 1, indexBuildWorkerThreads: 1});
+assert.commandWorked(result);
+var oldWorkerThreads = result.indexBuildWorkerThreads;
+
+assert.commandFailed(db.adminCommand({setParameter: 1, indexBuildWorkerThreads: 0}));
+assert.commandWorked(db.adminCommand({setParameter: 1, indexBuildWorkerThreads: 4}));
+
+try {
+    // Enough documents for the scan to hand several batches to the workers.
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 10000; ++i) {
+        bulk.insert({a: i % 100, b: [i, -i], c: i, d: i % 2});
+    }
+    assert.writeOK(bulk.execute());
+
+    // Several indexes built together, including a multikey and a partial index.
+    assert.commandWorked(coll.runCommand({createIndexes: coll.getName(),
+                                          indexes: [{key: {a: 1, c: 1}, name: "a_1_c_1"},
+                                                    {key: {b: 1}, name: "b_1"},
+                                                    {key: {c: -1}, name: "c_-1",
+                                                     partialFilterExpression: {d: 1}}]}));
+    assert(coll.validate(true).valid);
+
+    assert.eq(100, coll.find({a: 7}).hint({a: 1, c: 1}).itcount());
+    assert.eq(1, coll.find({b: -42}).hint({b: 1}).itcount());
+    assert.eq(5000, coll.find({d: 1}).hint({c: -1}).itcount());
+
+    // Keys come out of the merged sorters in order.
+    var prev = -1;
+    coll.find({}, {_id: 0, c: 1}).hint({a: 1, c: 1}).min({a: 3, c: MinKey}).max({a: 4, c: MinKey})
+        .forEach(function(doc) {
+            assert.lt(prev, doc.c);
+            prev = doc.c;
+        });
+
+    // Duplicates found across the workers fail a unique index build.
+    assert.commandFailed(coll.ensureIndex({a: 1}, {unique: true}));
+    assert.commandWorked(coll.ensureIndex({c: 1}, {unique: true}));
+
+    // Errors generating keys on a worker fail the build.
+    assert.writeOK(coll.insert({geo: {type: "Point", coordinates: [500, 500]}}));
+    assert.commandFailed(coll.ensureIndex({geo: "2dsphere"}));
+    assert.eq(5, coll.getIndexes().length);
+
+    // A build of many indexes uses fewer workers, so that it doesn't feed too many sorters.
+    var wide = db.index_build_parallel_wide;
+    wide.drop();
+    var indexes = [];
+    bulk = wide.initializeUnorderedBulkOp();
+    for (var i = 0; i < 1000; ++i) {
+        var doc = {};
+        for (var j = 0; j < 16; ++j) {
+            doc["f" + j] = i * j;
+        }
+        bulk.insert(doc);
+    }
+    assert.writeOK(bulk.execute());
+    for (var j = 0; j < 16; ++j) {
+        var key = {};
+        key["f" + j] = 1;
+        indexes.push({key: key, name: "f" + j + "_1"});
+    }
+    assert.commandWorked(wide.runCommand({createIndexes: wide.getName(), indexes: indexes}));
+    assert.eq(17, wide.getIndexes().length);
+    var log = assert.commandWorked(db.adminCommand({getLog: "global"})).log;
+    var lastWorkersLine;
+    log.forEach(function(line) {
+        if (/generating index keys on/.test(line)) {
+            lastWorkersLine = line;
+        }
+    });
+    assert(/generating index keys on 2 threads/.test(lastWorkersLine), lastWorkersLine);
+    wide.drop();
+}
+finally {
+    assert.commandWorked(db.adminCommand({setParameter: 1,
+                                          indexBuildWorkerThreads: oldWorkerThreads}));
+}
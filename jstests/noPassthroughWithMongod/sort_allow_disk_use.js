@@ -0,0 +1,79 @@
+// Test that a blocking sort in a find spills to disk, rather than failing, when it outgrows the
+// internal sort memory limit and allowDiskUse is set.
+//
+// Note that this test sets the server parameter "internalQueryExecMaxBlockingSortBytes", and
+// restores the original value of the parameter before exiting.  As a result, this test cannot run
+// in the sharding passthrough (because mongos does not have this parameter), and cannot run in the
+// parallel suite (because the change of the parameter value would interfere with other tests).
+
+var coll = db.sort_allow_disk_use;
+coll.drop();
+
+// Set the internal sort memory limit to 1MB.
+var result = db.adminCommand({getParameter: 1, internalQueryExecMaxBlockingSortBytes: 1});
+assert.commandWorked(result);
+var oldSortLimit = result.internalQueryExecMaxBlockingSortBytes;
+var newSortLimit = 1024 * 1024;
+assert.commandWorked(db.adminCommand({setParameter: 1,
+                                      internalQueryExecMaxBlockingSortBytes: newSortLimit}));
+
+try {
+    // Insert ~3MB of data, with duplicate sort keys so that ties have to be broken consistently.
+    var largeStr = '';
+    for (var i = 0; i < 32 * 1024; ++i) {
+        largeStr += 'x';
+    }
+    for (var i = 0; i < 100; ++i) {
+        assert.writeOK(coll.insert({a: largeStr, b: i % 50, c: i}));
+    }
+
+    // Without allowDiskUse the sort still fails.
+    assert.throws(function() {
+        coll.find().sort({b: 1}).itcount();
+    });
+
+    // With it, all the documents come back in order.
+    var results = coll.find({}, {a: 0}).sort({b: -1, c: 1}).allowDiskUse().toArray();
+    assert.eq(100, results.length);
+    for (var i = 1; i < results.length; ++i) {
+        assert.gte(results[i - 1].b, results[i].b);
+        if (results[i - 1].b === results[i].b) {
+            assert.lt(results[i - 1].c, results[i].c);
+        }
+    }
+
+    // A limit and skip are honored once the sort has spilled.
+    results = coll.find({}, {a: 0}).sort({c: 1}).skip(10).limit(60).allowDiskUse().toArray();
+    assert.eq(60, results.length);
+    assert.eq(10, results[0].c);
+    assert.eq(69, results[59].c);
+
+    // Results survive being returned over several getMores.
+    assert.eq(100, coll.find().sort({b: 1}).batchSize(7).allowDiskUse().itcount());
+
+    // The find command accepts the option directly, and explain reports that the sort spilled.
+    var cmdRes = db.runCommand({find: coll.getName(), sort: {b: 1}, allowDiskUse: true,
+                                projection: {a: 0}, batchSize: 200});
+    assert.commandWorked(cmdRes);
+    assert.eq(100, cmdRes.cursor.firstBatch.length);
+
+    var explain = coll.find().sort({b: 1}).allowDiskUse().explain("executionStats");
+    var sortStage = explain.executionStats.executionStages;
+    while (sortStage.stage !== "SORT") {
+        sortStage = sortStage.inputStage;
+    }
+    assert.eq(true, sortStage.usedDisk, tojson(explain));
+
+    // Sorts which fit in memory do not spill.
+    explain = coll.find().sort({b: 1}).limit(5).allowDiskUse().explain("executionStats");
+    sortStage = explain.executionStats.executionStages;
+    while (sortStage.stage !== "SORT") {
+        sortStage = sortStage.inputStage;
+    }
+    assert(!sortStage.usedDisk, tojson(explain));
+}
+finally {
+    // Restore the original sort memory limit.
+    assert.commandWorked(db.adminCommand({setParameter: 1,
+                                          internalQueryExecMaxBlockingSortBytes: oldSortLimit}));
+}
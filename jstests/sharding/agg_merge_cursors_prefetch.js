@@ -0,0 +1,76 @@
+// Checks that a split aggregation merges the same results whether or not the merging shard
+// prefetches getMores on the shard cursors, with batches small enough to need many getMores.
+
+var st = new ShardingTest({shards: 2, mongos: 1, other: {chunksize: 1}});
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB("admin");
+var coll = mongos.getCollection("aggPrefetch.coll");
+
+assert.commandWorked(admin.runCommand({enableSharding: coll.getDB().getName()}));
+st.ensurePrimaryShard(coll.getDB().getName(), 'shard0000');
+assert.commandWorked(admin.runCommand({shardCollection: coll.getFullName(), key: {_id: 1}}));
+assert.commandWorked(admin.runCommand({split: coll.getFullName(), middle: {_id: 1000}}));
+assert.commandWorked(admin.runCommand({moveChunk: coll.getFullName(),
+                                       find: {_id: 1000},
+                                       to: 'shard0001'}));
+
+var bulk = coll.initializeUnorderedBulkOp();
+for (var i = 0; i < 2000; i++) {
+    bulk.insert({_id: i, g: i % 7});
+}
+assert.writeOK(bulk.execute());
+
+var setOnShards = function(params) {
+    [st.shard0, st.shard1].forEach(function(shard) {
+        var cmd = {setParameter: 1};
+        for (var name in params) {
+            cmd[name] = params[name];
+        }
+        assert.commandWorked(shard.getDB("admin").runCommand(cmd));
+    });
+};
+
+var runPipelines = function() {
+    // Unsorted merge of every document.
+    var projected = coll.aggregate([{$project: {g: 1}}]).toArray();
+    assert.eq(2000, projected.length);
+    var seen = {};
+    projected.forEach(function(doc) {
+        assert(!seen[doc._id], tojson(doc));
+        seen[doc._id] = true;
+    });
+
+    // Unsorted merge of partial groups.
+    var grouped = coll.aggregate([{$group: {_id: "$g", n: {$sum: 1}}},
+                                  {$sort: {_id: 1}}]).toArray();
+    assert.eq(7, grouped.length, tojson(grouped));
+    var total = 0;
+    grouped.forEach(function(doc) {
+        total += doc.n;
+    });
+    assert.eq(2000, total, tojson(grouped));
+
+    // Sorted merge of presorted shard streams.
+    var sorted = coll.aggregate([{$sort: {_id: -1}}, {$project: {_id: 1}}]).toArray();
+    assert.eq(2000, sorted.length);
+    for (var i = 0; i < sorted.length; i++) {
+        assert.eq(1999 - i, sorted[i]._id);
+    }
+};
+
+try {
+    setOnShards({internalDocumentSourceMergeCursorsBatchSize: 10,
+                 internalDocumentSourceMergeCursorsPrefetch: true});
+    runPipelines();
+
+    setOnShards({internalDocumentSourceMergeCursorsPrefetch: false});
+    runPipelines();
+}
+finally {
+    setOnShards({internalDocumentSourceMergeCursorsBatchSize: 0,
+                 internalDocumentSourceMergeCursorsPrefetch: true});
+}
+
+st.stop();
@@ -424,6 +424,13 @@ namespace mongo {
             size_t operator() (const BSONElement& elem) const;
         };
 
+        /**
+         * Like Hasher, but ignores the field name, as woCompare(e, false) does.
+         */
+        struct HasherWithoutField {
+            size_t operator() (const BSONElement& elem) const;
+        };
+
         const char * rawdata() const { return data; }
 
         /** 0 == Equality, just not defined yet */
@@ -42,6 +42,13 @@ namespace mongo {
         }
     };
 
+    /** Equality to go with BSONElement::HasherWithoutField in hashed containers. */
+    struct BSONElementEqWithoutField {
+        bool operator()( const BSONElement &l, const BSONElement &r ) const {
+            return l.woCompare( r, false ) == 0;
+        }
+    };
+
     class BSONObjCmp {
     public:
         BSONObjCmp( const BSONObj &order = BSONObj() ) : _order( order ) {}
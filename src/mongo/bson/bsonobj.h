@@ -119,6 +119,16 @@ namespace mongo {
             , _ownedBuffer(std::move(ownedBuffer)) {
         }
 
+        /** Construct an owned BSONObj whose data lives somewhere inside 'holder' rather than at
+         *  its start. This lets many small objects share one allocation; the memory is released
+         *  once the last of them is gone.
+        */
+        BSONObj(SharedBuffer holder, const char* bsonData)
+            : _objdata(bsonData)
+            , _ownedBuffer(std::move(holder)) {
+            dassert(_ownedBuffer.get() && _objdata >= _ownedBuffer.get());
+        }
+
         /** Move construct a BSONObj */
         BSONObj(BSONObj&& other)
             : _objdata(std::move(other._objdata))
@@ -178,6 +188,13 @@ namespace mongo {
         */
         bool isOwned() const { return _ownedBuffer.get() != 0; }
 
+        /** @return true if this is owned, but through a buffer that it may share with other
+            objects, as an object made by BSONObj(SharedBuffer, const char*) does.
+        */
+        bool isInSharedBuffer() const {
+            return isOwned() && _objdata != _ownedBuffer.get();
+        }
+
         /** assure the data buffer is under the control of this BSONObj and not a remote buffer
             @see isOwned()
         */
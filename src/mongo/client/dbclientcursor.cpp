@@ -140,6 +140,9 @@ namespace mongo {
             }
         }
 
+        if ( ! retry )
+            _prefetchMore();
+
         return ! retry;
     }
 
@@ -153,27 +156,61 @@ namespace mongo {
         return ok;
     }
 
+    void DBClientCursor::_assembleGetMore( Message& toSend ) {
+        BufBuilder b;
+        b.appendNum(opts);
+        b.appendStr(ns);
+        b.appendNum(nextBatchSize());
+        b.appendNum(cursorId);
+
+        toSend.setData(dbGetMore, b.buf(), b.len());
+    }
+
+    void DBClientCursor::_prefetchMore() {
+        if ( !_prefetch || _getMorePending || !cursorId || haveLimit )
+            return;
+        if ( opts & ( QueryOption_CursorTailable | QueryOption_Exhaust ) )
+            return;
+        if ( !_client || !_client->lazySupported() )
+            return;
+
+        Message toSend;
+        _assembleGetMore( toSend );
+        _client->say( toSend );
+        _getMorePending = true;
+    }
+
     void DBClientCursor::requestMore() {
         verify( cursorId && batch.pos == batch.nReturned );
 
+        if ( _getMorePending ) {
+            // The getMore went out when the previous batch arrived; only its reply is left.
+            _getMorePending = false;
+            auto_ptr<Message> response(new Message());
+            uassert( 28678,
+                     str::stream() << "error receiving prefetched batch for cursor " << cursorId
+                                   << " from " << _client->getServerAddress(),
+                     _client->recv( *response ) && !response->empty() );
+            this->batch.m = response;
+            dataReceived();
+            _prefetchMore();
+            return;
+        }
+
         if (haveLimit) {
             nToReturn -= batch.nReturned;
             verify(nToReturn > 0);
         }
-        BufBuilder b;
-        b.appendNum(opts);
-        b.appendStr(ns);
-        b.appendNum(nextBatchSize());
-        b.appendNum(cursorId);
 
         Message toSend;
-        toSend.setData(dbGetMore, b.buf(), b.len());
+        _assembleGetMore( toSend );
         auto_ptr<Message> response(new Message());
 
         if ( _client ) {
             _client->call( toSend, *response );
             this->batch.m = response;
             dataReceived();
+            _prefetchMore();
         }
         else {
             verify( _scopedHost.size() );
@@ -341,6 +378,8 @@ namespace mongo {
         verify( _scopedHost.size() == 0 );
         verify( conn );
         verify( conn->get() );
+        // The connection is about to go back to the pool, so it can't have a reply in flight.
+        verify( !_getMorePending );
 
         if ( conn->get()->type() == ConnectionString::SET ||
              conn->get()->type() == ConnectionString::SYNC ) {
@@ -135,6 +135,19 @@ namespace mongo {
         /// Change batchSize after construction. Can change after requesting first batch.
         void setBatchSize(int newBatchSize) { batchSize = newBatchSize; }
 
+        /**
+         * Once enabled, each batch received from the server is immediately followed by a getMore
+         * for the next one, sent without waiting for its reply.  The reply is only read when the
+         * batch in hand runs out, so the round trip overlaps with consuming the current batch and
+         * several prefetching cursors on different connections wait on their servers in parallel.
+         *
+         * Only for cursors that own their connection for their whole lifetime: while a getMore is
+         * in flight its reply is the next message on the connection, so the connection must not
+         * be used for anything else.  Ignored for cursors with a limit, tailable and exhaust
+         * cursors, and connections that do not support lazy requests.
+         */
+        void enablePrefetch() { _prefetch = true; _prefetchMore(); }
+
         DBClientCursor( DBClientBase* client, const std::string &_ns, BSONObj _query, int _nToReturn,
                         int _nToSkip, const BSONObj *_fieldsToReturn, int queryOptions , int bs ) :
             _client(client),
@@ -149,7 +162,9 @@ namespace mongo {
             resultFlags(0),
             cursorId(),
             _ownCursor( true ),
-            wasError( false ) {
+            wasError( false ),
+            _prefetch( false ),
+            _getMorePending( false ) {
             _finishConsInit();
         }
 
@@ -165,7 +180,9 @@ namespace mongo {
             resultFlags(0),
             cursorId(_cursorId),
             _ownCursor(true),
-            wasError(false) {
+            wasError(false),
+            _prefetch(false),
+            _getMorePending(false) {
             _finishConsInit();
         }
 
@@ -240,10 +257,17 @@ namespace mongo {
         std::string _lazyHost;
         bool wasError;
 
+        // See enablePrefetch().  '_getMorePending' is true while a prefetched getMore has been
+        // sent but its reply not yet read.
+        bool _prefetch;
+        bool _getMorePending;
+
         void dataReceived() { bool retry; std::string lazyHost; dataReceived( retry, lazyHost ); }
         void dataReceived( bool& retry, std::string& lazyHost );
         void requestMore();
         void exhaustReceiveMore(); // for exhaust
+        void _assembleGetMore( Message& toSend );
+        void _prefetchMore();
 
         // Don't call from a virtual function
         void _assertIfNull() const { uassert(13348, "connection died", this); }
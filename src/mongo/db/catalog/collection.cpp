@@ -335,6 +335,48 @@ namespace {
         return res;
     }
 
+    Status Collection::insertDocuments(OperationContext* txn,
+                                       const std::vector<BSONObj>& docs,
+                                       bool enforceQuota,
+                                       bool fromMigrate) {
+        invariant(txn->lockState()->inAWriteUnitOfWork());
+
+        // Capped inserts may delete older documents of the same group while it is still being
+        // indexed, so those go one at a time.
+        if (isCapped()) {
+            for (size_t i = 0; i < docs.size(); i++) {
+                StatusWith<RecordId> res = insertDocument(txn, docs[i], enforceQuota, fromMigrate);
+                if (!res.isOK())
+                    return res.getStatus();
+            }
+            return Status::OK();
+        }
+
+        const bool hasIdIndex = _indexCatalog.findIdIndex(txn);
+        for (size_t i = 0; i < docs.size(); i++) {
+            auto status = checkValidation(txn, docs[i]);
+            if (!status.isOK())
+                return status;
+
+            if (hasIdIndex && docs[i]["_id"].eoo()) {
+                return Status(ErrorCodes::InternalError,
+                              str::stream() << "Collection::insertDocuments got "
+                              "document without _id for ns:" << _ns.ns());
+            }
+        }
+
+        const SnapshotId sid = txn->recoveryUnit()->getSnapshotId();
+
+        Status status = _insertDocuments(txn, docs, enforceQuota);
+        invariant(sid == txn->recoveryUnit()->getSnapshotId());
+        if (!status.isOK())
+            return status;
+
+        getGlobalServiceContext()->getOpObserver()->onInserts(txn, ns(), docs, fromMigrate);
+
+        return Status::OK();
+    }
+
     StatusWith<RecordId> Collection::insertDocument(OperationContext* txn,
                                                     const BSONObj& doc,
                                                     MultiIndexBlock* indexBlock,
@@ -405,6 +447,37 @@ namespace {
         return loc;
     }
 
+    Status Collection::_insertDocuments(OperationContext* txn,
+                                        const std::vector<BSONObj>& docs,
+                                        bool enforceQuota) {
+        dassert(txn->lockState()->isCollectionLockedForMode(ns().toString(), MODE_IX));
+
+        std::vector<RecordData> records;
+        records.reserve(docs.size());
+        for (size_t i = 0; i < docs.size(); i++) {
+            records.push_back(RecordData(docs[i].objdata(), docs[i].objsize()));
+        }
+
+        std::vector<RecordId> locs;
+        locs.reserve(docs.size());
+        Status status = _recordStore->insertRecords(txn,
+                                                    records,
+                                                    _enforceQuota(enforceQuota),
+                                                    &locs);
+        if (!status.isOK())
+            return status;
+
+        invariant(locs.size() == docs.size());
+        for (size_t i = 0; i < locs.size(); i++) {
+            invariant(RecordId::min() < locs[i]);
+            invariant(locs[i] < RecordId::max());
+        }
+
+        _infoCache.notifyOfWriteOp();
+
+        return _indexCatalog.indexRecords(txn, docs, locs);
+    }
+
     Status Collection::aboutToDeleteCapped( OperationContext* txn,
                                             const RecordId& loc,
                                             RecordData data ) {
@@ -216,6 +216,17 @@ namespace mongo {
                                             bool enforceQuota,
                                             bool fromMigrate = false);
 
+        /**
+         * Inserts a group of documents, with the same semantics as calling insertDocument on each
+         * of them, but writing the records, index entries and oplog entries a group at a time.
+         * Must be called inside a WriteUnitOfWork. On error, nothing can be assumed about which
+         * documents made it in, so the unit of work must be rolled back.
+         */
+        Status insertDocuments( OperationContext* txn,
+                                const std::vector<BSONObj>& docs,
+                                bool enforceQuota,
+                                bool fromMigrate = false );
+
         /**
          * Callers must ensure no document validation is performed for this collection when calling
          * this method.
@@ -379,6 +390,10 @@ namespace mongo {
                                              const BSONObj& doc,
                                              bool enforceQuota );
 
+        Status _insertDocuments( OperationContext* txn,
+                                 const std::vector<BSONObj>& docs,
+                                 bool enforceQuota );
+
         bool _enforceQuota( bool userEnforeQuota ) const;
 
         int _magic;
@@ -57,9 +57,10 @@ namespace mongo {
             BSONObj::iterator i( oldSpec );
             while( i.more() ) {
                 BSONElement e = i.next();
-                if ( str::equals( e.fieldName(), "v" ) ) {
-                    // Drop any preexisting index version spec.  The default index version will
-                    // be used instead for the new index.
+                if ( str::equals( e.fieldName(), "v" ) && e.numberInt() != 2 ) {
+                    // Drop any preexisting index version spec, except for the prefix compressed
+                    // format that has to be asked for.  The default index version will be used
+                    // instead for the new index.
                     continue;
                 }
                 if ( str::equals( e.fieldName(), "background" ) ) {
@@ -493,9 +493,16 @@ namespace {
                                              << "mmapv1 storage engine");
             }
 
+            // v2 is the mmapv1 btree format with prefix compressed buckets
+            if (v == 2 && !getGlobalServiceContext()->getGlobalStorageEngine()->isMmapV1()) {
+                return Status( ErrorCodes::CannotCreateIndex,
+                               str::stream() << "use of v2 indexes is only allowed with the "
+                                             << "mmapv1 storage engine");
+            }
+
             // note (one day) we may be able to fresh build less versions than we can use
             // isASupportedIndexVersionNumber() is what we can use
-            if ( v != 0 && v != 1 ) {
+            if ( v != 0 && v != 1 && v != 2 ) {
                 return Status( ErrorCodes::CannotCreateIndex,
                                str::stream() << "this version of mongod cannot build new indexes "
                                              << "of version number " << v );
@@ -1199,6 +1206,24 @@ namespace {
         return Status::OK();
     }
 
+    Status IndexCatalog::indexRecords(OperationContext* txn,
+                                      const std::vector<BSONObj>& objs,
+                                      const std::vector<RecordId>& locs) {
+        invariant(objs.size() == locs.size());
+
+        for ( IndexCatalogEntryContainer::const_iterator i = _entries.begin();
+              i != _entries.end();
+              ++i ) {
+            for (size_t doc = 0; doc < objs.size(); doc++) {
+                Status s = _indexRecord(txn, *i, objs[doc], locs[doc]);
+                if (!s.isOK())
+                    return s;
+            }
+        }
+
+        return Status::OK();
+    }
+
     void IndexCatalog::unindexRecord(OperationContext* txn,
                                      const BSONObj& obj,
                                      const RecordId& loc,
@@ -269,6 +269,14 @@ namespace mongo {
         // this throws for now
         Status indexRecord(OperationContext* txn, const BSONObj& obj, const RecordId &loc);
 
+        /**
+         * Indexes each of 'objs' at the RecordId in the same position of 'locs'. Goes through the
+         * indexes one at a time, so that each index's pages are touched in a single pass.
+         */
+        Status indexRecords(OperationContext* txn,
+                            const std::vector<BSONObj>& objs,
+                            const std::vector<RecordId>& locs);
+
         void unindexRecord(OperationContext* txn,
                            const BSONObj& obj,
                            const RecordId& loc,
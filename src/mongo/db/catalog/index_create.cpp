@@ -34,8 +34,10 @@
 
 #include "mongo/db/catalog/index_create.h"
 
+#include <algorithm>
 #include <boost/make_shared.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <deque>
 
 #include "mongo/base/error_codes.h"
 #include "mongo/client/dbclientinterface.h"
@@ -49,7 +51,13 @@
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
 
@@ -59,6 +67,63 @@ namespace mongo {
     using std::string;
     using std::endl;
 
+namespace {
+    const int kMaxIndexBuildWorkerThreads = 64;
+
+    class IndexBuildWorkerThreadsParameter : public ExportedServerParameter<int> {
+    public:
+        IndexBuildWorkerThreadsParameter(int* value)
+            : ExportedServerParameter<int>(ServerParameterSet::getGlobal(),
+                                           "indexBuildWorkerThreads",
+                                           value,
+                                           true,   // allowedToChangeAtStartup
+                                           true)   // allowedToChangeAtRuntime
+        {}
+
+        virtual Status validate(const int& potentialNewValue) {
+            if (potentialNewValue < 1 || potentialNewValue > kMaxIndexBuildWorkerThreads) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << name() << " must be between 1 and "
+                                            << kMaxIndexBuildWorkerThreads);
+            }
+            return Status::OK();
+        }
+    };
+
+    // Number of threads generating keys for a foreground index build. With the default of 1 the
+    // keys are generated by the thread scanning the collection. Builds of many indexes use fewer,
+    // see cappedIndexBuildWorkers().
+    int indexBuildWorkerThreads = 1;
+    IndexBuildWorkerThreadsParameter indexBuildWorkerThreadsParam(&indexBuildWorkerThreads);
+
+    // Limits on how many documents the collection scan hands to a worker at a time.
+    const size_t kParallelBatchMaxDocs = 1000;
+    const size_t kParallelBatchMaxBytes = 4 * 1024 * 1024;
+
+    // Memory shared by the BulkBuilders of every worker building the same index, the same amount
+    // a single BulkBuilder gets on its own.
+    const size_t kParallelBulkMemoryBytes = 100 * 1024 * 1024;
+
+    // Least memory a worker's BulkBuilder gets, so that its spills don't turn into many small
+    // runs.
+    const size_t kMinParallelBulkMemoryBytes = 16 * 1024 * 1024;
+
+    // Most BulkBuilders the workers of a build may feed between them. Each one spills to files of
+    // its own, and the runs of every builder of an index are open at once while they are merged.
+    const size_t kMaxParallelBulkBuilders = 32;
+
+    /**
+     * Returns how many workers should generate the keys of 'numIndexes' indexes, given the
+     * configured number, so that the BulkBuilders they feed stay within the limits above.
+     */
+    size_t cappedIndexBuildWorkers(size_t configured, size_t numIndexes) {
+        size_t workers = std::min(configured,
+                                  kParallelBulkMemoryBytes / kMinParallelBulkMemoryBytes);
+        workers = std::min(workers, kMaxParallelBulkBuilders / std::max(numIndexes, size_t(1)));
+        return std::max(workers, size_t(1));
+    }
+} // namespace
+
     /**
      * On rollback sets MultiIndexBlock::_needToCleanup to true.
      */
@@ -89,6 +154,185 @@ namespace mongo {
         MultiIndexBlock* const _indexer;
     };
 
+    /**
+     * Generates the keys of a foreground bulk build on a set of worker threads while the calling
+     * thread scans the collection. The scan hands owned copies of the documents to the workers in
+     * batches, and each worker feeds its own BulkBuilder for every index being built, so the
+     * workers share nothing but the queue of batches. finish() folds the workers' builders into
+     * the MultiIndexBlock's, where commitBulk() merges their sorted keys.
+     *
+     * Only key generation moves off the scanning thread: storage engine cursors and recovery
+     * units are tied to the OperationContext, which must only be used by a single thread.
+     */
+    class MultiIndexBlock::ParallelKeyGenerator {
+        MONGO_DISALLOW_COPYING(ParallelKeyGenerator);
+    public:
+        ParallelKeyGenerator(MultiIndexBlock* indexer, size_t numWorkers)
+            : _indexer(indexer),
+              _maxQueuedBatches(2 * numWorkers),
+              _builders(numWorkers) {
+
+            for (size_t worker = 0; worker < numWorkers; worker++) {
+                for (size_t i = 0; i < _indexer->_indexes.size(); i++) {
+                    _builders[worker].push_back(_indexer->_indexes[i].real->initiateBulk(
+                                                    kParallelBulkMemoryBytes / numWorkers));
+                }
+            }
+
+            for (size_t worker = 0; worker < numWorkers; worker++) {
+                _workers.emplace_back(stdx::bind(&ParallelKeyGenerator::_runWorker, this, worker));
+            }
+        }
+
+        ~ParallelKeyGenerator() {
+            _shutdown();
+        }
+
+        /**
+         * Queues 'doc' to have its keys generated. Returns the error of any worker which has
+         * failed, after which the build must be abandoned.
+         */
+        Status add(const BSONObj& doc, const RecordId& loc) {
+            _batchBytes += doc.objsize();
+            _batch.push_back(std::make_pair(doc.getOwned(), loc));
+
+            if (_batch.size() < kParallelBatchMaxDocs && _batchBytes < kParallelBatchMaxBytes)
+                return Status::OK();
+
+            return _flushBatch();
+        }
+
+        /**
+         * Waits for the workers to generate the keys of every document added and hands their
+         * BulkBuilders over to the MultiIndexBlock's.
+         */
+        Status finish() {
+            Status status = _flushBatch();
+            _shutdown();
+            if (!status.isOK())
+                return status;
+
+            for (size_t worker = 0; worker < _builders.size(); worker++) {
+                for (size_t i = 0; i < _indexer->_indexes.size(); i++) {
+                    _indexer->_indexes[i].bulk->absorb(std::move(_builders[worker][i]));
+                }
+            }
+            return Status::OK();
+        }
+
+    private:
+        typedef std::vector<std::pair<BSONObj, RecordId> > Batch;
+
+        Status _flushBatch() {
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            while (_status.isOK() && _queue.size() >= _maxQueuedBatches) {
+                _queueNotFull.wait(lk);
+            }
+            if (!_status.isOK())
+                return _status;
+
+            if (!_batch.empty()) {
+                _queue.push_back(Batch());
+                _queue.back().swap(_batch);
+                _batchBytes = 0;
+                _queueNotEmpty.notify_one();
+            }
+            return Status::OK();
+        }
+
+        void _shutdown() {
+            {
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                _shuttingDown = true;
+                _queueNotEmpty.notify_all();
+            }
+            for (size_t worker = 0; worker < _workers.size(); worker++) {
+                if (_workers[worker].joinable())
+                    _workers[worker].join();
+            }
+        }
+
+        void _runWorker(size_t worker) {
+            std::vector<std::unique_ptr<IndexAccessMethod::BulkBuilder> >& builders =
+                _builders[worker];
+
+            while (true) {
+                Batch batch;
+                {
+                    stdx::unique_lock<stdx::mutex> lk(_mutex);
+                    while (_queue.empty() && !_shuttingDown && _status.isOK()) {
+                        _queueNotEmpty.wait(lk);
+                    }
+                    if (_queue.empty() || !_status.isOK())
+                        return;
+
+                    batch.swap(_queue.front());
+                    _queue.pop_front();
+                    _queueNotFull.notify_one();
+                }
+
+                try {
+                    for (Batch::const_iterator it = batch.begin(); it != batch.end(); ++it) {
+                        for (size_t i = 0; i < _indexer->_indexes.size(); i++) {
+                            const IndexToBuild& index = _indexer->_indexes[i];
+                            if (index.filterExpression &&
+                                !index.filterExpression->matchesBSON(it->first)) {
+                                continue;
+                            }
+
+                            // Generating keys into a BulkBuilder never touches the
+                            // OperationContext, which belongs to the scanning thread.
+                            Status status = builders[i]->insert(NULL,
+                                                                it->first,
+                                                                it->second,
+                                                                index.options,
+                                                                NULL);
+                            if (!status.isOK()) {
+                                _fail(status);
+                                return;
+                            }
+                        }
+                    }
+                }
+                catch (const DBException& ex) {
+                    _fail(ex.toStatus());
+                    return;
+                }
+                catch (const std::exception& ex) {
+                    _fail(Status(ErrorCodes::InternalError, ex.what()));
+                    return;
+                }
+            }
+        }
+
+        void _fail(const Status& status) {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            if (_status.isOK())
+                _status = status;
+            _queueNotEmpty.notify_all();
+            _queueNotFull.notify_all();
+        }
+
+        MultiIndexBlock* const _indexer;
+        const size_t _maxQueuedBatches;
+
+        // Only used by the scanning thread.
+        Batch _batch;
+        size_t _batchBytes = 0;
+
+        // _builders[worker][i] is the BulkBuilder 'worker' feeds for _indexer->_indexes[i].
+        std::vector<std::vector<std::unique_ptr<IndexAccessMethod::BulkBuilder> > > _builders;
+
+        stdx::mutex _mutex;
+        stdx::condition_variable _queueNotEmpty;
+        stdx::condition_variable _queueNotFull;
+        std::deque<Batch> _queue;
+        Status _status = Status::OK();
+        bool _shuttingDown = false;
+
+        std::vector<stdx::thread> _workers;
+    };
+
     MultiIndexBlock::MultiIndexBlock(OperationContext* txn, Collection* collection)
         : _collection(collection),
           _txn(txn),
@@ -244,6 +488,16 @@ namespace mongo {
             exec->setYieldPolicy(PlanExecutor::WRITE_CONFLICT_RETRY_ONLY);
         }
 
+        // Foreground builds which can use the bulk method for every index may generate their keys
+        // on several threads.
+        std::unique_ptr<ParallelKeyGenerator> keyGenerator;
+        const size_t numWorkers = cappedIndexBuildWorkers(indexBuildWorkerThreads,
+                                                          _indexes.size());
+        if (!_buildInBackground && numWorkers > 1 && _allIndexesUseBulk()) {
+            log() << "\t generating index keys on " << numWorkers << " threads";
+            keyGenerator.reset(new ParallelKeyGenerator(this, numWorkers));
+        }
+
         Snapshotted<BSONObj> objToIndex;
         RecordId loc;
         PlanExecutor::ExecState state;
@@ -266,6 +520,17 @@ namespace mongo {
                 // Done before insert so we can retry document if it WCEs.
                 progress->setTotalWhileRunning( _collection->numRecords(_txn) );
 
+                if (keyGenerator) {
+                    // Bulk builders defer duplicate key checks to doneInserting().
+                    Status ret = keyGenerator->add(objToIndex.value(), loc);
+                    if (!ret.isOK())
+                        return ret;
+                    progress->hit();
+                    n++;
+                    retries = 0;
+                    continue;
+                }
+
                 WriteUnitOfWork wunit(_txn);
                 Status ret = insert(objToIndex.value(), loc);
                 if (ret.isOK()) {
@@ -312,6 +577,12 @@ namespace mongo {
 
         progress->finished();
 
+        if (keyGenerator) {
+            Status ret = keyGenerator->finish();
+            if (!ret.isOK())
+                return ret;
+        }
+
         Status ret = doneInserting(dupsOut);
         if (!ret.isOK())
             return ret;
@@ -322,6 +593,14 @@ namespace mongo {
         return Status::OK();
     }
 
+    bool MultiIndexBlock::_allIndexesUseBulk() const {
+        for (size_t i = 0; i < _indexes.size(); i++) {
+            if (!_indexes[i].bulk)
+                return false;
+        }
+        return !_indexes.empty();
+    }
+
     Status MultiIndexBlock::insert(const BSONObj& doc, const RecordId& loc) {
         for ( size_t i = 0; i < _indexes.size(); i++ ) {
 
@@ -181,6 +181,7 @@ namespace mongo {
     private:
         class SetNeedToCleanupOnRollback;
         class CleanupIndexesVectorOnRollback;
+        class ParallelKeyGenerator;
 
         struct IndexToBuild {
 #if defined(_MSC_VER) && _MSC_VER < 1900 // MVSC++ <= 2013 can't generate default move operations
@@ -212,6 +213,12 @@ namespace mongo {
             InsertDeleteOptions options;
         };
 
+        /**
+         * Returns true if every index being built has a BulkBuilder, which is required for keys to
+         * be generated by a ParallelKeyGenerator.
+         */
+        bool _allIndexesUseBulk() const;
+
         std::vector<IndexToBuild> _indexes;
 
         std::unique_ptr<BackgroundOperation> _backgroundOperation;
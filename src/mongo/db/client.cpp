@@ -42,6 +42,7 @@
 #include "mongo/base/status.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/service_context.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/exit.h"
@@ -89,6 +90,21 @@ namespace mongo {
         *currentClient.get() = service->makeClient(fullDesc, mp);
     }
 
+    ServiceContext::UniqueClient Client::releaseCurrent() {
+        return std::move(*currentClient.getMake());
+    }
+
+    void Client::setCurrent(ServiceContext::UniqueClient client) {
+        invariant(currentClient.getMake()->get() == nullptr);
+        invariant(client);
+        setThreadName(client->desc());
+        {
+            stdx::lock_guard<Client> lk(*client);
+            client->_threadId = stdx::this_thread::get_id();
+        }
+        *currentClient.getMake() = std::move(client);
+    }
+
     Client::Client(std::string desc,
                    ServiceContext* serviceContext,
                    AbstractMessagingPort *p)
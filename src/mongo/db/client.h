@@ -76,6 +76,20 @@ namespace mongo {
          */
         static void initThreadIfNotAlready();
 
+        /**
+         * Detaches the Client from the current thread and returns it, leaving the thread without
+         * a Client. Returns nullptr if the thread has no Client.
+         *
+         * Used by transports which service one connection from several threads over time.
+         */
+        static ServiceContext::UniqueClient releaseCurrent();
+
+        /**
+         * Attaches "client", previously returned by releaseCurrent(), to the current thread,
+         * which must not already have a Client, and names the thread after it.
+         */
+        static void setCurrent(ServiceContext::UniqueClient client);
+
         std::string clientAddress(bool includePort = false) const;
         const std::string& desc() const { return _desc; }
 
@@ -127,8 +141,9 @@ namespace mongo {
         // Description for the client (e.g. conn8)
         const std::string _desc;
 
-        // OS id of the thread, which owns this client
-        const boost::thread::id _threadId;
+        // OS id of the thread the client is attached to. Changes when setCurrent() moves the
+        // client to another thread, so it is protected by _lock.
+        boost::thread::id _threadId;
 
         // > 0 for things "conn", 0 otherwise
         const ConnectionId _connectionId;
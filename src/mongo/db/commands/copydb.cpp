@@ -153,6 +153,8 @@ namespace {
             }
 
             Cloner cloner;
+            std::unique_ptr<DBClientBase>& authConn =
+                CopyDbAuthConnection::forClient(txn->getClient()).conn;
 
             // Get MONGODB-CR parameters
             string username = cmdObj.getStringField( "username" );
@@ -160,27 +162,27 @@ namespace {
             string key = cmdObj.getStringField( "key" );
 
             if ( !username.empty() && !nonce.empty() && !key.empty() ) {
-                uassert( 13008, "must call copydbgetnonce first", authConn_.get() );
+                uassert( 13008, "must call copydbgetnonce first", authConn.get() );
                 BSONObj ret;
                 {
-                    if ( !authConn_->runCommand( cloneOptions.fromDB,
-                                                 BSON( "authenticate" << 1 << "user" << username
-                                                       << "nonce" << nonce << "key" << key ), ret ) ) {
+                    if ( !authConn->runCommand( cloneOptions.fromDB,
+                                                BSON( "authenticate" << 1 << "user" << username
+                                                      << "nonce" << nonce << "key" << key ), ret ) ) {
                         errmsg = "unable to login " + ret.toString();
                         return false;
                     }
                 }
-                cloner.setConnection( authConn_.release() );
+                cloner.setConnection( authConn.release() );
             }
             else if (cmdObj.hasField(saslCommandConversationIdFieldName) &&
                      cmdObj.hasField(saslCommandPayloadFieldName)) {
-                uassert( 25487, "must call copydbsaslstart first", authConn_.get() );
+                uassert( 25487, "must call copydbsaslstart first", authConn.get() );
                 BSONObj ret;
-                if ( !authConn_->runCommand( cloneOptions.fromDB,
-                                             BSON( "saslContinue" << 1 <<
-                                                   cmdObj[saslCommandConversationIdFieldName] <<
-                                                   cmdObj[saslCommandPayloadFieldName] ),
-                                             ret ) ) {
+                if ( !authConn->runCommand( cloneOptions.fromDB,
+                                            BSON( "saslContinue" << 1 <<
+                                                  cmdObj[saslCommandConversationIdFieldName] <<
+                                                  cmdObj[saslCommandPayloadFieldName] ),
+                                            ret ) ) {
                     errmsg = "unable to login " + ret.toString();
                     return false;
                 }
@@ -191,7 +193,7 @@ namespace {
                 }
 
                 result.append("done", true);
-                cloner.setConnection( authConn_.release() );
+                cloner.setConnection( authConn.release() );
             }
             else if (!fromSelf) {
                 // If fromSelf leave the cloner's conn empty, it will use a DBDirectClient instead.
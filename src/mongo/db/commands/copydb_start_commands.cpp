@@ -40,6 +40,7 @@
 #include "mongo/db/cloner.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/copydb.h"
+#include "mongo/db/commands/copydb_start_commands.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/util/log.h"
 
@@ -48,9 +49,8 @@ namespace mongo {
     using std::string;
     using std::stringstream;
 
-    // SERVER-4328 todo review for concurrency
-    // :(
-    thread_specific_ptr<DBClientBase> authConn_;
+    const Client::Decoration<CopyDbAuthConnection> CopyDbAuthConnection::forClient =
+        Client::declareDecoration<CopyDbAuthConnection>();
 
     /* Usage:
      * admindb.$cmd.findOne( { copydbgetnonce: 1, fromhost: <connection string> } );
@@ -101,14 +101,16 @@ namespace mongo {
 
             const ConnectionString cs(uassertStatusOK(ConnectionString::parse(fromhost)));
 
-            authConn_.reset(cs.connect(errmsg));
-            if (!authConn_.get()) {
+            std::unique_ptr<DBClientBase>& authConn =
+                CopyDbAuthConnection::forClient(txn->getClient()).conn;
+            authConn.reset(cs.connect(errmsg));
+            if (!authConn) {
                 return false;
             }
 
             BSONObj ret;
 
-            if( !authConn_->runCommand( "admin", BSON( "getnonce" << 1 ), ret ) ) {
+            if( !authConn->runCommand( "admin", BSON( "getnonce" << 1 ), ret ) ) {
                 errmsg = "couldn't get nonce " + ret.toString();
                 return false;
             }
@@ -188,17 +190,19 @@ namespace mongo {
                 return false;
             }
 
-            authConn_.reset(cs.connect(errmsg));
-            if (!authConn_.get()) {
+            std::unique_ptr<DBClientBase>& authConn =
+                CopyDbAuthConnection::forClient(txn->getClient()).conn;
+            authConn.reset(cs.connect(errmsg));
+            if (!authConn) {
                 return false;
             }
 
             BSONObj ret;
-            if( !authConn_->runCommand( fromDb,
-                                        BSON( "saslStart" << 1 <<
-                                              mechanismElement <<
-                                              payloadElement),
-                                        ret ) ) {
+            if( !authConn->runCommand( fromDb,
+                                       BSON( "saslStart" << 1 <<
+                                             mechanismElement <<
+                                             payloadElement),
+                                       ret ) ) {
                 return appendCommandStatus(result,
                                            Command::getStatusFromCommandResult(ret));
 
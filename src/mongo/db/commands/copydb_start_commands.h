@@ -26,12 +26,25 @@
 *    it in the license file.
 */
 
-#include <boost/thread/tss.hpp>
+#pragma once
+
+#include <memory>
 
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/db/client.h"
 
 namespace mongo {
 
-    extern thread_specific_ptr<DBClientBase> authConn_;
+    /**
+     * The connection to the source host that copydbgetnonce or copydbsaslstart authenticates on,
+     * kept with the Client until the copydb command which follows takes it over. It lives on the
+     * Client rather than the thread because a transport may run the two commands of one
+     * connection on different threads.
+     */
+    struct CopyDbAuthConnection {
+        static const Client::Decoration<CopyDbAuthConnection> forClient;
+
+        std::unique_ptr<DBClientBase> conn;
+    };
 
 } // namespace mongo
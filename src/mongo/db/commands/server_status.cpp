@@ -276,6 +276,11 @@ namespace mongo {
 
                 BSONObjBuilder b;
                 networkCounter.append( b );
+                if ( transportCounters.isEnabled() ) {
+                    BSONObjBuilder transport( b.subobjStart( "transport" ) );
+                    transportCounters.append( transport );
+                    transport.done();
+                }
                 return b.obj();
             }
                 
@@ -113,6 +113,13 @@ namespace mongo {
     // TODO: Determine queueing behavior we want here
     MONGO_EXPORT_SERVER_PARAMETER( queueForMigrationCommit, bool, true );
 
+    // Maximum number of documents of an insert batch written in one unit of work. 1 disables
+    // grouping, so that every document gets its own unit of work.
+    MONGO_EXPORT_SERVER_PARAMETER( internalInsertMaxBatchSize, int, 64 );
+
+    // Inserts stop being grouped once the group reaches this size.
+    static const int kInsertGroupMaxBytes = 256 * 1024;
+
     using mongoutils::str::stream;
 
     WriteBatchExecutor::WriteBatchExecutor( OperationContext* txn,
@@ -632,6 +639,9 @@ namespace mongo {
                                    const BSONObj& indexDesc,
                                    WriteOpResult* result );
 
+    static bool groupInsert( WriteBatchExecutor::ExecInsertsState* state,
+                             const std::vector<BSONObj>& docsToInsert );
+
     static void multiUpdate( OperationContext* txn,
                              const BatchItemRef& updateItem,
                              WriteOpResult* result );
@@ -795,6 +805,41 @@ namespace mongo {
         }
     }
 
+    // Returns the document to insert for the request item at "index", which must have normalized
+    // successfully
+    static const BSONObj& getInsertDoc( const WriteBatchExecutor::ExecInsertsState& state,
+                                        size_t index ) {
+        const StatusWith<BSONObj>& normalizedInsert = state.normalizedInserts[index];
+        return normalizedInsert.getValue().isEmpty() ?
+            state.request->getInsertRequest()->getDocumentsAt( index ) :
+            normalizedInsert.getValue();
+    }
+
+    // Returns the end of the run of inserts starting at the current one, which can be written as a
+    // group. Index creations and documents which failed to normalize are never grouped.
+    static size_t getInsertGroupEnd( const WriteBatchExecutor::ExecInsertsState& state ) {
+        if ( state.request->isInsertIndexRequest() )
+            return state.currIndex + 1;
+
+        const size_t maxDocs = std::max( internalInsertMaxBatchSize, 1 );
+
+        size_t groupEnd = state.currIndex;
+        int groupBytes = 0;
+        while ( groupEnd < state.normalizedInserts.size() &&
+                groupEnd - state.currIndex < maxDocs ) {
+            if ( !state.normalizedInserts[groupEnd].isOK() )
+                break;
+
+            groupBytes += getInsertDoc( state, groupEnd ).objsize();
+            if ( groupEnd > state.currIndex && groupBytes > kInsertGroupMaxBytes )
+                break;
+
+            ++groupEnd;
+        }
+
+        return groupEnd;
+    }
+
     void WriteBatchExecutor::execInserts( const BatchedCommandRequest& request,
                                           std::vector<WriteErrorDetail*>* errors ) {
 
@@ -817,6 +862,11 @@ namespace mongo {
         // particularly on operation interruption.  These kinds of errors necessarily prevent
         // further insertOne calls, and stop the batch.  As a result, the only expected source of
         // such exceptions are interruptions.
+        //
+        // Runs of documents which normalized successfully are first tried as a group, through
+        // execInsertGroup(), which writes them in a single unit of work. If anything in the group
+        // fails, nothing of it is kept and its documents go through insertOne() one by one, so
+        // that every error is reported against the right document.
         ExecInsertsState state(_txn, &request);
         normalizeInserts(request, &state.normalizedInserts);
 
@@ -835,14 +885,13 @@ namespace mongo {
         ElapsedTracker elapsedTracker(internalQueryExecYieldIterations,
                                       internalQueryExecYieldPeriodMS);
 
+        // Inserts before this index are executed one at a time, because their group failed
+        size_t ungroupedEnd = 0;
+
         for (state.currIndex = 0;
              state.currIndex < state.request->sizeWriteOps();
              ++state.currIndex) {
 
-            if (state.currIndex + 1 == state.request->sizeWriteOps()) {
-                setupSynchronousCommit(_txn);
-            }
-
             if (elapsedTracker.intervalHasElapsed()) {
                 // Yield between inserts.
                 if (state.hasLock()) {
@@ -860,6 +909,26 @@ namespace mongo {
                 elapsedTracker.resetLastTime();
             }
 
+            if (state.currIndex >= ungroupedEnd) {
+                const size_t groupEnd = getInsertGroupEnd(state);
+                if (groupEnd - state.currIndex > 1) {
+                    if (groupEnd == state.request->sizeWriteOps()) {
+                        setupSynchronousCommit(_txn);
+                    }
+
+                    if (execInsertGroup(&state, groupEnd)) {
+                        state.currIndex = groupEnd - 1;
+                        continue;
+                    }
+
+                    ungroupedEnd = groupEnd;
+                }
+            }
+
+            if (state.currIndex + 1 == state.request->sizeWriteOps()) {
+                setupSynchronousCommit(_txn);
+            }
+
             WriteErrorDetail* error = NULL;
             execOneInsert(&state, &error);
             if (error) {
@@ -1058,9 +1127,7 @@ namespace mongo {
             return;
         }
 
-        const BSONObj& insertDoc = normalizedInsert.getValue().isEmpty() ?
-            state->request->getInsertRequest()->getDocumentsAt( state->currIndex ) :
-            normalizedInsert.getValue();
+        const BSONObj& insertDoc = getInsertDoc(*state, state->currIndex);
 
         int attempt = 0;
         while (true) {
@@ -1130,6 +1197,84 @@ namespace mongo {
         }
     }
 
+    bool WriteBatchExecutor::execInsertGroup(ExecInsertsState* state, size_t groupEnd) {
+        std::vector<BSONObj> docsToInsert;
+        docsToInsert.reserve(groupEnd - state->currIndex);
+        for (size_t i = state->currIndex; i < groupEnd; ++i) {
+            docsToInsert.push_back(getInsertDoc(*state, i));
+        }
+
+        // The group is reported as a single operation, described by its first document
+        CurOp currentOp(_txn);
+        currentOp.setOp(dbInsert);
+        beginCurrentOp(&currentOp, _txn->getClient(), BatchItemRef(state->request,
+                                                                    state->currIndex));
+
+        if (!groupInsert(state, docsToInsert)) {
+            return false;
+        }
+
+        WriteOpStats stats;
+        stats.n = 1;
+        for (size_t i = state->currIndex; i < groupEnd; ++i) {
+            BatchItemRef currInsertItem(state->request, i);
+            incOpStats(currInsertItem);
+            incWriteStats(currInsertItem, stats, NULL, &currentOp);
+        }
+
+        finishCurrentOp(_txn, &currentOp, NULL);
+        return true;
+    }
+
+    /**
+     * Perform a group of inserts into a collection in a single unit of work, retrying on write
+     * conflicts.  Requires the inserts be preprocessed.
+     *
+     * Returns false, with none of the documents inserted, if any of the inserts failed.
+     */
+    static bool groupInsert( WriteBatchExecutor::ExecInsertsState* state,
+                             const std::vector<BSONObj>& docsToInsert ) {
+        // we have to be top level so we can retry
+        invariant(!state->txn->lockState()->inAWriteUnitOfWork());
+
+        int attempt = 0;
+        while (true) {
+            try {
+                WriteOpResult result;
+                if (!state->lockAndCheck(&result)) {
+                    return false;
+                }
+
+                WriteUnitOfWork wunit(state->txn);
+                Status status = state->getCollection()->insertDocuments(state->txn,
+                                                                        docsToInsert,
+                                                                        true);
+                if (!status.isOK()) {
+                    return false;
+                }
+
+                wunit.commit();
+                return true;
+            }
+            catch ( const WriteConflictException& wce ) {
+                const std::string ns = state->getCollection() ?
+                    state->getCollection()->ns().ns() : state->request->getNS();
+                state->unlock();
+                CurOp::get(state->txn)->debug().writeConflicts++;
+                state->txn->recoveryUnit()->abandonSnapshot();
+                WriteConflictException::logAndBackoff( attempt++, "insert", ns );
+            }
+            catch (const StaleConfigException&) {
+                return false;
+            }
+            catch (const DBException& ex) {
+                if (ErrorCodes::isInterruption(ex.getCode()))
+                    throw;
+                return false;
+            }
+        }
+    }
+
     /**
      * Perform a single insert into a collection.  Requires the insert be preprocessed and the
      * collection already has been created.
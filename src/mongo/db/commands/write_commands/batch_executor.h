@@ -101,6 +101,13 @@ namespace mongo {
          */
         void execOneInsert( ExecInsertsState* state, WriteErrorDetail** error );
 
+        /**
+         * Executes the inserts from the current one up to, but not including, "groupEnd" in a
+         * single unit of work. Returns false without having inserted anything if any of them
+         * fails, in which case they need to be executed one at a time to report their errors.
+         */
+        bool execInsertGroup( ExecInsertsState* state, size_t groupEnd );
+
         /**
          * Executes an update item (which may update many documents or upsert), and returns the
          * upserted _id on upsert or error on failure.
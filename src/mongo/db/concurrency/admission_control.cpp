@@ -0,0 +1,304 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/concurrency/admission_control.h"
+
+#include <algorithm>
+#include <boost/static_assert.hpp>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    // Number of admitted operations running on the current thread. Only the outermost of them
+    // holds a slot.
+    TSP_DECLARE(int, admissionSlotsHeld)
+    TSP_DEFINE(int, admissionSlotsHeld)
+
+namespace {
+
+    // How long a queued operation sleeps between checks for interruption
+    const uint64_t InterruptCheckIntervalMicros = 100 * 1000;
+
+    const char* AdmissionClassNames[] = {
+        "userRead",
+        "userWrite",
+        "replication",
+        "internal",
+    };
+
+    // Ensure we do not add new classes without updating the names array
+    BOOST_STATIC_ASSERT((sizeof(AdmissionClassNames) / sizeof(AdmissionClassNames[0]))
+                                == AdmissionClassesCount);
+
+    AdmissionController globalAdmissionController;
+
+
+    class AdmissionControlServerParameter : public ServerParameter {
+        MONGO_DISALLOW_COPYING(AdmissionControlServerParameter);
+    public:
+        AdmissionControlServerParameter()
+            : ServerParameter(ServerParameterSet::getGlobal(),
+                              "admissionControlMaxConcurrentOperations",
+                              true,   // allowedToChangeAtStartup
+                              true) { // allowedToChangeAtRuntime
+        }
+
+        virtual void append(OperationContext* txn, BSONObjBuilder& b, const std::string& name) {
+            b.append(name, globalAdmissionController.getMaxConcurrentOperations());
+        }
+
+        virtual Status set(const BSONElement& newValueElement) {
+            if (!newValueElement.isNumber()) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << name() << " has to be a number");
+            }
+            return globalAdmissionController.setMaxConcurrentOperations(
+                                                        newValueElement.numberInt());
+        }
+
+        virtual Status setFromString(const std::string& str) {
+            int num = 0;
+            Status status = parseNumberFromString(str, &num);
+            if (!status.isOK()) {
+                return status;
+            }
+            return globalAdmissionController.setMaxConcurrentOperations(num);
+        }
+
+    } admissionControlServerParameter;
+
+} // namespace
+
+
+    const char* admissionClassName(AdmissionClass admissionClass) {
+        return AdmissionClassNames[admissionClass];
+    }
+
+    AdmissionController* getGlobalAdmissionController() {
+        return &globalAdmissionController;
+    }
+
+
+    AdmissionController::ClassStats::ClassStats()
+        : admitted(0),
+          queued(0),
+          queueTimeMicros(0) {
+
+    }
+
+    AdmissionController::AdmissionController()
+        : _maxConcurrent(0),
+          _active(0),
+          _preferUserWrites(true) {
+
+    }
+
+    void AdmissionController::admit(OperationContext* txn, AdmissionClass admissionClass) {
+        invariant(admissionClass < AdmissionClassesCount);
+
+        int* slotsHeld = admissionSlotsHeld.getMake();
+
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _stats[admissionClass].admitted++;
+
+        // A nested operation runs on the slot of the one it is nested in, since the thread can
+        // only run one of them at a time.
+        if (*slotsHeld > 0) {
+            (*slotsHeld)++;
+            _recordQueueTime_inlock(admissionClass, 0);
+            return;
+        }
+
+        if (_maxConcurrent == 0 ||
+            _active < _maxConcurrent ||
+            admissionClass == ADMISSION_REPLICATION) {
+
+            _active++;
+            (*slotsHeld)++;
+            _recordQueueTime_inlock(admissionClass, 0);
+            return;
+        }
+
+        Waiter waiter;
+        _queues[admissionClass].push_back(&waiter);
+        _stats[admissionClass].queued++;
+
+        const uint64_t startMicros = curTimeMicros64();
+        while (!waiter.admitted) {
+            uint64_t waitMicros = InterruptCheckIntervalMicros;
+            if (txn) {
+                // Checking for interrupt may take other locks, so don't hold ours while doing so
+                lk.unlock();
+                try {
+                    txn->checkForInterrupt();
+                }
+                catch (...) {
+                    lk.lock();
+                    _abandonWait_inlock(admissionClass, &waiter);
+                    throw;
+                }
+                lk.lock();
+
+                if (waiter.admitted) {
+                    break;
+                }
+
+                // Wake up in time for the operation's maxTimeMS. 0 means it has none.
+                const uint64_t remainingMicros = txn->getRemainingMaxTimeMicros();
+                if (remainingMicros > 0) {
+                    waitMicros = std::min(waitMicros, remainingMicros);
+                }
+            }
+
+            waiter.cond.wait_for(lk, Microseconds(waitMicros));
+        }
+
+        // The slot was accounted for by whoever admitted us
+        (*slotsHeld)++;
+        _recordQueueTime_inlock(admissionClass, curTimeMicros64() - startMicros);
+    }
+
+    void AdmissionController::release(AdmissionClass admissionClass) {
+        invariant(admissionClass < AdmissionClassesCount);
+
+        int* slotsHeld = admissionSlotsHeld.get();
+        if (slotsHeld && *slotsHeld > 0 && --(*slotsHeld) > 0) {
+            // A nested operation, which took no slot of its own
+            return;
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        invariant(_active > 0);
+        _active--;
+
+        _admitWaiters_inlock();
+    }
+
+    Status AdmissionController::setMaxConcurrentOperations(int newMax) {
+        if (newMax < 0) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "The maximum number of concurrent operations must be "
+                                        << "0 (unbounded) or positive; given " << newMax);
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _maxConcurrent = newMax;
+
+        _admitWaiters_inlock();
+        return Status::OK();
+    }
+
+    int AdmissionController::getMaxConcurrentOperations() const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _maxConcurrent;
+    }
+
+    void AdmissionController::report(BSONObjBuilder* builder) const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+        builder->append("maxConcurrentOperations", _maxConcurrent);
+        builder->append("active", _active);
+
+        for (int i = 0; i < AdmissionClassesCount; i++) {
+            const ClassStats& stats = _stats[i];
+
+            BSONObjBuilder classBuilder(builder->subobjStart(AdmissionClassNames[i]));
+            classBuilder.append("currentQueue", static_cast<int>(_queues[i].size()));
+            classBuilder.append("admitted", static_cast<long long>(stats.admitted));
+            classBuilder.append("queued", static_cast<long long>(stats.queued));
+            classBuilder.append("queueTimeMicros", static_cast<long long>(stats.queueTimeMicros));
+
+            BSONObjBuilder histogramBuilder(classBuilder.subobjStart("queueTimeHistogram"));
+            stats.queueTimeHistogram.append(&histogramBuilder);
+            histogramBuilder.done();
+
+            classBuilder.done();
+        }
+    }
+
+    void AdmissionController::_recordQueueTime_inlock(AdmissionClass admissionClass,
+                                                      uint64_t micros) {
+        ClassStats& stats = _stats[admissionClass];
+        stats.queueTimeMicros += micros;
+        stats.queueTimeHistogram.record(micros);
+    }
+
+    void AdmissionController::_abandonWait_inlock(AdmissionClass admissionClass,
+                                                  Waiter* waiter) {
+        if (waiter->admitted) {
+            invariant(_active > 0);
+            _active--;
+            _admitWaiters_inlock();
+            return;
+        }
+
+        std::deque<Waiter*>& queue = _queues[admissionClass];
+        queue.erase(std::find(queue.begin(), queue.end(), waiter));
+    }
+
+    void AdmissionController::_admitWaiters_inlock() {
+        while (_maxConcurrent == 0 || _active < _maxConcurrent) {
+            std::deque<Waiter*>* queue;
+
+            if (!_queues[ADMISSION_INTERNAL].empty()) {
+                queue = &_queues[ADMISSION_INTERNAL];
+            }
+            else if (!_queues[ADMISSION_USER_WRITE].empty() &&
+                     (_preferUserWrites || _queues[ADMISSION_USER_READ].empty())) {
+                queue = &_queues[ADMISSION_USER_WRITE];
+                _preferUserWrites = false;
+            }
+            else if (!_queues[ADMISSION_USER_READ].empty()) {
+                queue = &_queues[ADMISSION_USER_READ];
+                _preferUserWrites = true;
+            }
+            else {
+                // Replication is never queued, so there is nobody left to admit
+                dassert(_queues[ADMISSION_REPLICATION].empty());
+                break;
+            }
+
+            Waiter* waiter = queue->front();
+            queue->pop_front();
+
+            _active++;
+            waiter->admitted = true;
+            waiter->cond.notify_one();
+        }
+    }
+
+} // namespace mongo
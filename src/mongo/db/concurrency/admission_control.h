@@ -0,0 +1,175 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/db/stats/wait_time_histogram.h"
+#include "mongo/platform/cstdint.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+    class OperationContext;
+
+    /**
+     * Classes of operations, which the admission controller queues separately.
+     */
+    enum AdmissionClass {
+        ADMISSION_USER_READ,
+        ADMISSION_USER_WRITE,
+
+        /**
+         * Replication apply. These are never queued, but still occupy a slot while they run, so
+         * that user operations cannot starve a secondary's applier.
+         */
+        ADMISSION_REPLICATION,
+
+        /**
+         * Operations started by the server itself (TTL deletes, background jobs). Queued ahead of
+         * user operations.
+         */
+        ADMISSION_INTERNAL,
+
+        // Counts the classes. Always insert new classes above this entry.
+        AdmissionClassesCount
+    };
+
+    /**
+     * Returns a human-readable name for the specified admission class.
+     */
+    const char* admissionClassName(AdmissionClass admissionClass);
+
+
+    /**
+     * Bounds the number of operations which may hold the global lock at the same time. Operations
+     * beyond the bound wait in a FIFO queue per admission class. Whenever a slot frees up it goes
+     * to the internal queue first, and otherwise alternates between the user write and user read
+     * queues, so neither can starve the other.
+     *
+     * Unlike the lock manager, which only queues conflicting requests, this queues compatible
+     * ones too, so that past the point where the storage engine stops scaling, extra load shows
+     * up as queueing latency rather than as lost throughput.
+     *
+     * A bound of 0 (the default) disables queueing; time spent queued and the counts of admitted
+     * operations are still tracked.
+     */
+    class AdmissionController {
+        MONGO_DISALLOW_COPYING(AdmissionController);
+    public:
+        AdmissionController();
+
+        /**
+         * Blocks until an operation of the specified class may proceed. Every call must be
+         * matched by a call to release with the same class, on the same thread.
+         *
+         * While queued, the wait is interrupted when "txn" is killed or runs past its maxTimeMS,
+         * in which case the operation leaves the queue and the exception from
+         * txn->checkForInterrupt() propagates. "txn" may be NULL, in which case the wait cannot
+         * be interrupted.
+         *
+         * An operation started by a thread which is already admitted, such as a DBDirectClient
+         * call or an internal command run by another operation, is admitted right away, so that it
+         * cannot wait for itself. It takes no slot of its own and is not counted as active: the
+         * thread runs one operation at a time, so the bound on the number of threads running
+         * admitted operations still holds.
+         */
+        void admit(OperationContext* txn, AdmissionClass admissionClass);
+
+        /**
+         * Gives back the slot of an operation previously admitted with the specified class.
+         */
+        void release(AdmissionClass admissionClass);
+
+        /**
+         * Changes the maximum number of concurrently admitted operations. Lowering the bound does
+         * not wait for the operations already admitted. 0 disables queueing.
+         */
+        Status setMaxConcurrentOperations(int newMax);
+        int getMaxConcurrentOperations() const;
+
+        /**
+         * Appends the current and cumulative queueing statistics for each class.
+         */
+        void report(BSONObjBuilder* builder) const;
+
+    private:
+
+        struct Waiter {
+            Waiter() : admitted(false) { }
+
+            stdx::condition_variable cond;
+            bool admitted;
+        };
+
+        struct ClassStats {
+            ClassStats();
+
+            int64_t admitted;
+            int64_t queued;
+            int64_t queueTimeMicros;
+            WaitTimeHistogram queueTimeHistogram;
+        };
+
+        void _recordQueueTime_inlock(AdmissionClass admissionClass, uint64_t micros);
+
+        /**
+         * Takes an interrupted waiter out of its queue, or gives back its slot if it was admitted
+         * in the meantime.
+         */
+        void _abandonWait_inlock(AdmissionClass admissionClass, Waiter* waiter);
+
+        /**
+         * Hands out free slots to waiting operations, in priority order.
+         */
+        void _admitWaiters_inlock();
+
+        mutable stdx::mutex _mutex;
+
+        int _maxConcurrent;
+        int _active;
+
+        // Which of the user queues gets the next slot, when both have waiters
+        bool _preferUserWrites;
+
+        std::deque<Waiter*> _queues[AdmissionClassesCount];
+        ClassStats _stats[AdmissionClassesCount];
+    };
+
+
+    /**
+     * Retrieves the admission controller consulted by all lockers.
+     */
+    AdmissionController* getGlobalAdmissionController();
+
+} // namespace mongo
@@ -0,0 +1,332 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/db/concurrency/admission_control.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+    BSONObj reportFor(const AdmissionController& controller, AdmissionClass admissionClass) {
+        BSONObjBuilder builder;
+        controller.report(&builder);
+        return builder.obj()[admissionClassName(admissionClass)].Obj().getOwned();
+    }
+
+    void waitForQueueLength(const AdmissionController& controller,
+                            AdmissionClass admissionClass,
+                            int length) {
+        while (reportFor(controller, admissionClass)["currentQueue"].numberInt() != length) {
+            sleepmillis(1);
+        }
+    }
+
+    /**
+     * Admits an operation of the specified class on a separate thread, records the class once
+     * admitted and then releases the slot.
+     */
+    class Admitter {
+    public:
+        Admitter(AdmissionController* controller,
+                 AdmissionClass admissionClass,
+                 stdx::mutex* mutex,
+                 std::vector<AdmissionClass>* admittedOrder)
+            : _thread(stdx::bind(&Admitter::run,
+                                 controller,
+                                 admissionClass,
+                                 mutex,
+                                 admittedOrder)) {
+
+        }
+
+        void join() { _thread.join(); }
+
+    private:
+        static void run(AdmissionController* controller,
+                        AdmissionClass admissionClass,
+                        stdx::mutex* mutex,
+                        std::vector<AdmissionClass>* admittedOrder) {
+            controller->admit(NULL, admissionClass);
+            {
+                stdx::lock_guard<stdx::mutex> lk(*mutex);
+                admittedOrder->push_back(admissionClass);
+            }
+            controller->release(admissionClass);
+        }
+
+        stdx::thread _thread;
+    };
+
+
+    /**
+     * Operation which is interrupted once it has been killed.
+     */
+    class KillableOperationContext : public OperationContextNoop {
+    public:
+        virtual void checkForInterrupt() override {
+            uassert(ErrorCodes::Interrupted, "operation was interrupted", !_killed.load());
+        }
+
+        void kill() { _killed.store(1); }
+
+    private:
+        AtomicUInt32 _killed;
+    };
+
+    void admitUntilInterrupted(AdmissionController* controller,
+                               OperationContext* txn,
+                               Status* status) {
+        try {
+            controller->admit(txn, ADMISSION_USER_READ);
+            controller->release(ADMISSION_USER_READ);
+        }
+        catch (const DBException& e) {
+            *status = e.toStatus();
+        }
+    }
+
+
+    TEST(AdmissionControl, UnboundedNeverQueues) {
+        AdmissionController controller;
+
+        for (int i = 0; i < 100; i++) {
+            controller.admit(NULL, ADMISSION_USER_READ);
+        }
+        for (int i = 0; i < 100; i++) {
+            controller.release(ADMISSION_USER_READ);
+        }
+
+        BSONObj stats = reportFor(controller, ADMISSION_USER_READ);
+        ASSERT_EQUALS(100, stats["admitted"].numberLong());
+        ASSERT_EQUALS(0, stats["queued"].numberLong());
+        ASSERT_EQUALS(100, stats["queueTimeHistogram"]["lt100us"].numberLong());
+    }
+
+    TEST(AdmissionControl, InvalidBound) {
+        AdmissionController controller;
+        ASSERT_NOT_OK(controller.setMaxConcurrentOperations(-1));
+        ASSERT_OK(controller.setMaxConcurrentOperations(0));
+        ASSERT_OK(controller.setMaxConcurrentOperations(10));
+        ASSERT_EQUALS(10, controller.getMaxConcurrentOperations());
+    }
+
+    TEST(AdmissionControl, QueuesPastBound) {
+        AdmissionController controller;
+        ASSERT_OK(controller.setMaxConcurrentOperations(1));
+
+        stdx::mutex mutex;
+        std::vector<AdmissionClass> admittedOrder;
+
+        controller.admit(NULL, ADMISSION_USER_READ);
+
+        Admitter writer(&controller, ADMISSION_USER_WRITE, &mutex, &admittedOrder);
+        waitForQueueLength(controller, ADMISSION_USER_WRITE, 1);
+
+        {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            ASSERT(admittedOrder.empty());
+        }
+
+        controller.release(ADMISSION_USER_READ);
+        writer.join();
+
+        ASSERT_EQUALS(1U, admittedOrder.size());
+        ASSERT_EQUALS(1, reportFor(controller, ADMISSION_USER_WRITE)["queued"].numberLong());
+        ASSERT_EQUALS(0, reportFor(controller, ADMISSION_USER_WRITE)["currentQueue"].numberInt());
+    }
+
+    TEST(AdmissionControl, RaisingBoundAdmitsWaiters) {
+        AdmissionController controller;
+        ASSERT_OK(controller.setMaxConcurrentOperations(1));
+
+        stdx::mutex mutex;
+        std::vector<AdmissionClass> admittedOrder;
+
+        controller.admit(NULL, ADMISSION_USER_WRITE);
+
+        Admitter reader(&controller, ADMISSION_USER_READ, &mutex, &admittedOrder);
+        waitForQueueLength(controller, ADMISSION_USER_READ, 1);
+
+        ASSERT_OK(controller.setMaxConcurrentOperations(0));
+        reader.join();
+
+        ASSERT_EQUALS(1U, admittedOrder.size());
+        controller.release(ADMISSION_USER_WRITE);
+    }
+
+    TEST(AdmissionControl, InternalAdmittedBeforeUser) {
+        AdmissionController controller;
+        ASSERT_OK(controller.setMaxConcurrentOperations(1));
+
+        stdx::mutex mutex;
+        std::vector<AdmissionClass> admittedOrder;
+
+        controller.admit(NULL, ADMISSION_USER_READ);
+
+        Admitter reader(&controller, ADMISSION_USER_READ, &mutex, &admittedOrder);
+        waitForQueueLength(controller, ADMISSION_USER_READ, 1);
+
+        Admitter internal(&controller, ADMISSION_INTERNAL, &mutex, &admittedOrder);
+        waitForQueueLength(controller, ADMISSION_INTERNAL, 1);
+
+        controller.release(ADMISSION_USER_READ);
+        internal.join();
+        reader.join();
+
+        ASSERT_EQUALS(2U, admittedOrder.size());
+        ASSERT_EQUALS(ADMISSION_INTERNAL, admittedOrder[0]);
+        ASSERT_EQUALS(ADMISSION_USER_READ, admittedOrder[1]);
+    }
+
+    TEST(AdmissionControl, UserReadsAndWritesAlternate) {
+        AdmissionController controller;
+        ASSERT_OK(controller.setMaxConcurrentOperations(1));
+
+        stdx::mutex mutex;
+        std::vector<AdmissionClass> admittedOrder;
+
+        controller.admit(NULL, ADMISSION_USER_READ);
+
+        Admitter reader1(&controller, ADMISSION_USER_READ, &mutex, &admittedOrder);
+        waitForQueueLength(controller, ADMISSION_USER_READ, 1);
+        Admitter reader2(&controller, ADMISSION_USER_READ, &mutex, &admittedOrder);
+        waitForQueueLength(controller, ADMISSION_USER_READ, 2);
+        Admitter writer1(&controller, ADMISSION_USER_WRITE, &mutex, &admittedOrder);
+        waitForQueueLength(controller, ADMISSION_USER_WRITE, 1);
+        Admitter writer2(&controller, ADMISSION_USER_WRITE, &mutex, &admittedOrder);
+        waitForQueueLength(controller, ADMISSION_USER_WRITE, 2);
+
+        controller.release(ADMISSION_USER_READ);
+        reader1.join();
+        reader2.join();
+        writer1.join();
+        writer2.join();
+
+        ASSERT_EQUALS(4U, admittedOrder.size());
+        for (size_t i = 1; i < admittedOrder.size(); i++) {
+            ASSERT_NOT_EQUALS(admittedOrder[i - 1], admittedOrder[i]);
+        }
+    }
+
+    TEST(AdmissionControl, ReplicationNeverQueued) {
+        AdmissionController controller;
+        ASSERT_OK(controller.setMaxConcurrentOperations(1));
+
+        stdx::mutex mutex;
+        std::vector<AdmissionClass> admittedOrder;
+
+        controller.admit(NULL, ADMISSION_USER_WRITE);
+
+        // Would block forever if replication were queued behind the user write
+        Admitter replication(&controller, ADMISSION_REPLICATION, &mutex, &admittedOrder);
+        replication.join();
+
+        ASSERT_EQUALS(1U, admittedOrder.size());
+        controller.release(ADMISSION_USER_WRITE);
+    }
+
+    TEST(AdmissionControl, NestedAdmissionNeverQueued) {
+        AdmissionController controller;
+        ASSERT_OK(controller.setMaxConcurrentOperations(1));
+
+        controller.admit(NULL, ADMISSION_USER_WRITE);
+
+        // Would block forever if the thread waited for the slot it already holds
+        controller.admit(NULL, ADMISSION_USER_READ);
+
+        // The nested operation runs on the slot of the outer one
+        BSONObjBuilder builder;
+        controller.report(&builder);
+        ASSERT_EQUALS(1, builder.obj()["active"].numberInt());
+
+        controller.release(ADMISSION_USER_READ);
+        controller.release(ADMISSION_USER_WRITE);
+    }
+
+    TEST(AdmissionControl, NestedAdmissionKeepsTheBound) {
+        AdmissionController controller;
+        ASSERT_OK(controller.setMaxConcurrentOperations(1));
+
+        controller.admit(NULL, ADMISSION_USER_WRITE);
+
+        stdx::mutex mutex;
+        std::vector<AdmissionClass> admittedOrder;
+        Admitter other(&controller, ADMISSION_USER_READ, &mutex, &admittedOrder);
+        waitForQueueLength(controller, ADMISSION_USER_READ, 1);
+
+        // Releasing the nested operation doesn't let the other thread in
+        controller.admit(NULL, ADMISSION_USER_WRITE);
+        controller.release(ADMISSION_USER_WRITE);
+        ASSERT_EQUALS(1, reportFor(controller, ADMISSION_USER_READ)["currentQueue"].numberInt());
+        {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            ASSERT_TRUE(admittedOrder.empty());
+        }
+
+        controller.release(ADMISSION_USER_WRITE);
+        other.join();
+        ASSERT_EQUALS(1U, admittedOrder.size());
+    }
+
+    TEST(AdmissionControl, InterruptedWaitLeavesQueue) {
+        AdmissionController controller;
+        ASSERT_OK(controller.setMaxConcurrentOperations(1));
+
+        controller.admit(NULL, ADMISSION_USER_WRITE);
+
+        KillableOperationContext txn;
+        Status status = Status::OK();
+        stdx::thread waiter(stdx::bind(&admitUntilInterrupted, &controller, &txn, &status));
+        waitForQueueLength(controller, ADMISSION_USER_READ, 1);
+
+        txn.kill();
+        waiter.join();
+
+        ASSERT_EQUALS(ErrorCodes::Interrupted, status.code());
+        ASSERT_EQUALS(0, reportFor(controller, ADMISSION_USER_READ)["currentQueue"].numberInt());
+
+        controller.release(ADMISSION_USER_WRITE);
+
+        BSONObjBuilder builder;
+        controller.report(&builder);
+        ASSERT_EQUALS(0, builder.obj()["active"].numberInt());
+    }
+
+} // namespace
+} // namespace mongo
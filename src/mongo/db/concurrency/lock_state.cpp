@@ -34,8 +34,10 @@
 
 #include <vector>
 
+#include "mongo/db/client.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/operation_context.h"
 #include "mongo/platform/compiler.h"
 #include "mongo/util/background.h"
 #include "mongo/util/concurrency/synchronization.h"
@@ -256,7 +258,9 @@ namespace {
         : _id(idCounter.addAndFetch(1)),
           _requestStartTime(0),
           _wuowNestingLevel(0),
-          _batchWriter(false) {
+          _batchWriter(false),
+          _admissionClass(AdmissionClassesCount),
+          _admittedAs(AdmissionClassesCount) {
     }
 
     template<bool IsForMMAPV1>
@@ -283,6 +287,10 @@ namespace {
 
     template<bool IsForMMAPV1>
     LockResult LockerImpl<IsForMMAPV1>::lockGlobalBegin(LockMode mode) {
+        if (!_requests.find(resourceIdGlobal)) {
+            _admit(mode);
+        }
+
         const LockResult result = lockBegin(resourceIdGlobal, mode);
         if (result == LOCK_OK) return LOCK_OK;
 
@@ -725,8 +733,14 @@ namespace {
         if (result != LOCK_OK) {
             LockRequestsMap::Iterator it = _requests.find(resId);
             if (globalLockManager.unlock(it.objAddr())) {
-                scoped_spinlock scopedLock(_lock);
-                it.remove();
+                {
+                    scoped_spinlock scopedLock(_lock);
+                    it.remove();
+                }
+
+                if (resId == resourceIdGlobal) {
+                    _releaseAdmission();
+                }
             }
         }
 
@@ -747,8 +761,15 @@ namespace {
         }
 
         if (globalLockManager.unlock(it.objAddr())) {
-            scoped_spinlock scopedLock(_lock);
-            it.remove();
+            const ResourceId resId = it.key();
+            {
+                scoped_spinlock scopedLock(_lock);
+                it.remove();
+            }
+
+            if (resId == resourceIdGlobal) {
+                _releaseAdmission();
+            }
 
             return true;
         }
@@ -756,6 +777,48 @@ namespace {
         return false;
     }
 
+    template<bool IsForMMAPV1>
+    void LockerImpl<IsForMMAPV1>::_admit(LockMode globalMode) {
+        invariant(_admittedAs == AdmissionClassesCount);
+
+        // Operations taking the global lock in S or X mode wait for everybody else through the
+        // lock manager anyways and must not be stuck behind a queue of the operations they are
+        // going to block, so they are not admission controlled.
+        if (globalMode == MODE_S || globalMode == MODE_X) {
+            return;
+        }
+
+        AdmissionClass admissionClass;
+        if (_batchWriter) {
+            admissionClass = ADMISSION_REPLICATION;
+        }
+        else if (_admissionClass != AdmissionClassesCount) {
+            admissionClass = _admissionClass;
+        }
+        else {
+            admissionClass = (globalMode == MODE_IX) ? ADMISSION_USER_WRITE : ADMISSION_USER_READ;
+        }
+
+        // The wait for admission can be interrupted through the operation using this locker
+        OperationContext* txn = haveClient() ? cc().getOperationContext() : NULL;
+        if (txn && txn->lockState() != this) {
+            txn = NULL;
+        }
+
+        getGlobalAdmissionController()->admit(txn, admissionClass);
+        _admittedAs = admissionClass;
+    }
+
+    template<bool IsForMMAPV1>
+    void LockerImpl<IsForMMAPV1>::_releaseAdmission() {
+        if (_admittedAs == AdmissionClassesCount) {
+            return;
+        }
+
+        getGlobalAdmissionController()->release(_admittedAs);
+        _admittedAs = AdmissionClassesCount;
+    }
+
     template<bool IsForMMAPV1>
     LockMode LockerImpl<IsForMMAPV1>::_getModeForMMAPV1FlushLock() const {
         invariant(IsForMMAPV1);
@@ -241,10 +241,29 @@ namespace mongo {
         virtual void setIsBatchWriter(bool newValue) { _batchWriter = newValue; }
         virtual bool isBatchWriter() const { return _batchWriter; }
 
+        virtual void setAdmissionClass(AdmissionClass admissionClass) {
+            _admissionClass = admissionClass;
+        }
+
         virtual bool hasStrongLocks() const;
 
     private:
         bool _batchWriter;
+
+        /**
+         * Admission to the global lock. The locker is admitted before it first requests the global
+         * lock and gives the slot back when it no longer holds the global lock at all, so a yield
+         * gives up the slot as well.
+         */
+        void _admit(LockMode globalMode);
+        void _releaseAdmission();
+
+        // Class set through setAdmissionClass. AdmissionClassesCount means it was never set.
+        AdmissionClass _admissionClass;
+
+        // Class under which the current global lock request was admitted, or
+        // AdmissionClassesCount if it was not admitted.
+        AdmissionClass _admittedAs;
     };
 
     typedef LockerImpl<false> DefaultLockerImpl;
@@ -31,6 +31,7 @@
 #include <climits> // For UINT_MAX
 #include <vector>
 
+#include "mongo/db/concurrency/admission_control.h"
 #include "mongo/db/concurrency/lock_manager.h"
 #include "mongo/db/concurrency/lock_stats.h"
 
@@ -283,6 +284,14 @@ namespace mongo {
         virtual void setIsBatchWriter(bool newValue) = 0;
         virtual bool isBatchWriter() const = 0;
 
+        /**
+         * Sets the class under which the admission controller queues this locker's operations
+         * when they acquire the global lock. By default, batch writers are admitted as
+         * replication and everything else as user reads or user writes, depending on the mode of
+         * the global lock.
+         */
+        virtual void setAdmissionClass(AdmissionClass admissionClass) = 0;
+
         /**
          * A string lock is MODE_X or MODE_S.
          * These are incompatible with other locks and therefore are strong.
@@ -166,6 +166,8 @@ namespace mongo {
             invariant(false);
         }
 
+        virtual void setAdmissionClass(AdmissionClass admissionClass) { }
+
         virtual bool hasStrongLocks() const {
             return false;
         }
@@ -42,6 +42,7 @@
 #include <signal.h>
 #include <string>
 
+#include "mongo/base/checked_cast.h"
 #include "mongo/base/init.h"
 #include "mongo/base/initializer.h"
 #include "mongo/base/status.h"
@@ -94,6 +95,7 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/db/ttl.h"
 #include "mongo/platform/process_id.h"
+#include "mongo/s/d_state.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/assert_util.h"
@@ -156,6 +158,22 @@ namespace mongo {
             Client::initThread("conn", p);
         }
 
+        virtual bool supportsDetachedSessions() const { return true; }
+
+        virtual std::unique_ptr<SessionState> detachSession( AbstractMessagingPort* p ) {
+            std::unique_ptr<ConnectionState> state(new ConnectionState());
+            state->client = Client::releaseCurrent();
+            state->shardedConnectionInfo = ShardedConnectionInfo::release();
+            return std::move(state);
+        }
+
+        virtual void attachSession( AbstractMessagingPort* p,
+                                    std::unique_ptr<SessionState> state ) {
+            ConnectionState* connState = checked_cast<ConnectionState*>(state.get());
+            Client::setCurrent(std::move(connState->client));
+            ShardedConnectionInfo::set(std::move(connState->shardedConnectionInfo));
+        }
+
         virtual void process(Message& m , AbstractMessagingPort* port) {
             while ( true ) {
                 if ( inShutdown() ) {
@@ -200,6 +218,14 @@ namespace mongo {
                 break;
             }
         }
+
+    private:
+        // The thread local state of a connection, for the asio transport.
+        class ConnectionState : public SessionState {
+        public:
+            ServiceContext::UniqueClient client;
+            std::unique_ptr<ShardedConnectionInfo> shardedConnectionInfo;
+        };
     };
 
     static void logStartup() {
@@ -406,6 +432,9 @@ namespace mongo {
         MessageServer::Options options;
         options.port = listenPort;
         options.ipList = serverGlobalParams.bind_ip;
+        options.transportMode = mongodGlobalParams.transportMode;
+        options.ioThreads = mongodGlobalParams.asioIoThreads;
+        options.workerThreads = mongodGlobalParams.asioWorkerThreads;
 
         MessageServer* server = createServer(options, new MyMessageHandler());
         server->setAsTimeTracker();
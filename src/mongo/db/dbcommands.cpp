@@ -83,6 +83,7 @@
 #include "mongo/db/ops/insert.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/repair_database.h"
 #include "mongo/db/repl/optime.h"
@@ -913,6 +914,10 @@ namespace mongo {
             result.appendNumber("totalIndexSize", indexSize / scale);
             result.append("indexSizes", indexSizes.obj());
 
+            BSONObjBuilder planCacheStats(result.subobjStart("planCache"));
+            collection->infoCache()->getPlanCache()->appendStats(&planCacheStats);
+            planCacheStats.doneFast();
+
             return true;
         }
 
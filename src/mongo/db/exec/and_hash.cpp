@@ -297,6 +297,7 @@ namespace mongo {
             }
 
             // Update memory stats.
+            member->copyOutOfArena();
             _memUsage += member->getMemUsage();
 
             ++_commonStats.needTime;
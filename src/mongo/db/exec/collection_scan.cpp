@@ -65,6 +65,10 @@ namespace mongo {
         // Explain reports the direction of the collection scan.
         _specificStats.direction = params.direction;
 
+        if (NULL != _filter && internalQueryExecCompileFilters) {
+            _compiledFilter = CompiledMatchExpression::compile(_filter);
+        }
+
         // We pre-allocate a WSM and use it to pass up fetch requests. This should never be used
         // for anything other than passing up NEED_YIELD. We use the loc and owned obj state, but
         // the loc isn't really pointing at any obj. The obj field of the WSM should never be used.
@@ -78,6 +82,27 @@ namespace mongo {
         // Adds the amount of time taken by work() to executionTimeMillis.
         ScopedTimer timer(&_commonStats.executionTimeMillis);
 
+        if (_deferredState.isSet()) {
+            return _deferredState.take(out);
+        }
+
+        return doWork(out);
+    }
+
+    PlanStage::StageState CollectionScan::workBatch(size_t maxWorks,
+                                                    vector<WorkingSetID>* results,
+                                                    WorkingSetID* out) {
+        // Adds the amount of time taken by the whole batch to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        return workBatchWith([this](WorkingSetID* id) {
+                                 ++_commonStats.works;
+                                 return doWork(id);
+                             },
+                             &_deferredState, maxWorks, results, out);
+    }
+
+    PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
         if (_isDead) { return PlanStage::DEAD; }
 
         // Do some init if we haven't already.
@@ -182,7 +207,7 @@ namespace mongo {
                                                           WorkingSetID* out) {
         ++_specificStats.docsTested;
 
-        if (Filter::passes(member, _filter)) {
+        if (Filter::passes(member, _filter, _compiledFilter.get())) {
             *out = memberID;
             ++_commonStats.advanced;
             return PlanStage::ADVANCED;
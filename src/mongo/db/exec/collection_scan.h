@@ -29,10 +29,12 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <memory>
 
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
 #include "mongo/db/record_id.h"
 
 namespace mongo {
@@ -55,6 +57,9 @@ namespace mongo {
                        const MatchExpression* filter);
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* results,
+                                     WorkingSetID* out);
         virtual bool isEOF();
 
         virtual void invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type);
@@ -74,6 +79,11 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        /**
+         * Performs one unit of work for work() or workBatch(), which account for its stats.
+         */
+        StageState doWork(WorkingSetID* out);
+
         /**
          * If the member (with id memberID) passes our filter, set *out to memberID and return that
          * ADVANCED.  Otherwise, free memberID and return NEED_TIME.
@@ -91,6 +101,9 @@ namespace mongo {
         // The filter is not owned by us.
         const MatchExpression* _filter;
 
+        // _filter compiled for matching documents, if there was anything to compile.
+        std::unique_ptr<CompiledMatchExpression> _compiledFilter;
+
         boost::scoped_ptr<RecordIterator> _iter;
 
         CollectionScanParams _params;
@@ -103,6 +116,9 @@ namespace mongo {
         // used for all fetch requests, changing the RecordId as appropriate.
         const WorkingSetID _wsidForFetch;
 
+        // Set when a batch ended with results and a state still to be returned.
+        DeferredState _deferredState;
+
         // Stats
         CommonStats _commonStats;
         CollectionScanStats _specificStats;
@@ -100,7 +100,7 @@ namespace mongo {
             // Return this key. Adjust the _seekPoint so that it is exclusive on the field we
             // are using.
             
-            if (!kv->key.isOwned()) kv->key = kv->key.getOwned();
+            kv->key = _workingSet->getOwned(kv->key);
             _seekPoint.keyPrefix = kv->key;
             _seekPoint.prefixLen = _params.fieldNo + 1;
             _seekPoint.prefixExclusive = true;
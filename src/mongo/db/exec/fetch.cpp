@@ -58,7 +58,12 @@ namespace mongo {
           _child(child),
           _filter(filter),
           _idRetrying(WorkingSet::INVALID_ID),
-          _commonStats(kStageType) { }
+          _commonStats(kStageType) {
+
+        if (NULL != _filter && internalQueryExecCompileFilters) {
+            _compiledFilter = CompiledMatchExpression::compile(_filter);
+        }
+    }
 
     FetchStage::~FetchStage() { }
 
@@ -69,6 +74,11 @@ namespace mongo {
             return false;
         }
 
+        if (_nextChildResult < _childResults.size()) {
+            // Our child produced results in a batch which we haven't fetched yet.
+            return false;
+        }
+
         return _child->isEOF();
     }
 
@@ -78,66 +88,139 @@ namespace mongo {
         // Adds the amount of time taken by work() to executionTimeMillis.
         ScopedTimer timer(&_commonStats.executionTimeMillis);
 
+        if (_deferredState.isSet()) { return _deferredState.take(out); }
+
         if (isEOF()) { return PlanStage::IS_EOF; }
 
-        // Either retry the last WSM we worked on or get a new one from our child.
+        // Either retry the last WSM we worked on, take the next result of our child's last batch,
+        // or get a new one from our child.
         WorkingSetID id;
         StageState status;
-        if (_idRetrying == WorkingSet::INVALID_ID) {
-            status = _child->work(&id);
-        }
-        else {
+        if (_idRetrying != WorkingSet::INVALID_ID) {
             status = ADVANCED;
             id = _idRetrying;
             _idRetrying = WorkingSet::INVALID_ID;
         }
+        else if (_nextChildResult < _childResults.size()) {
+            status = ADVANCED;
+            id = _childResults[_nextChildResult++];
+        }
+        else {
+            status = _child->work(&id);
+        }
 
         if (PlanStage::ADVANCED == status) {
-            WorkingSetMember* member = _ws->get(id);
+            return fetchAndFilter(id, out);
+        }
+
+        return handleChildState(status, id, out);
+    }
+
+    PlanStage::StageState FetchStage::workBatch(size_t maxWorks,
+                                                vector<WorkingSetID>* results,
+                                                WorkingSetID* out) {
+        ++_commonStats.works;
+
+        // Adds the amount of time taken by the whole batch to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        if (_deferredState.isSet()) { return _deferredState.take(out); }
+
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        // Only ask our child for more once everything it gave us last time has been fetched.
+        if (_idRetrying == WorkingSet::INVALID_ID && _nextChildResult == _childResults.size()) {
+            _childResults.clear();
+            _nextChildResult = 0;
 
-            // If there's an obj there, there is no fetching to perform.
-            if (member->hasObj()) {
-                ++_specificStats.alreadyHasObj;
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            StageState status = _child->workBatch(maxWorks, &_childResults, &id);
+            if (PlanStage::ADVANCED != status) {
+                return handleChildState(status, id, out);
+            }
+        }
+
+        const size_t numResultsBefore = results->size();
+        while ((_idRetrying != WorkingSet::INVALID_ID || _nextChildResult < _childResults.size())
+               && results->size() - numResultsBefore < maxWorks) {
+            WorkingSetID id;
+            if (_idRetrying != WorkingSet::INVALID_ID) {
+                id = _idRetrying;
+                _idRetrying = WorkingSet::INVALID_ID;
             }
             else {
-                // We need a valid loc to fetch from and this is the only state that has one.
-                verify(WorkingSetMember::LOC_AND_IDX == member->state);
-                verify(member->hasLoc());
-
-                // We might need to retrieve 'nextLoc' from secondary storage, in which case we send
-                // a NEED_YIELD request up to the PlanExecutor.
-                std::auto_ptr<RecordFetcher> fetcher(_collection->documentNeedsFetch(_txn,
-                                                                                     member->loc));
-                if (NULL != fetcher.get()) {
-                    // There's something to fetch. Hand the fetcher off to the WSM, and pass up
-                    // a fetch request.
-                    _idRetrying = id;
-                    member->setFetcher(fetcher.release());
-                    *out = id;
-                    _commonStats.needYield++;
-                    return NEED_YIELD;
-                }
+                id = _childResults[_nextChildResult++];
+            }
 
-                // The doc is already in memory, so go ahead and grab it. Now we have a RecordId
-                // as well as an unowned object
-                try {
-                    if (!WorkingSetCommon::fetch(_txn, member, _collection)) {
-                        _ws->free(id);
-                        _commonStats.needTime++;
-                        return NEED_TIME;
-                    }
-                }
-                catch (const WriteConflictException& wce) {
-                    _idRetrying = id;
-                    *out = WorkingSet::INVALID_ID;
-                    _commonStats.needYield++;
-                    return NEED_YIELD;
+            WorkingSetID memberOut = WorkingSet::INVALID_ID;
+            StageState status = fetchAndFilter(id, &memberOut);
+            if (PlanStage::ADVANCED == status) {
+                results->push_back(memberOut);
+            }
+            else if (PlanStage::NEED_YIELD == status) {
+                // Hand back what we have so far; the yield is requested by our next call.
+                if (results->size() == numResultsBefore) {
+                    *out = memberOut;
+                    return status;
                 }
+                _deferredState.set(status, memberOut);
+                break;
+            }
+        }
+
+        return results->size() == numResultsBefore ? PlanStage::NEED_TIME : PlanStage::ADVANCED;
+    }
+
+    PlanStage::StageState FetchStage::fetchAndFilter(WorkingSetID id, WorkingSetID* out) {
+        WorkingSetMember* member = _ws->get(id);
+
+        // If there's an obj there, there is no fetching to perform.
+        if (member->hasObj()) {
+            ++_specificStats.alreadyHasObj;
+        }
+        else {
+            // We need a valid loc to fetch from and this is the only state that has one.
+            verify(WorkingSetMember::LOC_AND_IDX == member->state);
+            verify(member->hasLoc());
+
+            // We might need to retrieve 'nextLoc' from secondary storage, in which case we send
+            // a NEED_YIELD request up to the PlanExecutor.
+            std::auto_ptr<RecordFetcher> fetcher(_collection->documentNeedsFetch(_txn,
+                                                                                 member->loc));
+            if (NULL != fetcher.get()) {
+                // There's something to fetch. Hand the fetcher off to the WSM, and pass up
+                // a fetch request.
+                _idRetrying = id;
+                member->setFetcher(fetcher.release());
+                *out = id;
+                _commonStats.needYield++;
+                return NEED_YIELD;
             }
 
-            return returnIfMatches(member, id, out);
+            // The doc is already in memory, so go ahead and grab it. Now we have a RecordId
+            // as well as an unowned object
+            try {
+                if (!WorkingSetCommon::fetch(_txn, member, _collection)) {
+                    _ws->free(id);
+                    _commonStats.needTime++;
+                    return NEED_TIME;
+                }
+            }
+            catch (const WriteConflictException& wce) {
+                _idRetrying = id;
+                *out = WorkingSet::INVALID_ID;
+                _commonStats.needYield++;
+                return NEED_YIELD;
+            }
         }
-        else if (PlanStage::FAILURE == status) {
+
+        return returnIfMatches(member, id, out);
+    }
+
+    PlanStage::StageState FetchStage::handleChildState(StageState status,
+                                                       WorkingSetID id,
+                                                       WorkingSetID* out) {
+        if (PlanStage::FAILURE == status) {
             *out = id;
             // If a stage fails, it may create a status WSM to indicate why it
             // failed, in which case 'id' is valid.  If ID is invalid, we
@@ -188,6 +271,14 @@ namespace mongo {
                 WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
             }
         }
+
+        // The same goes for the results of our child's last batch that we haven't fetched yet.
+        for (size_t i = _nextChildResult; i < _childResults.size(); i++) {
+            WorkingSetMember* member = _ws->get(_childResults[i]);
+            if (member->hasLoc() && (member->loc == dl)) {
+                WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+            }
+        }
     }
 
     PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
@@ -209,7 +300,7 @@ namespace mongo {
         // predicate.
         ++_specificStats.docsExamined;
 
-        if (Filter::passes(member, _filter)) {
+        if (Filter::passes(member, _filter, _compiledFilter.get())) {
             if (NULL != _filter) {
                 ++_specificStats.matchTested;
             }
@@ -29,10 +29,12 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <memory>
 
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
 #include "mongo/db/record_id.h"
 
 namespace mongo {
@@ -57,6 +59,9 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* results,
+                                     WorkingSetID* out);
 
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
@@ -75,6 +80,17 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        /**
+         * Fetches the document for the result 'id' of our child, if it doesn't already have one,
+         * and returns it through returnIfMatches(). Returns NEED_YIELD, and retries 'id' on the
+         * next call, if the document has to be paged in or fetching it hit a write conflict.
+         */
+        StageState fetchAndFilter(WorkingSetID id, WorkingSetID* out);
+
+        /**
+         * Passes up a state other than ADVANCED from our child.
+         */
+        StageState handleChildState(StageState status, WorkingSetID id, WorkingSetID* out);
 
         /**
          * If the member (with id memberID) passes our filter, set *out to memberID and return that
@@ -96,9 +112,20 @@ namespace mongo {
         // The filter is not owned by us.
         const MatchExpression* _filter;
 
+        // _filter compiled for matching documents, if there was anything to compile.
+        std::unique_ptr<CompiledMatchExpression> _compiledFilter;
+
         // If not Null, we use this rather than asking our child what to do next.
         WorkingSetID _idRetrying;
 
+        // Results from our child's last workBatch(), which are fetched before asking it for more.
+        // Those before _nextChildResult have already been fetched.
+        std::vector<WorkingSetID> _childResults;
+        size_t _nextChildResult = 0;
+
+        // Set when a batch ended with results and a state still to be returned.
+        DeferredState _deferredState;
+
         // Stats
         CommonStats _commonStats;
         FetchStats _specificStats;
@@ -30,6 +30,7 @@
 
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
 #include "mongo/db/matcher/matchable.h"
 
 namespace mongo {
@@ -158,6 +159,19 @@ namespace mongo {
             return filter->matches(&doc, NULL);
         }
 
+        /**
+         * As above, but runs 'compiled', which was compiled from 'filter', when 'wsm' has a
+         * document to run it against. 'compiled' may be NULL.
+         */
+        static bool passes(WorkingSetMember* wsm,
+                           const MatchExpression* filter,
+                           const CompiledMatchExpression* compiled) {
+            if (NULL != compiled && wsm->hasObj()) {
+                return compiled->matchesBSON(wsm->obj.value());
+            }
+            return passes(wsm, filter);
+        }
+
         static bool passes(const BSONObj& keyData,
                            const BSONObj& keyPattern,
                            const MatchExpression* filter) {
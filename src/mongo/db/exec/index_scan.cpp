@@ -134,6 +134,27 @@ namespace mongo {
         // Adds the amount of time taken by work() to executionTimeMillis.
         ScopedTimer timer(&_commonStats.executionTimeMillis);
 
+        if (_deferredState.isSet()) {
+            return _deferredState.take(out);
+        }
+
+        return doWork(out);
+    }
+
+    PlanStage::StageState IndexScan::workBatch(size_t maxWorks,
+                                               std::vector<WorkingSetID>* results,
+                                               WorkingSetID* out) {
+        // Adds the amount of time taken by the whole batch to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        return workBatchWith([this](WorkingSetID* id) {
+                                 ++_commonStats.works;
+                                 return doWork(id);
+                             },
+                             &_deferredState, maxWorks, results, out);
+    }
+
+    PlanStage::StageState IndexScan::doWork(WorkingSetID* out) {
         // Get the next kv pair from the index, if any.
         boost::optional<IndexKeyEntry> kv;
         try {
@@ -209,7 +230,7 @@ namespace mongo {
             ++_specificStats.matchTested;
         }
         
-        if (!kv->key.isOwned()) kv->key = kv->key.getOwned();
+        kv->key = _workingSet->getOwned(kv->key);
 
         // We found something to return, so fill out the WSM.
         WorkingSetID id = _workingSet->allocate();
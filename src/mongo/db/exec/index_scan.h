@@ -103,6 +103,9 @@ namespace mongo {
         virtual ~IndexScan() { }
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* results,
+                                     WorkingSetID* out);
         virtual bool isEOF();
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
@@ -121,6 +124,11 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        /**
+         * Performs one unit of work for work() or workBatch(), which account for its stats.
+         */
+        StageState doWork(WorkingSetID* out);
+
         /**
          * Initialize the underlying index Cursor, returning first result if any.
          */
@@ -152,6 +160,9 @@ namespace mongo {
         const bool _forward;
         const IndexScanParams _params;
 
+        // Set when a batch ended with results and a state still to be returned.
+        DeferredState _deferredState;
+
         // Stats
         CommonStats _commonStats;
         IndexScanStats _specificStats;
@@ -67,7 +67,44 @@ namespace mongo {
             ++_commonStats.advanced;
             return PlanStage::ADVANCED;
         }
-        else if (PlanStage::FAILURE == status) {
+
+        return handleChildState(status, id, out);
+    }
+
+    PlanStage::StageState LimitStage::workBatch(size_t maxWorks,
+                                                vector<WorkingSetID>* results,
+                                                WorkingSetID* out) {
+        ++_commonStats.works;
+
+        // Adds the amount of time taken by the whole batch to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        if (0 == _numToReturn) {
+            // We've returned as many results as we're limited to.
+            return PlanStage::IS_EOF;
+        }
+
+        // A batch has no more results than works, so this can't take us over the limit.
+        const size_t numResultsBefore = results->size();
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState status = _child->workBatch(std::min(maxWorks, size_t(_numToReturn)),
+                                              results,
+                                              &id);
+        if (PlanStage::ADVANCED != status) {
+            return handleChildState(status, id, out);
+        }
+
+        const size_t numResults = results->size() - numResultsBefore;
+        invariant(numResults <= size_t(_numToReturn));
+        _numToReturn -= numResults;
+        _commonStats.advanced += numResults;
+        return status;
+    }
+
+    PlanStage::StageState LimitStage::handleChildState(StageState status,
+                                                       WorkingSetID id,
+                                                       WorkingSetID* out) {
+        if (PlanStage::FAILURE == status) {
             *out = id;
             // If a stage fails, it may create a status WSM to indicate why it
             // failed, in which case 'id' is valid.  If ID is invalid, we
@@ -48,6 +48,7 @@
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -230,13 +231,32 @@ namespace mongo {
         size_t numWorks = getTrialPeriodWorks(_txn, _collection);
         size_t numResults = getTrialPeriodNumToReturn(*_query);
 
+        // Time the trial period separately, on both the wall clock and this thread's CPU clock.
+        // A wall time well above the CPU time means the trial was waiting on yields or I/O
+        // rather than evaluating candidates.
+        const unsigned long long trialStartMicros = curTimeMicros64();
+        const unsigned long long trialStartCpuMicros = curThreadCpuTimeMicros64();
+
         // Work the plans, stopping when a plan hits EOF or returns some
         // fixed number of results.
+        //
+        // The candidates are worked in turn on this thread rather than concurrently. Each
+        // candidate tree reads through '_txn', and the results it buffers point into that
+        // context's snapshot. Moving a candidate to a worker with its own OperationContext would
+        // also give it its own Locker, whose intent lock can queue behind a writer that is itself
+        // waiting on the lock this operation holds while it waits for the worker.
         for (size_t ix = 0; ix < numWorks; ++ix) {
+            ++_specificStats.trialRounds;
             bool moreToDo = workAllPlans(numResults, yieldPolicy);
             if (!moreToDo) { break; }
         }
 
+        _specificStats.trialWallMicros = curTimeMicros64() - trialStartMicros;
+        const unsigned long long trialEndCpuMicros = curThreadCpuTimeMicros64();
+        if (trialEndCpuMicros >= trialStartCpuMicros) {
+            _specificStats.trialCpuMicros = trialEndCpuMicros - trialStartCpuMicros;
+        }
+
         if (_failure) {
             invariant(WorkingSet::INVALID_ID != _statusMemberId);
             WorkingSetMember* member = _candidates[0].ws->get(_statusMemberId);
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/invalidation_type.h"
@@ -184,6 +186,40 @@ namespace mongo {
          */
         virtual StageState work(WorkingSetID* out) = 0;
 
+        /**
+         * Performs up to 'maxWorks' units of work, appending the ids of the results produced to
+         * 'results', of which there are never more than 'maxWorks'. Produces the same results, in
+         * the same order, as that many calls to work(), without the cost of a call through each
+         * stage of the tree per result.
+         *
+         * Returns ADVANCED if and only if results were appended. Otherwise returns the state
+         * work() would have: NEED_TIME if the batch ran out of works, or whichever of IS_EOF,
+         * NEED_YIELD, DEAD or FAILURE ended it, with *out set as work() sets it.
+         *
+         * A batch which has results never carries another state with them. A stage which reaches
+         * IS_EOF, NEED_YIELD, DEAD or FAILURE after producing results ends the batch there and
+         * returns ADVANCED, then returns that state from its next call to work() or workBatch().
+         *
+         * Stages which can move through many results without leaving the stage override this.
+         * The default simply calls work() until it produces a result.
+         */
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* results,
+                                     WorkingSetID* out) {
+            StageState state = NEED_TIME;
+            for (size_t i = 0; i < maxWorks && NEED_TIME == state; i++) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                state = work(&id);
+                if (ADVANCED == state) {
+                    results->push_back(id);
+                }
+                else {
+                    *out = id;
+                }
+            }
+            return state;
+        }
+
         /**
          * Returns true if no more work can be done on the query / out of results.
          */
@@ -283,6 +319,67 @@ namespace mongo {
          */
         virtual const SpecificStats* getSpecificStats() const = 0;
 
+    protected:
+        /**
+         * The state which ended a batch after it had produced results. The stage keeps it to
+         * return from its next call to work() or workBatch(), before doing any more work.
+         */
+        class DeferredState {
+        public:
+            bool isSet() const { return _isSet; }
+
+            void set(StageState state, WorkingSetID id) {
+                _isSet = true;
+                _state = state;
+                _id = id;
+            }
+
+            StageState take(WorkingSetID* out) {
+                invariant(_isSet);
+                _isSet = false;
+                *out = _id;
+                return _state;
+            }
+
+        private:
+            bool _isSet = false;
+            StageState _state = NEED_TIME;
+            WorkingSetID _id = WorkingSet::INVALID_ID;
+        };
+
+        /**
+         * Implements workBatch() for a stage by repeating 'workOnce', a function behaving like the
+         * stage's work(), up to 'maxWorks' times. A state which ends the batch after it has
+         * produced results is kept in 'deferred'; the stage's work() must return it first.
+         */
+        template <typename WorkOnce>
+        static StageState workBatchWith(const WorkOnce& workOnce,
+                                        DeferredState* deferred,
+                                        size_t maxWorks,
+                                        std::vector<WorkingSetID>* results,
+                                        WorkingSetID* out) {
+            if (deferred->isSet()) {
+                return deferred->take(out);
+            }
+
+            const size_t numResultsBefore = results->size();
+            for (size_t i = 0; i < maxWorks; i++) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                const StageState state = workOnce(&id);
+                if (ADVANCED == state) {
+                    results->push_back(id);
+                }
+                else if (NEED_TIME != state) {
+                    if (results->size() == numResultsBefore) {
+                        *out = id;
+                        return state;
+                    }
+                    deferred->set(state, id);
+                    break;
+                }
+            }
+            return results->size() == numResultsBefore ? NEED_TIME : ADVANCED;
+        }
     };
 
 }  // namespace mongo
@@ -435,11 +435,21 @@ namespace mongo {
     };
 
     struct MultiPlanStats : public SpecificStats {
-        MultiPlanStats() { }
+        MultiPlanStats() : trialRounds(0),
+                           trialWallMicros(0),
+                           trialCpuMicros(0) { }
 
         virtual SpecificStats* clone() const {
             return new MultiPlanStats(*this);
         }
+
+        // How many times every candidate was worked before a winner was picked.
+        size_t trialRounds;
+
+        // Elapsed and query thread CPU time spent ranking the candidates. The wall time
+        // includes any yields taken during the trial period.
+        long long trialWallMicros;
+        long long trialCpuMicros;
     };
 
     struct OrStats : public SpecificStats {
@@ -477,7 +487,7 @@ namespace mongo {
     };
 
     struct SortStats : public SpecificStats {
-        SortStats() : forcedFetches(0), memUsage(0), memLimit(0) { }
+        SortStats() : forcedFetches(0), memUsage(0), memLimit(0), usedDisk(false) { }
 
         virtual ~SortStats() { }
 
@@ -495,6 +505,9 @@ namespace mongo {
         // What's our memory limit?
         size_t memLimit;
 
+        // Did we outgrow memLimit and spill to disk?
+        bool usedDisk;
+
         // The number of results to return from the sort.
         size_t limit;
 
@@ -642,7 +655,8 @@ namespace mongo {
     };
 
     struct TextStats : public SpecificStats {
-        TextStats() : keysExamined(0), fetches(0), parsedTextQuery() { }
+        TextStats() : keysExamined(0), negatedKeysExamined(0), fetches(0), parsedTextQuery(),
+                      limit(0) { }
 
         virtual SpecificStats* clone() const {
             TextStats* specific = new TextStats(*this);
@@ -653,6 +667,9 @@ namespace mongo {
 
         size_t keysExamined;
 
+        // How many of 'keysExamined' were read for negated terms.
+        size_t negatedKeysExamined;
+
         size_t fetches;
 
         // Human-readable form of the FTSQuery associated with the text stage.
@@ -660,6 +677,9 @@ namespace mongo {
 
         // Index keys that precede the "text" index key.
         BSONObj indexPrefix;
+
+        // How many of the best scoring documents the stage looks for, or 0 to return them all.
+        size_t limit;
     };
 
 }  // namespace mongo
@@ -226,8 +226,50 @@ namespace mongo {
 
             *out = id;
             ++_commonStats.advanced;
+            return status;
         }
-        else if (PlanStage::FAILURE == status) {
+
+        return handleChildState(status, id, out);
+    }
+
+    PlanStage::StageState ProjectionStage::workBatch(size_t maxWorks,
+                                                     vector<WorkingSetID>* results,
+                                                     WorkingSetID* out) {
+        ++_commonStats.works;
+
+        // Adds the amount of time taken by the whole batch to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        const size_t numResultsBefore = results->size();
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState status = _child->workBatch(maxWorks, results, &id);
+        if (PlanStage::ADVANCED != status) {
+            return handleChildState(status, id, out);
+        }
+
+        // Project our child's results in place.
+        for (size_t i = numResultsBefore; i < results->size(); i++) {
+            Status projStatus = transform(_ws->get((*results)[i]));
+            if (!projStatus.isOK()) {
+                warning() << "Couldn't execute projection, status = "
+                          << projStatus.toString() << endl;
+                for (size_t j = numResultsBefore; j < results->size(); j++) {
+                    _ws->free((*results)[j]);
+                }
+                results->resize(numResultsBefore);
+                *out = WorkingSetCommon::allocateStatusMember(_ws, projStatus);
+                return PlanStage::FAILURE;
+            }
+        }
+
+        _commonStats.advanced += results->size() - numResultsBefore;
+        return status;
+    }
+
+    PlanStage::StageState ProjectionStage::handleChildState(StageState status,
+                                                            WorkingSetID id,
+                                                            WorkingSetID* out) {
+        if (PlanStage::FAILURE == status) {
             *out = id;
             // If a stage fails, it may create a status WSM to indicate why it
             // failed, in which case 'id' is valid.  If ID is invalid, we
@@ -84,6 +84,9 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* results,
+                                     WorkingSetID* out);
 
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
@@ -122,6 +125,11 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        /**
+         * Passes up a state other than ADVANCED from our child.
+         */
+        StageState handleChildState(StageState status, WorkingSetID id, WorkingSetID* out);
+
         Status transform(WorkingSetMember* member);
 
         boost::scoped_ptr<ProjectionExec> _exec;
@@ -69,7 +69,47 @@ namespace mongo {
             ++_commonStats.advanced;
             return PlanStage::ADVANCED;
         }
-        else if (PlanStage::FAILURE == status) {
+
+        return handleChildState(status, id, out);
+    }
+
+    PlanStage::StageState SkipStage::workBatch(size_t maxWorks,
+                                               vector<WorkingSetID>* results,
+                                               WorkingSetID* out) {
+        ++_commonStats.works;
+
+        // Adds the amount of time taken by the whole batch to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        const size_t numResultsBefore = results->size();
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState status = _child->workBatch(maxWorks, results, &id);
+        if (PlanStage::ADVANCED != status) {
+            return handleChildState(status, id, out);
+        }
+
+        // Drop as many of the results as we still have to skip.
+        const size_t numToDrop = std::min(results->size() - numResultsBefore, size_t(_toSkip));
+        for (size_t i = 0; i < numToDrop; i++) {
+            _ws->free((*results)[numResultsBefore + i]);
+        }
+        results->erase(results->begin() + numResultsBefore,
+                       results->begin() + numResultsBefore + numToDrop);
+        _toSkip -= numToDrop;
+
+        if (results->size() == numResultsBefore) {
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
+        _commonStats.advanced += results->size() - numResultsBefore;
+        return status;
+    }
+
+    PlanStage::StageState SkipStage::handleChildState(StageState status,
+                                                      WorkingSetID id,
+                                                      WorkingSetID* out) {
+        if (PlanStage::FAILURE == status) {
             *out = id;
             // If a stage fails, it may create a status WSM to indicate why it
             // failed, in which case 'id' is valid.  If ID is invalid, we
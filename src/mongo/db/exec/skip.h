@@ -49,6 +49,9 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* results,
+                                     WorkingSetID* out);
 
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
@@ -67,6 +70,11 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        /**
+         * Passes up a state other than ADVANCED from our child.
+         */
+        StageState handleChildState(StageState status, WorkingSetID id, WorkingSetID* out);
+
         WorkingSet* _ws;
         boost::scoped_ptr<PlanStage> _child;
 
@@ -41,6 +41,7 @@
 #include "mongo/db/query/lite_parsed_query.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/storage_options.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
@@ -49,6 +50,49 @@ namespace mongo {
     using std::endl;
     using std::vector;
 
+namespace {
+
+    /**
+     * Orders the keys SortStage gives its external Sorter, {k: <sort key>, l: <RecordId>}, the
+     * same way WorkingSetComparator orders items in memory.
+     */
+    class ExternalSortComparator {
+    public:
+        explicit ExternalSortComparator(const BSONObj& pattern) : _pattern(pattern) { }
+
+        int operator()(const std::pair<BSONObj, BSONObj>& lhs,
+                       const std::pair<BSONObj, BSONObj>& rhs) const {
+            const int result = lhs.first.firstElement().Obj().woCompare(
+                                    rhs.first.firstElement().Obj(), _pattern, false);
+            if (0 != result) {
+                return result;
+            }
+
+            const long long lhsLoc = lhs.first["l"].numberLong();
+            const long long rhsLoc = rhs.first["l"].numberLong();
+            if (lhsLoc == rhsLoc) {
+                return 0;
+            }
+            return lhsLoc < rhsLoc ? -1 : 1;
+        }
+
+    private:
+        BSONObj _pattern;
+    };
+
+    // Computed data such as text scores lives only in the WorkingSetMember, so members that carry
+    // any can't be spilled to disk.
+    bool hasComputedData(const WorkingSetMember& member) {
+        for (int i = 0; i < WSM_COMPUTED_NUM_TYPES; ++i) {
+            if (member.hasComputed(static_cast<WorkingSetComputedDataType>(i))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // namespace
+
     // static
     const char* SortStage::kStageType = "SORT";
 
@@ -294,6 +338,7 @@ namespace mongo {
           _pattern(params.pattern),
           _query(params.query),
           _limit(params.limit),
+          _allowDiskUse(params.allowDiskUse),
           _sorted(false),
           _resultIterator(_data.end()),
           _commonStats(kStageType),
@@ -305,7 +350,9 @@ namespace mongo {
     bool SortStage::isEOF() {
         // We're done when our child has no more results, we've sorted the child's results, and
         // we've returned all sorted results.
-        return _child->isEOF() && _sorted && (_data.end() == _resultIterator);
+        const bool exhausted = _externalIterator ? !_externalIterator->more()
+                                                 : _data.end() == _resultIterator;
+        return _child->isEOF() && _sorted && exhausted;
     }
 
     PlanStage::StageState SortStage::work(WorkingSetID* out) {
@@ -329,12 +376,21 @@ namespace mongo {
 
         const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes);
         if (_memUsage > maxBytes) {
-            mongoutils::str::stream ss;
-            ss << "Sort operation used more than the maximum " << maxBytes
-               << " bytes of RAM. Add an index, or specify a smaller limit.";
-            Status status(ErrorCodes::OperationFailed, ss);
-            *out = WorkingSetCommon::allocateStatusMember( _ws, status);
-            return PlanStage::FAILURE;
+            if (!_allowDiskUse) {
+                mongoutils::str::stream ss;
+                ss << "Sort operation used more than the maximum " << maxBytes
+                   << " bytes of RAM. Add an index, specify a smaller limit,"
+                   << " or set allowDiskUse.";
+                Status status(ErrorCodes::OperationFailed, ss);
+                *out = WorkingSetCommon::allocateStatusMember( _ws, status);
+                return PlanStage::FAILURE;
+            }
+
+            Status status = switchToExternalSort();
+            if (!status.isOK()) {
+                *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+                return PlanStage::FAILURE;
+            }
         }
 
         if (isEOF()) { return PlanStage::IS_EOF; }
@@ -371,7 +427,16 @@ namespace mongo {
                     item.loc = member->loc;
                 }
 
-                addToBuffer(item);
+                if (_externalSorter) {
+                    Status status = addToExternalSorter(item);
+                    if (!status.isOK()) {
+                        *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+                        return PlanStage::FAILURE;
+                    }
+                }
+                else {
+                    addToBuffer(item);
+                }
 
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
@@ -379,7 +444,14 @@ namespace mongo {
             else if (PlanStage::IS_EOF == code) {
                 // TODO: We don't need the lock for this.  We could ask for a yield and do this work
                 // unlocked.  Also, this is performing a lot of work for one call to work(...)
-                sortBuffer();
+                if (_externalSorter) {
+                    // The iterator merges the spilled runs and outlives the sorter.
+                    _externalIterator.reset(_externalSorter->done());
+                    _externalSorter.reset();
+                }
+                else {
+                    sortBuffer();
+                }
                 _resultIterator = _data.begin();
                 _sorted = true;
                 ++_commonStats.needTime;
@@ -410,6 +482,20 @@ namespace mongo {
         }
 
         // Returning results.
+        if (_externalIterator) {
+            // These documents were copied out of the working set when they were spilled, so they
+            // come back as owned objects without a RecordId to invalidate.
+            verify(_sorted);
+            verify(_externalIterator->more());
+            *out = _ws->allocate();
+            WorkingSetMember* member = _ws->get(*out);
+            member->obj = Snapshotted<BSONObj>(SnapshotId(), _externalIterator->next().second);
+            member->state = WorkingSetMember::OWNED_OBJ;
+
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
         verify(_resultIterator != _data.end());
         verify(_sorted);
         *out = _resultIterator->wsid;
@@ -516,11 +602,13 @@ namespace mongo {
         WorkingSetID wsidToFree = WorkingSet::INVALID_ID;
 
         if (_limit == 0) {
+            _ws->get(item.wsid)->copyOutOfArena();
             _data.push_back(item);
             _memUsage += _ws->get(item.wsid)->getMemUsage();
         }
         else if (_limit == 1) {
             if (_data.empty()) {
+                _ws->get(item.wsid)->copyOutOfArena();
                 _data.push_back(item);
                 _memUsage = _ws->get(item.wsid)->getMemUsage();
                 return;
@@ -530,6 +618,7 @@ namespace mongo {
             // Compare new item with existing item in vector.
             if (cmp(item, _data[0])) {
                 wsidToFree = _data[0].wsid;
+                _ws->get(item.wsid)->copyOutOfArena();
                 _data[0] = item;
                 _memUsage = _ws->get(item.wsid)->getMemUsage();
             }
@@ -539,6 +628,7 @@ namespace mongo {
             // Limit not reached - insert and return
             vector<SortableDataItem>::size_type limit(_limit);
             if (_dataSet->size() < limit) {
+                _ws->get(item.wsid)->copyOutOfArena();
                 _dataSet->insert(item);
                 _memUsage += _ws->get(item.wsid)->getMemUsage();
                 return;
@@ -551,6 +641,7 @@ namespace mongo {
             const SortableDataItem& lastItem = *lastItemIt;
             const WorkingSetComparator& cmp = *_sortKeyComparator;
             if (cmp(item, lastItem)) {
+                _ws->get(item.wsid)->copyOutOfArena();
                 _memUsage -= _ws->get(lastItem.wsid)->getMemUsage();
                 _memUsage += _ws->get(item.wsid)->getMemUsage();
                 wsidToFree = lastItem.wsid;
@@ -574,6 +665,68 @@ namespace mongo {
         }
     }
 
+    Status SortStage::switchToExternalSort() {
+        vector<SortableDataItem> items;
+        if (_dataSet) {
+            items.assign(_dataSet->begin(), _dataSet->end());
+        }
+        else {
+            items.swap(_data);
+        }
+
+        for (vector<SortableDataItem>::const_iterator it = items.begin(); it != items.end(); ++it) {
+            if (hasComputedData(*_ws->get(it->wsid))) {
+                return Status(ErrorCodes::OperationFailed,
+                              "Sort operation exceeded its memory limit and cannot use the disk "
+                              "for documents with computed metadata such as text scores. "
+                              "Add an index, or specify a smaller limit.");
+            }
+        }
+
+        LOG(1) << "sort stage exceeded " << _memUsage << " bytes, sorting " << items.size()
+               << " buffered documents and any further input externally";
+
+        SortOptions opts;
+        opts.limit = _limit;
+        opts.maxMemoryUsageBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes);
+        opts.extSortAllowed = true;
+        opts.tempDir = storageGlobalParams.dbpath + "/_tmp";
+        opts.backgroundSpill = true;
+        opts.readAhead = true;
+        _externalSorter.reset(ExternalSorter::make(
+                                opts, ExternalSortComparator(_sortKeyGen->getSortComparator())));
+        _specificStats.usedDisk = true;
+
+        for (vector<SortableDataItem>::const_iterator it = items.begin(); it != items.end(); ++it) {
+            invariant(addToExternalSorter(*it).isOK());
+        }
+
+        _data.clear();
+        _dataSet.reset();
+        _memUsage = 0;
+        return Status::OK();
+    }
+
+    Status SortStage::addToExternalSorter(const SortableDataItem& item) {
+        WorkingSetMember* member = _ws->get(item.wsid);
+        if (hasComputedData(*member)) {
+            return Status(ErrorCodes::OperationFailed,
+                          "Sort operation cannot use the disk for documents with computed "
+                          "metadata such as text scores.");
+        }
+
+        BSONObjBuilder keyBuilder;
+        keyBuilder.append("k", item.sortKey);
+        keyBuilder.append("l", static_cast<long long>(item.loc.repr()));
+        _externalSorter->add(keyBuilder.obj(), member->obj.value().getOwned());
+
+        if (member->hasLoc()) {
+            _wsidByDiskLoc.erase(member->loc);
+        }
+        _ws->free(item.wsid);
+        return Status::OK();
+    }
+
     void SortStage::sortBuffer() {
         if (_limit == 0) {
             const WorkingSetComparator& cmp = *_sortKeyComparator;
@@ -594,3 +747,6 @@ namespace mongo {
     }
 
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
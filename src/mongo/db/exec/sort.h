@@ -37,6 +37,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/platform/unordered_map.h"
 
 
@@ -47,7 +48,7 @@ namespace mongo {
     // Parameters that must be provided to a SortStage
     class SortStageParams {
     public:
-        SortStageParams() : collection(NULL), limit(0) { }
+        SortStageParams() : collection(NULL), limit(0), allowDiskUse(false) { }
 
         // Used for resolving RecordIds to BSON
         const Collection* collection;
@@ -60,6 +61,10 @@ namespace mongo {
 
         // Equal to 0 for no limit.
         size_t limit;
+
+        // If true, the stage sorts externally instead of failing once it buffers more than
+        // internalQueryExecMaxBlockingSortBytes.
+        bool allowDiskUse;
     };
 
     /**
@@ -139,6 +144,10 @@ namespace mongo {
      *
      * Preconditions: For each field in 'pattern', all inputs in the child must handle a
      * getFieldDotted for that field.
+     *
+     * If 'allowDiskUse' is set and the buffered data outgrows the memory limit, the buffered
+     * documents are handed over to a Sorter which spills sorted runs to disk, and results are
+     * returned as owned objects merged from those runs.
      */
     class SortStage : public PlanStage {
     public:
@@ -191,6 +200,9 @@ namespace mongo {
         // Equal to 0 for no limit.
         size_t _limit;
 
+        // May we sort externally rather than fail when we run out of memory?
+        bool _allowDiskUse;
+
         //
         // Sort key generation
         //
@@ -240,6 +252,17 @@ namespace mongo {
          */
         void sortBuffer();
 
+        /**
+         * Moves everything buffered so far into _externalSorter, which handles all further input.
+         * Fails if any buffered member carries computed data, which the sorter cannot keep.
+         */
+        Status switchToExternalSort();
+
+        /**
+         * Adds one item to _externalSorter and frees its working set member.
+         */
+        Status addToExternalSorter(const SortableDataItem& item);
+
         // Comparator for data buffer
         // Initialization follows sort key generator
         boost::scoped_ptr<WorkingSetComparator> _sortKeyComparator;
@@ -262,6 +285,20 @@ namespace mongo {
         typedef unordered_map<RecordId, WorkingSetID, RecordId::Hasher> DataMap;
         DataMap _wsidByDiskLoc;
 
+        //
+        // External sort
+        //
+
+        // Keys are {k: <sort key>, l: <RecordId>} so that ties break as they do in memory;
+        // values are the owned documents.
+        typedef Sorter<BSONObj, BSONObj> ExternalSorter;
+
+        // Set once the buffered data has outgrown the memory limit; takes all input after that.
+        boost::scoped_ptr<ExternalSorter> _externalSorter;
+
+        // Iterates through the external sort's results once all input has been added.
+        boost::scoped_ptr<ExternalSorter::Iterator> _externalIterator;
+
         //
         // Stats
         //
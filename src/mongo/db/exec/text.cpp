@@ -38,6 +38,7 @@
 #include "mongo/db/exec/working_set_computed_data.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/query_knobs.h"
 
 namespace mongo {
 
@@ -60,10 +61,12 @@ namespace mongo {
           _commonStats(kStageType),
           _internalState(INIT_SCANS),
           _currentIndexScanner(0),
-          _idRetrying(WorkingSet::INVALID_ID) {
+          _idRetrying(WorkingSet::INVALID_ID),
+          _negatedKeysBudget(0) {
         _scoreIterator = _scores.end();
         _specificStats.indexPrefix = _params.indexPrefix;
         _specificStats.indexName = _params.index->indexName();
+        _specificStats.limit = _params.limit;
     }
 
     TextStage::~TextStage() { }
@@ -98,10 +101,13 @@ namespace mongo {
             break;
 
         case READING_TERMS:
-            stageState = readFromSubScanners(out);
+            stageState = _params.limit ? readTopTerms(out) : readFromSubScanners(out);
+            break;
+        case READING_NEGATED_TERMS:
+            stageState = readNegatedTerms(out);
             break;
         case RETURNING_RESULTS:
-            stageState = returnResults(out);
+            stageState = _params.limit ? returnTopResults(out) : returnResults(out);
             break;
         case DONE:
             // Handled above.
@@ -158,6 +164,18 @@ namespace mongo {
         // TODO: If we're RETURNING_RESULTS we could somehow buffer the object.
         ScoreMap::iterator scoreIt = _scores.find(dl);
         if (scoreIt != _scores.end()) {
+            if (_params.limit) {
+                if (WorkingSet::INVALID_ID != scoreIt->second.wsid) {
+                    // The document is one of _topResults, so keep a copy of it.
+                    WorkingSetCommon::fetchAndInvalidateLoc(txn,
+                                                            _ws->get(scoreIt->second.wsid),
+                                                            _params.index->getCollection());
+                    scoreIt->second.wsid = WorkingSet::INVALID_ID;
+                }
+                // Keep the entry, which marks the document as seen, so that its other keys don't
+                // make it a candidate a second time.
+                return;
+            }
             if (scoreIt == _scoreIterator) {
                 _scoreIterator++;
             }
@@ -204,21 +222,7 @@ namespace mongo {
         for (std::set<std::string>::const_iterator it = _params.query.getTermsForBounds().begin();
              it != _params.query.getTermsForBounds().end();
              ++it) {
-            const string& term = *it;
-            IndexScanParams params;
-            params.bounds.startKey = FTSIndexFormat::getIndexKey(MAX_WEIGHT,
-                                                                 term,
-                                                                 _params.indexPrefix,
-                                                                 _params.spec.getTextIndexVersion());
-            params.bounds.endKey = FTSIndexFormat::getIndexKey(0,
-                                                               term,
-                                                                _params.indexPrefix,
-                                                               _params.spec.getTextIndexVersion());
-            params.bounds.endKeyInclusive = true;
-            params.bounds.isSimpleRange = true;
-            params.descriptor = _params.index;
-            params.direction = -1;
-            _scanners.mutableVector().push_back(new IndexScan(_txn, params, _ws, NULL));
+            _scanners.mutableVector().push_back(newTermScan(*it));
         }
 
         // If we have no terms we go right to EOF.
@@ -227,11 +231,34 @@ namespace mongo {
             return PlanStage::IS_EOF;
         }
 
+        if (_params.limit) {
+            // Nothing has been read yet, so the only bound is the one every key obeys.
+            _scannerBounds.assign(_scanners.size(), MAX_WEIGHT);
+            _scannerDone.assign(_scanners.size(), false);
+        }
+
         // Transition to the next state.
         _internalState = READING_TERMS;
         return PlanStage::NEED_TIME;
     }
 
+    PlanStage* TextStage::newTermScan(const string& term) {
+        IndexScanParams params;
+        params.bounds.startKey = FTSIndexFormat::getIndexKey(MAX_WEIGHT,
+                                                             term,
+                                                             _params.indexPrefix,
+                                                             _params.spec.getTextIndexVersion());
+        params.bounds.endKey = FTSIndexFormat::getIndexKey(0,
+                                                           term,
+                                                           _params.indexPrefix,
+                                                           _params.spec.getTextIndexVersion());
+        params.bounds.endKeyInclusive = true;
+        params.bounds.isSimpleRange = true;
+        params.descriptor = _params.index;
+        params.direction = -1;
+        return new IndexScan(_txn, params, _ws, NULL);
+    }
+
     PlanStage::StageState TextStage::readFromSubScanners(WorkingSetID* out) {
         // This should be checked before we get here.
         invariant(_currentIndexScanner < _scanners.size());
@@ -261,29 +288,106 @@ namespace mongo {
             }
 
             // If we're here we are done reading results.  Move to the next state.
-            _scoreIterator = _scores.begin();
-            _internalState = RETURNING_RESULTS;
+            return initNegatedTermScans();
+        }
+        else {
+            return handleScannerState(childState, id, out);
+        }
+    }
 
-            // Don't need to keep these around.
-            _scanners.clear();
+    PlanStage::StageState TextStage::initNegatedTermScans() {
+        // Don't need to keep these around.
+        _scanners.clear();
+
+        // The keys hold the terms of each document as _ftsMatcher finds them, except that they are
+        // lower case and leave out stop words. So a key for a negated term means that the document
+        // has it, as long as case doesn't matter.
+        const std::set<string>& negatedTerms = _params.query.getNegatedTerms();
+        if (negatedTerms.empty()
+            || _scores.empty()
+            || _params.query.getCaseSensitive()
+            || fts::TEXT_INDEX_VERSION_2 != _params.spec.getTextIndexVersion()
+            || internalQueryTextNegatedKeysPerCandidate <= 0) {
+            return finishNegatedTerms();
+        }
+
+        _negatedKeysBudget = _scores.size() * internalQueryTextNegatedKeysPerCandidate;
+        for (std::set<string>::const_iterator it = negatedTerms.begin();
+             it != negatedTerms.end();
+             ++it) {
+            _scanners.mutableVector().push_back(newTermScan(*it));
+        }
+
+        _currentIndexScanner = 0;
+        _internalState = READING_NEGATED_TERMS;
+        return PlanStage::NEED_TIME;
+    }
+
+    PlanStage::StageState TextStage::readNegatedTerms(WorkingSetID* out) {
+        if (_specificStats.negatedKeysExamined >= _negatedKeysBudget) {
+            // Fetching and tokenizing the documents is cheaper than reading on. The ones dropped so
+            // far all have a negated term, so they stay dropped.
+            return finishNegatedTerms();
+        }
+
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState childState = _scanners.vector()[_currentIndexScanner]->work(&id);
+
+        if (PlanStage::ADVANCED == childState) {
+            WorkingSetMember* wsm = _ws->get(id);
+            invariant(wsm->hasLoc());
+
+            ++_specificStats.keysExamined;
+            ++_specificStats.negatedKeysExamined;
+
+            ScoreMap::iterator scoreIt = _scores.find(wsm->loc);
+            if (scoreIt != _scores.end() && scoreIt->second.score >= 0) {
+                _ws->free(scoreIt->second.wsid);
+                scoreIt->second.wsid = WorkingSet::INVALID_ID;
+                scoreIt->second.score = -1;
+            }
+
+            _ws->free(id);
             return PlanStage::NEED_TIME;
         }
+        else if (PlanStage::IS_EOF == childState) {
+            ++_currentIndexScanner;
+            if (_currentIndexScanner < _scanners.size()) {
+                return PlanStage::NEED_TIME;
+            }
+            return finishNegatedTerms();
+        }
         else {
-            // Propagate WSID from below.
-            *out = id;
-            if (PlanStage::FAILURE == childState) {
-                // If a stage fails, it may create a status WSM to indicate why it
-                // failed, in which case 'id' is valid.  If ID is invalid, we
-                // create our own error message.
-                if (WorkingSet::INVALID_ID == id) {
-                    mongoutils::str::stream ss;
-                    ss << "text stage failed to read in results from child";
-                    Status status(ErrorCodes::InternalError, ss);
-                    *out = WorkingSetCommon::allocateStatusMember( _ws, status);
-                }
+            return handleScannerState(childState, id, out);
+        }
+    }
+
+    PlanStage::StageState TextStage::finishNegatedTerms() {
+        _scoreIterator = _scores.begin();
+        _internalState = RETURNING_RESULTS;
+
+        // Don't need to keep these around.
+        _scanners.clear();
+        return PlanStage::NEED_TIME;
+    }
+
+    PlanStage::StageState TextStage::handleScannerState(StageState state,
+                                                        WorkingSetID id,
+                                                        WorkingSetID* out) {
+        // Propagate WSID from below.
+        *out = id;
+        if (PlanStage::FAILURE == state) {
+            // If a stage fails, it may create a status WSM to indicate why it
+            // failed, in which case 'id' is valid.  If ID is invalid, we
+            // create our own error message.
+            if (WorkingSet::INVALID_ID == id) {
+                mongoutils::str::stream ss;
+                ss << "text stage failed to read in results from child";
+                Status status(ErrorCodes::InternalError, ss);
+                *out = WorkingSetCommon::allocateStatusMember( _ws, status);
             }
-            return childState;
         }
+        return state;
     }
 
     PlanStage::StageState TextStage::returnResults(WorkingSetID* out) {
@@ -303,8 +407,12 @@ namespace mongo {
         }
 
         WorkingSetMember* wsm = _ws->get(textRecordData.wsid);
+        const bool needsFetch = !wsm->hasObj();
         try {
             if (!WorkingSetCommon::fetchIfUnfetched(_txn, wsm, _params.index->getCollection())) {
+                if (needsFetch) {
+                    ++_specificStats.fetches;
+                }
                 _scoreIterator++;
                 _ws->free(textRecordData.wsid);
                 _commonStats.needTime++;
@@ -318,6 +426,9 @@ namespace mongo {
             return NEED_YIELD;
         }
 
+        if (needsFetch) {
+            ++_specificStats.fetches;
+        }
         _scoreIterator++;
 
         // Filter for phrases and negated terms
@@ -435,21 +546,18 @@ namespace mongo {
                     wasDeleted = true;
                 }
 
+                if (wasDeleted || wsm->hasObj()) {
+                    // The filter had to fetch.
+                    ++_specificStats.fetches;
+                }
+
                 if (!shouldKeep) {
-                    if (wasDeleted || wsm->hasObj()) {
-                        // We had to fetch but we're not going to return it.
-                        ++_specificStats.fetches;
-                    }
                     _ws->free(textRecordData->wsid);
                     textRecordData->wsid = WorkingSet::INVALID_ID;
                     *documentAggregateScore = -1;
                     return NEED_TIME;
                 }
             }
-            else {
-                // If we're here, we're going to return the doc, and we do a fetch later.
-                ++_specificStats.fetches;
-            }
         }
         else {
             // We already have a working set member for this RecordId. Free the new
@@ -469,8 +577,14 @@ namespace mongo {
             return NEED_TIME;
         }
 
+        // Aggregate relevance score, term keys.
+        *documentAggregateScore += getKeyScore(newKeyData.keyData);
+        return NEED_TIME;
+    }
+
+    double TextStage::getKeyScore(const BSONObj& keyData) const {
         // Locate score within possibly compound key: {prefix,term,score,suffix}.
-        BSONObjIterator keyIt(newKeyData.keyData);
+        BSONObjIterator keyIt(keyData);
         for (unsigned i = 0; i < _params.spec.numExtraBefore(); i++) {
             keyIt.next();
         }
@@ -478,11 +592,161 @@ namespace mongo {
         keyIt.next(); // Skip past 'term'.
 
         BSONElement scoreElement = keyIt.next();
-        double documentTermScore = scoreElement.number();
+        return scoreElement.number();
+    }
 
-        // Aggregate relevance score, term keys.
-        *documentAggregateScore += documentTermScore;
+    double TextStage::scoreDocument(const BSONObj& obj) const {
+        fts::TermFrequencyMap termScores;
+        _params.spec.scoreDocument(obj, &termScores);
+
+        // These are the scores that were put in the index keys for 'obj'. Add them up in the order
+        // of the scans, as addTerm() would, so that both come to exactly the same score.
+        double score = 0;
+        const std::set<std::string>& terms = _params.query.getTermsForBounds();
+        for (std::set<std::string>::const_iterator it = terms.begin(); it != terms.end(); ++it) {
+            fts::TermFrequencyMap::const_iterator termScore = termScores.find(*it);
+            if (termScore != termScores.end()) {
+                score += termScore->second;
+            }
+        }
+        return score;
+    }
+
+    PlanStage::StageState TextStage::readTopTerms(WorkingSetID* out) {
+        if (WorkingSet::INVALID_ID != _idRetrying) {
+            WorkingSetID id = _idRetrying;
+            _idRetrying = WorkingSet::INVALID_ID;
+            return addTopCandidate(id, out);
+        }
+
+        // A document that none of the scans has returned yet can score no more than the sum of
+        // their bounds. Pick the scan with the highest bound to read from next, as it is the one
+        // most likely to turn up a better document, and the one whose bound has most to lose.
+        double unseenBound = 0;
+        size_t next = _scanners.size();
+        for (size_t i = 0; i < _scanners.size(); ++i) {
+            if (_scannerDone[i]) {
+                continue;
+            }
+            unseenBound += _scannerBounds[i];
+            if (next == _scanners.size() || _scannerBounds[i] > _scannerBounds[next]) {
+                next = i;
+            }
+        }
+
+        const bool haveAllResults = (_topResults.size() == _params.limit
+                                     && _topResults.top().score >= unseenBound);
+        if (next == _scanners.size() || haveAllResults) {
+            while (!_topResults.empty()) {
+                _topResultsToReturn.push_back(_topResults.top());
+                _topResults.pop();
+            }
+
+            _internalState = RETURNING_RESULTS;
+
+            // Don't need to keep these around.
+            _scanners.clear();
+            return PlanStage::NEED_TIME;
+        }
+
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState childState = _scanners.vector()[next]->work(&id);
+
+        if (PlanStage::ADVANCED == childState) {
+            WorkingSetMember* wsm = _ws->get(id);
+            invariant(wsm->state == WorkingSetMember::LOC_AND_IDX);
+            invariant(1 == wsm->keyData.size());
+
+            ++_specificStats.keysExamined;
+            _scannerBounds[next] = getKeyScore(wsm->keyData.back().keyData);
+            return addTopCandidate(id, out);
+        }
+        else if (PlanStage::IS_EOF == childState) {
+            _scannerDone[next] = true;
+            return PlanStage::NEED_TIME;
+        }
+        else {
+            return handleScannerState(childState, id, out);
+        }
+    }
+
+    PlanStage::StageState TextStage::addTopCandidate(WorkingSetID wsid, WorkingSetID* out) {
+        WorkingSetMember* wsm = _ws->get(wsid);
+        invariant(wsm->hasLoc());
+
+        // A document is scored in full the first time one of its keys is read, so there is
+        // nothing to do for the others.
+        if (_scores.end() != _scores.find(wsm->loc)) {
+            _ws->free(wsid);
+            return NEED_TIME;
+        }
+
+        try {
+            if (!WorkingSetCommon::fetchIfUnfetched(_txn, wsm, _params.index->getCollection())) {
+                _scores[wsm->loc].score = -1;
+                _ws->free(wsid);
+                return NEED_TIME;
+            }
+        }
+        catch (const WriteConflictException& wce) {
+            // Do this document again next time around.
+            _idRetrying = wsid;
+            *out = WorkingSet::INVALID_ID;
+            return NEED_YIELD;
+        }
+
+        ++_specificStats.fetches;
+
+        TextRecordData* textRecordData = &_scores[wsm->loc];
+
+        // Filter for the stage's filter, phrases and negated terms.
+        if (!Filter::passes(wsm, _filter) || !_ftsMatcher.matches(wsm->obj.value())) {
+            textRecordData->score = -1;
+            _ws->free(wsid);
+            return NEED_TIME;
+        }
+
+        textRecordData->score = scoreDocument(wsm->obj.value());
+
+        if (_topResults.size() == _params.limit) {
+            if (textRecordData->score <= _topResults.top().score) {
+                _ws->free(wsid);
+                return NEED_TIME;
+            }
+
+            // Make room by dropping the worst of the results so far.
+            const WorkingSetID worst = _topResults.top().wsid;
+            _topResults.pop();
+
+            WorkingSetMember* worstMember = _ws->get(worst);
+            if (worstMember->hasLoc()) {
+                ScoreMap::iterator worstIt = _scores.find(worstMember->loc);
+                if (worstIt != _scores.end()) {
+                    worstIt->second.wsid = WorkingSet::INVALID_ID;
+                }
+            }
+            _ws->free(worst);
+        }
+
+        textRecordData->wsid = wsid;
+        _topResults.push(ScoredResult(textRecordData->score, wsid));
         return NEED_TIME;
     }
 
+    PlanStage::StageState TextStage::returnTopResults(WorkingSetID* out) {
+        if (_topResultsToReturn.empty()) {
+            _internalState = DONE;
+            return PlanStage::IS_EOF;
+        }
+
+        const ScoredResult result = _topResultsToReturn.back();
+        _topResultsToReturn.pop_back();
+
+        // Populate the working set member with the text score and return it.
+        WorkingSetMember* wsm = _ws->get(result.wsid);
+        wsm->addComputed(new TextScoreComputedData(result.score));
+        *out = result.wsid;
+        return PlanStage::ADVANCED;
+    }
+
 }  // namespace mongo
@@ -55,7 +55,7 @@ namespace mongo {
     class OperationContext;
 
     struct TextStageParams {
-        TextStageParams(const FTSSpec& s) : spec(s) {}
+        TextStageParams(const FTSSpec& s) : spec(s), limit(0) {}
 
         // Text index descriptor.  IndexCatalog owns this.
         IndexDescriptor* index;
@@ -68,11 +68,28 @@ namespace mongo {
 
         // The text query.
         FTSQuery query;
+
+        // If not 0, only the 'limit' documents with the highest text scores are wanted. The stage
+        // can then stop reading the index once nothing left in it can score higher.
+        size_t limit;
     };
 
     /**
      * Implements a blocking stage that returns text search results.
      *
+     * With a limit, the stage returns just the best 'limit' documents. The index scans for the
+     * terms return keys in order of decreasing score, so they are read as one merged stream, taking
+     * the next key from the scan whose keys can still score highest. Every document is scored in
+     * full when it is first seen, and reading stops as soon as the sum of the scores of the last
+     * keys read from each scan, which bounds the score of any document not yet seen, is no better
+     * than the worst of the results kept.
+     *
+     * The index has a key for every term of a document, so rather than fetching and tokenizing
+     * each document read to find the ones with negated terms, the stage can read the keys for the
+     * negated terms and drop the documents they point to. It does so as long as that doesn't mean
+     * reading many more keys than there are documents to check. The documents left are still
+     * matched in full, as the index leaves out stop words which the matcher counts.
+     *
      * Prerequisites: None; is a leaf node.
      * Output type: LOC_AND_OBJ_UNOWNED.
      *
@@ -91,10 +108,13 @@ namespace mongo {
             // 2. Read the terms/scores from the text index.
             READING_TERMS,
 
-            // 3. Return results to our parent.
+            // 3. Read the negated terms from the text index, dropping the documents they are in.
+            READING_NEGATED_TERMS,
+
+            // 4. Return results to our parent.
             RETURNING_RESULTS,
 
-            // 4. Done.
+            // 5. Done.
             DONE,
         };
 
@@ -136,6 +156,29 @@ namespace mongo {
          */
         StageState readFromSubScanners(WorkingSetID* out);
 
+        /**
+         * Returns an index scan over the keys for 'term', from highest score to lowest.
+         */
+        PlanStage* newTermScan(const std::string& term);
+
+        /**
+         * Called once readFromSubScanners is done. Sets up the scans for the negated terms if
+         * those are to be looked up in the index, and moves to the next state.
+         */
+        StageState initNegatedTermScans();
+
+        /**
+         * Reads a key for a negated term and drops the document it points to. Gives up and leaves
+         * the rest to _ftsMatcher after reading more keys than there are documents to drop times
+         * internalQueryTextNegatedKeysPerCandidate.
+         */
+        StageState readNegatedTerms(WorkingSetID* out);
+
+        /**
+         * Moves on to returning results.
+         */
+        StageState finishNegatedTerms();
+
         /**
          * Helper called from readFromSubScanners to update aggregate score with a new-found (term,
          * score) pair for this document.  Also rejects documents that don't match this stage's
@@ -149,6 +192,40 @@ namespace mongo {
          */
         StageState returnResults(WorkingSetID* out);
 
+        /**
+         * Used in place of readFromSubScanners() when there is a limit. Reads the next key from
+         * the scan with the highest bound on the scores still to come, or moves on to returning
+         * results once no document that hasn't been seen could make it into them.
+         */
+        StageState readTopTerms(WorkingSetID* out);
+
+        /**
+         * Helper called from readTopTerms to fetch, filter and score a document the first time
+         * one of its keys is read, keeping it if it is among the best 'limit' documents so far.
+         */
+        StageState addTopCandidate(WorkingSetID wsid, WorkingSetID* out);
+
+        /**
+         * Used in place of returnResults() when there is a limit. Returns the documents kept by
+         * readTopTerms(), best first.
+         */
+        StageState returnTopResults(WorkingSetID* out);
+
+        /**
+         * Passes up a state other than ADVANCED or IS_EOF from one of our index scans.
+         */
+        StageState handleScannerState(StageState state, WorkingSetID id, WorkingSetID* out);
+
+        /**
+         * Returns the score in the text index key 'keyData'.
+         */
+        double getKeyScore(const BSONObj& keyData) const;
+
+        /**
+         * Returns the score the text index keys for 'obj' add up to for the terms of our query.
+         */
+        double scoreDocument(const BSONObj& obj) const;
+
         // transactional context for read locks. Not owned by us
         OperationContext* _txn;
 
@@ -181,6 +258,9 @@ namespace mongo {
         // If not Null, we use this rather than asking our child what to do next.
         WorkingSetID _idRetrying;
 
+        // Used in READING_NEGATED_TERMS. How many keys we read for negated terms before we give up.
+        size_t _negatedKeysBudget;
+
         // Map each buffered record id to this data.
         struct TextRecordData {
             TextRecordData() : wsid(WorkingSet::INVALID_ID), score(0.0) { }
@@ -194,6 +274,28 @@ namespace mongo {
         typedef unordered_map<RecordId, TextRecordData, RecordId::Hasher> ScoreMap;
         ScoreMap _scores;
         ScoreMap::const_iterator _scoreIterator;
+
+        // Used when there is a limit. Each of _scanners returns keys in order of decreasing score,
+        // so none of its keys still to be read can score more than the last one it returned.
+        std::vector<double> _scannerBounds;
+        std::vector<bool> _scannerDone;
+
+        struct ScoredResult {
+            ScoredResult(double s, WorkingSetID w) : score(s), wsid(w) { }
+
+            // Puts the lowest score on top of a priority_queue.
+            bool operator<(const ScoredResult& other) const { return score > other.score; }
+
+            double score;
+            WorkingSetID wsid;
+        };
+
+        // The best documents found so far by readTopTerms(), worst on top. The 'wsid' of their
+        // entries in _scores is set, so that they can be kept through an invalidation.
+        std::priority_queue<ScoredResult> _topResults;
+
+        // The contents of _topResults once reading is done, best last.
+        std::vector<ScoredResult> _topResultsToReturn;
     };
 
 } // namespace mongo
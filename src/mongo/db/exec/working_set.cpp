@@ -35,10 +35,23 @@ namespace mongo {
 
     using std::string;
 
+    namespace {
+        // Size of each chunk of the arena used by WorkingSet::getOwned().
+        const size_t kArenaChunkSize = 64 * 1024;
+
+        // Larger objects get a buffer of their own so that they don't waste the rest of a chunk.
+        const size_t kMaxArenaObjSize = 4 * 1024;
+
+        // The first byte of each chunk is left unused. No copy then starts at the beginning of its
+        // buffer, which is how BSONObj::isInSharedBuffer() tells it from an object with a buffer of
+        // its own.
+        const size_t kArenaChunkStart = 1;
+    } // namespace
+
     WorkingSet::MemberHolder::MemberHolder() : member(NULL) { }
     WorkingSet::MemberHolder::~MemberHolder() {}
 
-    WorkingSet::WorkingSet() : _freeList(INVALID_ID) { }
+    WorkingSet::WorkingSet() : _freeList(INVALID_ID), _arenaUsed(0) { }
 
     WorkingSet::~WorkingSet() {
         for (size_t i = 0; i < _data.size(); i++) {
@@ -55,10 +68,12 @@ namespace mongo {
             _data.resize(_data.size() + 1);
             _data.back().nextFreeOrSelf = id;
             _data.back().member = new WorkingSetMember();
+            _stats.membersCreated++;
             return id;
         }
 
         // Pop the head off the free list and return it.
+        _stats.membersRecycled++;
         WorkingSetID id = _freeList;
         _freeList = _data[id].nextFreeOrSelf;
         _data[id].nextFreeOrSelf = id; // set to self to mark as in-use
@@ -92,18 +107,48 @@ namespace mongo {
     }
 
     void WorkingSet::clear() {
-        for (size_t i = 0; i < _data.size(); i++) {
-            delete _data[i].member;
-        }
-        _data.clear();
-
-        // Since working set is now empty, the free list pointer should
-        // point to nothing.
+        // Rebuild the free list from the back so that the lowest ids are handed out first, as they
+        // would be by a new WorkingSet.
         _freeList = INVALID_ID;
+        for (size_t i = _data.size(); i-- > 0;) {
+            _data[i].member->clear();
+            _data[i].nextFreeOrSelf = _freeList;
+            _freeList = i;
+        }
 
         _flagged.clear();
     }
 
+    BSONObj WorkingSet::getOwned(const BSONObj& obj) {
+        if (obj.isOwned()) {
+            return obj;
+        }
+
+        const size_t size = obj.objsize();
+        if (size > kMaxArenaObjSize) {
+            _stats.heapCopies++;
+            return obj.getOwned();
+        }
+
+        // Once nothing else references the current chunk, all of the objects carved out of it are
+        // gone and it can be reused from the start.
+        if (_arenaUsed > kArenaChunkStart && !_arena.isShared()) {
+            _arenaUsed = kArenaChunkStart;
+        }
+
+        if (!_arena.get() || _arenaUsed + size > kArenaChunkSize) {
+            _arena = SharedBuffer::allocate(kArenaChunkSize);
+            _arenaUsed = kArenaChunkStart;
+            _stats.arenaChunks++;
+        }
+
+        char* const dest = _arena.get() + _arenaUsed;
+        memcpy(dest, obj.objdata(), size);
+        _arenaUsed += size;
+        _stats.arenaCopies++;
+        return BSONObj(_arena, dest);
+    }
+
     //
     // Iteration
     //
@@ -185,6 +230,8 @@ namespace mongo {
         keyData.clear();
         obj.reset();
         state = WorkingSetMember::INVALID;
+        isSuspicious = false;
+        _fetcher.reset();
     }
 
     bool WorkingSetMember::hasLoc() const {
@@ -277,4 +324,16 @@ namespace mongo {
         return memUsage;
     }
 
+    void WorkingSetMember::copyOutOfArena() {
+        if (hasObj() && obj.value().isInSharedBuffer()) {
+            obj.setValue(obj.value().copy());
+        }
+
+        for (size_t i = 0; i < keyData.size(); ++i) {
+            if (keyData[i].keyData.isInSharedBuffer()) {
+                keyData[i].keyData = keyData[i].keyData.copy();
+            }
+        }
+    }
+
 }  // namespace mongo
@@ -36,6 +36,7 @@
 #include "mongo/db/record_id.h"
 #include "mongo/db/storage/snapshot.h"
 #include "mongo/platform/unordered_set.h"
+#include "mongo/util/shared_buffer.h"
 
 namespace mongo {
 
@@ -45,6 +46,30 @@ namespace mongo {
 
     typedef size_t WorkingSetID;
 
+    /**
+     * Counts the allocations a WorkingSet made, or avoided, over its lifetime.
+     */
+    struct WorkingSetStats {
+        WorkingSetStats() : membersCreated(0),
+                            membersRecycled(0),
+                            arenaCopies(0),
+                            arenaChunks(0),
+                            heapCopies(0) { }
+
+        // Calls to allocate() that had to construct a new WorkingSetMember.
+        size_t membersCreated;
+
+        // Calls to allocate() that were served from the free list.
+        size_t membersRecycled;
+
+        // Objects that getOwned() copied into the arena, and the chunks allocated to hold them.
+        size_t arenaCopies;
+        size_t arenaChunks;
+
+        // Objects too large for the arena, which getOwned() copied into a buffer of their own.
+        size_t heapCopies;
+    };
+
     /**
      * All data in use by a query.  Data is passed through the stage tree by referencing the ID of
      * an element of the working set.  Stages can add elements to the working set, delete elements
@@ -105,10 +130,23 @@ namespace mongo {
         const unordered_set<WorkingSetID>& getFlagged() const;
 
         /**
-         * Removes and deallocates all members of this working set.
+         * Frees all members of this working set. The members are kept on the free list to be
+         * reused by later calls to allocate().
          */
         void clear();
 
+        /**
+         * Returns an owned copy of 'obj', or 'obj' itself if it is already owned.
+         *
+         * Small objects are copied into an arena shared by this working set instead of a buffer of
+         * their own. The arena is refcounted like any owned BSONObj, so the copy may outlive the
+         * WorkingSet, and the arena's memory is rewound for reuse once no copies remain, which is
+         * typically between batches.
+         */
+        BSONObj getOwned(const BSONObj& obj);
+
+        const WorkingSetStats& getStats() const { return _stats; }
+
         //
         // Iteration
         //
@@ -184,6 +222,13 @@ namespace mongo {
 
         // An insert-only set of WorkingSetIDs that have been flagged for review.
         unordered_set<WorkingSetID> _flagged;
+
+        // The arena chunk that getOwned() is currently carving objects out of, and the number of
+        // bytes of it in use.
+        SharedBuffer _arena;
+        size_t _arenaUsed;
+
+        WorkingSetStats _stats;
     };
 
     /**
@@ -337,6 +382,14 @@ namespace mongo {
          */
         size_t getMemUsage() const;
 
+        /**
+         * Gives the object and index keys of this member buffers of their own if they were copied
+         * into a WorkingSet arena. A stage that keeps members past the current batch calls this,
+         * so that one small object doesn't hold on to a whole arena chunk, and so that its memory
+         * use is what getMemUsage() says.
+         */
+        void copyOutOfArena();
+
     private:
         boost::scoped_ptr<WorkingSetComputedData> _computed[WSM_COMPUTED_NUM_TYPES];
 
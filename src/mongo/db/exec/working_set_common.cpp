@@ -67,7 +67,7 @@ namespace mongo {
             }
             else if (it->state == WorkingSetMember::LOC_AND_UNOWNED_OBJ) {
                 // We already have the data so convert directly to owned state.
-                it->obj.setValue(it->obj.value().getOwned());
+                it->obj.setValue(workingSet->getOwned(it->obj.value()));
                 it->state = WorkingSetMember::LOC_AND_OWNED_OBJ;
             }
         }
@@ -245,4 +245,151 @@ namespace {
         ASSERT_EQ(counter, 1);
     }
 
+    //
+    // Member recycling and arena tests
+    //
+
+    TEST(WorkingSetRecyclingTest, ClearRecyclesMembers) {
+        WorkingSet ws;
+
+        WorkingSetID id1 = ws.allocate();
+        WorkingSetID id2 = ws.allocate();
+        ws.get(id1)->state = WorkingSetMember::LOC_AND_IDX;
+        ws.get(id1)->isSuspicious = true;
+        ws.get(id2)->state = WorkingSetMember::OWNED_OBJ;
+        ws.flagForReview(id2);
+        ASSERT_EQUALS(2U, ws.getStats().membersCreated);
+
+        ws.clear();
+        ASSERT(ws.begin() == ws.end());
+        ASSERT(ws.getFlagged().empty());
+
+        // The members are handed out again, lowest id first, in their initial state.
+        ASSERT_EQUALS(id1, ws.allocate());
+        ASSERT_EQUALS(id2, ws.allocate());
+        ASSERT_EQUALS(WorkingSetMember::INVALID, ws.get(id1)->state);
+        ASSERT_FALSE(ws.get(id1)->isSuspicious);
+        ASSERT_EQUALS(2U, ws.getStats().membersCreated);
+        ASSERT_EQUALS(2U, ws.getStats().membersRecycled);
+
+        ws.free(id2);
+        ASSERT_EQUALS(id2, ws.allocate());
+        ws.allocate();
+        ASSERT_EQUALS(3U, ws.getStats().membersCreated);
+        ASSERT_EQUALS(3U, ws.getStats().membersRecycled);
+    }
+
+    TEST(WorkingSetArenaTest, OwnedObjectsAreNotCopied) {
+        WorkingSet ws;
+
+        BSONObj owned = BSON("a" << 1);
+        BSONObj out = ws.getOwned(owned);
+        ASSERT_EQUALS(owned.objdata(), out.objdata());
+        ASSERT_EQUALS(0U, ws.getStats().arenaCopies);
+        ASSERT_EQUALS(0U, ws.getStats().heapCopies);
+    }
+
+    TEST(WorkingSetArenaTest, SmallObjectsShareAChunk) {
+        WorkingSet ws;
+
+        BSONObj first = BSON("a" << 1);
+        BSONObj second = BSON("b" << "two");
+        BSONObj firstCopy = ws.getOwned(BSONObj(first.objdata()));
+        BSONObj secondCopy = ws.getOwned(BSONObj(second.objdata()));
+
+        ASSERT(firstCopy.isOwned());
+        ASSERT(secondCopy.isOwned());
+        ASSERT_NOT_EQUALS(first.objdata(), firstCopy.objdata());
+        ASSERT_EQUALS(first, firstCopy);
+        ASSERT_EQUALS(second, secondCopy);
+        ASSERT_EQUALS(firstCopy.objdata() + firstCopy.objsize(), secondCopy.objdata());
+        ASSERT_EQUALS(2U, ws.getStats().arenaCopies);
+        ASSERT_EQUALS(1U, ws.getStats().arenaChunks);
+    }
+
+    TEST(WorkingSetArenaTest, ChunkIsRewoundOnceUnreferenced) {
+        WorkingSet ws;
+
+        BSONObj obj = BSON("a" << 1);
+        const char* firstData;
+        {
+            BSONObj copy = ws.getOwned(BSONObj(obj.objdata()));
+            firstData = copy.objdata();
+
+            // While a copy is alive, later copies go after it.
+            BSONObj other = ws.getOwned(BSONObj(obj.objdata()));
+            ASSERT_NOT_EQUALS(firstData, other.objdata());
+        }
+
+        // Both copies are gone, so the chunk is reused from the start.
+        BSONObj copy = ws.getOwned(BSONObj(obj.objdata()));
+        ASSERT_EQUALS(firstData, copy.objdata());
+        ASSERT_EQUALS(obj, copy);
+        ASSERT_EQUALS(1U, ws.getStats().arenaChunks);
+    }
+
+    TEST(WorkingSetArenaTest, FullChunkIsReplacedWhileReferenced) {
+        WorkingSet ws;
+
+        BSONObj obj = BSON("a" << string(1000, 'x'));
+        std::vector<BSONObj> copies;
+        for (int i = 0; i < 200; i++) {
+            copies.push_back(ws.getOwned(BSONObj(obj.objdata())));
+        }
+        ASSERT_GREATER_THAN(ws.getStats().arenaChunks, 1U);
+        for (size_t i = 0; i < copies.size(); i++) {
+            ASSERT_EQUALS(obj, copies[i]);
+        }
+    }
+
+    TEST(WorkingSetArenaTest, LargeObjectsGetTheirOwnBuffer) {
+        WorkingSet ws;
+
+        BSONObj big = BSON("a" << string(16 * 1024, 'x'));
+        BSONObj copy = ws.getOwned(BSONObj(big.objdata()));
+        ASSERT(copy.isOwned());
+        ASSERT_EQUALS(big, copy);
+        ASSERT_EQUALS(1U, ws.getStats().heapCopies);
+        ASSERT_EQUALS(0U, ws.getStats().arenaCopies);
+    }
+
+    TEST(WorkingSetArenaTest, CopiesOutliveTheWorkingSet) {
+        BSONObj obj = BSON("a" << 1 << "b" << "c");
+        BSONObj copy;
+        {
+            WorkingSet ws;
+            copy = ws.getOwned(BSONObj(obj.objdata()));
+        }
+        ASSERT_EQUALS(obj, copy);
+    }
+
+    TEST(WorkingSetArenaTest, KeptMembersDoNotPinTheArena) {
+        WorkingSet ws;
+
+        BSONObj obj = BSON("a" << 1);
+        BSONObj key = BSON("" << 1);
+        const char* firstData = ws.getOwned(BSONObj(obj.objdata())).objdata();
+
+        WorkingSetID id = ws.allocate();
+        WorkingSetMember* member = ws.get(id);
+        member->keyData.push_back(IndexKeyDatum(BSON("a" << 1),
+                                                ws.getOwned(BSONObj(key.objdata())),
+                                                NULL));
+        member->obj = Snapshotted<BSONObj>(SnapshotId(), ws.getOwned(BSONObj(obj.objdata())));
+        member->state = WorkingSetMember::OWNED_OBJ;
+        ASSERT(member->keyData[0].keyData.isInSharedBuffer());
+        ASSERT(member->obj.value().isInSharedBuffer());
+
+        member->copyOutOfArena();
+        ASSERT(!member->keyData[0].keyData.isInSharedBuffer());
+        ASSERT(!member->obj.value().isInSharedBuffer());
+        ASSERT_EQUALS(key, member->keyData[0].keyData);
+        ASSERT_EQUALS(obj, member->obj.value());
+        ASSERT_EQUALS(size_t(key.objsize() + obj.objsize()), member->getMemUsage());
+
+        // The member no longer references the chunk, so it is reused from the start.
+        ASSERT_EQUALS(firstData, ws.getOwned(BSONObj(obj.objdata())).objdata());
+        ASSERT_EQUALS(1U, ws.getStats().arenaChunks);
+    }
+
 }  // namespace
@@ -67,13 +67,13 @@ namespace mongo {
         BtreeExternalSortComparison(const BSONObj& ordering, int version)
             : _ordering(Ordering::make(ordering)),
               _version(version) {
-            invariant(version == 1 || version == 0);
+            invariant(version == 2 || version == 1 || version == 0);
         }
 
         typedef std::pair<BSONObj, RecordId> Data;
 
         int operator() (const Data& l, const Data& r) const {
-            int x = (_version == 1
+            int x = (_version != 0
                         ? l.first.woCompare(r.first, _ordering, /*considerfieldname*/false)
                         : oldCompare(l.first, r.first, _ordering));
             if (x) { return x; }
@@ -89,7 +89,9 @@ namespace mongo {
         : _btreeState(btreeState),
           _descriptor(btreeState->descriptor()),
           _newInterface(btree) {
-        verify(0 == _descriptor->version() || 1 == _descriptor->version());
+        verify(0 == _descriptor->version()
+               || 1 == _descriptor->version()
+               || 2 == _descriptor->version());
     }
 
     bool IndexAccessMethod::ignoreKeyTooLong(OperationContext *txn) {
@@ -327,16 +329,21 @@ namespace mongo {
         return Status::OK();
     }
 
-    std::unique_ptr<IndexAccessMethod::BulkBuilder> IndexAccessMethod::initiateBulk() {
+    std::unique_ptr<IndexAccessMethod::BulkBuilder> IndexAccessMethod::initiateBulk(
+            size_t maxMemoryUsageBytes) {
 
-        return std::unique_ptr<BulkBuilder>(new BulkBuilder(this, _descriptor));
+        return std::unique_ptr<BulkBuilder>(new BulkBuilder(this, _descriptor,
+                                                            maxMemoryUsageBytes));
     }
 
     IndexAccessMethod::BulkBuilder::BulkBuilder(const IndexAccessMethod* index,
-                                                const IndexDescriptor* descriptor)
+                                                const IndexDescriptor* descriptor,
+                                                size_t maxMemoryUsageBytes)
             : _sorter(Sorter::make(SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
                                                 .ExtSortAllowed()
-                                                .MaxMemoryUsageBytes(100*1024*1024),
+                                                .MaxMemoryUsageBytes(maxMemoryUsageBytes)
+                                                .BackgroundSpill()
+                                                .ReadAhead(),
                                    BtreeExternalSortComparison(descriptor->keyPattern(),
                                                                descriptor->version())))
             , _real(index) {
@@ -364,6 +371,17 @@ namespace mongo {
         return Status::OK();
     }
 
+    void IndexAccessMethod::BulkBuilder::absorb(std::unique_ptr<BulkBuilder> other) {
+        invariant(other->_real == _real);
+
+        _absorbedSorters.push_back(std::move(other->_sorter));
+        for (auto&& sorter : other->_absorbedSorters) {
+            _absorbedSorters.push_back(std::move(sorter));
+        }
+
+        _keysInserted += other->_keysInserted;
+        _isMultiKey = _isMultiKey || other->_isMultiKey;
+    }
 
     Status IndexAccessMethod::commitBulk(OperationContext* txn,
                                          std::unique_ptr<BulkBuilder> bulk,
@@ -375,6 +393,22 @@ namespace mongo {
 
         std::unique_ptr<BulkBuilder::Sorter::Iterator> i(bulk->_sorter->done());
 
+        if (!bulk->_absorbedSorters.empty()) {
+            // Keys gathered by several builders are each sorted on their own, so stream them
+            // through a merge to hand them to the btree builder in order.
+            std::vector<boost::shared_ptr<BulkBuilder::Sorter::Iterator>> iters;
+            iters.push_back(boost::shared_ptr<BulkBuilder::Sorter::Iterator>(i.release()));
+            for (auto&& sorter : bulk->_absorbedSorters) {
+                iters.push_back(boost::shared_ptr<BulkBuilder::Sorter::Iterator>(sorter->done()));
+            }
+
+            i.reset(BulkBuilder::Sorter::Iterator::merge(
+                        iters,
+                        SortOptions(),
+                        BtreeExternalSortComparison(_descriptor->keyPattern(),
+                                                    _descriptor->version())));
+        }
+
         ProgressMeterHolder pm(*txn->setMessage("Index Bulk Build: (2/3) btree bottom up",
                                                 "Index: (2/3) BTree Bottom Up Progress",
                                                 bulk->_keysInserted,
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/db/index/index_descriptor.h"
@@ -193,14 +194,24 @@ namespace mongo {
                           const InsertDeleteOptions& options,
                           int64_t* numInserted);
 
+            /**
+             * Takes over the keys collected by 'other', which must have been initiated on the same
+             * index. They are merged with this builder's own keys by commitBulk(). This is how the
+             * per-thread builders of a parallel index build are combined.
+             */
+            void absorb(std::unique_ptr<BulkBuilder> other);
+
         private:
             friend class IndexAccessMethod;
 
             using Sorter = mongo::Sorter<BSONObj, RecordId>;
 
-            BulkBuilder(const IndexAccessMethod* index, const IndexDescriptor* descriptor);
+            BulkBuilder(const IndexAccessMethod* index,
+                        const IndexDescriptor* descriptor,
+                        size_t maxMemoryUsageBytes);
 
             std::unique_ptr<Sorter> _sorter;
+            std::vector<std::unique_ptr<Sorter>> _absorbedSorters;
             const IndexAccessMethod* _real;
             int64_t _keysInserted = 0;
             bool _isMultiKey = false;
@@ -212,8 +223,10 @@ namespace mongo {
          * This can return NULL, meaning bulk mode is not available.
          *
          * It is only legal to initiate bulk when the index is new and empty.
+         *
+         * The BulkBuilder spills its keys to disk once they use more than 'maxMemoryUsageBytes'.
          */
-        std::unique_ptr<BulkBuilder> initiateBulk();
+        std::unique_ptr<BulkBuilder> initiateBulk(size_t maxMemoryUsageBytes = 100 * 1024 * 1024);
 
         /**
          * Call this when you are ready to finish your bulk work.
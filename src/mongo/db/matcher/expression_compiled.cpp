@@ -0,0 +1,353 @@
+// expression_compiled.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/expression_compiled.h"
+
+#include <cmath>
+
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecCompileFilters, bool, true);
+
+    namespace {
+
+        template <typename T>
+        int compareValues(T lhs, T rhs) {
+            if (lhs < rhs) return -1;
+            return lhs == rhs ? 0 : 1;
+        }
+
+        bool satisfies(MatchExpression::MatchType op, int cmp) {
+            switch (op) {
+            case MatchExpression::LT: return cmp < 0;
+            case MatchExpression::LTE: return cmp <= 0;
+            case MatchExpression::EQ: return cmp == 0;
+            case MatchExpression::GT: return cmp > 0;
+            case MatchExpression::GTE: return cmp >= 0;
+            default: invariant(false);
+            }
+        }
+
+        /**
+         * Appends the conjuncts of 'expr' to 'out', looking through nested $ands.
+         */
+        void flattenConjuncts(const MatchExpression* expr,
+                              std::vector<const MatchExpression*>* out) {
+            if (expr->matchType() != MatchExpression::AND) {
+                out->push_back(expr);
+                return;
+            }
+
+            for (size_t i = 0; i < expr->numChildren(); i++) {
+                flattenConjuncts(expr->getChild(i), out);
+            }
+        }
+
+    } // namespace
+
+    CompiledMatchExpression::CompiledMatchExpression() : _numSlots(0), _numCompiled(0) {
+        _nodes.push_back(PathNode(StringData()));
+    }
+
+    // static
+    std::unique_ptr<CompiledMatchExpression> CompiledMatchExpression::compile(
+            const MatchExpression* root) {
+        std::unique_ptr<CompiledMatchExpression> compiled(new CompiledMatchExpression());
+
+        std::vector<const MatchExpression*> conjuncts;
+        flattenConjuncts(root, &conjuncts);
+
+        // The compiled leaves are cheap, so they run ahead of the conjuncts left to the tree.
+        std::vector<Instruction> trees;
+        for (size_t i = 0; i < conjuncts.size(); i++) {
+            Instruction instruction = Instruction();
+            if (compiled->_compileLeaf(conjuncts[i], &instruction)) {
+                compiled->_program.push_back(instruction);
+                compiled->_numCompiled++;
+            }
+            else {
+                instruction.kernel = kTree;
+                instruction.expr = conjuncts[i];
+                trees.push_back(instruction);
+            }
+        }
+
+        if (!compiled->_numCompiled) {
+            return std::unique_ptr<CompiledMatchExpression>();
+        }
+
+        compiled->_program.insert(compiled->_program.end(), trees.begin(), trees.end());
+        return compiled;
+    }
+
+    bool CompiledMatchExpression::_compileLeaf(const MatchExpression* expr, Instruction* out) {
+        // These are the leaves that match a non-array element exactly when matchesSingleElement()
+        // says so. The others either treat arrays specially even when they aren't traversed, or
+        // aren't about a single path at all.
+        switch (expr->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+        case MatchExpression::EXISTS:
+        case MatchExpression::MATCH_IN:
+            break;
+        default:
+            return false;
+        }
+
+        // An empty path has lookup rules of its own.
+        if (expr->path().empty()) {
+            return false;
+        }
+
+        const int slot = _slotForPath(expr->path());
+        if (slot < 0) {
+            return false;
+        }
+
+        out->kernel = kGenericLeaf;
+        out->op = expr->matchType();
+        out->expr = expr;
+        out->slot = slot;
+
+        switch (expr->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::GT:
+        case MatchExpression::GTE: {
+            const BSONElement& rhs = static_cast<const ComparisonMatchExpression*>(expr)->getData();
+            switch (rhs.type()) {
+            case NumberInt:
+            case NumberLong:
+                out->kernel = kIntegral;
+                out->integralOperand = rhs.numberLong();
+                break;
+            case NumberDouble:
+                if (!std::isnan(rhs._numberDouble())) {
+                    out->kernel = kDouble;
+                    out->doubleOperand = rhs._numberDouble();
+                }
+                break;
+            case String:
+                out->kernel = kString;
+                out->stringOperand = rhs.valueStringData();
+                break;
+            default:
+                break;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        return true;
+    }
+
+    int CompiledMatchExpression::_slotForPath(StringData path) {
+        size_t node = 0;
+        while (true) {
+            const size_t dot = path.find('.');
+            const StringData part = (dot == std::string::npos) ? path : path.substr(0, dot);
+
+            size_t child = 0;
+            const std::vector<size_t>& children = _nodes[node].children;
+            for (size_t i = 0; i < children.size() && !child; i++) {
+                if (_nodes[children[i]].name == part) {
+                    child = children[i];
+                }
+            }
+
+            if (!child) {
+                if (_nodes.size() >= kMaxPathNodes) {
+                    return -1;
+                }
+                child = _nodes.size();
+                _nodes.push_back(PathNode(part));
+                _nodes[node].children.push_back(child);
+            }
+
+            node = child;
+            if (dot == std::string::npos) {
+                break;
+            }
+            path = path.substr(dot + 1);
+        }
+
+        if (_nodes[node].slot < 0) {
+            if (_numSlots >= kMaxSlots) {
+                return -1;
+            }
+            _nodes[node].slot = _numSlots++;
+        }
+        return _nodes[node].slot;
+    }
+
+    bool CompiledMatchExpression::matchesBSON(const BSONObj& doc) const {
+        // Elements for paths that aren't found stay EOO, which is what the tree's path iterator
+        // produces for them too.
+        BSONElement slots[kMaxSlots];
+        _resolve(doc, 0, slots);
+
+        for (size_t i = 0; i < _program.size(); i++) {
+            if (!_run(_program[i], slots, doc)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void CompiledMatchExpression::_resolve(const BSONObj& obj,
+                                           size_t node,
+                                           BSONElement* slots) const {
+        const std::vector<size_t>& children = _nodes[node].children;
+        dassert(children.size() < 64);
+
+        // Only the first field with a given name counts, as with BSONObj::getField(). Stop as
+        // soon as every child has been found.
+        uint64_t found = 0;
+        size_t remaining = children.size();
+
+        BSONObjIterator it(obj);
+        while (remaining && it.more()) {
+            const BSONElement e = it.next();
+            const StringData name = e.fieldNameStringData();
+
+            for (size_t i = 0; i < children.size(); i++) {
+                const PathNode& child = _nodes[children[i]];
+                if ((found & (1ULL << i)) || child.name != name) {
+                    continue;
+                }
+
+                found |= 1ULL << i;
+                remaining--;
+
+                if (child.slot >= 0) {
+                    slots[child.slot] = e;
+                }
+
+                if (!child.children.empty()) {
+                    if (e.type() == Object) {
+                        _resolve(e.embeddedObject(), children[i], slots);
+                    }
+                    else if (e.type() == Array) {
+                        _resolveToArray(e, children[i], slots);
+                    }
+                    // Otherwise the longer paths can't be followed and stay missing.
+                }
+                break;
+            }
+        }
+    }
+
+    void CompiledMatchExpression::_resolveToArray(const BSONElement& array,
+                                                  size_t node,
+                                                  BSONElement* slots) const {
+        const std::vector<size_t>& children = _nodes[node].children;
+        for (size_t i = 0; i < children.size(); i++) {
+            const PathNode& child = _nodes[children[i]];
+            if (child.slot >= 0) {
+                slots[child.slot] = array;
+            }
+            _resolveToArray(array, children[i], slots);
+        }
+    }
+
+    bool CompiledMatchExpression::_run(const Instruction& instruction,
+                                       const BSONElement* slots,
+                                       const BSONObj& doc) const {
+        if (instruction.kernel == kTree) {
+            return instruction.expr->matchesBSON(doc);
+        }
+
+        const BSONElement& e = slots[instruction.slot];
+
+        // The path ran into an array, either at its end or on the way there. The tree's path
+        // iterator knows how to look inside arrays, so leave this leaf to it.
+        if (e.type() == Array) {
+            return instruction.expr->matchesBSON(doc);
+        }
+
+        switch (instruction.kernel) {
+        case kIntegral:
+            if (e.type() == NumberInt) {
+                return satisfies(instruction.op,
+                                 compareValues<long long>(e._numberInt(),
+                                                          instruction.integralOperand));
+            }
+            if (e.type() == NumberLong) {
+                return satisfies(instruction.op,
+                                 compareValues(e._numberLong(), instruction.integralOperand));
+            }
+            break;
+
+        case kDouble:
+            if (e.type() == NumberDouble && !std::isnan(e._numberDouble())) {
+                return satisfies(instruction.op,
+                                 compareValues(e._numberDouble(), instruction.doubleOperand));
+            }
+            if (e.type() == NumberInt) {
+                // Every int is exactly representable as a double.
+                return satisfies(instruction.op,
+                                 compareValues<double>(e._numberInt(),
+                                                       instruction.doubleOperand));
+            }
+            break;
+
+        case kString:
+            if (e.type() == String) {
+                return satisfies(instruction.op,
+                                 e.valueStringData().compare(instruction.stringOperand));
+            }
+            break;
+
+        case kGenericLeaf:
+            break;
+
+        case kTree:
+            invariant(false);
+        }
+
+        // Missing fields, mixed types, NaNs and every other leaf take the general route.
+        return instruction.expr->matchesSingleElement(e);
+    }
+
+}  // namespace mongo
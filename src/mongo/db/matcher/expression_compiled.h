@@ -0,0 +1,155 @@
+// expression_compiled.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+    // Should collection scans, fetches and Matcher run their filters as a CompiledMatchExpression?
+    extern bool internalQueryExecCompileFilters;
+
+    /**
+     * A MatchExpression tree flattened into a program that is cheaper to run against BSON
+     * documents than the tree itself.
+     *
+     * The conjuncts of a top-level $and are compiled into instructions. Each field path that a
+     * compiled leaf refers to is resolved in a single pass over the document before any instruction
+     * runs, instead of once per leaf, and comparisons against numbers and strings use kernels
+     * specialized for the operand's type instead of the generic element comparison. Conjuncts that
+     * aren't compiled, and any leaf whose path runs into an array, are evaluated by the tree, so
+     * matchesBSON() always agrees with MatchExpression::matchesBSON().
+     *
+     * The program points into the tree it was compiled from, which must outlive it.
+     */
+    class CompiledMatchExpression {
+        MONGO_DISALLOW_COPYING(CompiledMatchExpression);
+    public:
+        /**
+         * Returns NULL if no part of 'root' could be compiled, in which case callers should just
+         * use 'root' itself.
+         */
+        static std::unique_ptr<CompiledMatchExpression> compile(const MatchExpression* root);
+
+        /**
+         * Equivalent to root->matchesBSON(doc) for the 'root' this was compiled from, except that
+         * no MatchDetails are available.
+         */
+        bool matchesBSON(const BSONObj& doc) const;
+
+        /**
+         * The number of conjuncts that were compiled rather than left to the tree.
+         */
+        size_t numCompiled() const { return _numCompiled; }
+
+    private:
+        // Limits that let the per-document state live on the stack.
+        static const size_t kMaxSlots = 32;
+        static const size_t kMaxPathNodes = 64;
+
+        enum Kernel {
+            // Compare against a NumberInt or NumberLong operand.
+            kIntegral,
+
+            // Compare against a NumberDouble operand that isn't NaN.
+            kDouble,
+
+            // Compare against a String operand.
+            kString,
+
+            // Any other leaf; calls MatchExpression::matchesSingleElement().
+            kGenericLeaf,
+
+            // A conjunct that isn't compiled; calls MatchExpression::matchesBSON().
+            kTree,
+        };
+
+        struct Instruction {
+            Kernel kernel;
+            MatchExpression::MatchType op;
+            const MatchExpression* expr;
+
+            // Index of the resolved element for the expression's path. Unused by kTree.
+            size_t slot;
+
+            // The operand, unpacked according to 'kernel'.
+            long long integralOperand;
+            double doubleOperand;
+            StringData stringOperand;
+        };
+
+        /**
+         * One component of one or more field paths. Paths that share a prefix share the nodes for
+         * it, so the referenced fields of a subdocument are all found in one scan of it.
+         */
+        struct PathNode {
+            explicit PathNode(StringData partName) : name(partName.toString()), slot(-1) { }
+
+            std::string name;
+
+            // The slot filled with the element found at this node, or -1 if no path ends here.
+            int slot;
+
+            // Indexes into _nodes.
+            std::vector<size_t> children;
+        };
+
+        CompiledMatchExpression();
+
+        bool _compileLeaf(const MatchExpression* expr, Instruction* out);
+
+        /**
+         * Returns the slot for 'path', adding nodes for it as needed, or -1 if there isn't room.
+         */
+        int _slotForPath(StringData path);
+
+        void _resolve(const BSONObj& obj, size_t node, BSONElement* slots) const;
+        void _resolveToArray(const BSONElement& array, size_t node, BSONElement* slots) const;
+
+        bool _run(const Instruction& instruction,
+                  const BSONElement* slots,
+                  const BSONObj& doc) const;
+
+        // _nodes[0] is the root, which stands for the document itself.
+        std::vector<PathNode> _nodes;
+        size_t _numSlots;
+
+        std::vector<Instruction> _program;
+        size_t _numCompiled;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,202 @@
+// expression_compiled_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/** Unit tests for CompiledMatchExpression, checking it against the MatchExpression tree. */
+
+#include "mongo/unittest/unittest.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_compiled.h"
+#include "mongo/db/matcher/expression_parser.h"
+
+namespace mongo {
+
+    namespace {
+
+        MatchExpression* parse(const BSONObj& query) {
+            StatusWithMatchExpression result = MatchExpressionParser::parse(query);
+            ASSERT_OK(result.getStatus());
+            return result.getValue();
+        }
+
+        /**
+         * Checks that the compiled form of 'query' agrees with the tree on every document.
+         */
+        void assertAgrees(const BSONObj& query, const std::vector<BSONObj>& docs) {
+            boost::scoped_ptr<MatchExpression> expr(parse(query));
+            std::unique_ptr<CompiledMatchExpression> compiled =
+                CompiledMatchExpression::compile(expr.get());
+            ASSERT(compiled);
+
+            for (size_t i = 0; i < docs.size(); i++) {
+                if (expr->matchesBSON(docs[i]) != compiled->matchesBSON(docs[i])) {
+                    FAIL(str::stream() << "query " << query << " on " << docs[i]
+                                       << " tree: " << expr->matchesBSON(docs[i]));
+                }
+            }
+        }
+
+        std::vector<BSONObj> documents() {
+            const char* json[] = {
+                "{}",
+                "{a: 5}",
+                "{a: 5.5}",
+                "{a: NumberLong(5)}",
+                "{a: -0.0}",
+                "{a: NaN}",
+                "{a: null}",
+                "{a: 'abc'}",
+                "{a: 'ab'}",
+                "{a: {x: 1, y: 'foo', z: 2.5}}",
+                "{a: {x: 7, y: 'bar', z: 20}, b: true}",
+                "{a: {x: null}}",
+                "{a: {y: 'foo'}, a: {x: 100}}",
+                "{a: 1, a: 9}",
+                "{a: [1, 5, 9]}",
+                "{a: [[5]]}",
+                "{a: []}",
+                "{a: [{x: 1}, {x: 10}]}",
+                "{a: {x: [3, 8]}}",
+                "{a: 5, b: {c: {d: 'foo'}}}",
+                "{b: {c: [{d: 'foo'}]}}",
+                "{b: {c: 5}}",
+                "{a: {'0': 5}}",
+                "{a: {$minKey: 1}}",
+                "{a: {$maxKey: 1}}",
+                "{a: ObjectId('000000000000000000000000')}",
+            };
+
+            std::vector<BSONObj> docs;
+            for (size_t i = 0; i < sizeof(json) / sizeof(json[0]); i++) {
+                docs.push_back(fromjson(json[i]));
+            }
+
+            // Strings with NUL bytes can't be written in JSON.
+            docs.push_back(BSON("a" << StringData("ab\0c", StringData::LiteralTag())));
+            docs.push_back(BSON("a" << 2147483648LL));
+            return docs;
+        }
+
+    } // namespace
+
+    TEST(CompiledMatchExpression, Comparisons) {
+        const std::vector<BSONObj> docs = documents();
+        const char* ops[] = {"$lt", "$lte", "$eq", "$gt", "$gte"};
+        for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+            assertAgrees(BSON("a" << BSON(ops[i] << 5)), docs);
+            assertAgrees(BSON("a" << BSON(ops[i] << 5LL)), docs);
+            assertAgrees(BSON("a" << BSON(ops[i] << 5.0)), docs);
+            assertAgrees(BSON("a" << BSON(ops[i] << 5.5)), docs);
+            assertAgrees(BSON("a" << BSON(ops[i] << 0.0)), docs);
+            assertAgrees(BSON("a" << BSON(ops[i] << std::nan(""))), docs);
+            assertAgrees(BSON("a" << BSON(ops[i] << 2147483648LL)), docs);
+            assertAgrees(BSON("a" << BSON(ops[i] << "ab")), docs);
+            assertAgrees(BSON("a" << BSON(ops[i] << StringData("ab\0", StringData::LiteralTag()))),
+                         docs);
+            assertAgrees(BSON("a" << BSON(ops[i] << BSONNULL)), docs);
+            assertAgrees(BSON("a.x" << BSON(ops[i] << 7)), docs);
+            assertAgrees(BSON("a.0" << BSON(ops[i] << 5)), docs);
+            assertAgrees(BSON("b.c.d" << BSON(ops[i] << "foo")), docs);
+        }
+    }
+
+    TEST(CompiledMatchExpression, OtherLeaves) {
+        const std::vector<BSONObj> docs = documents();
+        assertAgrees(fromjson("{a: {$exists: true}}"), docs);
+        assertAgrees(fromjson("{'a.x': {$exists: true}}"), docs);
+        assertAgrees(fromjson("{a: {$in: [5, 'abc', null]}}"), docs);
+        assertAgrees(fromjson("{'a.y': {$in: ['foo', 'bar']}}"), docs);
+        assertAgrees(fromjson("{a: {$mod: [2, 1]}}"), docs);
+        assertAgrees(fromjson("{a: /^ab/}"), docs);
+        assertAgrees(fromjson("{a: [1, 5, 9]}"), docs);
+        assertAgrees(fromjson("{a: {x: 1, y: 'foo', z: 2.5}}"), docs);
+    }
+
+    TEST(CompiledMatchExpression, ConjunctionsOverOneSubdocument) {
+        const std::vector<BSONObj> docs = documents();
+        assertAgrees(fromjson("{'a.x': {$gte: 1}, 'a.y': 'foo', 'a.z': {$lt: 10}}"), docs);
+        assertAgrees(fromjson("{'a.x': {$gt: 0, $lt: 50}, a: {$exists: true}}"), docs);
+        assertAgrees(fromjson("{$and: [{a: {$gte: 1}}, {$and: [{a: {$lte: 9}}]}]}"), docs);
+        assertAgrees(fromjson("{a: 5, 'b.c.d': 'foo'}"), docs);
+        assertAgrees(fromjson("{a: null, b: null}"), docs);
+    }
+
+    TEST(CompiledMatchExpression, MixedWithTreeConjuncts) {
+        const std::vector<BSONObj> docs = documents();
+        assertAgrees(fromjson("{'a.x': {$gt: 0}, $or: [{b: true}, {'a.y': 'foo'}]}"), docs);
+        assertAgrees(fromjson("{a: {$ne: 5}, 'a.x': {$exists: true}}"), docs);
+        assertAgrees(fromjson("{a: {$elemMatch: {x: 10}}, 'a.x': 10}"), docs);
+        assertAgrees(fromjson("{a: {$size: 3}, a: {$gte: 5}}"), docs);
+        assertAgrees(fromjson("{a: {$type: 2}, a: {$lt: 'b'}}"), docs);
+    }
+
+    TEST(CompiledMatchExpression, CountsCompiledConjuncts) {
+        boost::scoped_ptr<MatchExpression> expr(
+            parse(fromjson("{a: 1, 'b.c': {$gt: 'x'}, $or: [{d: 1}, {e: 1}]}")));
+        std::unique_ptr<CompiledMatchExpression> compiled =
+            CompiledMatchExpression::compile(expr.get());
+        ASSERT(compiled);
+        ASSERT_EQUALS(2U, compiled->numCompiled());
+    }
+
+    TEST(CompiledMatchExpression, NothingToCompile) {
+        boost::scoped_ptr<MatchExpression> expr(parse(fromjson("{$or: [{a: 1}, {b: 1}]}")));
+        ASSERT(!CompiledMatchExpression::compile(expr.get()));
+
+        expr.reset(parse(BSONObj()));
+        ASSERT(!CompiledMatchExpression::compile(expr.get()));
+    }
+
+    TEST(CompiledMatchExpression, TooManyPathsAreLeftToTheTree) {
+        BSONObjBuilder query;
+        BSONObjBuilder doc;
+        for (int i = 0; i < 100; i++) {
+            const std::string field = str::stream() << "f" << i;
+            query.append(field, i);
+            doc.append(field, i);
+        }
+
+        // The parsed expression points into the query, so keep it alive.
+        const BSONObj queryObj = query.obj();
+        boost::scoped_ptr<MatchExpression> expr(parse(queryObj));
+        std::unique_ptr<CompiledMatchExpression> compiled =
+            CompiledMatchExpression::compile(expr.get());
+        ASSERT(compiled);
+        ASSERT_LESS_THAN(compiled->numCompiled(), 100U);
+
+        const BSONObj matching = doc.obj();
+        ASSERT(compiled->matchesBSON(matching));
+        ASSERT(!compiled->matchesBSON(BSON("f99" << 99)));
+    }
+
+}  // namespace mongo
@@ -467,6 +467,7 @@ namespace mongo {
             _hasEmptyArray = true;
 
         _equalities.insert( e );
+        _hashedEqualities.insert( e );
         return Status::OK();
     }
 
@@ -492,6 +493,7 @@ namespace mongo {
         toFillIn._hasNull = _hasNull;
         toFillIn._hasEmptyArray = _hasEmptyArray;
         toFillIn._equalities = _equalities;
+        toFillIn._hashedEqualities = _hashedEqualities;
         for ( unsigned i = 0; i < _regexes.size(); i++ )
             toFillIn._regexes.push_back( static_cast<RegexMatchExpression*>(_regexes[i]->shallowClone()) );
     }
@@ -35,6 +35,7 @@
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonmisc.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/platform/unordered_set.h"
 
 namespace pcrecpp {
     class RE;
@@ -295,7 +296,7 @@ namespace mongo {
         Status addRegex( RegexMatchExpression* expr );
 
         const BSONElementSet& equalities() const { return _equalities; }
-        bool contains( const BSONElement& elem ) const { return _equalities.count(elem) > 0; }
+        bool contains( const BSONElement& elem ) const { return _hashedEqualities.count(elem) > 0; }
 
         size_t numRegexes() const { return _regexes.size(); }
         RegexMatchExpression* regex( int idx ) const { return _regexes[idx]; }
@@ -317,6 +318,13 @@ namespace mongo {
         bool _hasNull; // if _equalities has a jstNULL element in it
         bool _hasEmptyArray;
         BSONElementSet _equalities;
+
+        // The same elements as _equalities, hashed by canonical type and value, so that
+        // contains() doesn't have to compare its way down the tree for a long $in list.
+        unordered_set<BSONElement,
+                      BSONElement::HasherWithoutField,
+                      BSONElementEqWithoutField> _hashedEqualities;
+
         std::vector<RegexMatchExpression*> _regexes;
     };
 
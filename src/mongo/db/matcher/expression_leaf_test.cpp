@@ -30,6 +30,8 @@
 
 #include "mongo/unittest/unittest.h"
 
+#include <limits>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
@@ -1500,6 +1502,65 @@ namespace mongo {
         ASSERT( !in.matchesBSON( BSON( "a" << BSON_ARRAY( BSON_ARRAY( 5 ) ) ), NULL ) );
     }
 
+    TEST( InMatchExpression, MatchesEquivalentTypes ) {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        BSONObj operand = BSON_ARRAY( 5 << 2.5 << "abc" << 0.0 << nan );
+        InMatchExpression in;
+        in.init( "a" );
+        BSONObjIterator it( operand );
+        while ( it.more() ) {
+            ASSERT_OK( in.getArrayFilterEntries()->addEquality( it.next() ) );
+        }
+
+        // Equal numbers match whatever their type, and Symbols match Strings.
+        ASSERT( in.matchesBSON( BSON( "a" << 5.0 ), NULL ) );
+        ASSERT( in.matchesBSON( BSON( "a" << 5LL ), NULL ) );
+        ASSERT( in.matchesBSON( BSON( "a" << 2.5 ), NULL ) );
+        ASSERT( in.matchesBSON( BSON( "a" << -0.0 ), NULL ) );
+        ASSERT( in.matchesBSON( BSON( "a" << 0LL ), NULL ) );
+        ASSERT( in.matchesBSON( BSON( "a" << nan ), NULL ) );
+        ASSERT( in.matchesBSON( BSONObjBuilder().appendSymbol( "a", "abc" ).obj(), NULL ) );
+        ASSERT( !in.matchesBSON( BSON( "a" << 2 ), NULL ) );
+        ASSERT( !in.matchesBSON( BSON( "a" << "5" ), NULL ) );
+        ASSERT( !in.matchesBSON( BSONObjBuilder().appendCode( "a", "abc" ).obj(), NULL ) );
+    }
+
+    TEST( InMatchExpression, MatchesLargeList ) {
+        BSONArrayBuilder operandBuilder;
+        for ( int i = 0; i < 10000; i++ ) {
+            operandBuilder.append( i * 2 );
+            operandBuilder.append( BSON( "x" << i ) );
+        }
+        BSONObj operand = operandBuilder.arr();
+
+        InMatchExpression in;
+        in.init( "a" );
+        BSONObjIterator it( operand );
+        while ( it.more() ) {
+            ASSERT_OK( in.getArrayFilterEntries()->addEquality( it.next() ) );
+        }
+
+        for ( int i = 0; i < 20000; i++ ) {
+            ASSERT_EQUALS( i % 2 == 0, in.matchesBSON( BSON( "a" << i ), NULL ) );
+            ASSERT_EQUALS( i < 10000,
+                           in.matchesBSON( BSON( "a" << BSON( "x" << double( i ) ) ), NULL ) );
+        }
+        ASSERT( !in.matchesBSON( BSON( "a" << BSON( "y" << 1 ) ), NULL ) );
+    }
+
+    TEST( InMatchExpression, CopyMatchesLikeOriginal ) {
+        BSONObj operand = BSON_ARRAY( 1 << "r" );
+        InMatchExpression in;
+        in.init( "a" );
+        in.getArrayFilterEntries()->addEquality( operand[0] );
+        in.getArrayFilterEntries()->addEquality( operand[1] );
+
+        boost::scoped_ptr<LeafMatchExpression> copy( in.shallowClone() );
+        ASSERT( copy->matchesBSON( BSON( "a" << 1.0 ), NULL ) );
+        ASSERT( copy->matchesBSON( BSON( "a" << "r" ), NULL ) );
+        ASSERT( !copy->matchesBSON( BSON( "a" << 2 ), NULL ) );
+    }
+
     TEST( InMatchExpression, MatchesNull ) {
         BSONObj operand = BSON_ARRAY( BSONNULL );
 
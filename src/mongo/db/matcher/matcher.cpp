@@ -51,12 +51,18 @@ namespace mongo {
                  result.isOK() );
 
         _expression.reset( result.getValue() );
+        if ( internalQueryExecCompileFilters ) {
+            _compiled = CompiledMatchExpression::compile( _expression.get() );
+        }
     }
 
     bool Matcher::matches(const BSONObj& doc, MatchDetails* details ) const {
         if ( !_expression )
             return true;
 
+        if ( _compiled && !details )
+            return _compiled->matchesBSON( doc );
+
         return _expression->matchesBSON( doc, details );
     }
 
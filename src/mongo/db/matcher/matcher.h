@@ -31,11 +31,13 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <memory>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/base/status.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/matcher/match_details.h"
 
@@ -63,6 +65,9 @@ namespace mongo {
         BSONObj _pattern;
 
         boost::scoped_ptr<MatchExpression> _expression;
+
+        // Runs in place of _expression when no MatchDetails are asked for.
+        std::unique_ptr<CompiledMatchExpression> _compiled;
     };
 
 }  // namespace mongo
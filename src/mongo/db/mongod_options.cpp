@@ -134,6 +134,21 @@ namespace mongo {
         general_options.addOptionChaining("net.http.RESTInterfaceEnabled", "rest", moe::Switch,
                 "turn on simple rest api");
 
+        general_options.addOptionChaining("net.transportMode", "transportMode", moe::String,
+                "how client connections are serviced: threadPerConnection (default) dedicates a "
+                "thread to each connection, asio multiplexes connections over a few I/O threads "
+                "and runs requests on a fixed pool of worker threads")
+                                         .format("(:?threadPerConnection)|(:?asio)",
+                                                 "(threadPerConnection/asio)");
+
+        general_options.addOptionChaining("net.asio.ioThreads", "asioIoThreads", moe::Int,
+                "number of threads reading requests off the network with --transportMode=asio");
+
+        general_options.addOptionChaining("net.asio.workerThreads", "asioWorkerThreads",
+                moe::Int,
+                "number of threads running requests with --transportMode=asio; requests beyond "
+                "this are queued until a worker is free");
+
         // Diagnostic Options
 
         general_options.addOptionChaining("diaglog", "diaglog", moe::Int,
@@ -521,6 +536,19 @@ namespace mongo {
             return ret;
         }
 
+        if (params.count("net.transportMode") &&
+            params["net.transportMode"].as<std::string>() == "asio") {
+#ifdef _WIN32
+            return Status(ErrorCodes::BadValue,
+                          "transportMode asio is not supported on Windows");
+#endif
+            if (params.count("net.ssl.mode") &&
+                params["net.ssl.mode"].as<std::string>() != "disabled") {
+                return Status(ErrorCodes::BadValue,
+                              "transportMode asio can not be used with SSL");
+            }
+        }
+
         if ((params.count("nodur") || params.count("nojournal")) &&
             (params.count("dur") || params.count("journal"))) {
             return Status(ErrorCodes::BadValue,
@@ -995,6 +1023,23 @@ namespace mongo {
         if (params.count("net.http.RESTInterfaceEnabled")) {
             serverGlobalParams.rest = params["net.http.RESTInterfaceEnabled"].as<bool>();
         }
+        if (params.count("net.transportMode")) {
+            mongodGlobalParams.transportMode =
+                params["net.transportMode"].as<std::string>() == "asio" ?
+                    MessageServer::kAsio : MessageServer::kThreadPerConnection;
+        }
+        if (params.count("net.asio.ioThreads")) {
+            mongodGlobalParams.asioIoThreads = params["net.asio.ioThreads"].as<int>();
+            if (mongodGlobalParams.asioIoThreads < 1) {
+                return Status(ErrorCodes::BadValue, "asioIoThreads has to be at least 1");
+            }
+        }
+        if (params.count("net.asio.workerThreads")) {
+            mongodGlobalParams.asioWorkerThreads = params["net.asio.workerThreads"].as<int>();
+            if (mongodGlobalParams.asioWorkerThreads < 1) {
+                return Status(ErrorCodes::BadValue, "asioWorkerThreads has to be at least 1");
+            }
+        }
         if (params.count("net.http.JSONPEnabled")) {
             serverGlobalParams.jsonp = params["net.http.JSONPEnabled"].as<bool>();
         }
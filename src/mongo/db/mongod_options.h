@@ -32,6 +32,7 @@
 #include "mongo/db/repl/repl_settings.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/util/net/message_server.h"
 #include "mongo/util/options_parser/environment.h"
 #include "mongo/util/options_parser/option_section.h"
 
@@ -47,8 +48,15 @@ namespace mongo {
     struct MongodGlobalParams {
         bool scriptingEnabled; // --noscripting
 
+        MessageServer::TransportMode transportMode; // --transportMode
+        int asioIoThreads;     // --asioIoThreads, 0 means pick based on cores
+        int asioWorkerThreads; // --asioWorkerThreads, 0 means pick based on cores
+
         MongodGlobalParams() :
-            scriptingEnabled(true)
+            scriptingEnabled(true),
+            transportMode(MessageServer::kThreadPerConnection),
+            asioIoThreads(0),
+            asioWorkerThreads(0)
         { }
     };
 
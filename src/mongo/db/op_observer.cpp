@@ -68,6 +68,22 @@ namespace mongo {
         }
     }
 
+    void OpObserver::onInserts(OperationContext* txn,
+                               const NamespaceString& ns,
+                               const std::vector<BSONObj>& docs,
+                               bool fromMigrate) {
+        repl::_logOps(txn, "i", ns.ns().c_str(), docs, fromMigrate);
+
+        for (size_t i = 0; i < docs.size(); i++) {
+            getGlobalAuthorizationManager()->logOp(txn, "i", ns.ns().c_str(), docs[i], nullptr);
+            logOpForSharding(txn, "i", ns.ns().c_str(), docs[i], nullptr, fromMigrate);
+        }
+        logOpForDbHash(txn, ns.ns().c_str());
+        if (strstr(ns.ns().c_str(), ".system.js")) {
+            Scope::storedFuncMod(txn);
+        }
+    }
+
     void OpObserver::onUpdate(OperationContext* txn,
                               oplogUpdateEntryArgs args) {
         repl::_logOp(txn, "u", args.ns.c_str(), args.update, &args.criteria, args.fromMigrate);
@@ -84,6 +84,10 @@ namespace {
         _recovery.reset(storageEngine->newRecoveryUnit());
 
         auto client = getClient();
+        if (!client->isFromUserConnection()) {
+            lockState()->setAdmissionClass(ADMISSION_INTERNAL);
+        }
+
         stdx::lock_guard<Client> lk(*client);
         client->setOperationContext(this);
     }
@@ -491,12 +491,12 @@ namespace mongo {
     private:
         DocumentSourceGroup(const boost::intrusive_ptr<ExpressionContext> &pExpCtx);
 
-        /// Spill groups map to disk and returns an iterator to the file.
-        boost::shared_ptr<Sorter<Value, Value>::Iterator> spill();
-
         // Only used by spill. Would be function-local if that were legal in C++03.
         class SpillSTLComparator;
 
+        // Groups the input on worker threads, one hash partition each. See populatePartitioned().
+        class Partitions;
+
         /*
           Before returning anything, this source must fetch everything from
           the underlying source and group it.  populate() is used to do that
@@ -527,6 +527,30 @@ namespace mongo {
         typedef boost::unordered_map<Value, Accumulators, Value::Hash> GroupsMap;
         GroupsMap groups;
 
+        /**
+         * Adds the document at the root of 'vars', whose group key is 'id', to its group in
+         * 'groupsMap' and adjusts 'memoryUsageBytes' by how much the groups grew. Returns true if
+         * a new group was created.
+         */
+        bool accumulate(GroupsMap* groupsMap,
+                        Variables* vars,
+                        const Value& id,
+                        int* memoryUsageBytes);
+
+        /// Spill groups map to disk and returns an iterator to the file.
+        boost::shared_ptr<Sorter<Value, Value>::Iterator> spill(GroupsMap* groupsToSpill);
+
+        /**
+         * Used instead of the single threaded loop in populate() when $group is configured to use
+         * worker threads. The workers compute the group keys and hash partition the documents on
+         * them, so each partition's groups are disjoint and need no merging. Spilled runs from
+         * every partition are added to 'sortedFiles'; otherwise the groups of the partitions are
+         * left in 'groups' and _remainingGroups.
+         */
+        void populatePartitioned(
+                size_t numPartitions,
+                std::vector<boost::shared_ptr<Sorter<Value, Value>::Iterator> >* sortedFiles);
+
         /*
           The field names for the result documents and the accumulator
           factories for the result documents.  The Expressions are the
@@ -551,11 +575,13 @@ namespace mongo {
         const bool _extSortAllowed;
         const int _maxMemoryUsageBytes;
         boost::scoped_ptr<Variables> _variables;
+        size_t _numVariables; // each partition needs its own Variables of this size
         std::vector<std::string> _idFieldNames; // used when id is a document
         std::vector<boost::intrusive_ptr<Expression> > _idExpressions;
 
         // only used when !_spilled
         GroupsMap::iterator groupsIterator;
+        std::vector<GroupsMap> _remainingGroups; // output after groups if populatePartitioned()
 
         // only used when _spilled
         boost::scoped_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
@@ -28,6 +28,10 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <map>
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/accumulator.h"
@@ -36,6 +40,11 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
 
 namespace mongo {
 
@@ -44,6 +53,19 @@ namespace mongo {
     using std::pair;
     using std::vector;
 
+    // Number of threads a $group spreads its accumulators over. With the default of 1 everything
+    // is grouped on the thread running the pipeline.
+    MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupWorkerThreads, int, 1);
+
+namespace {
+    const int kMaxGroupWorkerThreads = 64;
+
+    // Documents are dealt to the $group worker threads this many at a time, and the pipeline
+    // blocks once kMaxQueuedBatches batches per thread are not yet fully grouped.
+    const size_t kPartitionBatchSize = 256;
+    const size_t kMaxQueuedBatches = 4;
+} // namespace
+
     const char DocumentSourceGroup::groupName[] = "$group";
 
     const char *DocumentSourceGroup::getSourceName() const {
@@ -108,8 +130,17 @@ namespace mongo {
                                         groupsIterator->second,
                                         pExpCtx->inShard);
 
-            if (++groupsIterator == groups.end())
-                dispose();
+            if (++groupsIterator == groups.end()) {
+                if (_remainingGroups.empty()) {
+                    dispose();
+                }
+                else {
+                    // move on to the groups of the next partition
+                    groups.swap(_remainingGroups.back());
+                    _remainingGroups.pop_back();
+                    groupsIterator = groups.begin();
+                }
+            }
 
             return out;
         }
@@ -118,6 +149,7 @@ namespace mongo {
     void DocumentSourceGroup::dispose() {
         // free our resources
         GroupsMap().swap(groups);
+        _remainingGroups.clear();
         _sorterIterator.reset();
 
         // make us look done
@@ -207,6 +239,7 @@ namespace mongo {
         , _spilled(false)
         , _extSortAllowed(pExpCtx->extSortAllowed && !pExpCtx->inRouter)
         , _maxMemoryUsageBytes(100*1024*1024)
+        , _numVariables(0)
     {}
 
     void DocumentSourceGroup::addAccumulator(
@@ -340,7 +373,8 @@ namespace mongo {
         uassert(15955, "a group specification must include an _id",
                 !pGroup->_idExpressions.empty());
 
-        pGroup->_variables.reset(new Variables(idGenerator.getIdCount()));
+        pGroup->_numVariables = idGenerator.getIdCount();
+        pGroup->_variables.reset(new Variables(pGroup->_numVariables));
 
         return pGroup;
     }
@@ -363,66 +397,46 @@ namespace mongo {
         vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
         int memoryUsageBytes = 0;
 
-        // This loop consumes all input from pSource and buckets it based on pIdExpression.
-        while (boost::optional<Document> input = pSource->getNext()) {
-            if (memoryUsageBytes > _maxMemoryUsageBytes) {
-                uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort."
-                               " Pass allowDiskUse:true to opt in.",
-                        _extSortAllowed);
-                sortedFiles.push_back(spill());
-                memoryUsageBytes = 0;
-            }
-
-            _variables->setRoot(*input);
-
-            /* get the _id value */
-            Value id = computeId(_variables.get());
-
-            /* treat missing values the same as NULL SERVER-4674 */
-            if (id.missing())
-                id = Value(BSONNULL);
+        const int numWorkers = std::min(internalDocumentSourceGroupWorkerThreads,
+                                        kMaxGroupWorkerThreads);
+        if (numWorkers > 1 && !pExpCtx->inRouter) {
+            populatePartitioned(numWorkers, &sortedFiles);
+        }
+        else {
+            // This loop consumes all input from pSource and buckets it based on pIdExpression.
+            while (boost::optional<Document> input = pSource->getNext()) {
+                if (memoryUsageBytes > _maxMemoryUsageBytes) {
+                    uassert(16945, "Exceeded memory limit for $group, but didn't allow external"
+                                   " sort. Pass allowDiskUse:true to opt in.",
+                            _extSortAllowed);
+                    sortedFiles.push_back(spill(&groups));
+                    memoryUsageBytes = 0;
+                }
 
-            /*
-              Look for the _id value in the map; if it's not there, add a
-              new entry with a blank accumulator.
-            */
-            const size_t oldSize = groups.size();
-            vector<intrusive_ptr<Accumulator> >& group = groups[id];
-            const bool inserted = groups.size() != oldSize;
+                _variables->setRoot(*input);
 
-            if (inserted) {
-                memoryUsageBytes += id.getApproximateSize();
+                /* get the _id value */
+                Value id = computeId(_variables.get());
 
-                // Add the accumulators
-                group.reserve(numAccumulators);
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    group.push_back(vpAccumulatorFactory[i]());
-                }
-            } else {
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    // subtract old mem usage. New usage added back after processing.
-                    memoryUsageBytes -= group[i]->memUsageForSorter();
-                }
-            }
+                /* treat missing values the same as NULL SERVER-4674 */
+                if (id.missing())
+                    id = Value(BSONNULL);
 
-            /* tickle all the accumulators for the group we found */
-            dassert(numAccumulators == group.size());
-            for (size_t i = 0; i < numAccumulators; i++) {
-                group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
-                memoryUsageBytes += group[i]->memUsageForSorter();
-            }
+                const bool inserted = accumulate(&groups, _variables.get(), id,
+                                                 &memoryUsageBytes);
 
-            // We are done with the ROOT document so release it.
-            _variables->clearRoot();
+                // We are done with the ROOT document so release it.
+                _variables->clearRoot();
 
-            DEV {
-                // In debug mode, spill every time we have a duplicate id to stress merge logic.
-                if (!inserted // is a dup
-                        && !pExpCtx->inRouter // can't spill to disk in router
-                        && !_extSortAllowed // don't change behavior when testing external sort
-                        && sortedFiles.size() < 20 // don't open too many FDs
-                        ) {
-                    sortedFiles.push_back(spill());
+                DEV {
+                    // In debug mode, spill every time we have a duplicate id to stress merge logic.
+                    if (!inserted // is a dup
+                            && !pExpCtx->inRouter // can't spill to disk in router
+                            && !_extSortAllowed // don't change behavior when testing external sort
+                            && sortedFiles.size() < 20 // don't open too many FDs
+                            ) {
+                        sortedFiles.push_back(spill(&groups));
+                    }
                 }
             }
         }
@@ -431,7 +445,7 @@ namespace mongo {
         if (!sortedFiles.empty()) {
             _spilled = true;
             if (!groups.empty()) {
-                sortedFiles.push_back(spill());
+                sortedFiles.push_back(spill(&groups));
             }
 
             // We won't be using groups again so free its memory.
@@ -457,6 +471,335 @@ namespace mongo {
         populated = true;
     }
 
+    bool DocumentSourceGroup::accumulate(GroupsMap* groupsMap,
+                                         Variables* vars,
+                                         const Value& id,
+                                         int* memoryUsageBytes) {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+
+        /*
+          Look for the _id value in the map; if it's not there, add a
+          new entry with a blank accumulator.
+        */
+        const size_t oldSize = groupsMap->size();
+        vector<intrusive_ptr<Accumulator> >& group = (*groupsMap)[id];
+        const bool inserted = groupsMap->size() != oldSize;
+
+        if (inserted) {
+            *memoryUsageBytes += id.getApproximateSize();
+
+            // Add the accumulators
+            group.reserve(numAccumulators);
+            for (size_t i = 0; i < numAccumulators; i++) {
+                group.push_back(vpAccumulatorFactory[i]());
+            }
+        } else {
+            for (size_t i = 0; i < numAccumulators; i++) {
+                // subtract old mem usage. New usage added back after processing.
+                *memoryUsageBytes -= group[i]->memUsageForSorter();
+            }
+        }
+
+        /* tickle all the accumulators for the group we found */
+        dassert(numAccumulators == group.size());
+        for (size_t i = 0; i < numAccumulators; i++) {
+            group[i]->process(vpExpression[i]->evaluate(vars), _doingMerge);
+            *memoryUsageBytes += group[i]->memUsageForSorter();
+        }
+
+        return inserted;
+    }
+
+    /**
+     * Groups the input on one worker thread per hash partition of the group keys. The pipeline's
+     * thread only reads documents and deals them out in numbered batches, each to the next worker
+     * in turn. The worker dealt a batch computes the group key of each of its documents and routes
+     * the document to the partition its key hashes to. Each worker also accumulates what was
+     * routed to its own partition, taking the batches strictly in number order, so every group
+     * sees its documents in input order and no group is in more than one partition.
+     *
+     * If the input ends before the first batch fills, no thread is started and finish() groups
+     * that batch on the caller's thread instead.
+     *
+     * A worker only writes the state of its own partition, and the queues it shares with the
+     * other workers under '_mutex'. The expressions and accumulator factories shared with the
+     * DocumentSourceGroup are only read.
+     */
+    class DocumentSourceGroup::Partitions {
+        MONGO_DISALLOW_COPYING(Partitions);
+    public:
+        typedef vector<Document> Batch;
+        typedef vector<pair<Value, Document> > KeyedBatch;
+
+        struct Partition {
+            explicit Partition(size_t numVariables) : variables(numVariables) {}
+
+            GroupsMap groups;
+            vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
+
+            // Only used by this partition's worker, or by finish() if no worker was started.
+            Variables variables;
+            int memoryUsageBytes = 0;
+
+            // Guarded by Partitions::_mutex.
+            std::deque<pair<size_t, Batch> > dealt; // batches this worker computes keys for
+            std::map<size_t, KeyedBatch> routed;    // this partition's share of each batch
+            size_t nextRouted = 0;                  // number of the next share to accumulate
+        };
+
+        Partitions(DocumentSourceGroup* group, size_t numPartitions, int maxMemoryUsageBytes)
+            : _group(group)
+            , _maxMemoryUsageBytes(maxMemoryUsageBytes) {
+            for (size_t i = 0; i < numPartitions; i++) {
+                _partitions.emplace_back(new Partition(group->_numVariables));
+            }
+        }
+
+        ~Partitions() {
+            {
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                _shuttingDown = true;
+                _changed.notify_all();
+            }
+            _join();
+        }
+
+        size_t size() const { return _partitions.size(); }
+        Partition& get(size_t i) { return *_partitions[i]; }
+
+        void add(const Document& input) {
+            _batch.push_back(input);
+            if (_batch.size() >= kPartitionBatchSize)
+                _dealBatch();
+        }
+
+        /**
+         * Waits for every document added to be grouped, rethrowing any error from a worker.
+         */
+        void finish() {
+            if (_threads.empty()) {
+                vector<KeyedBatch> shares(_partitions.size());
+                _route(&_partitions[0]->variables, _batch, &shares);
+                for (size_t i = 0; i < _partitions.size(); i++) {
+                    _accumulate(_partitions[i].get(), shares[i]);
+                }
+                _batch.clear();
+                return;
+            }
+
+            if (!_batch.empty())
+                _dealBatch();
+
+            {
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                _inputDone = true;
+                _changed.notify_all();
+            }
+            _join();
+            if (_error)
+                std::rethrow_exception(_error);
+        }
+
+    private:
+        void _dealBatch() {
+            if (_threads.empty()) {
+                for (size_t i = 0; i < _partitions.size(); i++) {
+                    _threads.emplace_back(stdx::bind(&Partitions::_run, this, i));
+                }
+            }
+
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            while (!_error
+                    && _numBatches - _oldestUnaccumulated() >= kMaxQueuedBatches * size()) {
+                _changed.wait(lk);
+            }
+            if (_error)
+                std::rethrow_exception(_error);
+
+            Partition& worker = *_partitions[_numBatches % size()];
+            worker.dealt.push_back(std::make_pair(_numBatches, Batch()));
+            worker.dealt.back().second.swap(_batch);
+            _numBatches++;
+            _changed.notify_all();
+        }
+
+        // Returns the number of the oldest batch some partition has yet to accumulate its share
+        // of. Must hold '_mutex'.
+        size_t _oldestUnaccumulated() const {
+            size_t oldest = _numBatches;
+            for (size_t i = 0; i < _partitions.size(); i++) {
+                oldest = std::min(oldest, _partitions[i]->nextRouted);
+            }
+            return oldest;
+        }
+
+        void _join() {
+            for (size_t i = 0; i < _threads.size(); i++) {
+                if (_threads[i].joinable())
+                    _threads[i].join();
+            }
+        }
+
+        void _run(size_t partitionIndex) {
+            Partition& own = *_partitions[partitionIndex];
+            while (true) {
+                // Accumulating the next share of this partition comes before computing the keys
+                // of a dealt batch, so the oldest batches leave the window first.
+                bool accumulating = false;
+                size_t batchNumber = 0;
+                KeyedBatch share;
+                Batch batch;
+                {
+                    stdx::unique_lock<stdx::mutex> lk(_mutex);
+                    while (true) {
+                        if (_error || _shuttingDown)
+                            return;
+
+                        if (!own.routed.empty() && own.routed.begin()->first == own.nextRouted) {
+                            accumulating = true;
+                            share.swap(own.routed.begin()->second);
+                            own.routed.erase(own.routed.begin());
+                            break;
+                        }
+                        if (!own.dealt.empty()) {
+                            batchNumber = own.dealt.front().first;
+                            batch.swap(own.dealt.front().second);
+                            own.dealt.pop_front();
+                            break;
+                        }
+                        if (_inputDone && own.nextRouted == _numBatches)
+                            return;
+
+                        _changed.wait(lk);
+                    }
+                }
+
+                vector<KeyedBatch> shares;
+                try {
+                    if (accumulating) {
+                        _accumulate(&own, share);
+                    }
+                    else {
+                        shares.resize(_partitions.size());
+                        _route(&own.variables, batch, &shares);
+                    }
+                }
+                catch (...) {
+                    stdx::lock_guard<stdx::mutex> lk(_mutex);
+                    _error = std::current_exception();
+                    _changed.notify_all();
+                    return;
+                }
+
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                if (accumulating) {
+                    own.nextRouted++;
+                }
+                else {
+                    // Every partition gets a share of every batch, even an empty one, so that its
+                    // worker can tell the batch is routed.
+                    for (size_t i = 0; i < _partitions.size(); i++) {
+                        _partitions[i]->routed[batchNumber].swap(shares[i]);
+                    }
+                }
+                _changed.notify_all();
+            }
+        }
+
+        /**
+         * Computes the group key of each document in 'batch' and appends the document to the
+         * share of 'shares' for the partition the key hashes to.
+         */
+        void _route(Variables* vars, const Batch& batch, vector<KeyedBatch>* shares) const {
+            const Value::Hash hasher = Value::Hash();
+            for (Batch::const_iterator it = batch.begin(); it != batch.end(); ++it) {
+                vars->setRoot(*it);
+
+                Value id = _group->computeId(vars);
+
+                /* treat missing values the same as NULL SERVER-4674 */
+                if (id.missing())
+                    id = Value(BSONNULL);
+
+                vars->clearRoot();
+
+                (*shares)[hasher(id) % shares->size()].push_back(std::make_pair(id, *it));
+            }
+        }
+
+        void _accumulate(Partition* partition, const KeyedBatch& share) {
+            for (KeyedBatch::const_iterator it = share.begin(); it != share.end(); ++it) {
+                if (partition->memoryUsageBytes > _maxMemoryUsageBytes) {
+                    uassert(16945, "Exceeded memory limit for $group, but didn't allow external"
+                                   " sort. Pass allowDiskUse:true to opt in.",
+                            _group->_extSortAllowed);
+                    partition->sortedFiles.push_back(_group->spill(&partition->groups));
+                    partition->memoryUsageBytes = 0;
+                }
+
+                partition->variables.setRoot(it->second);
+                _group->accumulate(&partition->groups, &partition->variables, it->first,
+                                   &partition->memoryUsageBytes);
+                partition->variables.clearRoot();
+            }
+        }
+
+        DocumentSourceGroup* const _group;
+        const int _maxMemoryUsageBytes;
+        vector<std::unique_ptr<Partition> > _partitions;
+
+        // Only used by the pipeline's thread.
+        Batch _batch;
+        vector<stdx::thread> _threads;
+
+        stdx::mutex _mutex;
+        stdx::condition_variable _changed;
+        size_t _numBatches = 0;
+        bool _inputDone = false;
+        bool _shuttingDown = false;
+        std::exception_ptr _error;
+    };
+
+    void DocumentSourceGroup::populatePartitioned(
+            size_t numPartitions,
+            vector<shared_ptr<Sorter<Value, Value>::Iterator> >* sortedFiles) {
+
+        Partitions partitions(this, numPartitions, _maxMemoryUsageBytes / numPartitions);
+        while (boost::optional<Document> input = pSource->getNext()) {
+            partitions.add(*input);
+        }
+
+        bool spilled = false;
+        partitions.finish();
+        for (size_t i = 0; i < numPartitions; i++) {
+            spilled = spilled || !partitions.get(i).sortedFiles.empty();
+        }
+
+        // No group is in more than one partition, so the partitions' spilled runs only need to be
+        // merged together like the runs of a single partition, and their in-memory groups can be
+        // output one partition after another.
+        for (size_t i = 0; i < numPartitions; i++) {
+            Partitions::Partition& partition = partitions.get(i);
+            if (spilled) {
+                sortedFiles->insert(sortedFiles->end(),
+                                    partition.sortedFiles.begin(),
+                                    partition.sortedFiles.end());
+                if (!partition.groups.empty()) {
+                    sortedFiles->push_back(spill(&partition.groups));
+                }
+            }
+            else if (!partition.groups.empty()) {
+                if (groups.empty()) {
+                    groups.swap(partition.groups);
+                }
+                else {
+                    _remainingGroups.push_back(GroupsMap());
+                    _remainingGroups.back().swap(partition.groups);
+                }
+            }
+        }
+    }
+
     class DocumentSourceGroup::SpillSTLComparator {
     public:
         bool operator() (const GroupsMap::value_type* lhs, const GroupsMap::value_type* rhs) const {
@@ -464,16 +807,19 @@ namespace mongo {
         }
     };
 
-    shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
+    shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill(
+            GroupsMap* groupsToSpill) {
         vector<const GroupsMap::value_type*> ptrs; // using pointers to speed sorting
-        ptrs.reserve(groups.size());
-        for (GroupsMap::const_iterator it=groups.begin(), end=groups.end(); it != end; ++it) {
+        ptrs.reserve(groupsToSpill->size());
+        for (GroupsMap::const_iterator it = groupsToSpill->begin(), end = groupsToSpill->end();
+                it != end; ++it) {
             ptrs.push_back(&*it);
         }
 
         stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator());
 
-        SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
+        SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir)
+                                                           .ReadAhead());
         switch (vpAccumulatorFactory.size()) { // same as ptrs[i]->second.size() for all i.
         case 0: // no values, essentially a distinct
             for (size_t i=0; i < ptrs.size(); i++) {
@@ -499,7 +845,7 @@ namespace mongo {
             break;
         }
 
-        groups.clear();
+        groupsToSpill->clear();
 
         return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
     }
@@ -623,7 +969,8 @@ namespace mongo {
                 ExpressionFieldPath::parse("$$ROOT." + vFieldName[i], vps));
         }
 
-        pMerger->_variables.reset(new Variables(idGenerator.getIdCount()));
+        pMerger->_numVariables = idGenerator.getIdCount();
+        pMerger->_variables.reset(new Variables(pMerger->_numVariables));
 
         return pMerger;
     }
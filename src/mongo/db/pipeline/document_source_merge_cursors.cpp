@@ -32,6 +32,8 @@
 
 #include <boost/make_shared.hpp>
 
+#include "mongo/db/server_parameters.h"
+
 namespace mongo {
 
     using boost::intrusive_ptr;
@@ -39,6 +41,13 @@ namespace mongo {
     using std::string;
     using std::vector;
 
+    // Whether each shard cursor keeps a getMore in flight while its current batch is merged.
+    MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceMergeCursorsPrefetch, bool, true);
+
+    // Number of documents to ask each shard for per getMore, which bounds how much of a shard's
+    // output is buffered here. 0 lets the shard pick its default batch size.
+    MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceMergeCursorsBatchSize, int, 0);
+
     const char DocumentSourceMergeCursors::name[] = "$mergeCursors";
 
     const char* DocumentSourceMergeCursors::getSourceName() const {
@@ -133,6 +142,18 @@ namespace mongo {
                     "error reading response from " + _cursors.back()->connection->toString(),
                     ok);
             verify(!retry);
+
+            // A batch size of 1 would close the cursor on the shard after one document.
+            const int batchSize = internalDocumentSourceMergeCursorsBatchSize;
+            if (batchSize > 0) {
+                (*it)->cursor.setBatchSize(batchSize == 1 ? 2 : batchSize);
+            }
+
+            // Ask every shard for its next batch up front, so that all shards work on their
+            // getMores at the same time instead of one after another as the merge reaches them.
+            if (internalDocumentSourceMergeCursorsPrefetch) {
+                (*it)->cursor.enablePrefetch();
+            }
         }
 
         _currentCursor = _cursors.begin();
@@ -153,9 +174,23 @@ namespace mongo {
         if (_unstarted)
             start();
 
+        // Prefer a cursor that has documents in hand over blocking on one that needs a getMore,
+        // so that the replies still in flight have longer to arrive.
+        if (!_cursors.empty() && !(*_currentCursor)->cursor.moreInCurrentBatch()) {
+            for (Cursors::iterator it = _cursors.begin(); it != _cursors.end(); ++it) {
+                if ((*it)->cursor.moreInCurrentBatch()) {
+                    _currentCursor = it;
+                    break;
+                }
+            }
+        }
+
         // purge eof cursors and release their connections
         while (!_cursors.empty() && !(*_currentCursor)->cursor.more()) {
-            (*_currentCursor)->connection.done();
+            // A cursor still open on the shard may have a prefetched reply on its way, in which
+            // case its connection can't be reused and is closed rather than pooled.
+            if ((*_currentCursor)->cursor.isDead())
+                (*_currentCursor)->connection.done();
             _cursors.erase(_currentCursor);
             _currentCursor = _cursors.begin();
         }
@@ -222,6 +222,8 @@ namespace mongo {
         if (pExpCtx->extSortAllowed && !pExpCtx->inRouter) {
             opts.extSortAllowed = true;
             opts.tempDir = pExpCtx->tempDir;
+            opts.backgroundSpill = true;
+            opts.readAhead = true;
         }
 
         return opts;
@@ -378,6 +378,7 @@ namespace mongo {
         // The order in which optimizations are applied can have significant impact on the
         // efficiency of the final pipeline. Be Careful!
         Optimizations::Sharded::findSplitPoint(shardPipeline.get(), this);
+        Optimizations::Sharded::limitSplitSortToMergeLimit(shardPipeline.get(), this);
         Optimizations::Sharded::moveFinalUnwindFromShardsToMerger(shardPipeline.get(), this);
         Optimizations::Sharded::limitFieldsSentFromShardsToMerger(shardPipeline.get(), this);
 
@@ -410,6 +411,37 @@ namespace mongo {
         }
     }
 
+    void Pipeline::Optimizations::Sharded::limitSplitSortToMergeLimit(Pipeline* shardPipe,
+                                                                      Pipeline* mergePipe) {
+        if (shardPipe->sources.empty() || mergePipe->sources.empty())
+            return;
+
+        DocumentSourceSort* shardSort =
+            dynamic_cast<DocumentSourceSort*>(shardPipe->sources.back().get());
+        DocumentSourceSort* mergeSort =
+            dynamic_cast<DocumentSourceSort*>(mergePipe->sources.front().get());
+        if (!shardSort || !mergeSort || mergeSort->getLimit() != -1)
+            return;
+
+        // $project outputs exactly one document per input, so a $limit after it bounds how many
+        // sorted documents are needed. Any other stage may drop or add documents.
+        for (size_t i = 1; i < mergePipe->sources.size(); i++) {
+            DocumentSource* source = mergePipe->sources[i].get();
+            if (DocumentSourceLimit* limit = dynamic_cast<DocumentSourceLimit*>(source)) {
+                bool coalesced = shardSort->coalesce(
+                    DocumentSourceLimit::create(shardPipe->pCtx, limit->getLimit()));
+                verify(coalesced);
+                coalesced = mergeSort->coalesce(
+                    DocumentSourceLimit::create(mergePipe->pCtx, limit->getLimit()));
+                verify(coalesced);
+                return;
+            }
+
+            if (!dynamic_cast<DocumentSourceProject*>(source))
+                return;
+        }
+    }
+
     void Pipeline::Optimizations::Sharded::moveFinalUnwindFromShardsToMerger(Pipeline* shardPipe,
                                                                              Pipeline* mergePipe) {
         while (!shardPipe->sources.empty()
@@ -106,6 +106,14 @@ namespace mongo {
          */
         static void findSplitPoint(Pipeline* shardPipe, Pipeline* mergePipe);
 
+        /**
+         * If the pipeline was split at a $sort and the merger later applies a $limit with only
+         * $project stages in between, gives both halves of the $sort that limit. The shards then
+         * keep only their top documents instead of sorting and sending everything, and the
+         * merger's streaming merge of their presorted output stops once it has enough.
+         */
+        static void limitSplitSortToMergeLimit(Pipeline* shardPipe, Pipeline* mergePipe);
+
         /**
          * If the final stage on shards is to unwind an array, move that stage to the merger. This
          * cuts down on network traffic and allows us to take advantage of reduced copying in
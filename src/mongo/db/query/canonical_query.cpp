@@ -652,4 +652,18 @@ namespace {
         return ss;
     }
 
+    const std::string* CanonicalQuery::getMemoizedPlanCacheKey(
+            unsigned long long keyGeneration) const {
+        if (0 == _planCacheKeyGeneration || keyGeneration != _planCacheKeyGeneration) {
+            return NULL;
+        }
+        return &_planCacheKey;
+    }
+
+    void CanonicalQuery::memoizePlanCacheKey(unsigned long long keyGeneration,
+                                             const std::string& key) const {
+        _planCacheKey = key;
+        _planCacheKeyGeneration = keyGeneration;
+    }
+
 }  // namespace mongo
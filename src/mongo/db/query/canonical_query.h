@@ -166,6 +166,17 @@ namespace mongo {
         std::string toString() const;
         std::string toStringShort() const;
 
+        /**
+         * Returns the plan cache key memoized on this query by PlanCache::computeKey(), or NULL
+         * if there is none or it was computed for a different key generation.
+         */
+        const std::string* getMemoizedPlanCacheKey(unsigned long long keyGeneration) const;
+
+        /**
+         * Memoizes the plan cache key computed for this query under 'keyGeneration'.
+         */
+        void memoizePlanCacheKey(unsigned long long keyGeneration, const std::string& key) const;
+
         /**
          * Validates match expression, checking for certain
          * combinations of operators in match expression and
@@ -206,7 +217,7 @@ namespace mongo {
         static MatchExpression* logicalRewrite(MatchExpression* tree);
     private:
         // You must go through canonicalize to create a CanonicalQuery.
-        CanonicalQuery() { }
+        CanonicalQuery() : _planCacheKeyGeneration(0) { }
 
         /**
          * Takes ownership of 'root' and 'lpq'.
@@ -221,6 +232,11 @@ namespace mongo {
         boost::scoped_ptr<MatchExpression> _root;
 
         boost::scoped_ptr<ParsedProjection> _proj;
+
+        // Memoized plan cache key, valid only for the key generation it was computed under.
+        // Generation 0 is never handed out by a PlanCache and means nothing is memoized.
+        mutable std::string _planCacheKey;
+        mutable unsigned long long _planCacheKeyGeneration;
     };
 
 }  // namespace mongo
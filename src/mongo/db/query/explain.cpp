@@ -39,6 +39,7 @@
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/query/stage_builder.h"
+#include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/server_parameters.h"
@@ -403,6 +404,9 @@ namespace mongo {
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("memUsage", spec->memUsage);
                 bob->appendNumber("memLimit", spec->memLimit);
+                if (spec->usedDisk) {
+                    bob->appendBool("usedDisk", true);
+                }
             }
 
             if (spec->limit > 0) {
@@ -423,12 +427,17 @@ namespace mongo {
 
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("keysExamined", spec->keysExamined);
+                bob->appendNumber("negatedKeysExamined", spec->negatedKeysExamined);
                 bob->appendNumber("docsExamined", spec->fetches);
             }
 
             bob->append("indexPrefix", spec->indexPrefix);
             bob->append("indexName", spec->indexName);
             bob->append("parsedTextQuery", spec->parsedTextQuery);
+
+            if (spec->limit) {
+                bob->appendNumber("limitAmount", spec->limit);
+            }
         }
         else if (STAGE_UPDATE == stats.stageType) {
             UpdateStats* spec = static_cast<UpdateStats*>(stats.specific.get());
@@ -650,6 +659,39 @@ namespace mongo {
             long long totalTimeMillis = CurOp::get(opCtx)->elapsedMillis();
             generateExecStats(winningStats.get(), verbosity, &execBob, totalTimeMillis);
 
+            // If the candidate plans were ranked, report what the trial period cost. The CPU
+            // time covers only the query thread, so comparing it against the wall time shows
+            // how much of the trial was spent waiting rather than working.
+            if (NULL != mps) {
+                const MultiPlanStats* mpsStats =
+                    static_cast<const MultiPlanStats*>(mps->getSpecificStats());
+                BSONObjBuilder trialBob(execBob.subobjStart("trialPeriod"));
+                trialBob.appendNumber("rounds", mpsStats->trialRounds);
+                trialBob.appendNumber("wallMicros", mpsStats->trialWallMicros);
+                trialBob.appendNumber("cpuMicros", mpsStats->trialCpuMicros);
+                trialBob.doneFast();
+            }
+
+            // Report what the working set allocated over the whole execution. Members recycled
+            // from the free list and objects carved out of an existing arena chunk cost no
+            // allocation, so only the rest count toward allocationsPerDocument.
+            if (const WorkingSet* ws = exec->getWorkingSet()) {
+                const WorkingSetStats& wsStats = ws->getStats();
+                const size_t allocations = wsStats.membersCreated + wsStats.arenaChunks
+                                           + wsStats.heapCopies;
+                const size_t nReturned = winningStats->common.advanced;
+
+                BSONObjBuilder wsBob(execBob.subobjStart("workingSet"));
+                wsBob.appendNumber("membersCreated", wsStats.membersCreated);
+                wsBob.appendNumber("membersRecycled", wsStats.membersRecycled);
+                wsBob.appendNumber("arenaCopies", wsStats.arenaCopies);
+                wsBob.appendNumber("arenaChunks", wsStats.arenaChunks);
+                wsBob.appendNumber("heapCopies", wsStats.heapCopies);
+                wsBob.append("allocationsPerDocument",
+                             nReturned ? double(allocations) / nReturned : double(allocations));
+                wsBob.doneFast();
+            }
+
             // Also generate exec stats for all plans, if the verbosity level is high enough.
             // These stats reflect what happened during the trial period that ranked the plans.
             if (verbosity >= ExplainCommon::EXEC_ALL_PLANS) {
@@ -30,6 +30,7 @@
 
 #include "mongo/db/query/index_bounds_builder.h"
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
@@ -691,48 +692,56 @@ namespace mongo {
         // This can happen.
         if (iv.empty()) { return; }
 
-        // Step 1: sort.
-        std::sort(iv.begin(), iv.end(), IntervalComparison);
+        // Step 1: sort. The point intervals for an $in list are usually built in order already,
+        // and checking for that is much cheaper than sorting a large list again.
+        if (!std::is_sorted(iv.begin(), iv.end(), IntervalComparison)) {
+            std::sort(iv.begin(), iv.end(), IntervalComparison);
+        }
 
-        // Step 2: Walk through and merge.
-        size_t i = 0;
-        while (i < iv.size() - 1) {
-            // Compare i with i + 1.
-            Interval::IntervalComparison cmp = iv[i].compare(iv[i + 1]);
+        // Step 2: Walk through and merge. The merged intervals are compacted into the front of
+        // 'iv', ending at iv[last], rather than erased from the middle of it, so that merging a
+        // long list stays linear.
+        size_t last = 0;
+        for (size_t i = 1; i < iv.size(); ++i) {
+            // Compare last with i.
+            Interval::IntervalComparison cmp = iv[last].compare(iv[i]);
 
             // This means our sort didn't work.
             verify(Interval::INTERVAL_SUCCEEDS != cmp);
 
             // Intervals are correctly ordered.
             if (Interval::INTERVAL_PRECEDES == cmp) {
-                // We can move to the next pair.
-                ++i;
+                // Interval 'i' starts the next merged interval.
+                ++last;
+                if (last != i) {
+                    iv[last] = iv[i];
+                }
             }
             else if (Interval::INTERVAL_EQUALS == cmp || Interval::INTERVAL_WITHIN == cmp) {
-                // Interval 'i' is equal to i+1, or is contained within i+1.
-                // Remove interval i and don't move to the next value of 'i'.
-                iv.erase(iv.begin() + i);
+                // Interval 'last' is equal to i, or is contained within i. Replace it with i.
+                iv[last] = iv[i];
             }
             else if (Interval::INTERVAL_CONTAINS == cmp) {
-                // Interval 'i' contains i+1, remove i+1 and don't move to the next value of 'i'.
-                iv.erase(iv.begin() + i + 1);
+                // Interval 'last' contains i, so drop i.
             }
             else if (Interval::INTERVAL_OVERLAPS_BEFORE == cmp
                      || Interval::INTERVAL_PRECEDES_COULD_UNION == cmp) {
-                // We want to merge intervals i and i+1.
-                // Interval 'i' starts before interval 'i+1'.
+                // We want to merge intervals last and i.
+                // Interval 'last' starts before interval 'i'.
                 BSONObjBuilder bob;
-                bob.appendAs(iv[i].start, "");
-                bob.appendAs(iv[i + 1].end, "");
+                bob.appendAs(iv[last].start, "");
+                bob.appendAs(iv[i].end, "");
                 BSONObj data = bob.obj();
-                bool startInclusive = iv[i].startInclusive;
-                bool endInclusive = iv[i + 1].endInclusive;
-                iv.erase(iv.begin() + i);
-                // iv[i] is now the former iv[i + 1]
-                iv[i] = makeRangeInterval(data, startInclusive, endInclusive);
-                // Don't increment 'i'.
+                bool startInclusive = iv[last].startInclusive;
+                bool endInclusive = iv[i].endInclusive;
+                iv[last] = makeRangeInterval(data, startInclusive, endInclusive);
+            }
+            else {
+                // The intervals are sorted by start, so nothing else can happen.
+                verify(false);
             }
         }
+        iv.resize(last + 1);
     }
 
     // static
@@ -511,6 +511,29 @@ namespace {
         ASSERT_EQUALS(tightness, IndexBoundsBuilder::EXACT);
     }
 
+    TEST(IndexBoundsBuilderTest, TranslateLargeIn) {
+        IndexEntry testIndex = IndexEntry(BSONObj());
+        BSONArrayBuilder inList;
+        for (int i = 5000; i > 0; --i) {
+            inList.append(i);
+            // Equal to the int, so it doesn't add an interval.
+            inList.append(double(i));
+        }
+        BSONObj obj = BSON("a" << BSON("$in" << inList.arr()));
+        auto_ptr<MatchExpression> expr(parseMatchExpression(obj));
+        BSONElement elt = obj.firstElement();
+        OrderedIntervalList oil;
+        IndexBoundsBuilder::BoundsTightness tightness;
+        IndexBoundsBuilder::translate(expr.get(), elt, testIndex, &oil, &tightness);
+        ASSERT_EQUALS(oil.name, "a");
+        ASSERT_EQUALS(oil.intervals.size(), 5000U);
+        for (int i = 0; i < 5000; ++i) {
+            ASSERT_EQUALS(Interval::INTERVAL_EQUALS, oil.intervals[i].compare(
+                Interval(BSON("" << i + 1 << "" << i + 1), true, true)));
+        }
+        ASSERT_EQUALS(tightness, IndexBoundsBuilder::EXACT);
+    }
+
     TEST(IndexBoundsBuilderTest, TranslateInArray) {
         IndexEntry testIndex = IndexEntry(BSONObj());
         BSONObj obj = fromjson("{a: {$in: [[1], 2]}}");
@@ -622,6 +645,29 @@ namespace {
         ASSERT_EQUALS(tightness, IndexBoundsBuilder::EXACT);
     }
 
+    TEST(IndexBoundsBuilderTest, UnionManyOverlapping) {
+        IndexEntry testIndex = IndexEntry(BSONObj());
+        vector<BSONObj> toUnion;
+        for (int i = 0; i < 100; ++i) {
+            toUnion.push_back(BSON("a" << (i % 10)));
+            toUnion.push_back(BSON("a" << BSON("$lt" << -5 - i)));
+        }
+        toUnion.push_back(fromjson("{a: {$gt: 200}}"));
+        OrderedIntervalList oil;
+        IndexBoundsBuilder::BoundsTightness tightness;
+        testTranslateAndUnion(toUnion, &oil, &tightness);
+        ASSERT_EQUALS(oil.name, "a");
+        ASSERT_EQUALS(oil.intervals.size(), 12U);
+        ASSERT_EQUALS(Interval::INTERVAL_EQUALS, oil.intervals[0].compare(
+            Interval(fromjson("{'': -Infinity, '': -5}"), true, false)));
+        for (int i = 0; i < 10; ++i) {
+            ASSERT_EQUALS(Interval::INTERVAL_EQUALS, oil.intervals[i + 1].compare(
+                Interval(BSON("" << i << "" << i), true, true)));
+        }
+        ASSERT_EQUALS(Interval::INTERVAL_EQUALS, oil.intervals[11].compare(
+            Interval(fromjson("{'': 200, '': Infinity}"), false, true)));
+    }
+
     TEST(IndexBoundsBuilderTest, UnionGtLt) {
         IndexEntry testIndex = IndexEntry(BSONObj());
         vector<BSONObj> toUnion;
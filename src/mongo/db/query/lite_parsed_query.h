@@ -139,6 +139,7 @@ namespace mongo {
         bool returnKey() const { return _returnKey; }
         bool showRecordId() const { return _showRecordId; }
         bool isSnapshot() const { return _snapshot; }
+        bool allowDiskUse() const { return _allowDiskUse; }
         bool hasReadPref() const { return _hasReadPref; }
 
         bool isTailable() const { return _tailable; }
@@ -247,6 +248,7 @@ namespace mongo {
         bool _returnKey = false;
         bool _showRecordId = false;
         bool _snapshot = false;
+        bool _allowDiskUse = false;
         bool _hasReadPref = false;
 
         // Options that can be specified in the OP_QUERY 'flags' header.
@@ -574,6 +574,30 @@ namespace {
         ASSERT_NOT_OK(status);
     }
 
+    TEST(LiteParsedQueryTest, ParseFromCommandAllowDiskUseWrongType) {
+        BSONObj cmdObj = fromjson("{find: 'testns',"
+                                   "sort: {a: 1},"
+                                   "allowDiskUse: 3}");
+
+        LiteParsedQuery* rawLpq;
+        bool isExplain = false;
+        Status status = LiteParsedQuery::make("testns", cmdObj, isExplain, &rawLpq);
+        ASSERT_NOT_OK(status);
+    }
+
+    TEST(LiteParsedQueryTest, ParseFromCommandAllowDiskUse) {
+        BSONObj cmdObj = fromjson("{find: 'testns',"
+                                   "sort: {a: 1},"
+                                   "allowDiskUse: true}");
+
+        LiteParsedQuery* rawLpq;
+        bool isExplain = false;
+        Status status = LiteParsedQuery::make("testns", cmdObj, isExplain, &rawLpq);
+        ASSERT_OK(status);
+        scoped_ptr<LiteParsedQuery> lpq(rawLpq);
+        ASSERT(lpq->allowDiskUse());
+    }
+
     TEST(LiteParsedQueryTest, ParseFromCommandTailableWrongType) {
         BSONObj cmdObj = fromjson("{find: 'testns',"
                                    "filter:  {a: 1},"
@@ -855,6 +879,7 @@ namespace {
         ASSERT_EQUALS(false, lpq->returnKey());
         ASSERT_EQUALS(false, lpq->showRecordId());
         ASSERT_EQUALS(false, lpq->isSnapshot());
+        ASSERT_EQUALS(false, lpq->allowDiskUse());
         ASSERT_EQUALS(false, lpq->hasReadPref());
         ASSERT_EQUALS(false, lpq->isTailable());
         ASSERT_EQUALS(false, lpq->isSlaveOk());
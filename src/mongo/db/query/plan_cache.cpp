@@ -36,6 +36,7 @@
 #include <math.h>
 #include <memory>
 #include "boost/thread/locks.hpp"
+#include <boost/functional/hash.hpp>
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/client/dbclientinterface.h"   // For QueryOption_foobar
 #include "mongo/db/matcher/expression_array.h"
@@ -59,11 +60,18 @@ namespace {
     const char kEncodeSortSection = '~';
     const char kEncodeProjectionSection = '|';
 
+    // Source of PlanCache key generations.  Generation 0 is reserved to mean "no key".
+    AtomicUInt64 planCacheKeyGenerationCounter;
+
+    unsigned long long nextPlanCacheKeyGeneration() {
+        return planCacheKeyGenerationCounter.addAndFetch(1);
+    }
+
     /**
      * Encode user-provided string. Cache key delimiters seen in the
      * user string are escaped with a backslash.
      */
-    void encodeUserString(StringData s, StringBuilder* keyBuilder) {
+    void encodeUserString(StringData s, StackStringBuilder* keyBuilder) {
         for (size_t i = 0; i < s.size(); ++i) {
             char c = s[i];
             switch (c) {
@@ -122,7 +130,7 @@ namespace {
      * - geometry type
      * - CRS (flat or spherical)
      */
-    void encodeGeoMatchExpression(const GeoMatchExpression* tree, StringBuilder* keyBuilder) {
+    void encodeGeoMatchExpression(const GeoMatchExpression* tree, StackStringBuilder* keyBuilder) {
         const GeoExpression& geoQuery = tree->getGeoExpression();
 
         // Type of geo query.
@@ -160,7 +168,7 @@ namespace {
      * - CRS (flat or spherical)
      */
     void encodeGeoNearMatchExpression(const GeoNearMatchExpression* tree,
-                                      StringBuilder* keyBuilder) {
+                                      StackStringBuilder* keyBuilder) {
         const GeoNearExpression& nearQuery = tree->getData();
 
         // isNearSphere
@@ -415,19 +423,43 @@ namespace {
     // PlanCache
     //
 
-    PlanCache::PlanCache() : _cache(internalQueryCacheSize) { }
+    const size_t PlanCache::kMaxPartitions;
 
-    PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize), _ns(ns) { }
+    PlanCache::PlanCache() : _keyGeneration(nextPlanCacheKeyGeneration()) {
+        init();
+    }
+
+    PlanCache::PlanCache(const std::string& ns)
+        : _keyGeneration(nextPlanCacheKeyGeneration()),
+          _ns(ns) {
+        init();
+    }
 
     PlanCache::~PlanCache() { }
 
+    void PlanCache::init() {
+        // Every partition holds at least one entry, and the partitions together hold exactly
+        // 'internalQueryCacheSize' entries.
+        const size_t cacheSize = static_cast<size_t>(std::max(internalQueryCacheSize, 1));
+        const size_t numPartitions = std::min(cacheSize, kMaxPartitions);
+        for (size_t i = 0; i < numPartitions; ++i) {
+            const size_t partitionSize = cacheSize / numPartitions +
+                                         (i < cacheSize % numPartitions ? 1 : 0);
+            _partitions.push_back(new Partition(partitionSize));
+        }
+    }
+
+    PlanCache::Partition& PlanCache::getPartition(const PlanCacheKey& key) const {
+        return *_partitions[boost::hash<PlanCacheKey>()(key) % _partitions.size()];
+    }
+
     /**
      * Traverses expression tree pre-order.
      * Appends an encoding of each node's match type and path name
      * to the output stream.
      */
     void PlanCache::encodeKeyForMatch(const MatchExpression* tree,
-                                      StringBuilder* keyBuilder) const {
+                                      StackStringBuilder* keyBuilder) const {
         // Encode match type and path.
         *keyBuilder << encodeMatchType(tree->matchType());
 
@@ -476,7 +508,7 @@ namespace {
      * Sort order is normalized because it provided by
      * LiteParsedQuery.
      */
-    void PlanCache::encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const {
+    void PlanCache::encodeKeyForSort(const BSONObj& sortObj, StackStringBuilder* keyBuilder) const {
         if (sortObj.isEmpty()) {
             return;
         }
@@ -514,7 +546,7 @@ namespace {
      * Orders the encoded elements in the projection by field name.
      * This handles all the special projection types ($meta, $elemMatch, etc.)
      */
-    void PlanCache::encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const {
+    void PlanCache::encodeKeyForProj(const BSONObj& projObj, StackStringBuilder* keyBuilder) const {
         if (projObj.isEmpty()) {
             return;
         }
@@ -573,10 +605,14 @@ namespace {
         entry->sort = pq.getSort().getOwned();
         entry->projection = pq.getProj().getOwned();
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        std::auto_ptr<PlanCacheEntry> evictedEntry = _cache.add(computeKey(query), entry);
+        PlanCacheKey key = computeKey(query);
+        Partition& partition = getPartition(key);
+
+        boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
+        std::auto_ptr<PlanCacheEntry> evictedEntry = partition.cache.add(key, entry);
 
         if (NULL != evictedEntry.get()) {
+            _evictions.fetchAndAdd(1);
             LOG(1) << _ns << ": plan cache maximum size exceeded - "
                    << "removed least recently used entry "
                    << evictedEntry->toString();
@@ -589,13 +625,16 @@ namespace {
         PlanCacheKey key = computeKey(query);
         verify(crOut);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        Partition& partition = getPartition(key);
+        boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
+        Status cacheStatus = partition.cache.get(key, &entry);
         if (!cacheStatus.isOK()) {
+            _misses.fetchAndAdd(1);
             return cacheStatus;
         }
         invariant(entry);
+        _hits.fetchAndAdd(1);
 
         *crOut = new CachedSolution(key, *entry);
 
@@ -609,9 +648,10 @@ namespace {
         std::auto_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
         PlanCacheKey ck = computeKey(cq);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        Partition& partition = getPartition(ck);
+        boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(ck, &entry);
+        Status cacheStatus = partition.cache.get(ck, &entry);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
@@ -626,31 +666,45 @@ namespace {
     }
 
     Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.remove(computeKey(canonicalQuery));
+        PlanCacheKey key = computeKey(canonicalQuery);
+        Partition& partition = getPartition(key);
+        boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
+        return partition.cache.remove(key);
     }
 
     void PlanCache::clear() {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        _cache.clear();
+        for (size_t i = 0; i < _partitions.size(); ++i) {
+            boost::lock_guard<boost::mutex> cacheLock(_partitions[i]->mutex);
+            _partitions[i]->cache.clear();
+        }
         _writeOperations.store(0);
     }
 
     PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
-        StringBuilder keyBuilder;
+        const PlanCacheKey* memoizedKey = cq.getMemoizedPlanCacheKey(_keyGeneration);
+        if (memoizedKey) {
+            return *memoizedKey;
+        }
+
+        // Most keys fit in the builder's stack buffer, which saves a heap allocation.
+        StackStringBuilder keyBuilder;
         encodeKeyForMatch(cq.root(), &keyBuilder);
         encodeKeyForSort(cq.getParsed().getSort(), &keyBuilder);
         encodeKeyForProj(cq.getParsed().getProj(), &keyBuilder);
-        return keyBuilder.str();
+
+        PlanCacheKey key = keyBuilder.str();
+        cq.memoizePlanCacheKey(_keyGeneration, key);
+        return key;
     }
 
     Status PlanCache::getEntry(const CanonicalQuery& query, PlanCacheEntry** entryOut) const {
         PlanCacheKey key = computeKey(query);
         verify(entryOut);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        Partition& partition = getPartition(key);
+        boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
+        Status cacheStatus = partition.cache.get(key, &entry);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
@@ -662,25 +716,41 @@ namespace {
     }
 
     std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
         std::vector<PlanCacheEntry*> entries;
         typedef std::list< std::pair<PlanCacheKey, PlanCacheEntry*> >::const_iterator ConstIterator;
-        for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-            PlanCacheEntry* entry = i->second;
-            entries.push_back(entry->clone());
+        for (size_t p = 0; p < _partitions.size(); ++p) {
+            const Partition& partition = *_partitions[p];
+            boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
+            for (ConstIterator i = partition.cache.begin(); i != partition.cache.end(); i++) {
+                PlanCacheEntry* entry = i->second;
+                entries.push_back(entry->clone());
+            }
         }
 
         return entries;
     }
 
     bool PlanCache::contains(const CanonicalQuery& cq) const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.hasKey(computeKey(cq));
+        PlanCacheKey key = computeKey(cq);
+        Partition& partition = getPartition(key);
+        boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
+        return partition.cache.hasKey(key);
     }
 
     size_t PlanCache::size() const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.size();
+        size_t total = 0;
+        for (size_t i = 0; i < _partitions.size(); ++i) {
+            boost::lock_guard<boost::mutex> cacheLock(_partitions[i]->mutex);
+            total += _partitions[i]->cache.size();
+        }
+        return total;
+    }
+
+    void PlanCache::appendStats(BSONObjBuilder* builder) const {
+        builder->appendNumber("size", static_cast<long long>(size()));
+        builder->appendNumber("hits", static_cast<long long>(_hits.load()));
+        builder->appendNumber("misses", static_cast<long long>(_misses.load()));
+        builder->appendNumber("evictions", static_cast<long long>(_evictions.load()));
     }
 
     void PlanCache::notifyOfWriteOp() {
@@ -698,6 +768,9 @@ namespace {
 
     void PlanCache::notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries) {
         _indexabilityState.updateDiscriminators(indexEntries);
+
+        // Keys computed against the old index set may no longer be correct.
+        _keyGeneration = nextPlanCacheKeyGeneration();
     }
 
 }  // namespace mongo
@@ -33,6 +33,7 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_tag.h"
@@ -344,6 +345,9 @@ namespace mongo {
          * This is provided in the public API simply as a convenience for consumers who need some
          * description of query shape (e.g. index filters).
          *
+         * The key is memoized on the query, so only the first call for a given query pays for
+         * encoding it.
+         *
          * Callers must hold the collection lock when calling this method.
          */
         PlanCacheKey computeKey(const CanonicalQuery&) const;
@@ -379,6 +383,12 @@ namespace mongo {
          */
         size_t size() const;
 
+        /**
+         * Appends the number of entries and the cumulative hit, miss and eviction counts of the
+         * cache to 'builder'.  Used by collStats.
+         */
+        void appendStats(BSONObjBuilder* builder) const;
+
         /**
          *  You must notify the cache if you are doing writes, as query plan utility will change.
          *  Cache is flushed after every 1000 notifications.
@@ -394,14 +404,46 @@ namespace mongo {
         void notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries);
 
     private:
-        void encodeKeyForMatch(const MatchExpression* tree, StringBuilder* keyBuilder) const;
-        void encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const;
-        void encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const;
+        void encodeKeyForMatch(const MatchExpression* tree, StackStringBuilder* keyBuilder) const;
+        void encodeKeyForSort(const BSONObj& sortObj, StackStringBuilder* keyBuilder) const;
+        void encodeKeyForProj(const BSONObj& projObj, StackStringBuilder* keyBuilder) const;
+
+        /**
+         * One slice of the cache.  Entries are spread over the partitions by a hash of their
+         * key, so that concurrent queries of different shapes rarely contend on the same mutex.
+         * Each partition runs its own LRU policy over a share of 'internalQueryCacheSize', and
+         * the shares add up to exactly that size.
+         */
+        struct Partition {
+            explicit Partition(size_t maxSize) : cache(maxSize) { }
 
-        LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
+            LRUKeyValue<PlanCacheKey, PlanCacheEntry> cache;
 
-        // Protects _cache.
-        mutable boost::mutex _cacheMutex;
+            // Protects 'cache'.
+            mutable boost::mutex mutex;
+        };
+
+        void init();
+
+        Partition& getPartition(const PlanCacheKey& key) const;
+
+        // A cache smaller than this has one partition per entry.
+        static const size_t kMaxPartitions = 16;
+
+        OwnedPointerVector<Partition> _partitions;
+
+        // Cumulative lookup and eviction counts since the cache was created.  Unlike the
+        // entries themselves, these survive clear().
+        mutable AtomicUInt64 _hits;
+        mutable AtomicUInt64 _misses;
+        AtomicUInt64 _evictions;
+
+        // Identifies the state that cache keys are currently computed from.  A fresh, globally
+        // unique value is taken whenever that state changes, so that a key memoized on a
+        // CanonicalQuery is only reused by the cache and index set that produced it.
+        //
+        // Concurrent access is synchronized by the collection lock, as for _indexabilityState.
+        unsigned long long _keyGeneration;
 
         // Counter for write notifications since initialization or last clear() invocation.  Starts
         // at 0.
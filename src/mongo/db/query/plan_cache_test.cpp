@@ -424,6 +424,50 @@ namespace {
         ASSERT_EQUALS(planCache.size(), 1U);
     }
 
+    TEST(PlanCacheTest, StatsCountHitsMissesAndEvictions) {
+        // The cache holds no more than 'internalQueryCacheSize' entries, however they are spread
+        // over its partitions, so adding more distinct query shapes has to evict something.
+        const int oldCacheSize = internalQueryCacheSize;
+        internalQueryCacheSize = 3;
+        PlanCache planCache;
+        internalQueryCacheSize = oldCacheSize;
+
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+
+        auto_ptr<CanonicalQuery> cq;
+        for (int i = 0; i < 17; ++i) {
+            cq.reset(canonicalize(BSON(std::string(str::stream() << "a" << i) << 1)));
+            ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+        }
+        ASSERT_LESS_THAN_OR_EQUALS(planCache.size(), 3U);
+
+        // The most recently added shape is always present.
+        CachedSolution* rawCachedSolution;
+        ASSERT_OK(planCache.get(*cq, &rawCachedSolution));
+        delete rawCachedSolution;
+
+        auto_ptr<CanonicalQuery> uncachedCq(canonicalize("{b: 1}"));
+        ASSERT_NOT_OK(planCache.get(*uncachedCq, &rawCachedSolution));
+
+        BSONObjBuilder bob;
+        planCache.appendStats(&bob);
+        BSONObj stats = bob.obj();
+        ASSERT_EQUALS(static_cast<long long>(planCache.size()), stats["size"].numberLong());
+        ASSERT_EQUALS(1, stats["hits"].numberLong());
+        ASSERT_EQUALS(1, stats["misses"].numberLong());
+        ASSERT_EQUALS(17 - stats["size"].numberLong(), stats["evictions"].numberLong());
+
+        // Clearing the cache keeps the counters.
+        planCache.clear();
+        BSONObjBuilder clearedBob;
+        planCache.appendStats(&clearedBob);
+        ASSERT_EQUALS(1, clearedBob.obj()["hits"].numberLong());
+    }
+
     /**
      * Each test in the CachePlanSelectionTest suite goes through
      * the following flow:
@@ -1185,6 +1229,27 @@ namespace {
         ASSERT_NOT_EQUALS(planCache.computeKey(*cqEqNull), planCache.computeKey(*cqEqNumber));
     }
 
+    // A key memoized on a query must not outlive a change to the index set it was computed for,
+    // nor be reused by a different cache.
+    TEST(PlanCacheTest, ComputeKeyMemoizationRespectsIndexChanges) {
+        PlanCache planCache;
+        unique_ptr<CanonicalQuery> cqEqNull(canonicalize("{a: null}}"));
+        unique_ptr<CanonicalQuery> cqEqNumber(canonicalize("{a: 0}}"));
+        ASSERT_EQ(planCache.computeKey(*cqEqNull), planCache.computeKey(*cqEqNumber));
+
+        planCache.notifyOfIndexEntries({IndexEntry(BSON("a" << 1),
+                                                   false, // multikey
+                                                   true, // sparse
+                                                   false, // unique
+                                                   "", // name
+                                                   nullptr, // filterExpr
+                                                   BSONObj())});
+        ASSERT_NOT_EQUALS(planCache.computeKey(*cqEqNull), planCache.computeKey(*cqEqNumber));
+
+        PlanCache otherPlanCache;
+        ASSERT_EQ(otherPlanCache.computeKey(*cqEqNull), otherPlanCache.computeKey(*cqEqNumber));
+    }
+
     // When a partial index is present, computeKey() should generate different keys depending on
     // whether or not the predicates in the given query "match" the predicates in the partial index
     // filter.
@@ -43,6 +43,7 @@
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 
 #include "mongo/util/stacktrace.h"
@@ -297,6 +298,25 @@ namespace mongo {
 
     void PlanExecutor::invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type) {
         if (!killed()) { _root->invalidate(txn, dl, type); }
+
+        // Batched results which haven't been handed out yet belong to us rather than any stage.
+        // If the document is being deleted or changed, keep our own copy of it or, for index
+        // keys, drop it.
+        for (size_t i = _nextBatchedResult; i < _batchedResults.size(); i++) {
+            WorkingSetMember* member = _workingSet->get(_batchedResults[i]);
+            if (!member->hasLoc() || member->loc != dl) {
+                continue;
+            }
+
+            if (member->hasObj()) {
+                WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+            }
+            else {
+                _workingSet->free(_batchedResults[i]);
+                _batchedResults.erase(_batchedResults.begin() + i);
+                i--;
+            }
+        }
     }
 
     PlanExecutor::ExecState PlanExecutor::getNext(BSONObj* objOut, RecordId* dlOut) {
@@ -365,7 +385,7 @@ namespace mongo {
             fetcher.reset();
 
             WorkingSetID id = WorkingSet::INVALID_ID;
-            PlanStage::StageState code = _root->work(&id);
+            PlanStage::StageState code = workRoot(&id);
 
             if (code != PlanStage::NEED_YIELD)
                 writeConflictsInARow = 0;
@@ -466,8 +486,32 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState PlanExecutor::workRoot(WorkingSetID* out) {
+        if (_nextBatchedResult < _batchedResults.size()) {
+            *out = _batchedResults[_nextBatchedResult++];
+            return PlanStage::ADVANCED;
+        }
+
+        const int batchSize = internalQueryExecWorkBatchSize;
+        if (batchSize <= 1) {
+            return _root->work(out);
+        }
+
+        _batchedResults.clear();
+        _nextBatchedResult = 0;
+
+        PlanStage::StageState code = _root->workBatch(batchSize, &_batchedResults, out);
+        if (PlanStage::ADVANCED == code) {
+            invariant(!_batchedResults.empty());
+            *out = _batchedResults[_nextBatchedResult++];
+        }
+        return code;
+    }
+
     bool PlanExecutor::isEOF() {
-        return killed() || (_stash.empty() && _root->isEOF());
+        return killed() || (_stash.empty()
+                            && _nextBatchedResult == _batchedResults.size()
+                            && _root->isEOF());
     }
 
     void PlanExecutor::registerExec() {
@@ -31,8 +31,10 @@
 #include <boost/optional.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <queue>
+#include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/storage/snapshot.h"
@@ -42,7 +44,6 @@ namespace mongo {
     class BSONObj;
     class Collection;
     class RecordId;
-    class PlanStage;
     class PlanExecutor;
     struct PlanStageStats;
     class PlanYieldPolicy;
@@ -410,6 +411,13 @@ namespace mongo {
 
         bool killed() { return static_cast<bool>(_killReason); };
 
+        /**
+         * Gets the next state and result from the root stage, like _root->work(). Results are
+         * produced a batch at a time if internalQueryExecWorkBatchSize allows, and handed out one
+         * at a time from _batchedResults.
+         */
+        PlanStage::StageState workRoot(WorkingSetID* out);
+
         // The OperationContext that we're executing within.  We need this in order to release
         // locks.
         OperationContext* _opCtx;
@@ -442,6 +450,11 @@ namespace mongo {
         // to consume yet. We empty the queue before retrieving further results from the plan
         // stages.
         std::queue<BSONObj> _stash;
+
+        // Results of the root stage's last workBatch(). Those before _nextBatchedResult have
+        // already been handed out by workRoot().
+        std::vector<WorkingSetID> _batchedResults;
+        size_t _nextBatchedResult = 0;
     };
 
 }  // namespace mongo
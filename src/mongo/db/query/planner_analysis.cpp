@@ -466,6 +466,7 @@ namespace mongo {
         SortNode* sort = new SortNode();
         sort->pattern = sortObj;
         sort->query = lpq.getFilter();
+        sort->allowDiskUse = lpq.allowDiskUse();
         sort->children.push_back(solnRoot);
         solnRoot = sort;
         // When setting the limit on the sort, we need to consider both
@@ -527,6 +528,14 @@ namespace mongo {
             sort->limit = 0;
         }
 
+        // When the sort is on the text score alone, the text stage can find the best documents
+        // itself without reading all of the index keys for the search terms.
+        if (sort->limit && STAGE_TEXT == sort->children[0]->getType()
+            && 1 == sortObj.nFields()
+            && LiteParsedQuery::isTextScoreMeta(sortObj.firstElement())) {
+            static_cast<TextNode*>(sort->children[0])->limit = sort->limit;
+        }
+
         *blockingSortOut = true;
 
         return solnRoot;
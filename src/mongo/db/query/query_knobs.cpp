@@ -68,4 +68,8 @@ namespace mongo {
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldIterations, int, 128);
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldPeriodMS, int, 10);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecWorkBatchSize, int, 1);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryTextNegatedKeysPerCandidate, int, 10);
+
 }  // namespace mongo
@@ -104,4 +104,12 @@ namespace mongo {
     // Yield if it's been at least this many milliseconds since we last yielded.
     extern int internalQueryExecYieldPeriodMS;
 
+    // How many units of work the PlanExecutor asks of the plan at once, with
+    // PlanStage::workBatch(). At 1 it calls PlanStage::work() for each.
+    extern int internalQueryExecWorkBatchSize;
+
+    // How many index keys may a text search read per candidate document to find the documents
+    // with negated terms, rather than tokenizing each candidate to look for them? 0 never does.
+    extern int internalQueryTextNegatedKeysPerCandidate;
+
 }  // namespace mongo
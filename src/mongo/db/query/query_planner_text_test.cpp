@@ -340,4 +340,44 @@ namespace {
         assertSolutionExists("{text: {search: 'blah', caseSensitive: true}}");
     }
 
+    // A sort on the text score alone lets the text stage look for just the top results.
+    TEST_F(QueryPlannerTest, TextScoreSortWithLimit) {
+        addIndex(BSON("_fts" << "text" << "_ftsx" << 1));
+        runQuerySortProjSkipLimit(fromjson("{$text: {$search: 'blah'}}"),
+                                  fromjson("{score: {$meta: 'textScore'}}"),
+                                  fromjson("{score: {$meta: 'textScore'}}"),
+                                  5, 20);
+
+        assertNumSolutions(1);
+        assertSolutionExists("{skip: {n: 5, node: {proj: {spec: {score: {$meta: 'textScore'}}, "
+                             "node: {sort: {pattern: {score: {$meta: 'textScore'}}, limit: 25, "
+                             "node: {text: {search: 'blah', limit: 25}}}}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, TextScoreSortWithoutLimit) {
+        addIndex(BSON("_fts" << "text" << "_ftsx" << 1));
+        runQuerySortProj(fromjson("{$text: {$search: 'blah'}}"),
+                         fromjson("{score: {$meta: 'textScore'}}"),
+                         fromjson("{score: {$meta: 'textScore'}}"));
+
+        assertNumSolutions(1);
+        assertSolutionExists("{proj: {spec: {score: {$meta: 'textScore'}}, "
+                             "node: {sort: {pattern: {score: {$meta: 'textScore'}}, limit: 0, "
+                             "node: {text: {search: 'blah', limit: 0}}}}}}");
+    }
+
+    // A sort on other fields as well needs all of the text results.
+    TEST_F(QueryPlannerTest, CompoundTextScoreSortWithLimit) {
+        addIndex(BSON("_fts" << "text" << "_ftsx" << 1));
+        runQuerySortProjSkipLimit(fromjson("{$text: {$search: 'blah'}}"),
+                                  fromjson("{score: {$meta: 'textScore'}, a: 1}"),
+                                  fromjson("{score: {$meta: 'textScore'}}"),
+                                  0, 20);
+
+        assertNumSolutions(1);
+        assertSolutionExists("{proj: {spec: {score: {$meta: 'textScore'}}, "
+                             "node: {sort: {pattern: {score: {$meta: 'textScore'}, a: 1}, "
+                             "limit: 20, node: {text: {search: 'blah', limit: 0}}}}}}");
+    }
+
 }  // namespace
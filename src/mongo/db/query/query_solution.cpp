@@ -80,6 +80,10 @@ namespace mongo {
         *ss << "caseSensitive= " << caseSensitive << '\n';
         addIndent(ss, indent + 1);
         *ss << "indexPrefix = " << indexPrefix.toString() << '\n';
+        if (limit) {
+            addIndent(ss, indent + 1);
+            *ss << "limit = " << limit << '\n';
+        }
         if (NULL != filter) {
             addIndent(ss, indent + 1);
             *ss << " filter = " << filter->toString();
@@ -97,6 +101,7 @@ namespace mongo {
         copy->language = this->language;
         copy->caseSensitive = this->caseSensitive;
         copy->indexPrefix = this->indexPrefix;
+        copy->limit = this->limit;
 
         return copy;
     }
@@ -631,6 +636,10 @@ namespace mongo {
         *ss << "query for bounds = " << query.toString() << '\n';
         addIndent(ss, indent + 1);
         *ss << "limit = " << limit << '\n';
+        if (allowDiskUse) {
+            addIndent(ss, indent + 1);
+            *ss << "allowDiskUse = true" << '\n';
+        }
         addCommon(ss, indent);
         addIndent(ss, indent + 1);
         *ss << "Child:" << '\n';
@@ -645,6 +654,7 @@ namespace mongo {
         copy->pattern = this->pattern;
         copy->query = this->query;
         copy->limit = this->limit;
+        copy->allowDiskUse = this->allowDiskUse;
 
         return copy;
     }
@@ -111,6 +111,7 @@ namespace mongo {
             params.pattern = sn->pattern;
             params.query = sn->query;
             params.limit = sn->limit;
+            params.allowDiskUse = sn->allowDiskUse;
             return new SortStage(params, ws, childStage);
         }
         else if (STAGE_PROJECTION == root->getType()) {
@@ -259,6 +260,7 @@ namespace mongo {
             params.index = index;
             params.spec = fam->getSpec();
             params.indexPrefix = node->indexPrefix;
+            params.limit = node->limit;
 
             const std::string& language = ("" == node->language
                                            ? fam->getSpec().defaultLanguage().str()
@@ -70,7 +70,12 @@ namespace {
             for ( size_t i = 0; i < indexNames.size(); i++ ) {
                 const string& name = indexNames[i];
                 BSONObj spec = cce->getIndexSpec( txn, name );
-                indexSpecs.push_back(spec.removeField("v").getOwned());
+                // Rebuilt indexes get the default version, unless they asked for prefix
+                // compressed (v2) buckets.
+                if (spec["v"].numberInt() != 2) {
+                    spec = spec.removeField("v");
+                }
+                indexSpecs.push_back(spec.getOwned());
 
                 const BSONObj key = spec.getObjectField("key");
                 const Status keyStatus = validateKeyPattern(key);
@@ -113,6 +113,7 @@ namespace {
                                        _lastFetchedHash(0),
                                        _pause(true),
                                        _appliedBuffer(true),
+                                       _batchesInFlight(0),
                                        _replCoord(getGlobalReplicationCoordinator()),
                                        _initialSyncRequestedFlag(false),
                                        _indexPrefetchConfig(PREFETCH_ALL) {
@@ -141,14 +142,41 @@ namespace {
 
     void BackgroundSync::notify(OperationContext* txn) {
         boost::lock_guard<boost::mutex> lock(_mutex);
+        _notify_inlock();
+    }
 
-        // If all ops in the buffer have been applied, unblock waitForRepl (if it's waiting)
-        if (_buffer.empty()) {
+    void BackgroundSync::_notify_inlock() {
+        // If all ops in the buffer have been applied, unblock waitForRepl (if it's waiting).
+        // Ops which the applier took out of the buffer are only applied once their batch is.
+        if (_buffer.empty() && _batchesInFlight == 0) {
             _appliedBuffer = true;
             _appliedBufferCondition.notify_all();
         }
     }
 
+    void BackgroundSync::startedBatch() {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        _batchesInFlight++;
+    }
+
+    void BackgroundSync::finishedBatch(OperationContext* txn) {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        invariant(_batchesInFlight > 0);
+        _batchesInFlight--;
+        _notify_inlock();
+    }
+
+    void BackgroundSync::clearBatchesInFlight(OperationContext* txn) {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        _batchesInFlight = 0;
+        _notify_inlock();
+    }
+
+    bool BackgroundSync::hasBatchesInFlight() {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        return _batchesInFlight > 0;
+    }
+
     void BackgroundSync::producerThread() {
         Client::initThread("rsBackgroundSync");
         AuthorizationSession::get(cc())->grantInternalAuthorization();
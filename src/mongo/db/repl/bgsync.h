@@ -86,6 +86,15 @@ namespace repl {
         void shutdown();
         void notify(OperationContext* txn);
 
+        // The applier calls startedBatch() before it takes the first op of a batch out of the
+        // buffer, and finishedBatch() once that batch has been applied.  The buffer only counts
+        // as applied when it is empty and no batch taken out of it is still being applied.
+        void startedBatch();
+        void finishedBatch(OperationContext* txn);
+        // Forgets the batches which the applier dropped without applying them.
+        void clearBatchesInFlight(OperationContext* txn);
+        bool hasBatchesInFlight();
+
         // Blocks until _pause becomes true from a call to stop() or shutdown()
         void waitUntilPaused();
 
@@ -154,6 +163,8 @@ namespace repl {
         boost::condition _pausedCondition;
         bool _appliedBuffer;
         boost::condition _appliedBufferCondition;
+        // number of batches taken out of _buffer which haven't been applied yet
+        int _batchesInFlight;
 
         HostAndPort _syncSourceHost;
 
@@ -168,6 +179,9 @@ namespace repl {
         // Checks the criteria for rolling back and executes a rollback if warranted.
         bool _rollbackIfNeeded(OperationContext* txn, OplogReader& r);
 
+        // Wakes up the producer if the applier has applied everything it took out of _buffer.
+        void _notify_inlock();
+
         // Evaluate if the current sync target is still good
         bool shouldChangeSyncSource();
 
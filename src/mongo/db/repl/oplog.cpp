@@ -116,54 +116,62 @@ namespace {
     }
 
     /**
-     * Allocates an optime for a new entry in the oplog, and updates the replication coordinator to
-     * reflect that new optime.  Returns the new optime and the correct value of the "h" field for
-     * the new oplog entry.
+     * Allocates optimes for 'count' new entries in the oplog, and updates the replication
+     * coordinator to reflect the last of them.  Fills 'slotsOut' with each new optime and the
+     * correct value of the "h" field for its oplog entry.
      *
-     * NOTE: From the time this function returns to the time that the new oplog entry is written
+     * NOTE: From the time this function returns to the time that the new oplog entries are written
      * to the storage system, all errors must be considered fatal.  This is because the this
-     * function registers the new optime with the storage system and the replication coordinator,
+     * function registers the new optimes with the storage system and the replication coordinator,
      * and provides no facility to revert those registrations on rollback.
      */
-    std::pair<OpTime, long long> getNextOpTime(OperationContext* txn,
-                                               Collection* oplog,
-                                               const char* ns,
-                                               ReplicationCoordinator* replCoord,
-                                               const char* opstr) {
+    void getNextOpTimes(OperationContext* txn,
+                        Collection* oplog,
+                        const char* ns,
+                        ReplicationCoordinator* replCoord,
+                        const char* opstr,
+                        size_t count,
+                        std::vector<std::pair<OpTime, long long> >* slotsOut) {
         boost::lock_guard<boost::mutex> lk(newOpMutex);
-        Timestamp ts = getNextGlobalTimestamp();
-        newTimestampNotifier.notify_all();
 
-        fassert(28560, oplog->getRecordStore()->oplogDiskLocRegister(txn, ts));
+        // Current term. If we're not a replset of pv=1, it could be the default value (0) or
+        // the last valid term before downgrade.
+        const bool isReplSet =
+            replCoord->getReplicationMode() == ReplicationCoordinator::modeReplSet;
+        const long long term = isReplSet ? ReplClientInfo::forClient(txn->getClient()).getTerm()
+                                         : 0;
+
+        // Check to make sure logOp() is legal at this point.
+        if (isReplSet && *opstr == 'n') {
+            // 'n' operations are always logged
+            invariant(*ns == '\0');
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            Timestamp ts = getNextGlobalTimestamp();
 
-        long long hashNew = 0;
-        long long term = 0;
+            fassert(28560, oplog->getRecordStore()->oplogDiskLocRegister(txn, ts));
 
-        // Set hash and term if we're in replset mode, otherwise they remain 0 in master/slave.
-        if (replCoord->getReplicationMode() == ReplicationCoordinator::modeReplSet) {
-            // Current term. If we're not a replset of pv=1, it could be the default value (0) or
-            // the last valid term before downgrade.
-            term = ReplClientInfo::forClient(txn->getClient()).getTerm();
+            long long hashNew = 0;
 
-            hashNew = BackgroundSync::get()->getLastAppliedHash();
+            // Set hash if we're in replset mode, otherwise it remains 0 in master/slave.
+            if (isReplSet) {
+                hashNew = BackgroundSync::get()->getLastAppliedHash();
 
-            // Check to make sure logOp() is legal at this point.
-            if (*opstr == 'n') {
-                // 'n' operations are always logged
-                invariant(*ns == '\0');
                 // 'n' operations do not advance the hash, since they are not rolled back
-            }
-            else {
-                // Advance the hash
-                hashNew = (hashNew * 131 + ts.asLL()) * 17 + replCoord->getMyId();
+                if (*opstr != 'n') {
+                    // Advance the hash
+                    hashNew = (hashNew * 131 + ts.asLL()) * 17 + replCoord->getMyId();
 
-                BackgroundSync::get()->setLastAppliedHash(hashNew);
+                    BackgroundSync::get()->setLastAppliedHash(hashNew);
+                }
             }
+
+            slotsOut->push_back(std::pair<OpTime, long long>(OpTime(ts, term), hashNew));
         }
+        newTimestampNotifier.notify_all();
 
-        OpTime opTime(ts, term);
-        replCoord->setMyLastOptime(opTime);
-        return std::pair<OpTime,long long>(opTime, hashNew);
+        replCoord->setMyLastOptime(slotsOut->back().first);
     }
 
     /**
@@ -238,12 +246,15 @@ namespace {
 
     */
 
-    void _logOp(OperationContext* txn,
-                const char *opstr,
-                const char *ns,
-                const BSONObj& obj,
-                BSONObj *o2,
-                bool fromMigrate) {
+namespace {
+
+    void _logOpsImpl(OperationContext* txn,
+                     const char *opstr,
+                     const char *ns,
+                     const BSONObj* objs,
+                     size_t count,
+                     BSONObj *o2,
+                     bool fromMigrate) {
         if ( strncmp(ns, "local.", 6) == 0 ) {
             return;
         }
@@ -260,6 +271,10 @@ namespace {
             return;
         }
 
+        if (count == 0) {
+            return;
+        }
+
         fassert(28626, txn->recoveryUnit());
 
         Lock::DBLock lk(txn->lockState(), "local", MODE_IX);
@@ -285,36 +300,56 @@ namespace {
                     _localOplogCollection);
         }
 
-        std::pair<OpTime, long long> slot = getNextOpTime(txn,
-                                                          _localOplogCollection,
-                                                          ns,
-                                                          replCoord,
-                                                          opstr);
-
-        /* we jump through a bunch of hoops here to avoid copying the obj buffer twice --
-           instead we do a single copy to the destination position in the memory mapped file.
-        */
-
-        BSONObjBuilder b(256);
-        b.append("ts", slot.first.getTimestamp());
-        b.append("t", slot.first.getTerm());
-        b.append("h", slot.second);
-        b.append("v", OPLOG_VERSION);
-        b.append("op", opstr);
-        b.append("ns", ns);
-        if (fromMigrate) {
-            b.appendBool("fromMigrate", true);
-        }
+        std::vector<std::pair<OpTime, long long> > slots;
+        slots.reserve(count);
+        getNextOpTimes(txn, _localOplogCollection, ns, replCoord, opstr, count, &slots);
+
+        for (size_t i = 0; i < count; i++) {
+            /* we jump through a bunch of hoops here to avoid copying the obj buffer twice --
+               instead we do a single copy to the destination position in the memory mapped file.
+            */
+
+            BSONObjBuilder b(256);
+            b.append("ts", slots[i].first.getTimestamp());
+            b.append("t", slots[i].first.getTerm());
+            b.append("h", slots[i].second);
+            b.append("v", OPLOG_VERSION);
+            b.append("op", opstr);
+            b.append("ns", ns);
+            if (fromMigrate) {
+                b.appendBool("fromMigrate", true);
+            }
 
-        if ( o2 ) {
-            b.append("o2", *o2);
+            if ( o2 ) {
+                b.append("o2", *o2);
+            }
+            BSONObj partial = b.done();
+
+            OplogDocWriter writer( partial, objs[i] );
+            checkOplogInsert( _localOplogCollection->insertDocument( txn, &writer, false ) );
         }
-        BSONObj partial = b.done();
 
-        OplogDocWriter writer( partial, obj );
-        checkOplogInsert( _localOplogCollection->insertDocument( txn, &writer, false ) );
+        ReplClientInfo::forClient(txn->getClient()).setLastOp( slots.back().first );
+    }
+
+} // namespace
+
+    void _logOp(OperationContext* txn,
+                const char *opstr,
+                const char *ns,
+                const BSONObj& obj,
+                BSONObj *o2,
+                bool fromMigrate) {
+        _logOpsImpl(txn, opstr, ns, &obj, 1, o2, fromMigrate);
+    }
 
-        ReplClientInfo::forClient(txn->getClient()).setLastOp( slot.first );
+    void _logOps(OperationContext* txn,
+                 const char *opstr,
+                 const char *ns,
+                 const std::vector<BSONObj>& objs,
+                 bool fromMigrate) {
+        _logOpsImpl(txn, opstr, ns, objs.empty() ? NULL : &objs[0], objs.size(), NULL,
+                    fromMigrate);
     }
 
     OpTime writeOpsToOplog(OperationContext* txn, const std::deque<BSONObj>& ops) {
@@ -656,6 +691,32 @@ namespace {
                     uassertStatusOK(status);
                 }
             }
+            else if (fieldO.type() == Array) {
+                // A group of inserts into one collection, built by the oplog applier. They are
+                // applied as plain inserts in a single unit of work; if any of them fails, for
+                // instance because it has been applied before, the caller applies the group one
+                // op at a time instead.
+                uassert(ErrorCodes::NamespaceNotFound, str::stream() <<
+                        "Failed to apply insert due to missing collection: " << op.toString(),
+                        collection);
+
+                WriteUnitOfWork wuow(txn);
+                bool first = true;
+                BSONObjIterator docIt(fieldO.embeddedObject());
+                while (docIt.more()) {
+                    const BSONObj doc = docIt.next().Obj();
+                    uassert(ErrorCodes::NoSuchKey, str::stream() <<
+                            "Failed to apply insert due to missing _id: " << doc.toString(),
+                            doc.hasField("_id"));
+                    uassertStatusOK(collection->insertDocument(txn, doc, true).getStatus());
+                    if (!first) {
+                        // gotInsert() was already called once for the whole op above.
+                        opCounters->gotInsert();
+                    }
+                    first = false;
+                }
+                wuow.commit();
+            }
             else {
                 // do upserts for inserts as we might get replayed more than once
                 OpDebug debug;
@@ -31,6 +31,7 @@
 #include <cstddef>
 #include <deque>
 #include <string>
+#include <vector>
 
 #include "mongo/base/status.h"
 #include "mongo/base/disallow_copying.h"
@@ -88,6 +89,16 @@ namespace repl {
                 BSONObj *o2,
                 bool fromMigrate);
 
+    /**
+     * Logs an operation of the same type for each of 'objs', as _logOp would, but taking the
+     * oplog locks and allocating the optimes once for the whole group.
+     */
+    void _logOps(OperationContext* txn,
+                 const char *opstr,
+                 const char *ns,
+                 const std::vector<BSONObj>& objs,
+                 bool fromMigrate);
+
     // Flush out the cached pointers to the local database and oplog.
     // Used by the closeDatabase command to ensure we don't cache closed things.
     void oplogCheckCloseDatabase(OperationContext* txn, Database * db);
@@ -33,6 +33,7 @@
 
 #include "mongo/db/repl/sync_tail.h"
 
+#include <algorithm>
 #include <boost/functional/hash.hpp>
 #include <boost/ref.hpp>
 #include <memory>
@@ -46,9 +47,12 @@
 #include "mongo/db/catalog/document_validation.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/db/db_raii.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/prefetch.h"
@@ -59,26 +63,62 @@
 #include "mongo/db/repl/replica_set_config.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/stats/timer_stats.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
     using std::endl;
 
 namespace repl {
+namespace {
 #if defined(MONGO_PLATFORM_64)
-    const int replWriterThreadCount = 16;
-    const int replPrefetcherThreadCount = 16;
+    const int kDefaultReplThreadCount = 16;
 #elif defined(MONGO_PLATFORM_32)
-    const int replWriterThreadCount = 2;
-    const int replPrefetcherThreadCount = 2;
+    const int kDefaultReplThreadCount = 2;
 #else
 #error need to include something that defines MONGO_PLATFORM_XX
 #endif
 
+    const int kMaxReplThreadCount = 256;
+
+    class ReplThreadCountParameter : public ExportedServerParameter<int> {
+    public:
+        ReplThreadCountParameter(const std::string& name, int* value)
+            : ExportedServerParameter<int>(ServerParameterSet::getGlobal(),
+                                           name,
+                                           value,
+                                           true,   // allowedToChangeAtStartup
+                                           false)  // allowedToChangeAtRuntime
+        {}
+
+        virtual Status validate(const int& potentialNewValue) {
+            if (potentialNewValue < 1 || potentialNewValue > kMaxReplThreadCount) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << name() << " must be between 1 and "
+                                            << kMaxReplThreadCount);
+            }
+            return Status::OK();
+        }
+    };
+} // namespace
+
+    // Size of the pools of threads applying and prefetching ops on secondaries.
+    int replWriterThreadCount = kDefaultReplThreadCount;
+    int replPrefetcherThreadCount = kDefaultReplThreadCount;
+    ReplThreadCountParameter replWriterThreadCountParam("replWriterThreadCount",
+                                                        &replWriterThreadCount);
+    ReplThreadCountParameter replPrefetcherThreadCountParam("replPrefetcherThreadCount",
+                                                            &replPrefetcherThreadCount);
+
+    // When true, each batch is spread over only as many of the writer threads as the
+    // WriterCountController finds useful, rather than all of them.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replAdaptiveWriterThreadCount, bool, false);
+
     static Counter64 opsAppliedStats;
 
     //The oplog entries applied
@@ -92,6 +132,56 @@ namespace repl {
     static ServerStatusMetricField<TimerStats> displayOpBatchesApplied(
                                                     "repl.apply.batches",
                                                     &applyBatchStats );
+
+    // Time spent collecting each batch from the bgsync queue
+    static TimerStats fetchBatchStats;
+    static ServerStatusMetricField<TimerStats> displayBatchesFetched(
+                                                    "repl.apply.fetch",
+                                                    &fetchBatchStats );
+
+    // Time spent prefetching each batch and splitting it into writer vectors
+    static TimerStats prepareBatchStats;
+    static ServerStatusMetricField<TimerStats> displayBatchesPrepared(
+                                                    "repl.apply.prepare",
+                                                    &prepareBatchStats );
+
+    // Time a prepared batch waited for the previous batch to finish applying
+    static TimerStats applierWaitStats;
+    static ServerStatusMetricField<TimerStats> displayApplierWaits(
+                                                    "repl.apply.applierWait",
+                                                    &applierWaitStats );
+
+    // Time spent writing each applied batch to the oplog, including waiting for durability
+    static TimerStats oplogWriteStats;
+    static ServerStatusMetricField<TimerStats> displayOplogWrites(
+                                                    "repl.apply.oplogWrite",
+                                                    &oplogWriteStats );
+
+    // Number of writer threads the last batch was spread over
+    static AtomicInt64 writerThreadsInUse;
+    class WriterThreadsInUseSSM : public ServerStatusMetric {
+    public:
+        WriterThreadsInUseSSM() : ServerStatusMetric("repl.apply.writerThreads") {}
+        virtual void appendAtLeaf(BSONObjBuilder& b) const {
+            b.appendNumber(_leafName, writerThreadsInUse.load());
+        }
+    } displayWriterThreadsInUse;
+
+    // Number of ops applied as part of a grouped insert
+    static Counter64 groupedInsertStats;
+    static ServerStatusMetricField<Counter64> displayGroupedInserts(
+                                                    "repl.apply.groupedInserts",
+                                                    &groupedInsertStats );
+
+    // When true, secondaries using a storage engine without document-level locking apply runs of
+    // inserts into one collection as a single grouped insert, and keep a collection locked across
+    // consecutive ops on it.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replGroupedApply, bool, true);
+
+    // When true, a secondary fetches and prepares the next batch while the current one is being
+    // applied, instead of doing one after the other.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replPipelinedBatchApplication, bool, false);
+
     void initializePrefetchThread() {
         if (!ClientBasic::getCurrent()) {
             Client::initThreadIfNotAlready();
@@ -110,11 +200,86 @@ namespace repl {
         }
     }
 
+    WriterCountController::WriterCountController(size_t maxWriters)
+        : _maxWriters(maxWriters),
+          _writerCount(maxWriters),
+          _direction(-1),
+          _lastThroughput(0),
+          _sampleBatches(0),
+          _sampleOps(0),
+          _sampleLargestWriterOps(0),
+          _sampleMillis(0) {
+        invariant(maxWriters > 0);
+    }
+
+    void WriterCountController::recordBatch(size_t numOps,
+                                            size_t largestWriterOps,
+                                            long long applyMillis) {
+        const size_t writerCount = _writerCount.load();
+
+        // Batches with fewer ops than writers say nothing about how many writers are useful.
+        if (numOps < writerCount || largestWriterOps == 0) {
+            return;
+        }
+
+        _sampleBatches++;
+        _sampleOps += numOps;
+        _sampleLargestWriterOps += largestWriterOps;
+        _sampleMillis += applyMillis;
+        if (_sampleBatches < kBatchesPerSample) {
+            return;
+        }
+
+        const double parallelism =
+            static_cast<double>(_sampleOps) / static_cast<double>(_sampleLargestWriterOps);
+        const double throughput =
+            static_cast<double>(_sampleOps) / static_cast<double>(std::max(_sampleMillis, 1LL));
+
+        size_t newWriterCount = writerCount;
+        if (parallelism * 2 < writerCount) {
+            // Most of each batch is going to a few writers; the rest mostly sit idle.
+            newWriterCount = static_cast<size_t>(parallelism * 2) + 1;
+            _direction = -1;
+        }
+        else {
+            if (_lastThroughput > 0 && throughput < _lastThroughput * 0.9) {
+                // The last step made things worse, so go back the other way.
+                _direction = -_direction;
+            }
+
+            const size_t step = std::max<size_t>(1, writerCount / 4);
+            if (_direction > 0) {
+                newWriterCount = writerCount + step;
+            }
+            else {
+                newWriterCount = writerCount > step ? writerCount - step : 1;
+            }
+        }
+        newWriterCount = std::min(std::max<size_t>(newWriterCount, 1), _maxWriters);
+
+        if (newWriterCount != writerCount) {
+            LOG(1) << "changing number of replication writer threads used per batch from "
+                   << writerCount << " to " << newWriterCount << " (parallelism "
+                   << parallelism << ", " << throughput << " ops/ms)";
+            _writerCount.store(newWriterCount);
+        }
+
+        _lastThroughput = throughput;
+        _sampleBatches = 0;
+        _sampleOps = 0;
+        _sampleLargestWriterOps = 0;
+        _sampleMillis = 0;
+    }
+
     SyncTail::SyncTail(BackgroundSyncInterface *q, MultiSyncApplyFunc func) :
         _networkQueue(q), 
         _applyFunc(func),
         _writerPool(replWriterThreadCount, "repl writer worker "),
-        _prefetcherPool(replPrefetcherThreadCount, "repl prefetch worker ")
+        _prefetcherPool(replPrefetcherThreadCount, "repl prefetch worker "),
+        _applierPool(1, "repl batch applier "),
+        _applierStatus(Status::OK()),
+        _tracksBatchesInFlight(false),
+        _writerCountController(replWriterThreadCount)
     {}
 
     SyncTail::~SyncTail() {}
@@ -257,6 +422,11 @@ namespace {
                 // one possible tweak here would be to stay in the read lock for this database 
                 // for multiple prefetches if they are for the same database.
                 OperationContextImpl txn;
+
+                // Prefetching only reads, so it need not wait for the batch currently being
+                // applied, which may overlap with prefetching the next one.
+                txn.lockState()->setIsBatchWriter(true);
+
                 AutoGetCollectionForRead ctx(&txn, ns);
                 Database* db = ctx.getDb();
                 if (db) {
@@ -285,8 +455,9 @@ namespace {
         prefetcherPool->join();
     }
 
-    // Doles out all the work to the writer pool threads and waits for them to complete
-    void applyOps(const std::vector< std::vector<BSONObj> >& writerVectors,
+    // Doles out all the work to the writer pool threads and waits for them to complete.
+    // Returns how long that took in milliseconds.
+    int applyOps(const std::vector< std::vector<BSONObj> >& writerVectors,
                             threadpool::ThreadPool* writerPool,
                             SyncTail::MultiSyncApplyFunc func,
                             SyncTail* sync) {
@@ -299,6 +470,7 @@ namespace {
             }
         }
         writerPool->join();
+        return timer.recordMillis();
     }
 
     void fillWriterVectors(const std::deque<BSONObj>& ops,
@@ -337,31 +509,37 @@ namespace {
         }
     }
 
-} // namespace
-
-    // Doles out all the work to the writer pool threads and waits for them to complete
-    // static
-    OpTime SyncTail::multiApply(OperationContext* txn,
-                                const OpQueue& ops,
-                                threadpool::ThreadPool* prefetcherPool,
-                                threadpool::ThreadPool* writerPool,
-                                MultiSyncApplyFunc func,
-                                SyncTail* sync,
-                                bool supportsWaitingUntilDurable) {
-        invariant(prefetcherPool);
-        invariant(writerPool);
-        invariant(func);
-        invariant(sync);
+    // Prefetches the batch if needed and splits it into one vector of ops per writer thread.
+    // Takes no locks which conflict with applying another batch.
+    // "writerCountController" may be null, in which case every writer thread is used.
+    void prepareBatch(const std::deque<BSONObj>& ops,
+                      threadpool::ThreadPool* prefetcherPool,
+                      const WriterCountController* writerCountController,
+                      std::vector< std::vector<BSONObj> >* writerVectors) {
+        TimerHolder timer(&prepareBatchStats);
 
         if (getGlobalServiceContext()->getGlobalStorageEngine()->isMmapV1()) {
             // Use a ThreadPool to prefetch all the operations in a batch.
-            prefetchOps(ops.getDeque(), prefetcherPool);
+            prefetchOps(ops, prefetcherPool);
         }
-        
-        std::vector< std::vector<BSONObj> > writerVectors(replWriterThreadCount);
 
-        fillWriterVectors(ops.getDeque(), &writerVectors);
-        LOG(2) << "replication batch size is " << ops.getDeque().size() << endl;
+        writerVectors->resize(writerCountController ? writerCountController->getWriterCount() :
+                                                      replWriterThreadCount);
+        fillWriterVectors(ops, writerVectors);
+    }
+
+    // Applies a batch prepared by prepareBatch() and writes it to the oplog, reporting how the
+    // batch went to "writerCountController" if it is not null.
+    // Returns the last OpTime applied.
+    OpTime applyPreparedOps(OperationContext* txn,
+                            const std::deque<BSONObj>& ops,
+                            const std::vector< std::vector<BSONObj> >& writerVectors,
+                            threadpool::ThreadPool* writerPool,
+                            SyncTail::MultiSyncApplyFunc func,
+                            SyncTail* sync,
+                            WriterCountController* writerCountController,
+                            bool supportsWaitingUntilDurable) {
+        LOG(2) << "replication batch size is " << ops.size() << endl;
         // We must grab this because we're going to grab write locks later.
         // We hold this mutex the entire time we're writing; it doesn't matter
         // because all readers are blocked anyway.
@@ -378,23 +556,37 @@ namespace {
             fassertFailed(28527);
         }
 
-        applyOps(writerVectors, writerPool, func, sync);
+        const int applyMillis = applyOps(writerVectors, writerPool, func, sync);
+
+        size_t largestWriterOps = 0;
+        for (size_t i = 0; i < writerVectors.size(); i++) {
+            largestWriterOps = std::max(largestWriterOps, writerVectors[i].size());
+        }
+        if (writerCountController) {
+            writerCountController->recordBatch(ops.size(), largestWriterOps, applyMillis);
+        }
+
+        writerThreadsInUse.store(writerVectors.size());
 
         if (inShutdown()) {
             return OpTime();
         }
 
+        TimerHolder oplogWriteTimer(&oplogWriteStats);
+
         const bool mustWaitUntilDurable = replCoord->isV1ElectionProtocol() &&
                                           supportsWaitingUntilDurable;
         if (mustWaitUntilDurable) {
             txn->recoveryUnit()->goingToWaitUntilDurable();
         }
 
-        OpTime lastOpTime = writeOpsToOplog(txn, ops.getDeque());
+        OpTime lastOpTime = writeOpsToOplog(txn, ops);
 
         if (mustWaitUntilDurable) {
             txn->recoveryUnit()->waitUntilDurable();
         }
+        oplogWriteTimer.recordMillis();
+
         ReplClientInfo::forClient(txn->getClient()).setLastOp(lastOpTime);
         replCoord->setMyLastOptime(lastOpTime);
         setNewTimestamp(lastOpTime.getTimestamp());
@@ -404,6 +596,98 @@ namespace {
         return lastOpTime;
     }
 
+} // namespace
+
+    // Doles out all the work to the writer pool threads and waits for them to complete
+    // static
+    OpTime SyncTail::multiApply(OperationContext* txn,
+                                const OpQueue& ops,
+                                threadpool::ThreadPool* prefetcherPool,
+                                threadpool::ThreadPool* writerPool,
+                                MultiSyncApplyFunc func,
+                                SyncTail* sync,
+                                bool supportsWaitingUntilDurable) {
+        invariant(prefetcherPool);
+        invariant(writerPool);
+        invariant(func);
+        invariant(sync);
+
+        WriterCountController* writerCountController = sync->_getWriterCountController();
+
+        std::vector< std::vector<BSONObj> > writerVectors;
+        prepareBatch(ops.getDeque(), prefetcherPool, writerCountController, &writerVectors);
+
+        return applyPreparedOps(txn,
+                                ops.getDeque(),
+                                writerVectors,
+                                writerPool,
+                                func,
+                                sync,
+                                writerCountController,
+                                supportsWaitingUntilDurable);
+    }
+
+    WriterCountController* SyncTail::_getWriterCountController() {
+        return replAdaptiveWriterThreadCount ? &_writerCountController : nullptr;
+    }
+
+    void SyncTail::_applyInBackground(std::shared_ptr<PreparedBatch> batch) {
+        {
+            TimerHolder timer(&applierWaitStats);
+            _waitForInFlightBatch();
+        }
+        _applierPool.schedule(&SyncTail::_applyPreparedBatch, this, batch);
+    }
+
+    void SyncTail::_applyPreparedBatch(std::shared_ptr<PreparedBatch> batch) {
+        try {
+            initializePrefetchThread();
+            OperationContextImpl txn;
+
+            // Set minValid to the last op to be applied in this next batch.
+            // This will cause this node to go into RECOVERING state
+            // if we should crash and restart before updating the oplog
+            setMinValid(&txn, extractOpTime(batch->ops.back()));
+
+            applyPreparedOps(&txn,
+                             batch->ops.getDeque(),
+                             batch->writerVectors,
+                             &_writerPool,
+                             _applyFunc,
+                             this,
+                             _getWriterCountController(),
+                             supportsWaitingUntilDurable());
+        }
+        catch (const DBException& e) {
+            _applierStatus = e.toStatus();
+        }
+
+        OperationContextImpl txn;
+        BackgroundSync::get()->finishedBatch(&txn);
+    }
+
+    void SyncTail::_startBatch() {
+        // The batch has to be in flight before its first op leaves the buffer, or the producer
+        // could see an empty buffer and no batch being applied.
+        if (_tracksBatchesInFlight) {
+            BackgroundSync::get()->startedBatch();
+        }
+    }
+
+    void SyncTail::_stopTrackingBatches() {
+        _tracksBatchesInFlight = false;
+        OperationContextImpl txn;
+        BackgroundSync::get()->clearBatchesInFlight(&txn);
+    }
+
+    void SyncTail::_waitForInFlightBatch() {
+        _applierPool.join();
+
+        Status status = _applierStatus;
+        _applierStatus = Status::OK();
+        uassertStatusOK(status);
+    }
+
     void SyncTail::oplogApplication(OperationContext* txn, const OpTime& endOpTime) {
         _applyOplogUntil(txn, endOpTime);
     }
@@ -478,6 +762,11 @@ namespace {
             return;
         }
 
+        // minValid and our last optime don't cover the ops which are still being applied.
+        if (BackgroundSync::get()->hasBatchesInFlight()) {
+            return;
+        }
+
         ScopedTransaction transaction(txn, MODE_S);
         Lock::GlobalRead readLock(txn->lockState());
 
@@ -508,6 +797,14 @@ namespace {
     /* tail an oplog.  ok to return, will be re-called. */
     void SyncTail::oplogApplication() {
         ReplicationCoordinator* replCoord = getGlobalReplicationCoordinator();
+        BackgroundSync* bgsync = BackgroundSync::get();
+
+        // Forget any batch dropped on the way out, once the applier thread is done.
+        _tracksBatchesInFlight = true;
+        ON_BLOCK_EXIT(&SyncTail::_stopTrackingBatches, this);
+
+        // Never leave a batch behind in the applier thread.
+        ON_BLOCK_EXIT(&threadpool::ThreadPool::join, &_applierPool);
 
         while(!inShutdown()) {
             OpQueue ops;
@@ -530,15 +827,19 @@ namespace {
                 // (always checked in the first iteration of this do-while loop, because
                 // ops is empty)
                 if (ops.empty() || now > lastTimeChecked) {
-                    BackgroundSync* bgsync = BackgroundSync::get();
                     if (bgsync->getInitialSyncRequestedFlag()) {
                         // got a resync command
+                        _waitForInFlightBatch();
                         return;
                     }
                     lastTimeChecked = now;
                     // can we become secondary?
                     // we have to check this before calling mgr, as we must be a secondary to
                     // become primary
+                    if (ops.empty() && !replCoord->isInPrimaryOrSecondaryState()) {
+                        // Only go live once the batch being applied in the background is done.
+                        _waitForInFlightBatch();
+                    }
                     tryToGoLiveAsASecondary(&txn, replCoord);
                 }
 
@@ -570,10 +871,24 @@ namespace {
             if (ops.empty()) {
                 continue;
             }
+            fetchBatchStats.record(batchTimer);
 
             const BSONObj lastOp = ops.back();
             handleSlaveDelay(lastOp);
 
+            if (replPipelinedBatchApplication) {
+                // Prepare this batch while the previous one is still being applied, then apply
+                // it in the background while the next one is fetched.
+                std::shared_ptr<PreparedBatch> batch = std::make_shared<PreparedBatch>();
+                batch->ops = ops;
+                prepareBatch(batch->ops.getDeque(),
+                             &_prefetcherPool,
+                             _getWriterCountController(),
+                             &batch->writerVectors);
+                _applyInBackground(batch);
+                continue;
+            }
+
             // Set minValid to the last op to be applied in this next batch.
             // This will cause this node to go into RECOVERING state
             // if we should crash and restart before updating the oplog
@@ -585,6 +900,7 @@ namespace {
                        _applyFunc,
                        this,
                        supportsWaitingUntilDurable());
+            bgsync->finishedBatch(&txn);
         }
     }
 
@@ -606,6 +922,8 @@ namespace {
             // if we don't have anything in the queue, wait a bit for something to appear
             if (ops->empty()) {
                 if (replCoord->isWaitingForApplierToDrain()) {
+                    // Draining is only complete once every batch has been applied.
+                    _waitForInFlightBatch();
                     BackgroundSync::get()->waitUntilPaused();
                     if (peek(&op)) {
                         // The producer generated a last batch of ops before pausing so return
@@ -634,6 +952,7 @@ namespace {
 
             if (ops->empty()) {
                 // apply commands one-at-a-time
+                _startBatch();
                 ops->push_back(op);
                 _networkQueue->consume();
             }
@@ -658,6 +977,9 @@ namespace {
         }
     
         // Copy the op to the deque and remove it from the bgsync queue.
+        if (ops->empty()) {
+            _startBatch();
+        }
         ops->push_back(op);
         _networkQueue->consume();
 
@@ -816,6 +1138,136 @@ namespace {
         }
     }
 
+namespace {
+
+    // Limits on how many inserts multiSyncApply() folds into one grouped insert.
+    const size_t kMaxGroupedInsertOps = 64;
+    const int kMaxGroupedInsertBytes = 256 * 1024;
+
+    bool isGroupableInsert(const BSONObj& op) {
+        const char* ns = op.getStringField("ns");
+        return op["op"].valuestrsafe()[0] == 'i' &&
+               nsIsFull(ns) &&
+               nsToCollectionSubstring(ns) != "system.indexes" &&
+               op["o"].isABSONObj();
+    }
+
+    // Returns the end of the run of inserts into the same collection which starts at "begin", or
+    // "begin" itself if that op is not an insert which can be grouped.
+    std::vector<BSONObj>::const_iterator endOfInsertGroup(
+                                            std::vector<BSONObj>::const_iterator begin,
+                                            std::vector<BSONObj>::const_iterator end) {
+        if (!isGroupableInsert(*begin)) {
+            return begin;
+        }
+
+        const StringData ns = begin->getStringField("ns");
+        size_t numOps = 0;
+        int numBytes = 0;
+        std::vector<BSONObj>::const_iterator it = begin;
+        while (it != end &&
+               numOps < kMaxGroupedInsertOps &&
+               numBytes < kMaxGroupedInsertBytes &&
+               isGroupableInsert(*it) &&
+               ns == it->getStringField("ns")) {
+            numBytes += it->objsize();
+            numOps++;
+            ++it;
+        }
+        return it;
+    }
+
+    // Applies the inserts in [begin, end) as a single grouped insert. Returns false, having
+    // applied none of them, if that did not work; the caller then applies them one at a time,
+    // which also copes with inserts which are being replayed.
+    bool applyInsertGroup(OperationContext* txn,
+                          std::vector<BSONObj>::const_iterator begin,
+                          std::vector<BSONObj>::const_iterator end) {
+        BSONObjBuilder groupBuilder;
+        groupBuilder.append("op", "i");
+        groupBuilder.append(begin->getField("ns"));
+        {
+            BSONArrayBuilder docs(groupBuilder.subarrayStart("o"));
+            for (std::vector<BSONObj>::const_iterator it = begin; it != end; ++it) {
+                docs.append(it->getObjectField("o"));
+            }
+        }
+        const BSONObj groupedOp = groupBuilder.obj();
+
+        try {
+            if (!SyncTail::syncApply(txn, groupedOp, true).isOK()) {
+                return false;
+            }
+        }
+        catch (const DBException& e) {
+            LOG(1) << "applying " << (end - begin) << " grouped inserts into "
+                   << begin->getStringField("ns") << " failed, applying them individually: "
+                   << causedBy(e);
+            return false;
+        }
+
+        // syncApply() counted the grouped op once.
+        opsAppliedStats.increment(end - begin - 1);
+        groupedInsertStats.increment(end - begin);
+        return true;
+    }
+
+    /**
+     * Holds the locks on the collection a writer thread last applied a CRUD op to, so that a run
+     * of ops on one collection does not lock and unlock it for every op. Only used on engines
+     * without document-level locking, where all ops on a collection go to the same writer.
+     */
+    class HeldCollectionLock {
+        MONGO_DISALLOW_COPYING(HeldCollectionLock);
+    public:
+        explicit HeldCollectionLock(OperationContext* txn) : _txn(txn) { }
+
+        // Holds the locks on op's collection if it is a CRUD op on an existing collection, and
+        // releases whatever is held otherwise, so that syncApply() is free to take stronger
+        // locks for it.
+        void prepareFor(const BSONObj& op) {
+            const char* ns = op.getStringField("ns");
+            const char* opType = op["op"].valuestrsafe();
+            const bool isCrudOp = isCrudOpType(opType) &&
+                                  nsIsFull(ns) &&
+                                  nsToCollectionSubstring(ns) != "system.indexes";
+            if (isCrudOp && _ns == ns) {
+                return;
+            }
+
+            release();
+            if (!isCrudOp) {
+                return;
+            }
+
+            const StringData dbName = nsToDatabaseSubstring(ns);
+            _dbLock.reset(new Lock::DBLock(_txn->lockState(), dbName, MODE_IX));
+            _collectionLock.reset(new Lock::CollectionLock(_txn->lockState(), ns, MODE_IX));
+
+            Database* db = dbHolder().get(_txn, dbName);
+            if (!db || !db->getCollection(ns)) {
+                // syncApply() will need to create it under an exclusive lock.
+                release();
+                return;
+            }
+            _ns = ns;
+        }
+
+        void release() {
+            _collectionLock.reset();
+            _dbLock.reset();
+            _ns.clear();
+        }
+
+    private:
+        OperationContext* const _txn;
+        std::unique_ptr<Lock::DBLock> _dbLock;
+        std::unique_ptr<Lock::CollectionLock> _collectionLock;
+        std::string _ns;
+    };
+
+} // namespace
+
     // This free function is used by the writer threads to apply each op
     void multiSyncApply(const std::vector<BSONObj>& ops, SyncTail* st) {
         initializeWriterThread();
@@ -829,10 +1281,27 @@ namespace {
 
         bool convertUpdatesToUpserts = true;
 
+        // With collection-level locking, every op on a collection is applied by this thread, so
+        // runs of them can share locks and inserts can be applied in groups.
+        const bool groupOps = replGroupedApply &&
+            !getGlobalServiceContext()->getGlobalStorageEngine()->supportsDocLocking();
+        HeldCollectionLock heldLock(&txn);
+
         for (std::vector<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
             try {
+                if (groupOps) {
+                    heldLock.prepareFor(*it);
+
+                    const std::vector<BSONObj>::const_iterator groupEnd =
+                        endOfInsertGroup(it, ops.end());
+                    if (groupEnd - it > 1 && applyInsertGroup(&txn, it, groupEnd)) {
+                        it = groupEnd - 1;
+                        continue;
+                    }
+                }
+
                 if (!SyncTail::syncApply(&txn, *it, convertUpdatesToUpserts).isOK()) {
                     fassertFailedNoTrace(16359);
                 }
@@ -29,10 +29,13 @@
 #pragma once
 
 #include <deque>
+#include <memory>
 
+#include "mongo/base/disallow_copying.h"
 #include "mongo/base/status.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/functional.h"
 #include "mongo/util/concurrency/thread_pool.h"
 
@@ -46,6 +49,49 @@ namespace repl {
     class ReplicationCoordinator;
     class OpTime;
 
+    /**
+     * Chooses how many of the writer threads each batch of ops is spread over, between 1 and the
+     * size of the writer pool, when replAdaptiveWriterThreadCount is on.
+     *
+     * Every few batches it looks at how evenly the batches hashed across writers and how quickly
+     * they were applied. If most of each batch landed on a few writers the extra ones are only
+     * overhead, so it shrinks to twice the parallelism actually achieved. Otherwise it keeps
+     * stepping in the direction which last improved apply throughput.
+     */
+    class WriterCountController {
+        MONGO_DISALLOW_COPYING(WriterCountController);
+    public:
+        explicit WriterCountController(size_t maxWriters);
+
+        // May be called concurrently with recordBatch().
+        size_t getWriterCount() const { return _writerCount.load(); }
+
+        /**
+         * Records a batch of "numOps" ops, of which the busiest writer applied "largestWriterOps",
+         * that took "applyMillis" to apply.
+         */
+        void recordBatch(size_t numOps, size_t largestWriterOps, long long applyMillis);
+
+        // Number of batches looked at before each adjustment.
+        static const size_t kBatchesPerSample = 8;
+
+    private:
+        const size_t _maxWriters;
+        AtomicUInt32 _writerCount;
+
+        // +1 while adding writers helps, -1 while removing them does.
+        int _direction;
+
+        // Ops applied per millisecond over the previous sample, 0 before the first one.
+        double _lastThroughput;
+
+        // Totals for the sample being collected.
+        size_t _sampleBatches;
+        size_t _sampleOps;
+        size_t _sampleLargestWriterOps;
+        long long _sampleMillis;
+    };
+
     /**
      * "Normal" replica set syncing
      */
@@ -173,6 +219,48 @@ namespace repl {
         void _applyOplogUntil(OperationContext* txn, const OpTime& endOpTime);
 
     private:
+        /**
+         * A batch of ops which has been prefetched and split into per-writer vectors, ready to be
+         * applied.
+         */
+        struct PreparedBatch {
+            OpQueue ops;
+            std::vector< std::vector<BSONObj> > writerVectors;
+        };
+
+        /**
+         * Waits for the batch previously handed to the applier thread, if any, and then hands
+         * "batch" to it, returning while "batch" is being applied.
+         */
+        void _applyInBackground(std::shared_ptr<PreparedBatch> batch);
+
+        /**
+         * Runs on the applier thread: sets minValid and applies "batch".
+         */
+        void _applyPreparedBatch(std::shared_ptr<PreparedBatch> batch);
+
+        /**
+         * Returns the controller picking the number of writers per batch, or nullptr if
+         * replAdaptiveWriterThreadCount is off and every batch uses the whole writer pool.
+         */
+        WriterCountController* _getWriterCountController();
+
+        /**
+         * Called before the first op of a batch is taken out of the bgsync queue.
+         */
+        void _startBatch();
+
+        /**
+         * Called when oplogApplication() returns: forgets any batch it dropped without applying.
+         */
+        void _stopTrackingBatches();
+
+        /**
+         * Blocks until the batch handed to the applier thread, if any, has been applied.
+         * Rethrows any exception which the applier thread hit.
+         */
+        void _waitForInFlightBatch();
+
         std::string _hostname;
 
         BackgroundSyncInterface* _networkQueue;
@@ -186,6 +274,19 @@ namespace repl {
         threadpool::ThreadPool _writerPool;
         // persistent pool of worker threads for prefetching
         threadpool::ThreadPool _prefetcherPool;
+        // single thread which applies prepared batches while oplogApplication() fetches and
+        // prepares the next one
+        threadpool::ThreadPool _applierPool;
+
+        // Result of the last batch applied by _applierPool, checked by _waitForInFlightBatch().
+        Status _applierStatus;
+
+        // Set by oplogApplication(), which tells BackgroundSync about each batch it takes out of
+        // the buffer so that the producer doesn't treat the buffer as applied too early.
+        bool _tracksBatchesInFlight;
+
+        // Number of writers to use for each batch, when adaptive.
+        WriterCountController _writerCountController;
 
     };
 
@@ -39,6 +39,7 @@
 #include "mongo/db/curop.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/repl/bgsync.h"
+#include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/operation_context_repl_mock.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/repl/replication_coordinator_mock.h"
@@ -344,4 +345,78 @@ namespace {
         ASSERT_EQUALS(1U, _opsApplied);
     }
 
+    TEST_F(SyncTailTest, SyncApplyGroupedInsert) {
+        {
+            Lock::GlobalWrite globalLock(_txn->lockState());
+            bool justCreated = false;
+            Database* db = dbHolder().openDb(_txn.get(), "test", &justCreated);
+            ASSERT_TRUE(db);
+            ASSERT_TRUE(db->createCollection(_txn.get(), "test.t"));
+        }
+        const BSONObj op = BSON("op" << "i" << "ns" << "test.t" <<
+                                "o" << BSON_ARRAY(BSON("_id" << 0) << BSON("_id" << 1)));
+        _txn->setReplicatedWrites(false);
+        ASSERT_OK(SyncTail::syncApply(_txn.get(),
+                                      op,
+                                      true,
+                                      applyOperation_inlock,
+                                      _applyCmd,
+                                      _incOps));
+        ASSERT_EQUALS(1U, _opsApplied);
+    }
+
+    TEST_F(SyncTailTest, SyncApplyGroupedInsertMissingId) {
+        {
+            Lock::GlobalWrite globalLock(_txn->lockState());
+            bool justCreated = false;
+            Database* db = dbHolder().openDb(_txn.get(), "test", &justCreated);
+            ASSERT_TRUE(db);
+            ASSERT_TRUE(db->createCollection(_txn.get(), "test.t"));
+        }
+        const BSONObj op = BSON("op" << "i" << "ns" << "test.t" <<
+                                "o" << BSON_ARRAY(BSON("_id" << 0) << BSON("x" << 1)));
+        _txn->setReplicatedWrites(false);
+        ASSERT_THROWS_CODE(SyncTail::syncApply(_txn.get(),
+                                               op,
+                                               true,
+                                               applyOperation_inlock,
+                                               _applyCmd,
+                                               _incOps),
+                           UserException,
+                           ErrorCodes::NoSuchKey);
+    }
+
+    TEST(WriterCountControllerTest, StartsWithAllWriters) {
+        WriterCountController controller(16);
+        ASSERT_EQUALS(16U, controller.getWriterCount());
+    }
+
+    TEST(WriterCountControllerTest, IgnoresBatchesSmallerThanWriterCount) {
+        WriterCountController controller(16);
+        for (size_t i = 0; i < 10 * WriterCountController::kBatchesPerSample; i++) {
+            controller.recordBatch(10, 10, 5);
+        }
+        ASSERT_EQUALS(16U, controller.getWriterCount());
+    }
+
+    TEST(WriterCountControllerTest, ShrinksWhenBatchesGoToOneWriter) {
+        WriterCountController controller(16);
+        for (size_t i = 0; i < WriterCountController::kBatchesPerSample; i++) {
+            controller.recordBatch(1000, 1000, 50);
+        }
+        ASSERT_LESS_THAN(controller.getWriterCount(), 4U);
+        ASSERT_GREATER_THAN_OR_EQUALS(controller.getWriterCount(), 1U);
+    }
+
+    TEST(WriterCountControllerTest, StaysWithinBounds) {
+        WriterCountController controller(8);
+        for (size_t i = 0; i < 50 * WriterCountController::kBatchesPerSample; i++) {
+            // Evenly spread batches whose apply time swings from sample to sample.
+            const size_t sample = i / WriterCountController::kBatchesPerSample;
+            controller.recordBatch(800, 100, sample % 2 ? 10 : 100);
+            ASSERT_GREATER_THAN_OR_EQUALS(controller.getWriterCount(), 1U);
+            ASSERT_LESS_THAN_OR_EQUALS(controller.getWriterCount(), 8U);
+        }
+    }
+
 } // namespace
@@ -50,6 +50,7 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
+#include <exception>
 #include <snappy.h>
 
 #include "mongo/base/string_data.h"
@@ -58,7 +59,11 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/s/mongos_options.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/print.h"
@@ -113,6 +118,86 @@ namespace mongo {
 #endif
         }
 
+        /**
+         * Threads shared by all Sorters for SortOptions::backgroundSpill and
+         * SortOptions::readAhead. Tasks run on them never wait for one another.
+         */
+        inline ThreadPool& backgroundThreads() {
+            static ThreadPool pool(4, "sorter ");
+            return pool;
+        }
+
+        /**
+         * Runs one function at a time on the background threads and lets the owner wait for it.
+         * An exception thrown by the function is rethrown by wait(). The destructor waits for a
+         * running function, so it must be declared after any members that function uses.
+         */
+        class BackgroundTask {
+            MONGO_DISALLOW_COPYING(BackgroundTask);
+        public:
+            BackgroundTask() : _running(false) {}
+
+            ~BackgroundTask() {
+                stdx::unique_lock<stdx::mutex> lk(_mutex);
+                while (_running) {
+                    _done.wait(lk);
+                }
+            }
+
+            /** True between start() and the matching wait(). */
+            bool started() const { return _started; }
+
+            void start(const stdx::function<void()>& fn) {
+                invariant(!_started);
+                _started = true;
+                {
+                    stdx::lock_guard<stdx::mutex> lk(_mutex);
+                    _running = true;
+                }
+                backgroundThreads().schedule(stdx::bind(&BackgroundTask::run, this, fn));
+            }
+
+            void wait() {
+                invariant(_started);
+                _started = false;
+
+                std::exception_ptr error;
+                {
+                    stdx::unique_lock<stdx::mutex> lk(_mutex);
+                    while (_running) {
+                        _done.wait(lk);
+                    }
+                    error.swap(_error);
+                }
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+
+        private:
+            void run(const stdx::function<void()>& fn) {
+                std::exception_ptr error;
+                try {
+                    fn();
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                _error = error;
+                _running = false;
+                _done.notify_all();
+            }
+
+            bool _started = false; // only used by the owning thread
+
+            stdx::mutex _mutex;
+            stdx::condition_variable _done;
+            bool _running;
+            std::exception_ptr _error;
+        };
+
         /** Ensures a named file is deleted when this object goes out of scope */
         class FileDeleter {
         public:
@@ -164,9 +249,13 @@ namespace mongo {
 
             FileIterator(const std::string& fileName,
                          const Settings& settings,
-                         boost::shared_ptr<FileDeleter> fileDeleter)
+                         boost::shared_ptr<FileDeleter> fileDeleter,
+                         bool readAhead = false)
                 : _settings(settings)
+                , _readAhead(readAhead)
                 , _done(false)
+                , _nextSize(0)
+                , _nextIsEof(false)
                 , _fileName(fileName)
                 , _fileDeleter(fileDeleter)
                 , _file(_fileName.c_str(), std::ios::in | std::ios::binary)
@@ -205,47 +294,85 @@ namespace mongo {
             }
 
             void fill() {
+                size_t size;
+                if (!_readAhead) {
+                    _done = !readBlock(&_buffer, &size);
+                }
+                else {
+                    // The first block is read here; after that, each fill() collects the block
+                    // read ahead during the previous one.
+                    if (!_readAheadTask.started()) {
+                        startReadAhead();
+                    }
+                    _readAheadTask.wait();
+
+                    _buffer.swap(_nextBuffer);
+                    size = _nextSize;
+                    _done = _nextIsEof;
+                    if (!_done) {
+                        startReadAhead();
+                    }
+                }
+
+                if (_done) {
+                    _reader.reset();
+                    return;
+                }
+                _reader.reset(new BufReader(_buffer.get(), size));
+            }
+
+            void startReadAhead() {
+                _readAheadTask.start(stdx::bind(&FileIterator::readAhead, this));
+            }
+
+            // Runs on a background thread, which is the only one touching _file and the _next*
+            // members until the task is waited for.
+            void readAhead() {
+                _nextIsEof = !readBlock(&_nextBuffer, &_nextSize);
+            }
+
+            // Reads and decompresses the next block into *buffer. Returns false at EOF.
+            bool readBlock(boost::scoped_array<char>* buffer, size_t* size) {
                 int32_t rawSize;
-                read(&rawSize, sizeof(rawSize));
-                if (_done) return;
+                if (!read(&rawSize, sizeof(rawSize)))
+                    return false;
 
                 // negative size means compressed
                 const bool compressed = rawSize < 0;
                 const int32_t blockSize = std::abs(rawSize);
 
-                _buffer.reset(new char[blockSize]);
-                read(_buffer.get(), blockSize);
-                massert(16816, "file too short?", !_done);
+                buffer->reset(new char[blockSize]);
+                massert(16816, "file too short?", read(buffer->get(), blockSize));
 
                 if (!compressed) {
-                    _reader.reset(new BufReader(_buffer.get(), blockSize));
-                    return;
+                    *size = blockSize;
+                    return true;
                 }
 
-                dassert(snappy::IsValidCompressedBuffer(_buffer.get(), blockSize));
+                dassert(snappy::IsValidCompressedBuffer(buffer->get(), blockSize));
 
                 size_t uncompressedSize;
                 massert(17061, "couldn't get uncompressed length",
-                        snappy::GetUncompressedLength(_buffer.get(), blockSize, &uncompressedSize));
+                        snappy::GetUncompressedLength(buffer->get(), blockSize, &uncompressedSize));
 
                 boost::scoped_array<char> decompressionBuffer(new char[uncompressedSize]);
                 massert(17062, "decompression failed",
-                        snappy::RawUncompress(_buffer.get(),
+                        snappy::RawUncompress(buffer->get(),
                                               blockSize,
                                               decompressionBuffer.get()));
 
                 // hold on to decompressed data and throw out compressed data at block exit
-                _buffer.swap(decompressionBuffer);
-                _reader.reset(new BufReader(_buffer.get(), uncompressedSize));
+                buffer->swap(decompressionBuffer);
+                *size = uncompressedSize;
+                return true;
             }
 
-            // sets _done to true on EOF - asserts on any other error
-            void read(void* out, size_t size) {
+            // returns false on EOF - asserts on any other error
+            bool read(void* out, size_t size) {
                 _file.read(reinterpret_cast<char*>(out), size);
                 if (!_file.good()) {
                     if (_file.eof()) {
-                        _done = true;
-                        return;
+                        return false;
                     }
 
                     msgasserted(16817, str::stream() << "error reading file \""
@@ -253,15 +380,24 @@ namespace mongo {
                                                      << myErrnoWithDescription());
                 }
                 verify(_file.gcount() == static_cast<std::streamsize>(size));
+                return true;
             }
 
             const Settings _settings;
+            const bool _readAhead;
             bool _done;
             boost::scoped_array<char> _buffer;
             boost::scoped_ptr<BufReader> _reader;
+
+            // The block being read ahead, if _readAhead.
+            boost::scoped_array<char> _nextBuffer;
+            size_t _nextSize;
+            bool _nextIsEof;
+
             std::string _fileName;
             boost::shared_ptr<FileDeleter> _fileDeleter; // Must outlive _file
             std::ifstream _file;
+            BackgroundTask _readAheadTask; // Must be destroyed first
         };
 
         /** Merge-sorts results from 0 or more FileIterators */
@@ -412,22 +548,28 @@ namespace mongo {
                 _memUsed += key.memUsageForSorter();
                 _memUsed += val.memUsageForSorter();
 
-                if (_memUsed > _opts.maxMemoryUsageBytes)
+                // With background spilling, one run can be in memory while the previous one is
+                // being written.
+                const bool halveRuns = _opts.backgroundSpill && _opts.extSortAllowed;
+                const size_t runSize = halveRuns ? _opts.maxMemoryUsageBytes / 2
+                                                 : _opts.maxMemoryUsageBytes;
+                if (_memUsed > runSize)
                     spill();
             }
 
             Iterator* done() {
-                if (_iters.empty()) {
-                    sort();
+                if (_iters.empty() && !_spillTask.started()) {
+                    sort(&_data);
                     return new InMemIterator<Key, Value>(_data);
                 }
 
                 spill();
+                waitForSpill();
                 return Iterator::merge(_iters, _opts, _comp);
             }
 
             // TEMP these are here for compatibility. Will be replaced with a general stats API
-            int numFiles() const { return _iters.size(); }
+            int numFiles() const { return _iters.size() + (_spillTask.started() ? 1 : 0); }
             size_t memUsed() const { return _memUsed; }
 
         private:
@@ -442,13 +584,13 @@ namespace mongo {
                 const Comparator& _comp;
             };
 
-            void sort() {
+            void sort(std::deque<Data>* data) {
                 STLComparator less(_comp);
-                std::stable_sort(_data.begin(), _data.end(), less);
+                std::stable_sort(data->begin(), data->end(), less);
 
                 // Does 2x more compares than stable_sort
                 // TODO test on windows
-                //std::sort(_data.begin(), _data.end(), comp);
+                //std::sort(data->begin(), data->end(), comp);
             }
 
             void spill() {
@@ -467,16 +609,44 @@ namespace mongo {
                         );
                 }
 
-                sort();
+                if (!_opts.backgroundSpill) {
+                    _iters.push_back(writeRun(&_data));
+                    _memUsed = 0;
+                    return;
+                }
+
+                // Only one run is written at a time, so this waits if the disk is the bottleneck.
+                waitForSpill();
+                _spillData.swap(_data);
+                _memUsed = 0;
+                _spillTask.start(stdx::bind(&NoLimitSorter::spillInBackground, this));
+            }
+
+            // Sorts *data and writes it to a new file, leaving *data empty.
+            boost::shared_ptr<Iterator> writeRun(std::deque<Data>* data) {
+                sort(data);
 
                 SortedFileWriter<Key, Value> writer(_opts, _settings);
-                for ( ; !_data.empty(); _data.pop_front()) {
-                    writer.addAlreadySorted(_data.front().first, _data.front().second);
+                for ( ; !data->empty(); data->pop_front()) {
+                    writer.addAlreadySorted(data->front().first, data->front().second);
                 }
 
-                _iters.push_back(boost::shared_ptr<Iterator>(writer.done()));
+                return boost::shared_ptr<Iterator>(writer.done());
+            }
 
-                _memUsed = 0;
+            // Runs on a background thread, which is the only one touching _spillData and
+            // _spilledRun until the task is waited for.
+            void spillInBackground() {
+                _spilledRun = writeRun(&_spillData);
+            }
+
+            void waitForSpill() {
+                if (!_spillTask.started())
+                    return;
+
+                _spillTask.wait();
+                _iters.push_back(_spilledRun);
+                _spilledRun.reset();
             }
 
             const Comparator _comp;
@@ -485,6 +655,11 @@ namespace mongo {
             size_t _memUsed;
             std::deque<Data> _data; // the "current" data
             std::vector<boost::shared_ptr<Iterator> > _iters; // data that has already been spilled
+
+            // The run being written by _spillTask, if _opts.backgroundSpill.
+            std::deque<Data> _spillData;
+            boost::shared_ptr<Iterator> _spilledRun;
+            BackgroundTask _spillTask; // Must be destroyed first
         };
 
         template <typename Key, typename Value, typename Comparator>
@@ -786,6 +961,7 @@ namespace mongo {
     SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts,
                                                    const Settings& settings)
         : _settings(settings)
+        , _readAhead(opts.readAhead)
     {
         namespace str = mongoutils::str;
 
@@ -857,7 +1033,10 @@ namespace mongo {
     SortIteratorInterface<Key, Value>* SortedFileWriter<Key, Value>::done() {
         spill();
         _file.close();
-        return new sorter::FileIterator<Key, Value>(_fileName, _settings, _fileDeleter);
+        return new sorter::FileIterator<Key, Value>(_fileName,
+                                                    _settings,
+                                                    _fileDeleter,
+                                                    _readAhead);
     }
 
     //
@@ -98,11 +98,18 @@ namespace mongo {
         bool extSortAllowed; /// If false, uassert if more mem needed than allowed.
         std::string tempDir; /// Directory to directly place files in.
                              /// Must be explicitly set if extSortAllowed is true.
+        bool backgroundSpill; /// Sort and write runs on a background thread while add()ing.
+                              /// Only affects unlimited sorts. Halves the in-memory run size
+                              /// so that memory use stays within maxMemoryUsageBytes.
+        bool readAhead; /// Read and decompress the next block of each spilled run on a
+                        /// background thread while the current one is being consumed.
 
         SortOptions()
             : limit(0)
             , maxMemoryUsageBytes(64*1024*1024)
             , extSortAllowed(false)
+            , backgroundSpill(false)
+            , readAhead(false)
         {}
 
         /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
@@ -126,6 +133,16 @@ namespace mongo {
             tempDir = newTempDir;
             return *this;
         }
+
+        SortOptions& BackgroundSpill(bool newBackgroundSpill=true) {
+            backgroundSpill = newBackgroundSpill;
+            return *this;
+        }
+
+        SortOptions& ReadAhead(bool newReadAhead=true) {
+            readAhead = newReadAhead;
+            return *this;
+        }
     };
 
     /// This is the output from the sorting framework
@@ -201,6 +218,7 @@ namespace mongo {
         void spill();
 
         const Settings _settings;
+        const bool _readAhead;
         std::string _fileName;
         boost::shared_ptr<sorter::FileDeleter> _fileDeleter; // Must outlive _file
         std::ofstream _file;
@@ -244,6 +244,23 @@ namespace mongo {
                 ASSERT_ITERATORS_EQUIVALENT(boost::shared_ptr<IWIterator>(sorter.done()),
                                             make_shared<IntIterator>(0,10*1000*1000));
             }
+            { // big, read ahead
+                SortedFileWriter<IntWrapper, IntWrapper> sorter(SortOptions(opts).ReadAhead());
+                for (int i=0; i< 1000*1000; i++)
+                    sorter.addAlreadySorted(i,-i);
+
+                ASSERT_ITERATORS_EQUIVALENT(boost::shared_ptr<IWIterator>(sorter.done()),
+                                            make_shared<IntIterator>(0,1000*1000));
+            }
+            { // read ahead, abandoned part way through
+                SortedFileWriter<IntWrapper, IntWrapper> sorter(SortOptions(opts).ReadAhead());
+                for (int i=0; i< 1000*1000; i++)
+                    sorter.addAlreadySorted(i,-i);
+
+                boost::shared_ptr<IWIterator> it(sorter.done());
+                for (int i=0; i< 1000; i++)
+                    ASSERT_EQUALS(i, it->next().first);
+            }
 
             ASSERT(boost::filesystem::is_empty(tempDir.path()));
         }
@@ -524,6 +541,15 @@ namespace mongo {
             }
             enum { MEM_LIMIT = 32*1024 };
         };
+
+        // Spills runs on background threads and reads them back ahead of the merge.
+        template <bool Random=true>
+        class LotsOfDataInBackground : public LotsOfDataLittleMemory<Random> {
+            typedef LotsOfDataLittleMemory<Random> Parent;
+            SortOptions adjustSortOptions(SortOptions opts) {
+                return Parent::adjustSortOptions(opts).BackgroundSpill().ReadAhead();
+            }
+        };
     }
 
     class SorterSuite : public mongo::unittest::Suite {
@@ -547,6 +573,8 @@ namespace mongo {
             add<SorterTests::LotsOfDataWithLimit<100,/*random=*/true> >();  // fits in mem
             add<SorterTests::LotsOfDataWithLimit<5000,/*random=*/false> >(); // spills
             add<SorterTests::LotsOfDataWithLimit<5000,/*random=*/true> >(); // spills
+            add<SorterTests::LotsOfDataInBackground</*random=*/false> >();
+            add<SorterTests::LotsOfDataInBackground</*random=*/true> >();
         }
     };
 
@@ -162,9 +162,26 @@ namespace mongo {
         _lock.unlock();
     }
 
+    void TransportCounters::enable(const std::string& mode, int ioThreads, int workerThreads) {
+        _mode = mode;
+        _ioThreads = ioThreads;
+        _workerThreads = workerThreads;
+        _enabled = true;
+    }
+
+    void TransportCounters::append( BSONObjBuilder& b ) {
+        b.append( "mode" , _mode );
+        b.append( "ioThreads" , _ioThreads );
+        b.append( "workerThreads" , _workerThreads );
+        b.appendNumber( "queued" , _queued.load() );
+        b.appendNumber( "running" , _running.load() );
+        b.appendNumber( "completed" , _completed.load() );
+    }
+
 
     OpCounters globalOpCounters;
     OpCounters replOpCounters;
     NetworkCounter networkCounter;
+    TransportCounters transportCounters;
 
 }
@@ -98,4 +98,36 @@ namespace mongo {
     };
 
     extern NetworkCounter networkCounter;
+
+    /**
+     * Counters for transports which hand requests off to a pool of worker threads rather than
+     * servicing each connection on its own thread.
+     */
+    class TransportCounters {
+    public:
+        TransportCounters() : _enabled(false), _ioThreads(0), _workerThreads(0) {}
+
+        /**
+         * Called once at startup, before any requests are counted.
+         */
+        void enable(const std::string& mode, int ioThreads, int workerThreads);
+
+        void gotQueued() { _queued.fetchAndAdd(1); }
+        void gotStarted() { _queued.fetchAndSubtract(1); _running.fetchAndAdd(1); }
+        void gotFinished() { _running.fetchAndSubtract(1); _completed.fetchAndAdd(1); }
+
+        bool isEnabled() const { return _enabled; }
+        void append( BSONObjBuilder& b );
+    private:
+        bool _enabled;
+        std::string _mode;
+        int _ioThreads;
+        int _workerThreads;
+
+        AtomicInt64 _queued;
+        AtomicInt64 _running;
+        AtomicInt64 _completed;
+    };
+
+    extern TransportCounters transportCounters;
 }
@@ -30,6 +30,7 @@
 
 #include "mongo/db/client.h"
 #include "mongo/db/commands/server_status.h"
+#include "mongo/db/concurrency/admission_control.h"
 #include "mongo/db/concurrency/lock_stats.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/operation_context.h"
@@ -135,5 +136,21 @@ namespace {
 
     } lockStatsServerStatusSection;
 
+
+    class AdmissionControlServerStatusSection : public ServerStatusSection {
+    public:
+        AdmissionControlServerStatusSection() : ServerStatusSection("admissionControl") { }
+
+        virtual bool includeByDefault() const { return true; }
+
+        virtual BSONObj generateSection(OperationContext* txn,
+                                        const BSONElement& configElement) const {
+            BSONObjBuilder ret;
+            getGlobalAdmissionController()->report(&ret);
+            return ret.obj();
+        }
+
+    } admissionControlServerStatusSection;
+
 } // namespace
 } // namespace mongo
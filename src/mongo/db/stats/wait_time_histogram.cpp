@@ -0,0 +1,74 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/wait_time_histogram.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+
+namespace mongo {
+
+    const uint64_t WaitTimeHistogram::BucketBoundsMicros[] = {
+        100,
+        1000,
+        10 * 1000,
+        100 * 1000,
+        1000 * 1000,
+    };
+
+    const char* const WaitTimeHistogram::BucketNames[] = {
+        "lt100us",
+        "lt1ms",
+        "lt10ms",
+        "lt100ms",
+        "lt1s",
+        "ge1s",
+    };
+
+    WaitTimeHistogram::WaitTimeHistogram() {
+        for (int i = 0; i < NumBuckets; i++) {
+            _buckets[i] = 0;
+        }
+    }
+
+    void WaitTimeHistogram::record(uint64_t micros) {
+        int bucket = 0;
+        while (bucket < NumBuckets - 1 && micros >= BucketBoundsMicros[bucket]) {
+            bucket++;
+        }
+        _buckets[bucket]++;
+    }
+
+    void WaitTimeHistogram::append(BSONObjBuilder* builder) const {
+        for (int bucket = 0; bucket < NumBuckets; bucket++) {
+            builder->append(BucketNames[bucket], static_cast<long long>(_buckets[bucket]));
+        }
+    }
+
+} // namespace mongo
@@ -0,0 +1,64 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Counts waits by how long they took, in buckets growing by a factor of ten from 100
+     * microseconds up to a second. Each bucket counts waits shorter than its bound, except for
+     * the last, which counts everything longer.
+     *
+     * Not thread safe; callers serialize access themselves.
+     */
+    class WaitTimeHistogram {
+    public:
+        enum { NumBuckets = 6 };
+
+        WaitTimeHistogram();
+
+        void record(uint64_t micros);
+
+        /**
+         * Appends one field per bucket, named after its bound, such as "lt100us" or "ge1s".
+         */
+        void append(BSONObjBuilder* builder) const;
+
+    private:
+        static const uint64_t BucketBoundsMicros[NumBuckets - 1];
+        static const char* const BucketNames[NumBuckets];
+
+        int64_t _buckets[NumBuckets];
+    };
+
+} // namespace mongo
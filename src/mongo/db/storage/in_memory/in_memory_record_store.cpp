@@ -64,6 +64,26 @@ namespace mongo {
         const RecordId _loc;
     };
 
+    class InMemoryRecordStore::InsertGroupChange : public RecoveryUnit::Change {
+    public:
+        InsertGroupChange(Data* data, std::vector<RecordId> locs)
+            : _data(data), _locs(std::move(locs)) {}
+        virtual void commit() {}
+        virtual void rollback() {
+            for (size_t i = 0; i < _locs.size(); i++) {
+                Records::iterator it = _data->records.find(_locs[i]);
+                if (it != _data->records.end()) {
+                    _data->dataSize -= it->second.size;
+                    _data->records.erase(it);
+                }
+            }
+        }
+
+    private:
+        Data* const _data;
+        const std::vector<RecordId> _locs;
+    };
+
     // Works for both removes and updates
     class InMemoryRecordStore::RemoveChange : public RecoveryUnit::Change {
     public:
@@ -292,6 +312,35 @@ namespace mongo {
         return StatusWith<RecordId>(loc);
     }
 
+    Status InMemoryRecordStore::insertRecords(OperationContext* txn,
+                                              const std::vector<RecordData>& records,
+                                              bool enforceQuota,
+                                              std::vector<RecordId>* locsOut) {
+        // Capped collections delete as they go and the oplog has its own RecordIds, so only
+        // plain collections are inserted as a group.
+        if (_isCapped || _data->isOplog) {
+            return RecordStore::insertRecords(txn, records, enforceQuota, locsOut);
+        }
+
+        std::vector<RecordId> locs;
+        locs.reserve(records.size());
+        for (size_t i = 0; i < records.size(); i++) {
+            const int len = records[i].size();
+            InMemoryRecord rec(len);
+            memcpy(rec.data.get(), records[i].data(), len);
+
+            const RecordId loc = allocateLoc();
+            _data->dataSize += len;
+            _data->records[loc] = rec;
+            locs.push_back(loc);
+        }
+
+        locsOut->insert(locsOut->end(), locs.begin(), locs.end());
+        txn->recoveryUnit()->registerChange(new InsertGroupChange(_data, std::move(locs)));
+
+        return Status::OK();
+    }
+
     StatusWith<RecordId> InMemoryRecordStore::updateRecord(OperationContext* txn,
                                                           const RecordId& loc,
                                                           const char* data,
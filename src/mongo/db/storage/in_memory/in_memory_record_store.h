@@ -72,6 +72,11 @@ namespace mongo {
                                                   const DocWriter* doc,
                                                   bool enforceQuota );
 
+        virtual Status insertRecords( OperationContext* txn,
+                                      const std::vector<RecordData>& records,
+                                      bool enforceQuota,
+                                      std::vector<RecordId>* locsOut );
+
         virtual StatusWith<RecordId> updateRecord( OperationContext* txn,
                                                   const RecordId& oldLocation,
                                                   const char* data,
@@ -163,6 +168,7 @@ namespace mongo {
 
     private:
         class InsertChange;
+        class InsertGroupChange;
         class RemoveChange;
         class TruncateChange;
 
@@ -174,11 +174,34 @@ namespace mongo {
             const char* input = static_cast<const char*>(src);
             char* output = static_cast<char*>(dst);
             const char* const end = input + bytes;
+
+            // Flip a word at a time, then finish off the tail a byte at a time.
+            while (size_t(end - input) >= sizeof(uint64_t)) {
+                uint64_t word;
+                memcpy(&word, input, sizeof(word));
+                word = ~word;
+                memcpy(output, &word, sizeof(word));
+                input += sizeof(word);
+                output += sizeof(word);
+            }
+
             while (input != end) {
                 *output++ = ~(*input++);
             }
         }
 
+        void copyBytes(char* dst, const void* src, size_t bytes, bool invert) {
+            if (invert) {
+                memcpy_flipBits(dst, src, bytes);
+            } else {
+                memcpy(dst, src, bytes);
+            }
+        }
+
+        char flipIf(uint8_t byte, bool invert) {
+            return invert ? ~byte : byte;
+        }
+
         template <typename T> T readType(BufReader* reader, bool inverted) {
             // TODO for C++11 to static_assert that T is integral
             T t = ConstDataView(static_cast<const char*>(reader->skip(sizeof(T)))).read<T>();
@@ -234,8 +257,10 @@ namespace mongo {
 
         string readInvertedCStringWithNuls(BufReader* reader) {
             std::string out;
+            bool firstPass = true;
             do {
-                if (!out.empty()) {
+                // out may still be empty after the first pass if the string starts with a NUL.
+                if (!firstPass) {
                     // If this isn't our first pass through the loop it means we hit an NUL byte
                     // encoded as "\xFF\00" in our inverted string.
                     reader->skip(1);
@@ -250,6 +275,7 @@ namespace mongo {
 
                 out.append(start, actualBytes);
                 reader->skip(1 + actualBytes);
+                firstPass = false;
             } while (reader->peek<unsigned char>() == 0x00);
 
             for (size_t i = 0; i < out.size(); i++) {
@@ -376,21 +402,23 @@ namespace mongo {
     }
 
     void KeyString::_appendDate(Date_t val, bool invert) {
-        _append(CType::kDate, invert);
         // see: http://en.wikipedia.org/wiki/Offset_binary
         uint64_t encoded = static_cast<uint64_t>(val.asInt64());
         encoded ^= (1LL << 63); // flip highest bit (equivalent to bias encoding)
-        _append(endian::nativeToBig(encoded), invert);
+        _appendCTypeAndUInt64(CType::kDate, endian::nativeToBig(encoded), invert, invert);
     }
 
     void KeyString::_appendTimestamp(Timestamp val, bool invert) {
-        _append(CType::kTimestamp, invert);
-        _append(endian::nativeToBig(val.asLL()), invert);
+        _appendCTypeAndUInt64(CType::kTimestamp,
+                              endian::nativeToBig(static_cast<uint64_t>(val.asLL())),
+                              invert,
+                              invert);
     }
 
     void KeyString::_appendOID(OID val, bool invert) {
-        _append(CType::kOID, invert);
-        _appendBytes(val.view().view(), OID::kOIDSize, invert);
+        char* const base = _buffer.skip(1 + OID::kOIDSize);
+        base[0] = flipIf(CType::kOID, invert);
+        copyBytes(base + 1, val.view().view(), OID::kOIDSize, invert);
     }
 
     void KeyString::_appendString(StringData val, bool invert) {
@@ -591,16 +619,27 @@ namespace mongo {
 
     void KeyString::_appendStringLike(StringData str, bool invert) {
         while (true) {
-            size_t firstNul = strnlen(str.rawData(), str.size());
-            // No NULs in string.
-            _appendBytes(str.rawData(), firstNul, invert);
-            if (firstNul == str.size() || firstNul == std::string::npos) {
-                _append(int8_t(0), invert);
+            // memchr scans a word or vector at a time, so strings without NULs (nearly all of
+            // them) are copied along with their terminator using a single reservation.
+            const char* const nul = str.empty()
+                                    ? NULL
+                                    : static_cast<const char*>(memchr(str.rawData(), 0x0,
+                                                                      str.size()));
+            if (!nul) {
+                char* const base = _buffer.skip(str.size() + 1);
+                if (!str.empty())
+                    copyBytes(base, str.rawData(), str.size(), invert);
+                base[str.size()] = flipIf(0x0, invert);
                 break;
             }
 
             // replace "\x00" with "\x00\xFF"
-            _appendBytes("\x00\xFF", 2, invert);
+            const size_t firstNul = nul - str.rawData();
+            char* const base = _buffer.skip(firstNul + 2);
+            if (firstNul)
+                copyBytes(base, str.rawData(), firstNul, invert);
+            base[firstNul] = flipIf(0x0, invert);
+            base[firstNul + 1] = flipIf(0xFF, invert);
             str = str.substr(firstNul + 1); // skip over the NUL byte
         }
     }
@@ -623,12 +662,16 @@ namespace mongo {
         memcpy(&data, &value, sizeof(data));
 
         if (value > 0) {
-            _append(CType::kNumericPositiveSmallDouble, invert);
-            _append(endian::nativeToBig(data), invert);
+            _appendCTypeAndUInt64(CType::kNumericPositiveSmallDouble,
+                                  endian::nativeToBig(data),
+                                  invert,
+                                  invert);
         }
         else {
-            _append(CType::kNumericNegativeSmallDouble, invert);
-            _append(endian::nativeToBig(data), !invert);
+            _appendCTypeAndUInt64(CType::kNumericNegativeSmallDouble,
+                                  endian::nativeToBig(data),
+                                  invert,
+                                  !invert);
         }
     }
 
@@ -640,12 +683,16 @@ namespace mongo {
         memcpy(&data, &value, sizeof(data));
 
         if (value > 0) {
-            _append(CType::kNumericPositiveLargeDouble, invert);
-            _append(endian::nativeToBig(data), invert);
+            _appendCTypeAndUInt64(CType::kNumericPositiveLargeDouble,
+                                  endian::nativeToBig(data),
+                                  invert,
+                                  invert);
         }
         else {
-            _append(CType::kNumericNegativeLargeDouble, invert);
-            _append(endian::nativeToBig(data), !invert);
+            _appendCTypeAndUInt64(CType::kNumericNegativeLargeDouble,
+                                  endian::nativeToBig(data),
+                                  invert,
+                                  !invert);
         }
     }
 
@@ -676,18 +723,32 @@ namespace mongo {
 
         const size_t bytesNeeded = (64 - countLeadingZeros64(value) + 7) / 8;
 
-        // Append the low bytes of value in big endian order.
+        const uint8_t ctype = isNegative
+                              ? uint8_t(CType::kNumericNegative1ByteInt - (bytesNeeded - 1))
+                              : uint8_t(CType::kNumericPositive1ByteInt + (bytesNeeded - 1));
+
+        // Append the low bytes of value in big endian order. Negative values have their magnitude
+        // inverted so that larger magnitudes sort first. The ctype and the value bytes are written
+        // with a single reservation since this is the hottest path for integer keys.
         value = endian::nativeToBig(value);
-        const void* firstUsedByte = reinterpret_cast<const char*>((&value) + 1) - bytesNeeded;
+        if (isNegative != invert)
+            value = ~value;
+        const char* firstUsedByte = reinterpret_cast<const char*>((&value) + 1) - bytesNeeded;
 
-        if (isNegative) {
-            _append(uint8_t(CType::kNumericNegative1ByteInt - (bytesNeeded - 1)), invert);
-            _appendBytes(firstUsedByte, bytesNeeded, !invert);
-        }
-        else {
-            _append(uint8_t(CType::kNumericPositive1ByteInt + (bytesNeeded - 1)), invert);
-            _appendBytes(firstUsedByte, bytesNeeded, invert);
-        }
+        char* const base = _buffer.skip(1 + bytesNeeded);
+        base[0] = flipIf(ctype, invert);
+        memcpy(base + 1, firstUsedByte, bytesNeeded);
+    }
+
+    void KeyString::_appendCTypeAndUInt64(uint8_t ctype,
+                                          uint64_t bigEndianValue,
+                                          bool invertCType,
+                                          bool invertValue) {
+        char* const base = _buffer.skip(1 + sizeof(bigEndianValue));
+        base[0] = flipIf(ctype, invertCType);
+        if (invertValue)
+            bigEndianValue = ~bigEndianValue;
+        memcpy(base + 1, &bigEndianValue, sizeof(bigEndianValue));
     }
 
     template <typename T>
@@ -697,12 +758,7 @@ namespace mongo {
 
     void KeyString::_appendBytes(const void* source, size_t bytes, bool invert) {
         char* const base = _buffer.skip(bytes);
-
-        if (invert) {
-            memcpy_flipBits(base, source, bytes);
-        } else {
-            memcpy(base, source, bytes);
-        }
+        copyBytes(base, source, bytes, invert);
     }
 
 
@@ -285,6 +285,14 @@ namespace mongo {
         void _appendInteger(const long long num, bool invert);
         void _appendPreshiftedIntegerPortion(uint64_t value, bool isNegative, bool invert);
 
+        /**
+         * Appends a ctype byte followed by an 8-byte value that is already in big endian order.
+         */
+        void _appendCTypeAndUInt64(uint8_t ctype,
+                                   uint64_t bigEndianValue,
+                                   bool invertCType,
+                                   bool invertValue);
+
         template <typename T> void _append(const T& thing, bool invert);
         void _appendBytes(const void* source, size_t bytes, bool invert);
 
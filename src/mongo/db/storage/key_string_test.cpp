@@ -844,3 +844,19 @@ TEST(KeyStringTest, RecordIds) {
     }
 }
 
+
+TEST(KeyStringTest, LongStringsWithNuls) {
+    // Long enough that inverted strings are flipped a word at a time with a ragged tail, with
+    // NUL bytes landing at the start, middle, and end of words.
+    std::string str;
+    for (int i = 0; i < 37; i++) {
+        str += (i % 5 == 0) ? '\0' : char('a' + i % 26);
+        ROUNDTRIP(BSON("" << str));
+        ROUNDTRIP(BSON("" << BSONSymbol(str)));
+        ROUNDTRIP(BSON("" << BSONCode(str)));
+    }
+
+    COMPARES_SAME(BSON("" << str), BSON("" << (str + '\0')));
+    COMPARES_SAME(BSON("" << (str + '\0')), BSON("" << (str + 'a')));
+    COMPARES_SAME(BSON("" << str.substr(0, 20)), BSON("" << str));
+}
@@ -366,14 +366,21 @@ namespace {
                                                          ordering,
                                                          indexName);
         }
-        else {
-            invariant(1 == version);
+        else if (1 == version) {
             return new BtreeInterfaceImpl<BtreeLayoutV1>(headManager,
                                                          recordStore,
                                                          cursorRegistry,
                                                          ordering,
                                                          indexName);
         }
+        else {
+            invariant(2 == version);
+            return new BtreeInterfaceImpl<BtreeLayoutV2>(headManager,
+                                                         recordStore,
+                                                         cursorRegistry,
+                                                         ordering,
+                                                         indexName);
+        }
     }
 
 }  // namespace mongo
@@ -52,6 +52,26 @@ namespace mongo {
     using std::stringstream;
     using std::vector;
 
+    namespace {
+
+        /**
+         * The type of the length stored before the suffix of a key that begins with its bucket's
+         * prefix.
+         */
+        typedef unsigned short SuffixSize;
+
+        /**
+         * Whether the 'size' bytes of key data are stored as a suffix of the bucket 'prefix'.  That
+         * only saves space with a prefix longer than the length stored with the suffix.
+         */
+        bool isStoredAsSuffix(StringData prefix, const char* data, int size) {
+            return prefix.size() > sizeof(SuffixSize)
+                && size >= static_cast<int>(prefix.size())
+                && memcmp(data, prefix.rawData(), prefix.size()) == 0;
+        }
+
+    }  // namespace
+
     // BtreeLogic::Builder algorithm
     //
     // Phase 1:
@@ -140,7 +160,7 @@ namespace mongo {
         }
         
         BucketType* rightLeaf = _getModifiableBucket(_rightLeafLoc);
-        if (!_logic->pushBack(rightLeaf, loc, *key, DiskLoc())) {
+        if (!_pushBack(rightLeaf, loc, *key, DiskLoc())) {
             // bucket was full, so split and try with the new node.
             _txn->recoveryUnit()->registerChange(new SetRightLeafLocChange(this, _rightLeafLoc));
             _rightLeafLoc = newBucket(rightLeaf, _rightLeafLoc);
@@ -182,10 +202,10 @@ namespace mongo {
         // Pull right-most key out of leftSib and move to parent, splitting parent if necessary.
         // Note that popBack() handles setting leftSib's nextChild to the former prevChildNode of
         // the popped key.
-        KeyDataType key;
+        const KeyDataOwnedType key(getFullKey(leftSib, leftSib->n - 1).data);
         DiskLoc val;
-        _logic->popBack(leftSib, &val, &key);
-        if (!_logic->pushBack(parent, val, key, leftSibLoc)) {
+        _logic->popBack(leftSib, &val);
+        if (!_pushBack(parent, val, key, leftSibLoc)) {
             // parent is full, so split it.
             parentLoc = newBucket(parent, parentLoc);
             parent = _getModifiableBucket(parentLoc);
@@ -202,6 +222,21 @@ namespace mongo {
         return newBucketLoc;
     }
 
+    /**
+     * A pushBack() that, before it gives up on a full bucket, tries to make room by compressing
+     * the keys already in it.
+     */
+    template <class BtreeLayout>
+    bool BtreeLogic<BtreeLayout>::Builder::_pushBack(BucketType* bucket,
+                                                     const DiskLoc loc,
+                                                     const KeyDataType& key,
+                                                     const DiskLoc prevChild) {
+        if (_logic->pushBack(bucket, loc, key, prevChild)) {
+            return true;
+        }
+        return _logic->_compressKeyData(bucket) && _logic->pushBack(bucket, loc, key, prevChild);
+    }
+
     template <class BtreeLayout>
     typename BtreeLogic<BtreeLayout>::BucketType*
     BtreeLogic<BtreeLayout>::Builder::_getModifiableBucket(DiskLoc loc) {
@@ -256,6 +291,220 @@ namespace mongo {
         return bucket->data + ofs;
     }
 
+    // static
+    template <class BtreeLayout>
+    StringData BtreeLogic<BtreeLayout>::_bucketPrefix(const BucketType* bucket) {
+        const int prefixSize = BtreeLayout::prefixSize(bucket);
+        return StringData(bucket->data + BtreeLayout::BucketBodySize - prefixSize, prefixSize);
+    }
+
+    /**
+     * Returns the key data of 'header', putting it back together in the BtreeLayout::KeyMax bytes
+     * at 'decoded' when it is stored as a suffix of the bucket prefix.  '*decodedSize' is set to
+     * the size of the key data put together there, or to 0 when the key is stored whole.
+     */
+    // static
+    template <class BtreeLayout>
+    const char* BtreeLogic<BtreeLayout>::_keyDataAt(const BucketType* bucket,
+                                                    const KeyHeaderType& header,
+                                                    char* decoded,
+                                                    int* decodedSize) {
+        const char* stored = bucket->data + header.keyDataOfs();
+        if (!BtreeLayout::isPrefixed(header)) {
+            *decodedSize = 0;
+            return stored;
+        }
+
+        const StringData prefix = _bucketPrefix(bucket);
+        SuffixSize suffixSize;
+        memcpy(&suffixSize, stored, sizeof(suffixSize));
+
+        // Keys longer than KeyMax are never inserted.
+        *decodedSize = prefix.size() + suffixSize;
+        invariant(*decodedSize <= BtreeLayout::KeyMax);
+
+        memcpy(decoded, prefix.rawData(), prefix.size());
+        memcpy(decoded + prefix.size(), stored + sizeof(suffixSize), suffixSize);
+        return decoded;
+    }
+
+    /**
+     * Returns the number of bytes the data of the i-th key takes in the bucket.
+     */
+    // static
+    template <class BtreeLayout>
+    int BtreeLogic<BtreeLayout>::_storedKeySize(const BucketType* bucket, int i) {
+        const KeyHeaderType& header = getKeyHeader(bucket, i);
+        const char* stored = bucket->data + header.keyDataOfs();
+        if (BtreeLayout::isPrefixed(header)) {
+            SuffixSize suffixSize;
+            memcpy(&suffixSize, stored, sizeof(suffixSize));
+            return sizeof(suffixSize) + suffixSize;
+        }
+        return KeyDataType(stored).dataSize();
+    }
+
+    /**
+     * Returns the number of bytes 'key' takes in a bucket with the given prefix.  This is never
+     * more than key.dataSize().
+     */
+    // static
+    template <class BtreeLayout>
+    int BtreeLogic<BtreeLayout>::_encodedKeySize(StringData prefix, const KeyDataType& key) {
+        const int size = key.dataSize();
+        if (!isStoredAsSuffix(prefix, key.data(), size)) {
+            return size;
+        }
+        return sizeof(SuffixSize) + size - prefix.size();
+    }
+
+    /**
+     * Writes the _encodedKeySize() bytes of 'key' to 'dest', and flags 'header' when they are a
+     * suffix of 'prefix'.  The key data offset must be set in 'header' beforehand.
+     */
+    // static
+    template <class BtreeLayout>
+    void BtreeLogic<BtreeLayout>::_encodeKey(StringData prefix,
+                                             const KeyDataType& key,
+                                             char* dest,
+                                             KeyHeaderType* header) {
+        const int size = key.dataSize();
+        if (!isStoredAsSuffix(prefix, key.data(), size)) {
+            memcpy(dest, key.data(), size);
+            return;
+        }
+
+        const SuffixSize suffixSize = size - prefix.size();
+        memcpy(dest, &suffixSize, sizeof(suffixSize));
+        memcpy(dest + sizeof(suffixSize), key.data() + prefix.size(), suffixSize);
+        BtreeLayout::setPrefixed(header);
+    }
+
+    /**
+     * Allocates space for and writes the data of 'key', of a key of 'bucket' whose 'header' is
+     * otherwise set.
+     */
+    // static
+    template <class BtreeLayout>
+    void BtreeLogic<BtreeLayout>::_writeKey(BucketType* bucket,
+                                            KeyHeaderType* header,
+                                            const KeyDataType& key) {
+        const StringData prefix = _bucketPrefix(bucket);
+        header->setKeyDataOfs((short) _alloc(bucket, _encodedKeySize(prefix, key)));
+        _encodeKey(prefix, key, dataAt(bucket, header->keyDataOfs()), header);
+    }
+
+    /**
+     * Gives the empty 'bucket' a prefix for the keys about to be added to it.  Prefixes too short
+     * to save space are not stored.
+     */
+    // static
+    template <class BtreeLayout>
+    void BtreeLogic<BtreeLayout>::_setPrefix(BucketType* bucket, StringData prefix) {
+        invariant(bucket->n == 0 && bucket->topSize == 0);
+        if (prefix.size() <= sizeof(SuffixSize)) {
+            return;
+        }
+
+        memcpy(dataAt(bucket, _alloc(bucket, prefix.size())), prefix.rawData(), prefix.size());
+        BtreeLayout::setPrefixSize(bucket, prefix.size());
+    }
+
+    /**
+     * Rewrites the data of the keys of 'bucket' to the top of its body, leaving out the space of
+     * keys no longer in it.  A prefix compressed bucket also gets a new prefix: of its current one,
+     * the longest one common to all its keys and none at all, the one that stores the keys in the
+     * fewest bytes.  The current prefix never takes more than the keys did before, so they fit.
+     */
+    // static
+    template <class BtreeLayout>
+    void BtreeLogic<BtreeLayout>::_rewriteKeyData(BucketType* bucket) {
+        const int tdz = totalDataSize(bucket);
+        const int KNS = sizeof(KeyHeaderType);
+
+        // Copied, as it is in the data being rewritten.
+        string prefix = _bucketPrefix(bucket).toString();
+
+        if (BtreeLayout::PrefixCompressed && bucket->n > 1) {
+            string common;
+            int fullSize = 0;
+            int currentSize = prefix.size();
+            for (int i = 0; i < bucket->n; ++i) {
+                const FullKey kn = getFullKey(bucket, i);
+                const int keySize = kn.data.dataSize();
+                if (i == 0) {
+                    common.assign(kn.data.data(), keySize);
+                }
+                else {
+                    size_t j = 0;
+                    while (j < common.size()
+                           && static_cast<int>(j) < keySize
+                           && common[j] == kn.data.data()[j]) {
+                        ++j;
+                    }
+                    common.resize(j);
+                }
+                fullSize += keySize;
+                currentSize += _storedKeySize(bucket, i);
+            }
+
+            const int commonLength = common.size();
+            int commonSize = fullSize;
+            if (commonLength > static_cast<int>(sizeof(SuffixSize))) {
+                commonSize = commonLength + fullSize
+                           - bucket->n * (commonLength - static_cast<int>(sizeof(SuffixSize)));
+            }
+
+            if (commonSize <= currentSize && commonSize < fullSize) {
+                prefix = common;
+            }
+            else if (currentSize >= fullSize) {
+                prefix.clear();
+            }
+        }
+        else if (bucket->n == 0) {
+            prefix.clear();
+        }
+
+        char temp[BtreeLayout::BucketSize];
+        int ofs = tdz - prefix.size();
+        memcpy(temp + ofs, prefix.data(), prefix.size());
+
+        for (int i = 0; i < bucket->n; i++) {
+            // Decoded with the current prefix, which stays in place until the copy below.
+            const FullKey kn = getFullKey(bucket, i);
+            ofs -= _encodedKeySize(prefix, kn.data);
+            KeyHeaderType& header = getKeyHeader(bucket, i);
+            header.setKeyDataOfsSavingUse(ofs);
+            _encodeKey(prefix, kn.data, temp + ofs, &header);
+        }
+
+        int dataUsed = tdz - ofs;
+        memcpy(bucket->data + ofs, temp + ofs, dataUsed);
+
+        BtreeLayout::setPrefixSize(bucket, prefix.size());
+        bucket->topSize = dataUsed;
+        bucket->emptySize = tdz - dataUsed - bucket->n * KNS;
+        int foo = bucket->emptySize;
+        invariant( foo >= 0 );
+    }
+
+    /**
+     * Rewrites the data of the keys of a prefix compressed bucket under the prefix that stores
+     * them in the fewest bytes.  Returns whether that made any room.
+     */
+    // static
+    template <class BtreeLayout>
+    bool BtreeLogic<BtreeLayout>::_compressKeyData(BucketType* bucket) {
+        if (!BtreeLayout::PrefixCompressed || bucket->n < 2) {
+            return false;
+        }
+
+        const int emptySize = bucket->emptySize;
+        _rewriteKeyData(bucket);
+        return bucket->emptySize > emptySize;
+    }
+
     template <class BtreeLayout>
     typename BtreeLogic<BtreeLayout>::BucketType*
     BtreeLogic<BtreeLayout>::btreemod(OperationContext* txn, BucketType* bucket) {
@@ -353,30 +602,24 @@ namespace mongo {
      * This is only used by BtreeLogic::Builder. Think very hard (and change this comment) before
      * using it anywhere else.
      *
-     * WARNING: The keyDataOut that is filled out by this function points to newly unalloced memory
-     * inside of this bucket. It only remains valid until the next write to this bucket.
+     * WARNING: The data of the popped key is unalloced, so the caller must copy the key beforehand.
      */
     template <class BtreeLayout>
-    void BtreeLogic<BtreeLayout>::popBack(BucketType* bucket,
-                                          DiskLoc* recordLocOut,
-                                          KeyDataType* keyDataOut) {
+    void BtreeLogic<BtreeLayout>::popBack(BucketType* bucket, DiskLoc* recordLocOut) {
 
         massert(17435,  "n==0 in btree popBack()", bucket->n > 0 );
 
         invariant(getKeyHeader(bucket, bucket->n - 1).isUsed());
 
-        FullKey kn = getFullKey(bucket, bucket->n - 1);
+        const KeyHeaderType& kn = getKeyHeader(bucket, bucket->n - 1);
         *recordLocOut = kn.recordLoc;
-        keyDataOut->assign(kn.data);
-        int keysize = kn.data.dataSize();
+        int keysize = _storedKeySize(bucket, bucket->n - 1);
 
         // The left/prev child of the node we are popping now goes in to the nextChild slot as all
         // of its keys are greater than all remaining keys in this node.
         bucket->nextChild = kn.prevChildBucket;
         bucket->n--;
 
-        // This is risky because the keyDataOut we filled out above will now point to this newly
-        // unalloced memory. 
         bucket->emptySize += sizeof(KeyHeaderType);
         _unalloc(bucket, keysize);
     }
@@ -390,7 +633,7 @@ namespace mongo {
                                            const KeyDataType& key,
                                            const DiskLoc prevChild) {
 
-        int bytesNeeded = key.dataSize() + sizeof(KeyHeaderType);
+        int bytesNeeded = _encodedKeySize(_bucketPrefix(bucket), key) + sizeof(KeyHeaderType);
         if (bytesNeeded > bucket->emptySize) {
             return false;
         }
@@ -411,10 +654,7 @@ namespace mongo {
         KeyHeaderType& kn = getKeyHeader(bucket, bucket->n++);
         kn.prevChildBucket = prevChild;
         kn.recordLoc = recordLoc;
-        kn.setKeyDataOfs((short)_alloc(bucket, key.dataSize()));
-        short ofs = kn.keyDataOfs();
-        char *p = dataAt(bucket, ofs);
-        memcpy(p, key.data(), key.dataSize());
+        _writeKey(bucket, &kn, key);
         return true;
     }
 
@@ -440,9 +680,11 @@ namespace mongo {
         invariant(bucket->n < 1024);
         invariant(keypos >= 0 && keypos <= bucket->n);
 
-        int bytesNeeded = key.dataSize() + sizeof(KeyHeaderType);
+        int bytesNeeded = _encodedKeySize(_bucketPrefix(bucket), key) + sizeof(KeyHeaderType);
         if (bytesNeeded > bucket->emptySize) {
             _pack(txn, bucket, bucketLoc, keypos);
+            // Packing may have changed the prefix the key is stored against.
+            bytesNeeded = _encodedKeySize(_bucketPrefix(bucket), key) + sizeof(KeyHeaderType);
             if (bytesNeeded > bucket->emptySize) {
                 return false;
             }
@@ -474,10 +716,12 @@ namespace mongo {
         KeyHeaderType& kn = getKeyHeader(bucket, keypos);
         kn.prevChildBucket.Null();
         kn.recordLoc = recordLoc;
-        kn.setKeyDataOfs((short) _alloc(bucket, key.dataSize()));
+        const StringData prefix = _bucketPrefix(bucket);
+        const int keySize = _encodedKeySize(prefix, key);
+        kn.setKeyDataOfs((short) _alloc(bucket, keySize));
         char *p = dataAt(bucket, kn.keyDataOfs());
-        txn->recoveryUnit()->writingPtr(p, key.dataSize());
-        memcpy(p, key.data(), key.dataSize());
+        txn->recoveryUnit()->writingPtr(p, keySize);
+        _encodeKey(prefix, key, p, &kn);
         return true;
     }
 
@@ -499,6 +743,27 @@ namespace mongo {
             return BtreeLayout::BucketSize - bucket->emptySize - BucketType::HeaderSize;
         }
 
+        int size = BtreeLayout::prefixSize(bucket);
+        for (int j = 0; j < bucket->n; ++j) {
+            if (mayDropKey(bucket, j, refPos)) {
+                continue;
+            }
+            size += _storedKeySize(bucket, j) + sizeof(KeyHeaderType);
+        }
+
+        return size;
+    }
+
+    /**
+     * Like _packedDataSize(), but for the keys copied into another bucket, where they may not
+     * share the prefix they are stored against in this one.
+     */
+    template <class BtreeLayout>
+    int BtreeLogic<BtreeLayout>::_copiedDataSize(BucketType* bucket, int refPos) {
+        if (!BtreeLayout::PrefixCompressed) {
+            return _packedDataSize(bucket, refPos);
+        }
+
         int size = 0;
         for (int j = 0; j < bucket->n; ++j) {
             if (mayDropKey(bucket, j, refPos)) {
@@ -522,7 +787,8 @@ namespace mongo {
 
         invariant(getBucket(txn, thisLoc) == bucket);
 
-        if (bucket->flags & Packed) {
+        // A prefix compressed bucket is repacked anyway for a better prefix.
+        if ((bucket->flags & Packed) && !BtreeLayout::PrefixCompressed) {
             return;
         }
 
@@ -534,15 +800,10 @@ namespace mongo {
      */
     template <class BtreeLayout>
     void BtreeLogic<BtreeLayout>::_packReadyForMod(BucketType* bucket, int &refPos) {
-        if (bucket->flags & Packed) {
+        if ((bucket->flags & Packed) && !BtreeLayout::PrefixCompressed) {
             return;
         }
 
-        int tdz = totalDataSize(bucket);
-        char temp[BtreeLayout::BucketSize];
-        int ofs = tdz;
-        bucket->topSize = 0;
-
         int i = 0;
         for (int j = 0; j < bucket->n; j++) {
             if (mayDropKey(bucket, j, refPos)) {
@@ -557,13 +818,6 @@ namespace mongo {
                 }
                 getKeyHeader(bucket, i) = getKeyHeader(bucket, j);
             }
-
-            short ofsold = getKeyHeader(bucket, i).keyDataOfs();
-            int sz = getFullKey(bucket, i).data.dataSize();
-            ofs -= sz;
-            bucket->topSize += sz;
-            memcpy(temp + ofs, dataAt(bucket, ofsold), sz);
-            getKeyHeader(bucket, i).setKeyDataOfsSavingUse(ofs);
             ++i;
         }
 
@@ -572,12 +826,7 @@ namespace mongo {
         }
 
         bucket->n = i;
-        int dataUsed = tdz - ofs;
-        memcpy(bucket->data + ofs, temp + ofs, dataUsed);
-
-        bucket->emptySize = tdz - dataUsed - bucket->n * sizeof(KeyHeaderType);
-        int foo = bucket->emptySize;
-        invariant( foo >= 0 );
+        _rewriteKeyData(bucket);
         setPacked(bucket);
         assertValid(_indexName, bucket, _ordering);
     }
@@ -619,7 +868,7 @@ namespace mongo {
                            / (keypos == bucket->n ? 10 : 2);
 
         for (int i = bucket->n - 1; i > -1; --i) {
-            rightSize += getFullKey(bucket, i).data.dataSize() + sizeof(KeyHeaderType);
+            rightSize += _storedKeySize(bucket, i) + sizeof(KeyHeaderType);
             if (rightSize > rightSizeLimit) {
                 split = i;
                 break;
@@ -656,10 +905,7 @@ namespace mongo {
         KeyHeaderType &kn = getKeyHeader(bucket, i);
         kn.recordLoc = recordLoc;
         kn.prevChildBucket = prevChildBucket;
-        short ofs = (short) _alloc(bucket, key.dataSize());
-        kn.setKeyDataOfs(ofs);
-        char *p = dataAt(bucket, ofs);
-        memcpy(p, key.data(), key.dataSize());
+        _writeKey(bucket, &kn, key);
     }
 
     template <class BtreeLayout>
@@ -1378,7 +1624,7 @@ namespace mongo {
 
         int sum = BucketType::HeaderSize
                 + _packedDataSize(leftBucket, pos)
-                + _packedDataSize(rightBucket, pos)
+                + _copiedDataSize(rightBucket, pos)
                 + getFullKey(bucket, leftIndex).data.dataSize()
                 + sizeof(KeyHeaderType);
 
@@ -1412,7 +1658,7 @@ namespace mongo {
         invariant(rightSizeLimit < BtreeLayout::BucketBodySize);
 
         for (int i = r->n - 1; i > -1; --i) {
-            rightSize += getFullKey(r, i).data.dataSize() + KNS;
+            rightSize += _storedKeySize(r, i) + KNS;
             if (rightSize > rightSizeLimit) {
                 split = l->n + 1 + i;
                 break;
@@ -1428,7 +1674,7 @@ namespace mongo {
 
         if (split == -1) {
             for (int i = l->n - 1; i > -1; --i) {
-                rightSize += getFullKey(l, i).data.dataSize() + KNS;
+                rightSize += _storedKeySize(l, i) + KNS;
                 if (rightSize > rightSizeLimit) {
                     split = i;
                     break;
@@ -1473,6 +1719,7 @@ namespace mongo {
             FullKey kn = getFullKey(r, i);
             invariant(pushBack(l, kn.recordLoc, kn.data, kn.prevChildBucket));
         }
+        _compressKeyData(l);
 
         l->nextChild = r->nextChild;
         fixParentPtrs(txn, l, leftNodeLoc, oldLNum);
@@ -1531,8 +1778,7 @@ namespace mongo {
             return false;
         }
 
-        doBalanceChildren(txn, btreemod(txn, bucket), bucketLoc, leftIndex);
-        return true;
+        return doBalanceChildren(txn, btreemod(txn, bucket), bucketLoc, leftIndex);
     }
 
     template <class BtreeLayout>
@@ -1621,7 +1867,7 @@ namespace mongo {
     }
 
     template <class BtreeLayout>
-    void BtreeLogic<BtreeLayout>::doBalanceChildren(OperationContext* txn,
+    bool BtreeLogic<BtreeLayout>::doBalanceChildren(OperationContext* txn,
                                                     BucketType* bucket,
                                                     const DiskLoc bucketLoc,
                                                     int leftIndex) {
@@ -1638,6 +1884,32 @@ namespace mongo {
 
         int split = _rebalancedSeparatorPos(txn, bucket, leftIndex);
 
+        if (BtreeLayout::PrefixCompressed) {
+            // The keys moved into a child are written whole unless they share its prefix, so only
+            // balance when they fit that way.
+            if (split == l->n) {
+                return false;
+            }
+
+            int moved = getFullKey(bucket, leftIndex).data.dataSize() + sizeof(KeyHeaderType);
+            if (split < l->n) {
+                for (int i = split + 1; i < l->n; ++i) {
+                    moved += getFullKey(l, i).data.dataSize() + sizeof(KeyHeaderType);
+                }
+                if (moved > r->emptySize) {
+                    return false;
+                }
+            }
+            else {
+                for (int i = 0; i < split - l->n - 1; ++i) {
+                    moved += getFullKey(r, i).data.dataSize() + sizeof(KeyHeaderType);
+                }
+                if (moved > l->emptySize) {
+                    return false;
+                }
+            }
+        }
+
         // By definition, if we are below the low water mark and cannot merge
         // then we must actively balance.
         invariant(split != l->n);
@@ -1647,6 +1919,7 @@ namespace mongo {
         else {
             doBalanceRightToLeft(txn, bucket, bucketLoc, leftIndex, split, l, lchild, r, rchild);
         }
+        return true;
     }
 
     template <class BtreeLayout>
@@ -1680,12 +1953,14 @@ namespace mongo {
             return true;
         }
 
+        // Neither side could be balanced, which unless the buckets are prefix compressed means
+        // that they can be merged.
         BucketType* pm = btreemod(txn, getBucket(txn, bucket->parent));
-        if (mayBalanceRight) {
+        if (mayBalanceRight && canMergeChildren(txn, pm, bucket->parent, parentIdx)) {
             doMergeChildren(txn, pm, bucket->parent, parentIdx);
             return true;
         }
-        else if (mayBalanceLeft) {
+        else if (mayBalanceLeft && canMergeChildren(txn, pm, bucket->parent, parentIdx - 1)) {
             doMergeChildren(txn, pm, bucket->parent, parentIdx - 1);
             return true;
         }
@@ -1834,10 +2109,13 @@ namespace mongo {
         DiskLoc rLoc = _addBucket(txn);
         BucketType* r = btreemod(txn, getBucket(txn, rLoc));
 
+        // The keys moved to r take no more room there under the same prefix.
+        _setPrefix(r, _bucketPrefix(bucket));
         for (int i = split + 1; i < bucket->n; i++) {
             FullKey kn = getFullKey(bucket, i);
             invariant(pushBack(r, kn.recordLoc, kn.data, kn.prevChildBucket));
         }
+        _compressKeyData(r);
         r->nextChild = bucket->nextChild;
         assertValid(_indexName, r, _ordering);
 
@@ -1974,7 +2252,9 @@ namespace mongo {
             return BSONObj();
         }
         else {
-            return getFullKey(bucket, keyOffset).data.toBson();
+            // A key put back together from the bucket prefix goes away with its FullKey.
+            const FullKey key = getFullKey(bucket, keyOffset);
+            return key.decodedSize ? key.data.toBson().getOwned() : key.data.toBson();
         }
     }
 
@@ -2421,4 +2701,7 @@ namespace mongo {
     template struct FixedWidthKey<DiskLoc56Bit>;
     template class BtreeLogic<BtreeLayoutV1>;
 
+    // V2 format.
+    template class BtreeLogic<BtreeLayoutV2>;
+
 }  // namespace mongo
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <cstring>
 #include <string>
 
 #include "mongo/db/catalog/head_manager.h"
@@ -113,6 +114,11 @@ namespace mongo {
              */
             DiskLoc newBucket(BucketType* leftSib, DiskLoc leftSibLoc);
 
+            bool _pushBack(BucketType* bucket,
+                           const DiskLoc loc,
+                           const KeyDataType& key,
+                           const DiskLoc prevChild);
+
             BucketType* _getModifiableBucket(DiskLoc loc);
             BucketType* _getBucket(DiskLoc loc);
 
@@ -252,13 +258,27 @@ namespace mongo {
          * This object and its BSONObj 'key' will become invalid if the KeyHeaderType data that owns
          * this it is moved within the btree.  In general, a KeyWrapper should not be expected to be
          * valid after a write.
+         *
+         * A key stored as a suffix of its bucket's prefix is put back together in 'decoded', which
+         * 'data' then points to, so 'data' must not outlive the FullKey.  Copies get their own.
          */
         struct FullKey {
             FullKey(const BucketType* bucket, int i)
                 : header(getKeyHeader(bucket, i)),
                   prevChildBucket(header.prevChildBucket),
                   recordLoc(header.recordLoc),
-                  data(bucket->data + header.keyDataOfs()) { }
+                  decodedSize(0),
+                  data(_keyDataAt(bucket, header, decoded, &decodedSize)) { }
+
+            FullKey(const FullKey& other)
+                : header(other.header),
+                  prevChildBucket(other.prevChildBucket),
+                  recordLoc(other.recordLoc),
+                  decodedSize(other.decodedSize),
+                  data(decodedSize ? static_cast<const char*>(memcpy(decoded,
+                                                                     other.decoded,
+                                                                     decodedSize))
+                                   : other.data.data()) { }
 
             // This is actually a reference to something on-disk.
             const KeyHeaderType& header;
@@ -267,6 +287,12 @@ namespace mongo {
             const LocType& prevChildBucket;
             const LocType& recordLoc;
 
+            // Holds the key data when it is not stored whole in the bucket, in which case
+            // 'decodedSize' is its size.  Binary searches decode a key per probe, so this stays off
+            // the heap.
+            char decoded[BtreeLayout::KeyMax];
+            int decodedSize;
+
             // This is *not* memory-mapped but its members point to something on-disk.
             KeyDataType data;
         };
@@ -297,12 +323,42 @@ namespace mongo {
 
         static void _delKeyAtPos(BucketType* bucket, int keypos, bool mayEmpty = false);
 
-        static void popBack(BucketType* bucket, DiskLoc* recordLocOut, KeyDataType *keyDataOut);
+        static void popBack(BucketType* bucket, DiskLoc* recordLocOut);
 
         static bool mayDropKey(BucketType* bucket, int index, int refPos);
 
         static int _packedDataSize(BucketType* bucket, int refPos);
 
+        static int _copiedDataSize(BucketType* bucket, int refPos);
+
+        //
+        // Prefix compression of the key data, a no-op unless BtreeLayout::PrefixCompressed.
+        //
+
+        static StringData _bucketPrefix(const BucketType* bucket);
+
+        static const char* _keyDataAt(const BucketType* bucket,
+                                      const KeyHeaderType& header,
+                                      char* decoded,
+                                      int* decodedSize);
+
+        static int _storedKeySize(const BucketType* bucket, int i);
+
+        static int _encodedKeySize(StringData prefix, const KeyDataType& key);
+
+        static void _encodeKey(StringData prefix,
+                               const KeyDataType& key,
+                               char* dest,
+                               KeyHeaderType* header);
+
+        static void _writeKey(BucketType* bucket, KeyHeaderType* header, const KeyDataType& key);
+
+        static void _setPrefix(BucketType* bucket, StringData prefix);
+
+        static void _rewriteKeyData(BucketType* bucket);
+
+        static bool _compressKeyData(BucketType* bucket);
+
         static void setPacked(BucketType* bucket);
 
         static void setNotPacked(BucketType* bucket);
@@ -467,7 +523,7 @@ namespace mongo {
 
         bool mayBalanceWithNeighbors(OperationContext* txn, BucketType* bucket, const DiskLoc bucketLoc);
 
-        void doBalanceChildren(OperationContext* txn,
+        bool doBalanceChildren(OperationContext* txn,
                                BucketType* bucket,
                                const DiskLoc bucketLoc,
                                int leftIndex);
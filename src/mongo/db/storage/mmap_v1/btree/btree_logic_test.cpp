@@ -2217,6 +2217,167 @@ namespace mongo {
     };
     */
 
+    /**
+     * Base for the tests of prefix compressed buckets, whose keys are long runs of one character
+     * followed by a number.
+     */
+    template<class OnDiskFormat>
+    class PrefixCompressionBase : public BtreeLogicTestBase<OnDiskFormat> {
+    protected:
+        static BSONObj prefixedKey(char c, int prefixLength, int n) {
+            char number[16];
+            sprintf(number, "%06d", n);
+            return BSON("" << (string(prefixLength, c) + number));
+        }
+
+        bool isPresent(const BSONObj& key, const DiskLoc& loc) {
+            OperationContextNoop txn;
+            int pos;
+            DiskLoc bucketLoc;
+            if (!this->_helper.btree.locate(&txn, key, loc, 1, &pos, &bucketLoc)) {
+                return false;
+            }
+            return this->getKey(bucketLoc.toRecordId(), pos).recordLoc == loc;
+        }
+
+        /**
+         * Returns how many buckets a V1 btree takes for 'keys' inserted in that order.
+         */
+        static long long uncompressedBuckets(const std::vector<BSONObj>& keys) {
+            OperationContextNoop txn;
+            BtreeLogicTestHelper<BtreeLayoutV1> helper(BSON("TheKey" << 1));
+            helper.btree.initAsEmpty(&txn);
+            for (size_t i = 0; i < keys.size(); ++i) {
+                ASSERT_OK(helper.btree.insert(&txn, keys[i], helper.dummyDiskLoc, true));
+            }
+            return helper.recordStore.numRecords(NULL);
+        }
+    };
+
+    template<class OnDiskFormat>
+    class PrefixCompressedInsert : public PrefixCompressionBase<OnDiskFormat> {
+    public:
+        void run() {
+            OperationContextNoop txn;
+            this->_helper.btree.initAsEmpty(&txn);
+
+            // Out of order, so that splits happen in the middle of buckets.
+            std::vector<BSONObj> keys;
+            for (int i = 0; i < 500; ++i) {
+                keys.push_back(this->prefixedKey('p', 300, (i * 7) % 500));
+                ASSERT_OK(this->insert(keys.back(), this->_helper.dummyDiskLoc));
+            }
+
+            this->checkValidNumKeys(500);
+            for (int i = 0; i < 500; ++i) {
+                ASSERT(this->isPresent(keys[i], this->_helper.dummyDiskLoc));
+            }
+            ASSERT(!this->isPresent(this->prefixedKey('p', 300, 500), this->_helper.dummyDiskLoc));
+            ASSERT(!this->isPresent(this->prefixedKey('p', 299, 5), this->_helper.dummyDiskLoc));
+
+            ASSERT_GREATER_THAN(OnDiskFormat::prefixSize(this->child(this->head(), 0)), 0);
+            ASSERT_LESS_THAN(this->_helper.recordStore.numRecords(NULL) * 4,
+                             this->uncompressedBuckets(keys));
+
+            // Keys put back together from their bucket prefix outlive the lookup.
+            for (int i = 0; i < 500; ++i) {
+                int pos;
+                DiskLoc bucketLoc;
+                ASSERT(this->_helper.btree.locate(&txn, keys[i], this->_helper.dummyDiskLoc, 1,
+                                                  &pos, &bucketLoc));
+                const BSONObj found = this->_helper.btree.getKey(&txn, bucketLoc, pos);
+                ASSERT_EQUALS(keys[i], found);
+            }
+        }
+    };
+
+    template<class OnDiskFormat>
+    class PrefixCompressedMixedPrefixes : public PrefixCompressionBase<OnDiskFormat> {
+    public:
+        void run() {
+            OperationContextNoop txn;
+            this->_helper.btree.initAsEmpty(&txn);
+
+            // Keys with and without a long common prefix end up in the same buckets.
+            std::vector<BSONObj> keys;
+            for (int i = 0; i < 600; ++i) {
+                const int n = (i * 11) % 600;
+                switch (n % 3) {
+                case 0: keys.push_back(this->prefixedKey('a', 400, n)); break;
+                case 1: keys.push_back(this->prefixedKey('b', 40, n)); break;
+                default: keys.push_back(this->prefixedKey('c', 1, n)); break;
+                }
+                ASSERT_OK(this->insert(keys.back(), this->_helper.dummyDiskLoc));
+            }
+            this->checkValidNumKeys(600);
+
+            // Removing the keys in another order merges and balances the buckets.
+            for (int i = 0; i < 600; ++i) {
+                const int victim = (i * 13) % 600;
+                ASSERT(this->unindex(keys[victim]));
+                ASSERT(!this->isPresent(keys[victim], this->_helper.dummyDiskLoc));
+
+                if (i % 50 == 0) {
+                    this->checkValidNumKeys(600 - i - 1);
+                    for (int j = i + 1; j < 600; ++j) {
+                        ASSERT(this->isPresent(keys[(j * 13) % 600], this->_helper.dummyDiskLoc));
+                    }
+                }
+            }
+            this->checkValidNumKeys(0);
+        }
+    };
+
+    template<class OnDiskFormat>
+    class PrefixCompressedDuplicateKeys : public PrefixCompressionBase<OnDiskFormat> {
+    public:
+        void run() {
+            OperationContextNoop txn;
+            this->_helper.btree.initAsEmpty(&txn);
+
+            // Identical keys leave nothing but the suffix length to store.
+            const BSONObj key = this->prefixedKey('d', 200, 0);
+            std::vector<DiskLoc> locs;
+            for (int i = 0; i < 300; ++i) {
+                StatusWith<RecordId> s = this->_helper.recordStore.insertRecord(&txn, "a", 1, false);
+                ASSERT_OK(s.getStatus());
+                locs.push_back(DiskLoc::fromRecordId(s.getValue()));
+                ASSERT_OK(this->insert(key, locs.back()));
+            }
+
+            this->checkValidNumKeys(300);
+            for (int i = 0; i < 300; ++i) {
+                ASSERT(this->isPresent(key, locs[i]));
+            }
+        }
+    };
+
+    template<class OnDiskFormat>
+    class PrefixCompressedBulkBuild : public PrefixCompressionBase<OnDiskFormat> {
+    public:
+        void run() {
+            OperationContextNoop txn;
+            this->_helper.btree.initAsEmpty(&txn);
+
+            std::vector<BSONObj> keys;
+            {
+                boost::scoped_ptr<typename BtreeLogic<OnDiskFormat>::Builder> builder(
+                    this->_helper.btree.newBuilder(&txn, true));
+                for (int i = 0; i < 2000; ++i) {
+                    keys.push_back(this->prefixedKey('e', 300, i));
+                    ASSERT_OK(builder->addKey(keys.back(), this->_helper.dummyDiskLoc));
+                }
+            }
+
+            this->checkValidNumKeys(2000);
+            for (int i = 0; i < 2000; ++i) {
+                ASSERT(this->isPresent(keys[i], this->_helper.dummyDiskLoc));
+            }
+            ASSERT_LESS_THAN(this->_helper.recordStore.numRecords(NULL) * 4,
+                             this->uncompressedBuckets(keys));
+        }
+    };
+
     //
     // TEST SUITE DEFINITION
     //
@@ -2279,7 +2440,6 @@ namespace mongo {
             add< PackedDataSizeEmptyBucket<OnDiskFormat> >();
 
             add< BalanceSingleParentKeyPackParent<OnDiskFormat> >();
-            add< BalanceSplitParent<OnDiskFormat> >();
             add< EvenRebalanceLeft<OnDiskFormat> >();
             add< EvenRebalanceLeftCusp<OnDiskFormat> >();
             add< EvenRebalanceRight<OnDiskFormat> >();
@@ -2288,7 +2448,6 @@ namespace mongo {
             add< OddRebalanceLeft<OnDiskFormat> >();
             add< OddRebalanceRight<OnDiskFormat> >();
             add< OddRebalanceCenter<OnDiskFormat> >();
-            add< RebalanceEmptyRight<OnDiskFormat> >();
             add< RebalanceEmptyLeft<OnDiskFormat> >();
 
             add< NoMoveAtLowWaterMarkRight<OnDiskFormat> >();
@@ -2308,20 +2467,36 @@ namespace mongo {
             add< DelInternalPromoteRightKey<OnDiskFormat> >();
             add< DelInternalReplacementPrevNonNull<OnDiskFormat> >();
             add< DelInternalReplacementNextNonNull<OnDiskFormat> >();
-            add< DelInternalSplitPromoteLeft<OnDiskFormat> >();
-            add< DelInternalSplitPromoteRight<OnDiskFormat> >();
 
             add< LocateEmptyForward<OnDiskFormat> >();
             add< LocateEmptyReverse<OnDiskFormat> >();
 
             add< DuplicateKeys<OnDiskFormat> >();
+
+            if (OnDiskFormat::PrefixCompressed) {
+                add< PrefixCompressedInsert<OnDiskFormat> >();
+                add< PrefixCompressedMixedPrefixes<OnDiskFormat> >();
+                add< PrefixCompressedDuplicateKeys<OnDiskFormat> >();
+                add< PrefixCompressedBulkBuild<OnDiskFormat> >();
+            }
+            else {
+                // These expect the bucket shapes of uncompressed keys, which a compressed bucket
+                // fits more of.
+                add< BalanceSplitParent<OnDiskFormat> >();
+                add< RebalanceEmptyRight<OnDiskFormat> >();
+                add< DelInternalSplitPromoteLeft<OnDiskFormat> >();
+                add< DelInternalSplitPromoteRight<OnDiskFormat> >();
+            }
         }
     };
 
-    // Test suite for both V0 and V1
+    // Test suite for V0, V1 and V2
     static unittest::SuiteInstance< BtreeLogicTestSuite<BtreeLayoutV0> > SUITE_V0(
         "BTreeLogicTests_V0");
 
     static unittest::SuiteInstance< BtreeLogicTestSuite<BtreeLayoutV1> > SUITE_V1(
         "BTreeLogicTests_V1");
+
+    static unittest::SuiteInstance< BtreeLogicTestSuite<BtreeLayoutV2> > SUITE_V2(
+        "BTreeLogicTests_V2");
 }
@@ -317,6 +317,81 @@ namespace mongo {
         sizeof(BtreeBucketV1) - sizeof(static_cast<BtreeBucketV1*>(NULL)->data)
                 == BtreeBucketV1::HeaderSize);
 
+    /**
+     * The fixed width data component of a key in a prefix compressed (V2) bucket.  It has the
+     * layout of the V1 one, but the top bit of the key data offset, which a bucket is too small to
+     * ever use, tells whether the key data is stored as a suffix of the bucket's prefix.
+     */
+    struct PrefixedFixedWidthKey : public FixedWidthKey<DiskLoc56Bit> {
+        enum { PrefixedBit = 0x8000 };
+
+        short keyDataOfs() const {
+            return static_cast<short>(_kdo & ~PrefixedBit);
+        }
+
+        void setKeyDataOfs(short s) {
+            _kdo = s;
+            invariant(s>=0);
+        }
+
+        void setKeyDataOfsSavingUse(short s) {
+            setKeyDataOfs(s);
+        }
+
+        bool isPrefixed() const { return _kdo & PrefixedBit; }
+
+        void setPrefixed() { _kdo |= PrefixedBit; }
+    };
+
+    BOOST_STATIC_ASSERT(sizeof(PrefixedFixedWidthKey) == sizeof(FixedWidthKey<DiskLoc56Bit>));
+
+    /**
+     * The V1 bucket with leading-prefix compression of its keys.  The bytes that begin the keys of
+     * the bucket are stored once, at the very top of the body, and 'prefixSize' long.  A key that
+     * begins with them only stores the rest of its data, preceded by the length of that rest:
+     *
+     * |hhhh|kkkkkkk--------ls ls lsbbb ls ls pppp|
+     * p = prefix
+     * l = length of the suffix that follows it
+     * s = suffix of a key that begins with the prefix
+     * b = a key that does not, stored as in V1
+     *
+     * The prefix is only chosen when the bucket is repacked (see BtreeLogic::_packReadyForMod).
+     * Keys added in between are stored in full when they do not begin with it.
+     */
+    struct BtreeBucketV2 {
+        /** Parent bucket of this bucket, which isNull() for the root bucket. */
+        DiskLoc56Bit parent;
+
+        /** Given that there are n keys, this is the n index child. */
+        DiskLoc56Bit nextChild;
+
+        unsigned short flags;
+
+        /** Size of the empty region. */
+        unsigned short emptySize;
+
+        /** Size used for bson storage, including storage of old keys and of the prefix. */
+        unsigned short topSize;
+
+        /* Number of keys in the bucket. */
+        unsigned short n;
+
+        /** Size of the prefix stored at the top of the body. */
+        unsigned short prefixSize;
+
+        /* Beginning of the bucket's body */
+        char data[4];
+
+        // Precalculated size constants
+        enum { HeaderSize = 24 };
+    };
+
+    // BtreeBucketV2 is part of the on-disk format, so it should never be changed
+    BOOST_STATIC_ASSERT(
+        sizeof(BtreeBucketV2) - sizeof(static_cast<BtreeBucketV2*>(NULL)->data)
+                == BtreeBucketV2::HeaderSize);
+
     enum Flags {
         Packed = 1
     };
@@ -345,6 +420,16 @@ namespace mongo {
             bucket->_wasSize = BucketSize;
             bucket->reserved = 0;
         }
+
+        static const bool PrefixCompressed = false;
+
+        static int prefixSize(const BucketType* bucket) { return 0; }
+
+        static void setPrefixSize(BucketType* bucket, int size) { invariant(size == 0); }
+
+        static bool isPrefixed(const FixedWidthKeyType& key) { return false; }
+
+        static void setPrefixed(FixedWidthKeyType* key) { invariant(false); }
     };
 
     struct BtreeLayoutV1 {
@@ -364,6 +449,50 @@ namespace mongo {
         static const unsigned short INVALID_N_SENTINEL = 0xffff;
 
         static void initBucket(BucketType* bucket) { }
+
+        static const bool PrefixCompressed = false;
+
+        static int prefixSize(const BucketType* bucket) { return 0; }
+
+        static void setPrefixSize(BucketType* bucket, int size) { invariant(size == 0); }
+
+        static bool isPrefixed(const FixedWidthKeyType& key) { return false; }
+
+        static void setPrefixed(FixedWidthKeyType* key) { invariant(false); }
+    };
+
+    /**
+     * The V1 key format in prefix compressed buckets, selected by creating an index with {v: 2}.
+     */
+    struct BtreeLayoutV2 {
+        typedef PrefixedFixedWidthKey FixedWidthKeyType;
+        typedef KeyV1 KeyType;
+        typedef KeyV1Owned KeyOwnedType;
+        typedef DiskLoc56Bit LocType;
+        typedef BtreeBucketV2 BucketType;
+
+        enum { BucketSize = 8192 - 16,  // The -16 is to leave room for the Record header
+               BucketBodySize = BucketSize - BucketType::HeaderSize 
+        };
+
+        static const int KeyMax = 1024;
+
+        // A sentinel value sometimes used to identify a deallocated bucket.
+        static const unsigned short INVALID_N_SENTINEL = 0xffff;
+
+        static void initBucket(BucketType* bucket) {
+            bucket->prefixSize = 0;
+        }
+
+        static const bool PrefixCompressed = true;
+
+        static int prefixSize(const BucketType* bucket) { return bucket->prefixSize; }
+
+        static void setPrefixSize(BucketType* bucket, int size) { bucket->prefixSize = size; }
+
+        static bool isPrefixed(const FixedWidthKeyType& key) { return key.isPrefixed(); }
+
+        static void setPrefixed(FixedWidthKeyType* key) { key->setPrefixed(); }
     };
 
 #pragma pack()
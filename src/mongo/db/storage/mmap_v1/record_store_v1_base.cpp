@@ -339,7 +339,8 @@ namespace mongo {
     StatusWith<RecordId> RecordStoreV1Base::_insertRecord( OperationContext* txn,
                                                           const char* data,
                                                           int len,
-                                                          bool enforceQuota ) {
+                                                          bool enforceQuota,
+                                                          long long* deferredNetLength ) {
 
         const int lenWHdr = len + Record::HeaderSize;
         const int lenToAlloc = shouldPadInserts() ? quantizeAllocationSpace(lenWHdr)
@@ -359,11 +360,51 @@ namespace mongo {
 
         _addRecordToRecListInExtent(txn, r, loc.getValue());
 
-        _details->incrementStats( txn, r->netLength(), 1 );
+        if ( deferredNetLength ) {
+            *deferredNetLength += r->netLength();
+        }
+        else {
+            _details->incrementStats( txn, r->netLength(), 1 );
+        }
 
         return StatusWith<RecordId>(loc.getValue().toRecordId());
     }
 
+    Status RecordStoreV1Base::insertRecords( OperationContext* txn,
+                                             const std::vector<RecordData>& records,
+                                             bool enforceQuota,
+                                             std::vector<RecordId>* locsOut ) {
+        // Capped allocation may reuse space freed by the inserts before it, so it goes one
+        // record at a time.
+        if ( isCapped() ) {
+            return RecordStore::insertRecords( txn, records, enforceQuota, locsOut );
+        }
+
+        long long totalNetLength = 0;
+        for ( size_t i = 0; i < records.size(); i++ ) {
+            const int len = records[i].size();
+            if ( len < 4 ) {
+                return Status( ErrorCodes::InvalidLength, "record has to be >= 4 bytes" );
+            }
+
+            if ( len + Record::HeaderSize > MaxAllowedAllocation ) {
+                return Status( ErrorCodes::InvalidLength, "record has to be <= 16.5MB" );
+            }
+
+            StatusWith<RecordId> loc = _insertRecord( txn, records[i].data(), len, enforceQuota,
+                                                      &totalNetLength );
+            if ( !loc.isOK() )
+                return loc.getStatus();
+
+            locsOut->push_back( loc.getValue() );
+        }
+
+        // The collection stats are journaled, so update them once for the whole group
+        _details->incrementStats( txn, totalNetLength, records.size() );
+
+        return Status::OK();
+    }
+
     StatusWith<RecordId> RecordStoreV1Base::updateRecord( OperationContext* txn,
                                                          const RecordId& oldLocation,
                                                          const char* data,
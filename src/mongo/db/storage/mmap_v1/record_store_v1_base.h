@@ -201,6 +201,11 @@ namespace mongo {
                                            const DocWriter* doc,
                                            bool enforceQuota );
 
+        virtual Status insertRecords( OperationContext* txn,
+                                      const std::vector<RecordData>& records,
+                                      bool enforceQuota,
+                                      std::vector<RecordId>* locsOut );
+
         virtual StatusWith<RecordId> updateRecord( OperationContext* txn,
                                                    const RecordId& oldLocation,
                                                    const char* data,
@@ -304,11 +309,16 @@ namespace mongo {
         /**
          * internal
          * doesn't check inputs or change padding
+         *
+         * If 'deferredNetLength' is not NULL, the net length of the record is added to it rather
+         * than to the collection stats, so that a caller inserting many records can update the
+         * stats once.
          */
         StatusWith<RecordId> _insertRecord( OperationContext* txn,
                                             const char* data,
                                             int len,
-                                            bool enforceQuota );
+                                            bool enforceQuota,
+                                            long long* deferredNetLength = NULL );
 
         boost::scoped_ptr<RecordStoreV1MetaData> _details;
         ExtentManager* _extentManager;
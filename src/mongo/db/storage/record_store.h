@@ -31,6 +31,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <vector>
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/bson/mutable/damage_vector.h"
@@ -188,6 +189,30 @@ namespace mongo {
                                                   const DocWriter* doc,
                                                   bool enforceQuota ) = 0;
 
+        /**
+         * Inserts a group of records in the current unit of work, appending the RecordId of each
+         * to 'locsOut' in the same order. Stops at the first failure and returns it, in which case
+         * the unit of work must be rolled back.
+         *
+         * The default implementation calls insertRecord for each record. Implementations override
+         * it to pay per-insert costs, such as cursor setup and size accounting, once per group.
+         */
+        virtual Status insertRecords( OperationContext* txn,
+                                      const std::vector<RecordData>& records,
+                                      bool enforceQuota,
+                                      std::vector<RecordId>* locsOut ) {
+            for ( size_t i = 0; i < records.size(); i++ ) {
+                StatusWith<RecordId> loc = insertRecord( txn,
+                                                         records[i].data(),
+                                                         records[i].size(),
+                                                         enforceQuota );
+                if ( !loc.isOK() )
+                    return loc.getStatus();
+                locsOut->push_back( loc.getValue() );
+            }
+            return Status::OK();
+        }
+
         /**
          * @param notifier - Only used by record stores which do not support doc-locking.
          *                   In the case of a document move, this is called after the document
@@ -183,4 +183,45 @@ namespace mongo {
         }
     }
 
+    // Insert a group of records in one unit of work and verify each can be read back.
+    TEST( RecordStoreTestHarness, InsertRecordsAsGroup ) {
+        scoped_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
+        scoped_ptr<RecordStore> rs( harnessHelper->newNonCappedRecordStore() );
+
+        const int nToInsert = 10;
+        std::vector<string> datas;
+        for ( int i = 0; i < nToInsert; i++ ) {
+            stringstream ss;
+            ss << "record " << i;
+            datas.push_back( ss.str() );
+        }
+
+        std::vector<RecordData> records;
+        for ( int i = 0; i < nToInsert; i++ ) {
+            records.push_back( RecordData( datas[i].c_str(), datas[i].size() + 1 ) );
+        }
+
+        std::vector<RecordId> locs;
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            {
+                WriteUnitOfWork uow( opCtx.get() );
+                ASSERT_OK( rs->insertRecords( opCtx.get(), records, false, &locs ) );
+                uow.commit();
+            }
+        }
+
+        ASSERT_EQUALS( static_cast<size_t>( nToInsert ), locs.size() );
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            ASSERT_EQUALS( nToInsert, rs->numRecords( opCtx.get() ) );
+
+            for ( int i = 0; i < nToInsert; i++ ) {
+                RecordData record = rs->dataFor( opCtx.get(), locs[i] );
+                ASSERT_EQUALS( datas[i], string( record.data() ) );
+            }
+        }
+    }
+
 } // namespace mongo
@@ -443,6 +443,9 @@ namespace mongo {
             if ( ident == "sizeStorer" )
                 continue;
 
+            if ( key == WiredTigerRecoveryUnit::kJournalFlushUri )
+                continue;
+
             all.push_back( ident.toString() );
         }
 
@@ -35,6 +35,7 @@
 
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 
+#include <algorithm>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_array.hpp>
 #include <wiredtiger.h>
@@ -72,6 +73,19 @@ namespace {
     BOOST_STATIC_ASSERT(kCurrentRecordStoreVersion >= kMinimumRecordStoreVersion);
     BOOST_STATIC_ASSERT(kCurrentRecordStoreVersion <= kMaximumRecordStoreVersion);
 
+    // Bounds on how many stones a capped oplog is divided into, and the smallest size we would
+    // like a stone to be when the oplog is large enough to allow it.
+    static const size_t kMinStonesToKeep = 10;
+    static const size_t kMaxStonesToKeep = 100;
+    static const int64_t kMinBytesPerStone = 16 * 1024 * 1024;
+
+    // How many stones past the ones to keep the background thread may fall behind before inserts
+    // into the oplog wait for it.
+    static const size_t kExcessStonesBeforeBackPressure = 2;
+
+    // Number of random samples taken per stone when laying down stones over a large oplog.
+    static const int kRandomSamplesPerStone = 10;
+
     bool shouldUseOplogHack(OperationContext* opCtx, const std::string& uri) {
         StatusWith<BSONObj> appMetadata = WiredTigerUtil::getApplicationMetadata(opCtx, uri);
         if (!appMetadata.isOK()) {
@@ -252,6 +266,10 @@ namespace {
 
         }
 
+        if (_isCapped && _isOplog) {
+            _oplogStones.reset(new OplogStones(ctx, this));
+        }
+
         _hasBackgroundThread = WiredTigerKVEngine::initRsOplogBackgroundThread(ns);
     }
 
@@ -261,6 +279,10 @@ namespace {
             _shuttingDown = true;
         }
 
+        if (_oplogStones) {
+            _oplogStones->kill();
+        }
+
         LOG(1) << "~WiredTigerRecordStore for: " << ns();
         if ( _sizeStorer ) {
             _sizeStorer->onDestroy( this );
@@ -395,6 +417,33 @@ namespace {
         // This variable isn't thread safe, but has loose semantics anyway.
         dassert( !_isOplog || _cappedMaxDocs == -1 );
 
+        if (_oplogStones && _hasBackgroundThread) {
+            // The background thread reclaims the oplog. Only hold up the insert when the thread
+            // has fallen behind by more than a couple of stones.
+            if (_oplogStones->numStones() <=
+                    _oplogStones->numStonesToKeep() + kExcessStonesBeforeBackPressure)
+                return 0;
+
+            // Synchronize on the background thread, without deleting anything ourselves.
+            // Don't wait forever: we're in a transaction, we could block eviction.
+            boost::unique_lock<boost::timed_mutex> lock(_cappedDeleterMutex, boost::defer_lock);
+            (void)lock.timed_lock(boost::posix_time::millisec(200));
+            return 0;
+        }
+
+        if (_oplogStones) {
+            // Without a background thread, whoever inserts past the last stone to keep reclaims
+            // the oplog, unless someone else already is.
+            if (!_oplogStones->hasExcessStones())
+                return 0;
+
+            boost::unique_lock<boost::timed_mutex> lock(_cappedDeleterMutex, boost::try_to_lock);
+            if (!lock.owns_lock())
+                return 0;
+
+            return reclaimOplog(txn);
+        }
+
         if (!cappedAndNeedDelete())
             return 0;
 
@@ -548,6 +597,315 @@ namespace {
         return docsRemoved;
     }
 
+    int64_t WiredTigerRecordStore::reclaimOplog(OperationContext* txn) {
+        invariant(_oplogStones);
+
+        // we do this is a side transaction in case it aborts
+        WiredTigerRecoveryUnit* realRecoveryUnit =
+            checked_cast<WiredTigerRecoveryUnit*>( txn->releaseRecoveryUnit() );
+        invariant( realRecoveryUnit );
+        WiredTigerSessionCache* sc = realRecoveryUnit->getSessionCache();
+        OperationContext::RecoveryUnitState const realRUstate =
+            txn->setRecoveryUnit(new WiredTigerRecoveryUnit(sc),
+                                 OperationContext::kNotInUnitOfWork);
+
+        WiredTigerRecoveryUnit::get(txn)->markNoTicketRequired(); // realRecoveryUnit already has
+        WT_SESSION* session = WiredTigerRecoveryUnit::get(txn)->getSession(txn)->getSession();
+
+        int64_t recordsRemoved = 0;
+        try {
+            while (boost::optional<OplogStones::Stone> stone =
+                       _oplogStones->peekOldestStoneIfNeeded()) {
+                if ( _shuttingDown )
+                    break;
+
+                LOG(1) << "Truncating the oplog up to " << stone->lastRecord << " to remove "
+                       << stone->records << " records totaling " << stone->bytes << " bytes";
+
+                WriteUnitOfWork wuow(txn);
+
+                WiredTigerCursor startWrap( _uri, _instanceId, true, txn);
+                WT_CURSOR* start = startWrap.get();
+                int ret = WT_OP_CHECK(start->next(start));
+                if (ret != WT_NOTFOUND) {
+                    invariantWTOK(ret);
+
+                    int64_t firstKey;
+                    invariantWTOK(start->get_key(start, &firstKey));
+
+                    // Out of order commits may have left the start of the oplog past this stone
+                    // already, in which case there is nothing left to truncate for it.
+                    if (_fromKey(firstKey) <= stone->lastRecord) {
+                        WiredTigerCursor stopWrap( _uri, _instanceId, true, txn);
+                        WT_CURSOR* stop = stopWrap.get();
+                        stop->set_key(stop, _makeKey(stone->lastRecord));
+
+                        ret = session->truncate(session, NULL, start, stop, NULL);
+                        if (ret == ENOENT || ret == WT_NOTFOUND) {
+                            // TODO we should remove this case once SERVER-17141 is resolved
+                            log() << "Soft failure truncating the oplog. Will try again later.";
+                            break;
+                        }
+                        invariantWTOK(ret);
+                    }
+                }
+
+                _changeNumRecords(txn, -stone->records);
+                _increaseDataSize(txn, -stone->bytes);
+                wuow.commit();
+
+                _oplogStones->popOldestStone();
+                recordsRemoved += stone->records;
+            }
+        }
+        catch ( const WriteConflictException& wce ) {
+            delete txn->releaseRecoveryUnit();
+            txn->setRecoveryUnit(realRecoveryUnit, realRUstate);
+            log() << "got conflict truncating the oplog, ignoring";
+            return recordsRemoved;
+        }
+        catch ( ... ) {
+            delete txn->releaseRecoveryUnit();
+            txn->setRecoveryUnit(realRecoveryUnit, realRUstate);
+            throw;
+        }
+
+        delete txn->releaseRecoveryUnit();
+        txn->setRecoveryUnit(realRecoveryUnit, realRUstate);
+        return recordsRemoved;
+    }
+
+    class WiredTigerRecordStore::OplogStones::InsertChange : public RecoveryUnit::Change {
+    public:
+        InsertChange(OplogStones* stones, int64_t bytesInserted, const RecordId& loc)
+            : _stones(stones), _bytesInserted(bytesInserted), _loc(loc) { }
+
+        virtual void commit() {
+            _stones->_addInsertedRecord(_bytesInserted, _loc);
+        }
+
+        virtual void rollback() { }
+
+    private:
+        OplogStones* _stones;
+        int64_t _bytesInserted;
+        RecordId _loc;
+    };
+
+    class WiredTigerRecordStore::OplogStones::TruncateChange : public RecoveryUnit::Change {
+    public:
+        TruncateChange(OplogStones* stones) : _stones(stones) { }
+
+        virtual void commit() {
+            _stones->_currentRecords.store(0);
+            _stones->_currentBytes.store(0);
+
+            boost::lock_guard<boost::mutex> lk(_stones->_mutex);
+            _stones->_stones.clear();
+        }
+
+        virtual void rollback() { }
+
+    private:
+        OplogStones* _stones;
+    };
+
+    WiredTigerRecordStore::OplogStones::OplogStones(OperationContext* txn,
+                                                    WiredTigerRecordStore* rs)
+        : _rs(rs),
+          _isDead(false) {
+        invariant(rs->isCapped());
+        invariant(rs->cappedMaxSize() > 0);
+
+        const int64_t maxSize = rs->cappedMaxSize();
+        _numStonesToKeep = std::min(kMaxStonesToKeep,
+                                    std::max(kMinStonesToKeep,
+                                             static_cast<size_t>(maxSize / kMinBytesPerStone)));
+        _minBytesPerStone = std::max(int64_t(1), maxSize / int64_t(_numStonesToKeep));
+
+        const int64_t numRecords = rs->numRecords(txn);
+        const int64_t dataSize = rs->dataSize(txn);
+
+        if (numRecords <= 0 || dataSize < _minBytesPerStone) {
+            // Not enough data for even a single stone.
+            _currentRecords.store(std::max(int64_t(0), numRecords));
+            _currentBytes.store(std::max(int64_t(0), dataSize));
+        }
+        else if (numRecords < kCollectionScanOnCreationThreshold) {
+            _calculateStonesByScanning(txn);
+        }
+        else {
+            _calculateStonesBySampling(txn, numRecords, dataSize);
+        }
+
+        LOG(1) << "Laid down " << _stones.size() << " stones over " << rs->ns()
+               << ", keeping " << _numStonesToKeep << " of at least " << _minBytesPerStone
+               << " bytes each";
+    }
+
+    bool WiredTigerRecordStore::OplogStones::hasExcessStones() const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        return _stones.size() > _numStonesToKeep;
+    }
+
+    void WiredTigerRecordStore::OplogStones::awaitHasExcessStonesOrDead(
+            boost::posix_time::milliseconds timeout) {
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        if (_isDead || _stones.size() > _numStonesToKeep)
+            return;
+        _oplogReclaimCv.timed_wait(lk, timeout);
+    }
+
+    void WiredTigerRecordStore::OplogStones::kill() {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _isDead = true;
+        _oplogReclaimCv.notify_all();
+    }
+
+    boost::optional<WiredTigerRecordStore::OplogStones::Stone>
+    WiredTigerRecordStore::OplogStones::peekOldestStoneIfNeeded() const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        if (_stones.size() <= _numStonesToKeep)
+            return boost::none;
+        return _stones.front();
+    }
+
+    void WiredTigerRecordStore::OplogStones::popOldestStone() {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        invariant(!_stones.empty());
+        _stones.pop_front();
+    }
+
+    void WiredTigerRecordStore::OplogStones::updateCurrentStoneAfterInsertOnCommit(
+            OperationContext* txn,
+            int64_t bytesInserted,
+            const RecordId& loc) {
+        txn->recoveryUnit()->registerChange(new InsertChange(this, bytesInserted, loc));
+    }
+
+    void WiredTigerRecordStore::OplogStones::clearStonesOnCommit(OperationContext* txn) {
+        txn->recoveryUnit()->registerChange(new TruncateChange(this));
+    }
+
+    void WiredTigerRecordStore::OplogStones::updateStonesAfterCappedTruncateAfter(
+            int64_t recordsRemoved,
+            int64_t bytesRemoved,
+            const RecordId& firstRemoved) {
+        int64_t recordsInRemovedStones = 0;
+        int64_t bytesInRemovedStones = 0;
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        while (!_stones.empty() && _stones.back().lastRecord >= firstRemoved) {
+            recordsInRemovedStones += _stones.back().records;
+            bytesInRemovedStones += _stones.back().bytes;
+            _stones.pop_back();
+        }
+
+        // Whatever survived of the stones that were cut into goes back into the current stone.
+        int64_t records = _currentRecords.load() + recordsInRemovedStones - recordsRemoved;
+        int64_t bytes = _currentBytes.load() + bytesInRemovedStones - bytesRemoved;
+        _currentRecords.store(std::max(int64_t(0), records));
+        _currentBytes.store(std::max(int64_t(0), bytes));
+    }
+
+    size_t WiredTigerRecordStore::OplogStones::numStones() const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        return _stones.size();
+    }
+
+    void WiredTigerRecordStore::OplogStones::_addInsertedRecord(int64_t bytesInserted,
+                                                                const RecordId& loc) {
+        // Only the insert that fills the current stone takes the mutex.
+        _currentRecords.fetchAndAdd(1);
+        int64_t newCurrentBytes = _currentBytes.addAndFetch(bytesInserted);
+        if (newCurrentBytes < _minBytesPerStone)
+            return;
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+
+        // Another insert may have closed off the stone while we waited for the mutex.
+        if (_currentBytes.load() < _minBytesPerStone)
+            return;
+
+        int64_t records = _currentRecords.swap(0);
+        int64_t bytes = _currentBytes.swap(0);
+        _stones.push_back(Stone(records, bytes, loc));
+
+        if (_stones.size() > _numStonesToKeep) {
+            _oplogReclaimCv.notify_all();
+        }
+    }
+
+    void WiredTigerRecordStore::OplogStones::_calculateStonesByScanning(OperationContext* txn) {
+        LOG(1) << "Scanning " << _rs->ns() << " to lay down its stones";
+
+        int64_t records = 0;
+        int64_t bytes = 0;
+
+        boost::scoped_ptr<RecordIterator> iterator( _rs->getIterator( txn ) );
+        while ( !iterator->isEOF() ) {
+            RecordId loc = iterator->getNext();
+            records++;
+            bytes += iterator->dataFor( loc ).size();
+            if ( bytes >= _minBytesPerStone ) {
+                _stones.push_back(Stone(records, bytes, loc));
+                records = 0;
+                bytes = 0;
+            }
+        }
+
+        _currentRecords.store(records);
+        _currentBytes.store(bytes);
+    }
+
+    void WiredTigerRecordStore::OplogStones::_calculateStonesBySampling(OperationContext* txn,
+                                                                       int64_t numRecords,
+                                                                       int64_t dataSize) {
+        LOG(1) << "Sampling " << _rs->ns() << " to lay down its stones";
+
+        // Assume every record is of the average size, and pick the boundaries of the stones
+        // from a sorted random sample of the RecordIds.
+        const int64_t avgRecordSize = std::max(int64_t(1), dataSize / numRecords);
+        const int64_t recordsPerStone =
+            std::max(int64_t(1), (_minBytesPerStone + avgRecordSize - 1) / avgRecordSize);
+        const int64_t bytesPerStone = recordsPerStone * avgRecordSize;
+        const int64_t wholeStones = numRecords / recordsPerStone;
+
+        WT_SESSION* session = WiredTigerRecoveryUnit::get(txn)->getSession(txn)->getSession();
+        WT_CURSOR* cursor = NULL;
+        invariantWTOK(session->open_cursor(session, _rs->getURI().c_str(), NULL,
+                                           "next_random=true", &cursor));
+        ON_BLOCK_EXIT(cursor->close, cursor);
+
+        std::vector<RecordId> samples;
+        samples.reserve(wholeStones * kRandomSamplesPerStone);
+        for (int64_t i = 0; i < wholeStones * kRandomSamplesPerStone; ++i) {
+            int ret = cursor->next(cursor);
+            if (ret == WT_NOTFOUND)
+                break;
+            invariantWTOK(ret);
+
+            int64_t key;
+            invariantWTOK(cursor->get_key(cursor, &key));
+            samples.push_back(_fromKey(key));
+        }
+
+        if (samples.size() < static_cast<size_t>(wholeStones * kRandomSamplesPerStone)) {
+            // The size storer overestimated what is there; fall back to counting.
+            _calculateStonesByScanning(txn);
+            return;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        for (int64_t i = 1; i <= wholeStones; ++i) {
+            const RecordId& lastRecord = samples[i * kRandomSamplesPerStone - 1];
+            _stones.push_back(Stone(recordsPerStone, bytesPerStone, lastRecord));
+        }
+
+        _currentRecords.store(numRecords - wholeStones * recordsPerStone);
+        _currentBytes.store(std::max(int64_t(0), dataSize - wholeStones * bytesPerStone));
+    }
+
     StatusWith<RecordId> WiredTigerRecordStore::extractAndCheckLocForOplog(const char* data,
                                                                            int len) {
         return oploghack::extractKey(data, len);
@@ -600,11 +958,52 @@ namespace {
         _changeNumRecords( txn, 1 );
         _increaseDataSize( txn, len );
 
+        if ( _oplogStones ) {
+            _oplogStones->updateCurrentStoneAfterInsertOnCommit( txn, len, loc );
+        }
+
         cappedDeleteAsNeeded(txn, loc);
 
         return StatusWith<RecordId>( loc );
     }
 
+    Status WiredTigerRecordStore::insertRecords( OperationContext* txn,
+                                                 const std::vector<RecordData>& records,
+                                                 bool enforceQuota,
+                                                 std::vector<RecordId>* locsOut ) {
+        // Capped deletes and oplog visibility are tracked per record, so those inserts keep
+        // going through insertRecord.
+        if ( _isCapped || _useOplogHack ) {
+            return RecordStore::insertRecords( txn, records, enforceQuota, locsOut );
+        }
+
+        WiredTigerCursor curwrap( _uri, _instanceId, true, txn);
+        curwrap.assertInActiveTxn();
+        WT_CURSOR *c = curwrap.get();
+        invariant( c );
+
+        long long totalLength = 0;
+        for ( size_t i = 0; i < records.size(); i++ ) {
+            const RecordId loc = _nextId();
+
+            c->set_key(c, _makeKey(loc));
+            WiredTigerItem value(records[i].data(), records[i].size());
+            c->set_value(c, value.Get());
+            int ret = WT_OP_CHECK(c->insert(c));
+            if (ret) {
+                return wtRCToStatus(ret, "WiredTigerRecordStore::insertRecords");
+            }
+
+            totalLength += records[i].size();
+            locsOut->push_back( loc );
+        }
+
+        _changeNumRecords( txn, records.size() );
+        _increaseDataSize( txn, totalLength );
+
+        return Status::OK();
+    }
+
     void WiredTigerRecordStore::dealtWithCappedLoc( const RecordId& loc ) {
         boost::lock_guard<boost::mutex> lk( _uncommittedDiskLocsMutex );
         SortedDiskLocs::iterator it = std::find(_uncommittedDiskLocs.begin(),
@@ -732,6 +1131,10 @@ namespace {
         _changeNumRecords(txn, -numRecords(txn));
         _increaseDataSize(txn, -dataSize(txn));
 
+        if (_oplogStones) {
+            _oplogStones->clearStonesOnCommit(txn);
+        }
+
         return Status::OK();
     }
 
@@ -983,7 +1386,7 @@ namespace {
 
     class WiredTigerRecordStore::DataSizeChange : public RecoveryUnit::Change {
     public:
-        DataSizeChange(WiredTigerRecordStore* rs, int amount) :_rs(rs), _amount(amount) {}
+        DataSizeChange(WiredTigerRecordStore* rs, int64_t amount) :_rs(rs), _amount(amount) {}
         virtual void commit() {}
         virtual void rollback() {
             _rs->_increaseDataSize( NULL, -_amount );
@@ -991,10 +1394,10 @@ namespace {
 
     private:
         WiredTigerRecordStore* _rs;
-        bool _amount;
+        int64_t _amount;
     };
 
-    void WiredTigerRecordStore::_increaseDataSize( OperationContext* txn, int amount ) {
+    void WiredTigerRecordStore::_increaseDataSize( OperationContext* txn, int64_t amount ) {
         if ( txn )
             txn->recoveryUnit()->registerChange(new DataSizeChange(this, amount));
 
@@ -1265,12 +1668,27 @@ namespace {
                                                           bool inclusive ) {
         WriteUnitOfWork wuow(txn);
         boost::scoped_ptr<RecordIterator> iter( getIterator( txn, end ) );
+        RecordId firstRemoved;
+        int64_t recordsRemoved = 0;
+        int64_t bytesRemoved = 0;
         while( !iter->isEOF() ) {
             RecordId loc = iter->getNext();
             if ( end < loc || ( inclusive && end == loc ) ) {
+                if ( _oplogStones ) {
+                    if ( firstRemoved.isNull() )
+                        firstRemoved = loc;
+                    ++recordsRemoved;
+                    bytesRemoved += iter->dataFor( loc ).size();
+                }
                 deleteRecord( txn, loc );
             }
         }
         wuow.commit();
+
+        if ( _oplogStones && recordsRemoved > 0 ) {
+            _oplogStones->updateStonesAfterCappedTruncateAfter( recordsRemoved,
+                                                                bytesRemoved,
+                                                                firstRemoved );
+        }
     }
 }
@@ -31,12 +31,17 @@
 
 #pragma once
 
+#include <deque>
 #include <set>
 #include <string>
 
+#include <boost/optional.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 
+#include "mongo/base/disallow_copying.h"
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/db/storage/capped_callback.h"
@@ -131,6 +136,11 @@ namespace mongo {
                                                   const DocWriter* doc,
                                                   bool enforceQuota );
 
+        virtual Status insertRecords( OperationContext* txn,
+                                      const std::vector<RecordData>& records,
+                                      bool enforceQuota,
+                                      std::vector<RecordId>* locsOut );
+
         virtual StatusWith<RecordId> updateRecord( OperationContext* txn,
                                                   const RecordId& oldLocation,
                                                   const char* data,
@@ -213,6 +223,21 @@ namespace mongo {
                                             const RecordId& justInserted);
 
         boost::timed_mutex& cappedDeleterMutex() { return _cappedDeleterMutex; }
+
+        class OplogStones;
+
+        /**
+         * The truncation markers of a capped oplog, or NULL for any other record store.
+         */
+        boost::shared_ptr<OplogStones> oplogStones() const { return _oplogStones; }
+
+        /**
+         * Truncates the oldest stones of a capped oplog, a whole stone at a time, for as long as
+         * it has more than it keeps. Returns the number of records removed.
+         * The caller must hold cappedDeleterMutex().
+         */
+        int64_t reclaimOplog(OperationContext* txn);
+
     private:
 
         class Iterator : public RecordIterator {
@@ -266,7 +291,7 @@ namespace mongo {
         void _setId(RecordId loc);
         bool cappedAndNeedDelete() const;
         void _changeNumRecords(OperationContext* txn, int64_t diff);
-        void _increaseDataSize(OperationContext* txn, int amount);
+        void _increaseDataSize(OperationContext* txn, int64_t amount);
         RecordData _getData( const WiredTigerCursor& cursor) const;
         StatusWith<RecordId> extractAndCheckLocForOplog(const char* data, int len);
         void _oplogSetStartHack( WiredTigerRecoveryUnit* wru ) const;
@@ -301,6 +326,108 @@ namespace mongo {
 
         bool _shuttingDown;
         bool _hasBackgroundThread;
+
+        // Non-NULL only for a capped oplog. Shared with the background thread, which waits on it
+        // without holding any locks on the collection.
+        boost::shared_ptr<OplogStones> _oplogStones;
+    };
+
+    /**
+     * Coarse truncation markers ("stones") over a capped oplog. Each stone closes off a run of
+     * committed inserts worth at least minBytesPerStone() bytes and remembers the last record in
+     * it, so that the oplog can be reclaimed by truncating everything up to the oldest stone in
+     * one call instead of walking it document by document. An oplog keeps numStonesToKeep()
+     * stones, plus the partially filled current one.
+     *
+     * Inserts are accounted for when they commit, which can be out of RecordId order, so the
+     * record and byte counts of a stone are close to, but not always exactly, what truncating it
+     * removes.
+     */
+    class WiredTigerRecordStore::OplogStones {
+        MONGO_DISALLOW_COPYING(OplogStones);
+    public:
+        struct Stone {
+            Stone(int64_t records, int64_t bytes, const RecordId& lastRecord)
+                : records(records), bytes(bytes), lastRecord(lastRecord) { }
+
+            int64_t records; // number of records covered by this stone
+            int64_t bytes; // size in bytes of the records covered by this stone
+            RecordId lastRecord; // the highest RecordId covered by this stone
+        };
+
+        /**
+         * Lays down the initial stones over the existing contents of 'rs', either by scanning it
+         * or, for large oplogs, by sampling it with a random cursor.
+         */
+        OplogStones(OperationContext* txn, WiredTigerRecordStore* rs);
+
+        bool hasExcessStones() const;
+
+        /**
+         * Blocks until there are stones to reclaim, kill() is called, or 'timeout' passes.
+         */
+        void awaitHasExcessStonesOrDead(boost::posix_time::milliseconds timeout);
+
+        /**
+         * Wakes up any waiter for good; called when the record store goes away.
+         */
+        void kill();
+
+        boost::optional<Stone> peekOldestStoneIfNeeded() const;
+
+        void popOldestStone();
+
+        /**
+         * Registers a change with 'txn' that adds an inserted record to the current stone when
+         * the insert commits.
+         */
+        void updateCurrentStoneAfterInsertOnCommit(OperationContext* txn,
+                                                   int64_t bytesInserted,
+                                                   const RecordId& loc);
+
+        /**
+         * Registers a change with 'txn' that drops every stone when a truncate of the whole
+         * oplog commits.
+         */
+        void clearStonesOnCommit(OperationContext* txn);
+
+        /**
+         * Accounts for temp_cappedTruncateAfter() having removed 'recordsRemoved' records and
+         * 'bytesRemoved' bytes starting at 'firstRemoved'.
+         */
+        void updateStonesAfterCappedTruncateAfter(int64_t recordsRemoved,
+                                                  int64_t bytesRemoved,
+                                                  const RecordId& firstRemoved);
+
+        size_t numStones() const;
+        size_t numStonesToKeep() const { return _numStonesToKeep; }
+        int64_t minBytesPerStone() const { return _minBytesPerStone; }
+        int64_t currentRecords() const { return _currentRecords.load(); }
+        int64_t currentBytes() const { return _currentBytes.load(); }
+
+    private:
+        class InsertChange;
+        class TruncateChange;
+
+        void _addInsertedRecord(int64_t bytesInserted, const RecordId& loc);
+        void _calculateStonesByScanning(OperationContext* txn);
+        void _calculateStonesBySampling(OperationContext* txn,
+                                        int64_t numRecords,
+                                        int64_t dataSize);
+
+        WiredTigerRecordStore* const _rs; // not owned
+
+        size_t _numStonesToKeep;
+        int64_t _minBytesPerStone;
+
+        // Records and bytes committed since the newest stone was laid down.
+        AtomicInt64 _currentRecords;
+        AtomicInt64 _currentBytes;
+
+        mutable boost::mutex _mutex; // protects the members below
+        boost::condition_variable _oplogReclaimCv;
+        std::deque<Stone> _stones; // oldest first
+        bool _isDead;
     };
 
     // WT failpoint to throw write conflict exceptions randomly
@@ -31,6 +31,7 @@
 
 #include "mongo/platform/basic.h"
 
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 #include <set>
 
@@ -69,9 +70,12 @@ namespace mongo {
             }
 
             /**
+             * If the oplog has stones, they are returned through 'stonesOut' so that the caller
+             * can wait on them without holding any locks.
              * @return Number of documents deleted.
              */
-            int64_t _deleteExcessDocuments() {
+            int64_t _deleteExcessDocuments(
+                    boost::shared_ptr<WiredTigerRecordStore::OplogStones>* stonesOut) {
                 if (!getGlobalServiceContext()->getGlobalStorageEngine()) {
                     LOG(1) << "no global storage engine yet";
                     return 0;
@@ -100,6 +104,13 @@ namespace mongo {
                     OldClientContext ctx(&txn, _ns, false);
                     WiredTigerRecordStore* rs =
                         checked_cast<WiredTigerRecordStore*>(collection->getRecordStore());
+
+                    *stonesOut = rs->oplogStones();
+                    if (*stonesOut) {
+                        boost::lock_guard<boost::timed_mutex> lock(rs->cappedDeleterMutex());
+                        return rs->reclaimOplog(&txn);
+                    }
+
                     WriteUnitOfWork wuow(&txn);
                     boost::lock_guard<boost::timed_mutex> lock(rs->cappedDeleterMutex());
                     int64_t removed = rs->cappedDeleteAsNeeded_inlock(&txn, RecordId::max());
@@ -119,9 +130,21 @@ namespace mongo {
                 Client::initThread(_name.c_str());
 
                 while (!inShutdown()) {
-                    int64_t removed = _deleteExcessDocuments();
+                    boost::shared_ptr<WiredTigerRecordStore::OplogStones> stones;
+                    int64_t removed = _deleteExcessDocuments(&stones);
                     LOG(2) << "WiredTigerRecordStoreThread deleted " << removed;
-                    if (removed == 0) {
+                    if (stones) {
+                        if (removed == 0 && stones->hasExcessStones()) {
+                            // Reclaiming hit a conflict; back off a little before retrying.
+                            sleepmillis(10);
+                        }
+                        else {
+                            // Sleep until an insert lays down a stone past the ones to keep.
+                            stones->awaitHasExcessStonesOrDead(
+                                boost::posix_time::milliseconds(1000));
+                        }
+                    }
+                    else if (removed == 0) {
                         // If we removed 0 documents, sleep a bit in case we're on a laptop
                         // or something to be nice.
                         sleepmillis(1000);
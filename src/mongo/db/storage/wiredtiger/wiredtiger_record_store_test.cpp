@@ -828,6 +828,111 @@ namespace {
         }
     }
 
+    RecordId _oplogStonesInsert( OperationContext* txn,
+                                 scoped_ptr<RecordStore>& rs,
+                                 int inc ) {
+        WriteUnitOfWork wuow( txn );
+        BSONObj obj = BSON( "ts" << Timestamp(1,inc) );
+        StatusWith<RecordId> res = rs->insertRecord( txn, obj.objdata(), obj.objsize(), false );
+        ASSERT_OK( res.getStatus() );
+        wuow.commit();
+        return res.getValue();
+    }
+
+    // Each oplog entry inserted by _oplogStonesInsert() is 17 bytes, so a 1700 byte oplog keeps
+    // ten stones of ten entries each.
+    TEST(WiredTigerRecordStoreTest, OplogStonesCreateAndReclaim) {
+        scoped_ptr<WiredTigerHarnessHelper> harnessHelper( new WiredTigerHarnessHelper() );
+        scoped_ptr<RecordStore> rs(harnessHelper->newCappedRecordStore("local.oplog.stones",
+                                                                       1700,
+                                                                       -1));
+        WiredTigerRecordStore* wrs = checked_cast<WiredTigerRecordStore*>(rs.get());
+        boost::shared_ptr<WiredTigerRecordStore::OplogStones> stones = wrs->oplogStones();
+        ASSERT( stones );
+        ASSERT_EQUALS( 10U, stones->numStonesToKeep() );
+        ASSERT_EQUALS( 170, stones->minBytesPerStone() );
+
+        scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+        for ( int i = 1; i <= 95; ++i ) {
+            _oplogStonesInsert( opCtx.get(), rs, i );
+        }
+        ASSERT_EQUALS( 9U, stones->numStones() );
+        ASSERT_EQUALS( 5, stones->currentRecords() );
+        ASSERT_EQUALS( 85, stones->currentBytes() );
+        ASSERT_FALSE( stones->hasExcessStones() );
+
+        // The 110th entry lays down an eleventh stone, which the next insert reclaims.
+        for ( int i = 96; i <= 110; ++i ) {
+            _oplogStonesInsert( opCtx.get(), rs, i );
+        }
+        ASSERT_EQUALS( 11U, stones->numStones() );
+        ASSERT_TRUE( stones->hasExcessStones() );
+
+        _oplogStonesInsert( opCtx.get(), rs, 111 );
+        ASSERT_EQUALS( 10U, stones->numStones() );
+        ASSERT_FALSE( stones->hasExcessStones() );
+        ASSERT_EQUALS( 101, rs->numRecords( opCtx.get() ) );
+        ASSERT_EQUALS( 101 * 17, rs->dataSize( opCtx.get() ) );
+
+        scoped_ptr<RecordIterator> it( rs->getIterator( opCtx.get() ) );
+        ASSERT_FALSE( it->isEOF() );
+        ASSERT_EQ( RecordId(1,11), it->getNext() );
+    }
+
+    TEST(WiredTigerRecordStoreTest, OplogStonesAfterRestartAndTruncation) {
+        scoped_ptr<WiredTigerHarnessHelper> harnessHelper( new WiredTigerHarnessHelper() );
+        scoped_ptr<RecordStore> rs(harnessHelper->newCappedRecordStore("local.oplog.stones",
+                                                                       1700,
+                                                                       -1));
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            for ( int i = 1; i <= 25; ++i ) {
+                _oplogStonesInsert( opCtx.get(), rs, i );
+            }
+        }
+
+        // Opening the oplog again lays the same stones down over what is already there.
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            rs.reset( new WiredTigerRecordStore( opCtx.get(), "local.oplog.stones", "table:a.b",
+                                                 true, 1700, -1 ) );
+        }
+        WiredTigerRecordStore* wrs = checked_cast<WiredTigerRecordStore*>(rs.get());
+        boost::shared_ptr<WiredTigerRecordStore::OplogStones> stones = wrs->oplogStones();
+        ASSERT_EQUALS( 2U, stones->numStones() );
+        ASSERT_EQUALS( 5, stones->currentRecords() );
+        ASSERT_EQUALS( 85, stones->currentBytes() );
+
+        // Cutting into the second stone folds what is left of it into the current stone.
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            rs->temp_cappedTruncateAfter( opCtx.get(), RecordId(1,15), false );
+        }
+        ASSERT_EQUALS( 1U, stones->numStones() );
+        ASSERT_EQUALS( 5, stones->currentRecords() );
+        ASSERT_EQUALS( 85, stones->currentBytes() );
+
+        // Truncating the whole oplog drops every stone.
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            WriteUnitOfWork wuow( opCtx.get() );
+            ASSERT_OK( rs->truncate( opCtx.get() ) );
+            wuow.commit();
+        }
+        ASSERT_EQUALS( 0U, stones->numStones() );
+        ASSERT_EQUALS( 0, stones->currentRecords() );
+        ASSERT_EQUALS( 0, stones->currentBytes() );
+    }
+
+    TEST(WiredTigerRecordStoreTest, OplogStonesOnlyForCappedOplog) {
+        scoped_ptr<WiredTigerHarnessHelper> harnessHelper( new WiredTigerHarnessHelper() );
+        scoped_ptr<RecordStore> capped(harnessHelper->newCappedRecordStore("a.b", 1700, -1));
+        ASSERT_FALSE( checked_cast<WiredTigerRecordStore*>(capped.get())->oplogStones() );
+
+        scoped_ptr<RecordStore> oplog(harnessHelper->newNonCappedRecordStore("local.oplog.foo"));
+        ASSERT_FALSE( checked_cast<WiredTigerRecordStore*>(oplog.get())->oplogStones() );
+    }
+
     TEST(WiredTigerRecordStoreTest, StorageSizeStatisticsDisabled) {
         WiredTigerHarnessHelper harnessHelper("statistics=(none)");
         scoped_ptr<RecordStore> rs(harnessHelper.newNonCappedRecordStore("a.b"));
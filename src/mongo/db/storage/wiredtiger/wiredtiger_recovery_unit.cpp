@@ -30,7 +30,7 @@
 
 #define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
 
-#include <boost/thread/condition.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include "mongo/base/checked_cast.h"
@@ -38,47 +38,136 @@
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/wait_time_histogram.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/stacktrace.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
     namespace {
-        struct WaitUntilDurableData {
-            WaitUntilDurableData() :
-                numWaitingForSync(0),
-                lastSyncTime(0) {
+
+        /**
+         * Makes every transaction committed before the call durable by committing a tiny write
+         * to the journalFlush table with sync=true. The journal is a single log, so syncing it
+         * for this commit syncs everything written to it before.
+         */
+        void flushJournal(WiredTigerSessionCache* sessionCache, long long flushNumber) {
+            WiredTigerSession* session = sessionCache->getSession();
+            ON_BLOCK_EXIT(&WiredTigerSessionCache::releaseSession, sessionCache, session);
+            WT_SESSION* s = session->getSession();
+
+            WT_CURSOR* c = NULL;
+            int ret = s->open_cursor(s, WiredTigerRecoveryUnit::kJournalFlushUri, NULL, NULL, &c);
+            if (ret == ENOENT) {
+                invariantWTOK(s->create(s, WiredTigerRecoveryUnit::kJournalFlushUri,
+                                        "key_format=q,value_format=q"));
+                ret = s->open_cursor(s, WiredTigerRecoveryUnit::kJournalFlushUri, NULL, NULL, &c);
+            }
+            invariantWTOK(ret);
+            ON_BLOCK_EXIT(c->close, c);
+
+            invariantWTOK(s->begin_transaction(s, "sync=true"));
+            c->set_key(c, int64_t(0));
+            c->set_value(c, int64_t(flushNumber));
+            ret = c->insert(c);
+            if (ret != 0) {
+                invariantWTOK(s->rollback_transaction(s, NULL));
+                invariantWTOK(ret);
             }
+            invariantWTOK(s->commit_transaction(s, NULL));
+        }
 
-            void syncHappend() {
-                boost::lock_guard<boost::mutex> lk( mutex );
-                lastSyncTime++;
-                condvar.notify_all();
+        /**
+         * Group commit for writers waiting for their already committed transactions to become
+         * durable. The first waiter to arrive when no flush is running becomes the leader and
+         * flushes the journal right away. Waiters that arrive while a flush is running cannot
+         * count on it to cover their commit, so they wait for it to finish and then the first of
+         * them leads the next round, on behalf of all the others.
+         */
+        class GroupCommit {
+        public:
+            GroupCommit()
+                : _flushing(false),
+                  _roundsStarted(0),
+                  _roundsFinished(0),
+                  _waits(0),
+                  _flushTimeMicros(0) {
             }
 
-            // return true if happened
-            bool waitUntilDurable() {
-                boost::unique_lock<boost::mutex> lk( mutex );
-                long long start = lastSyncTime;
-                numWaitingForSync.fetchAndAdd(1);
-                condvar.timed_wait(lk,boost::posix_time::milliseconds(50));
-                numWaitingForSync.fetchAndAdd(-1);
-                return lastSyncTime > start;
+            void waitUntilDurable(WiredTigerSessionCache* sessionCache) {
+                Timer waitTimer;
+
+                boost::unique_lock<boost::mutex> lk(_mutex);
+
+                // Only a round that starts after this point is guaranteed to cover our commit.
+                const long long neededRound = _roundsStarted + 1;
+                while (_roundsFinished < neededRound) {
+                    if (_flushing) {
+                        _roundFinishedCv.wait(lk);
+                        continue;
+                    }
+
+                    // Lead the next round.
+                    _flushing = true;
+                    const long long round = ++_roundsStarted;
+                    lk.unlock();
+
+                    Timer flushTimer;
+                    try {
+                        flushJournal(sessionCache, round);
+                    }
+                    catch (...) {
+                        lk.lock();
+                        _flushing = false;
+                        _roundsStarted--;
+                        _roundFinishedCv.notify_all();
+                        throw;
+                    }
+                    const long long flushMicros = flushTimer.micros();
+
+                    lk.lock();
+                    _flushing = false;
+                    _roundsFinished = round;
+                    _flushTimeMicros += flushMicros;
+                    _roundFinishedCv.notify_all();
+                }
+
+                _waitTimeHistogram.record(waitTimer.micros());
+                _waits++;
             }
 
-            AtomicUInt32 numWaitingForSync;
+            void appendStats(BSONObjBuilder* b) const {
+                boost::lock_guard<boost::mutex> lk(_mutex);
+                b->appendNumber("waits", _waits);
+                b->appendNumber("flushes", _roundsFinished);
+                b->appendNumber("flushTimeMicros", _flushTimeMicros);
+                BSONObjBuilder histogramBuilder(b->subobjStart("waitTimeHistogram"));
+                _waitTimeHistogram.append(&histogramBuilder);
+                histogramBuilder.done();
+            }
 
-            boost::mutex mutex; // this just protects lastSyncTime
-            boost::condition condvar;
-            long long lastSyncTime;
-        } waitUntilDurableData;
+        private:
+            mutable boost::mutex _mutex; // protects everything below
+            boost::condition_variable _roundFinishedCv;
+            bool _flushing;
+            long long _roundsStarted;
+            long long _roundsFinished;
+
+            long long _waits;
+            long long _flushTimeMicros;
+            WaitTimeHistogram _waitTimeHistogram;
+        } groupCommit;
     }
 
+    const char* const WiredTigerRecoveryUnit::kJournalFlushUri = "table:journalFlush";
+
     WiredTigerRecoveryUnit::WiredTigerRecoveryUnit(WiredTigerSessionCache* sc) :
         _sessionCache( sc ),
         _session( NULL ),
@@ -87,7 +176,6 @@ namespace mongo {
         _myTransactionCount( 1 ),
         _everStartedWrite( false ),
         _currentlySquirreled( false ),
-        _syncing( false ),
         _noTicketNeeded( false ) {
     }
 
@@ -171,20 +259,12 @@ namespace mongo {
     }
 
     void WiredTigerRecoveryUnit::goingToWaitUntilDurable() {
-        if ( _active ) {
-            // too late, can't change config
-            return;
-        }
-        // yay, we've configured ourselves for sync
-        _syncing = true;
+        // Nothing to set up: rather than syncing each of our own transactions as they commit,
+        // waitUntilDurable() joins a group commit that syncs them along with everyone else's.
     }
 
     bool WiredTigerRecoveryUnit::waitUntilDurable() {
-        if ( _syncing && _everStartedWrite ) {
-            // we did a sync, so we're good
-            return true;
-        }
-        waitUntilDurableData.waitUntilDurable();
+        groupCommit.waitUntilDurable(_sessionCache);
         return true;
     }
 
@@ -298,6 +378,10 @@ namespace mongo {
             bbb.done();
         }
         bb.done();
+
+        BSONObjBuilder groupCommitBuilder(b.subobjStart("groupCommit"));
+        groupCommit.appendStats(&groupCommitBuilder);
+        groupCommitBuilder.done();
     }
 
     void WiredTigerRecoveryUnit::_txnClose( bool commit ) {
@@ -306,8 +390,6 @@ namespace mongo {
         if ( commit ) {
             invariantWTOK( s->commit_transaction(s, NULL) );
             LOG(2) << "WT commit_transaction";
-            if ( _syncing )
-                waitUntilDurableData.syncHappend();
         }
         else {
             invariantWTOK( s->rollback_transaction(s, NULL) );
@@ -360,8 +442,7 @@ namespace mongo {
         _getTicket(opCtx);
 
         WT_SESSION *s = _session->getSession();
-        _syncing = _syncing || waitUntilDurableData.numWaitingForSync.load() > 0;
-        invariantWTOK( s->begin_transaction(s, _syncing ? "sync=true" : NULL) );
+        invariantWTOK( s->begin_transaction(s, NULL) );
         LOG(2) << "WT begin_transaction";
         _timer.reset();
         _active = true;
@@ -95,6 +95,13 @@ namespace mongo {
         static WiredTigerRecoveryUnit* get(OperationContext *txn);
 
         static void appendGlobalStats(BSONObjBuilder& b);
+
+        /**
+         * Internal table written with sync=true to flush the journal on behalf of writers
+         * waiting in waitUntilDurable().
+         */
+        static const char* const kJournalFlushUri;
+
     private:
 
         void _abort();
@@ -112,7 +119,6 @@ namespace mongo {
         bool _everStartedWrite;
         Timer _timer;
         bool _currentlySquirreled;
-        bool _syncing;
         RecordId _oplogReadTill;
 
         typedef OwnedPointerVector<Change> Changes;
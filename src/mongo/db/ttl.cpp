@@ -34,6 +34,10 @@
 
 #include "mongo/db/ttl.h"
 
+#include <algorithm>
+#include <map>
+#include <memory>
+
 #include "mongo/base/counter.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/user_name.h"
@@ -53,7 +57,11 @@
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/util/background.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
 
@@ -75,9 +83,166 @@ namespace mongo {
     MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorEnabled, bool, true );
     MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorSleepSecs, int, 60 ); //used for testing
 
+    // How many documents a TTL index has deleted per batch, before the locks are given up.
+    // 0 deletes all of its expired documents in one batch.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorBatchSize, int, 1000 );
+
+    // How many documents per second the TTL monitor may delete, over all of its threads.
+    // 0 for no limit.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorMaxDocsPerSecond, int, 0 );
+
+    // How long a TTL pass may run before it leaves the rest of the expired documents to the next
+    // pass. 0 for no limit.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorMaxPassMillis, int, 0 );
+
+    // How many databases a TTL pass works on at once.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorThreads, int, 1 );
+
+namespace {
+
+    /**
+     * What the TTL monitor has done for each TTL index, reported in serverStatus as
+     * metrics.ttl.indexes.<ns>.<index name>.
+     */
+    class TTLIndexMetrics : public ServerStatusMetric {
+    public:
+        struct IndexMetrics {
+            // Documents deleted through the index.
+            AtomicInt64 deletedDocuments;
+
+            // How long ago the oldest expired document which is left expired, as of the end of the
+            // last pass, or 0 if that pass deleted all of them.
+            AtomicInt64 lagSecs;
+        };
+
+        typedef std::pair<string, string> IndexKey;  // (ns, index name)
+
+        TTLIndexMetrics() : ServerStatusMetric("ttl.indexes") { }
+
+        std::shared_ptr<IndexMetrics> get(const string& ns, const string& indexName) {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            std::shared_ptr<IndexMetrics>& metrics = _metrics[IndexKey(ns, indexName)];
+            if (!metrics) {
+                metrics = std::make_shared<IndexMetrics>();
+            }
+            return metrics;
+        }
+
+        /**
+         * Forgets the metrics of the indexes not in 'ttlIndexes', which are no longer TTL indexes.
+         */
+        void retainOnly(const set<IndexKey>& ttlIndexes) {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            for (MetricsMap::iterator it = _metrics.begin(); it != _metrics.end();) {
+                if (ttlIndexes.count(it->first)) {
+                    ++it;
+                }
+                else {
+                    _metrics.erase(it++);
+                }
+            }
+        }
+
+        virtual void appendAtLeaf(BSONObjBuilder& b) const {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            BSONObjBuilder indexesBuilder(b.subobjStart(_leafName));
+
+            // _metrics is ordered by namespace, so each namespace's indexes are next to each other.
+            MetricsMap::const_iterator it = _metrics.begin();
+            while (it != _metrics.end()) {
+                const string& ns = it->first.first;
+                BSONObjBuilder nsBuilder(indexesBuilder.subobjStart(ns));
+                for (; it != _metrics.end() && it->first.first == ns; ++it) {
+                    BSONObjBuilder indexBuilder(nsBuilder.subobjStart(it->first.second));
+                    indexBuilder.append("deletedDocuments", it->second->deletedDocuments.load());
+                    indexBuilder.append("lagSecs", it->second->lagSecs.load());
+                }
+            }
+        }
+
+    private:
+        typedef std::map<IndexKey, std::shared_ptr<IndexMetrics> > MetricsMap;
+
+        mutable stdx::mutex _mutex;
+        MetricsMap _metrics;
+    };
+
+    TTLIndexMetrics ttlIndexMetrics;
+
+    /**
+     * Spaces out the batches of deletes of all TTL monitor threads, to keep to
+     * ttlMonitorMaxDocsPerSecond.
+     */
+    class DeleteRateLimiter {
+    public:
+        DeleteRateLimiter() : _nextBatchMicros(0), _maxPerSecond(0) { }
+
+        /**
+         * Accounts for a batch of 'numDeleted' deletes which started at 'batchStartMicros', and
+         * returns how many microseconds to wait before starting another.
+         */
+        long long reserve(long long numDeleted, unsigned long long batchStartMicros) {
+            const int maxPerSecond = ttlMonitorMaxDocsPerSecond;
+            if (maxPerSecond <= 0 || numDeleted <= 0) {
+                return 0;
+            }
+
+            unsigned long long waitUntilMicros;
+            {
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                // Batches reserved at another rate don't hold up those at the new one.
+                if (maxPerSecond != _maxPerSecond) {
+                    _maxPerSecond = maxPerSecond;
+                    _nextBatchMicros = 0;
+                }
+                // Time not used by earlier batches is lost, rather than saved up for a burst.
+                _nextBatchMicros = std::max(_nextBatchMicros, batchStartMicros);
+                _nextBatchMicros += numDeleted * 1000 * 1000 / maxPerSecond;
+                waitUntilMicros = _nextBatchMicros;
+            }
+
+            const unsigned long long nowMicros = curTimeMicros64();
+            return waitUntilMicros > nowMicros ? waitUntilMicros - nowMicros : 0;
+        }
+
+    private:
+        stdx::mutex _mutex;
+        unsigned long long _nextBatchMicros;
+        int _maxPerSecond;
+    };
+
+    /**
+     * Sleeps for 'micros' between batches of deletes. The sleep is cut short by shutdown, by the
+     * TTL monitor being disabled, or by a change of ttlMonitorMaxDocsPerSecond.
+     */
+    void sleepBetweenBatches(long long micros) {
+        // How long to sleep before looking for a reason to stop sleeping.
+        const unsigned long long sliceMicros = 100 * 1000;
+
+        const int maxPerSecond = ttlMonitorMaxDocsPerSecond;
+        const unsigned long long wakeMicros = curTimeMicros64() + micros;
+        while (!inShutdown() && ttlMonitorEnabled && ttlMonitorMaxDocsPerSecond == maxPerSecond) {
+            const unsigned long long nowMicros = curTimeMicros64();
+            if (nowMicros >= wakeMicros) {
+                return;
+            }
+            sleepmicros(std::min(sliceMicros, wakeMicros - nowMicros));
+        }
+    }
+
+    void initializeWorkerThread() {
+        // Only do this once per thread
+        if (!ClientBasic::getCurrent()) {
+            Client::initThreadIfNotAlready();
+            AuthorizationSession::get(cc())->grantInternalAuthorization();
+        }
+    }
+
+}  // namespace
+
     class TTLMonitor : public BackgroundJob {
     public:
-        TTLMonitor(){}
+        TTLMonitor() : _workerCount(0) {}
         virtual ~TTLMonitor(){}
 
         virtual string name() const { return "TTLMonitor"; }
@@ -132,26 +297,95 @@ namespace mongo {
 
             ttlPasses.increment();
 
+            // Find all the TTL indexes up front, so as to drop the metrics of any others.
+            vector<std::pair<string, vector<BSONObj> > > work;
+            set<TTLIndexMetrics::IndexKey> ttlIndexes;
             for ( set<string>::const_iterator i=dbs.begin(); i!=dbs.end(); ++i ) {
-                string db = *i;
-
                 vector<BSONObj> indexes;
-                getTTLIndexesForDB(&txn, db, &indexes);
+                getTTLIndexesForDB(&txn, *i, &indexes);
+                if (indexes.empty()) {
+                    continue;
+                }
+
+                for (vector<BSONObj>::const_iterator it = indexes.begin();
+                     it != indexes.end(); ++it) {
+                    ttlIndexes.insert(TTLIndexMetrics::IndexKey((*it)["ns"].str(),
+                                                                (*it)["name"].str()));
+                }
+                work.push_back(std::make_pair(*i, indexes));
+            }
+            ttlIndexMetrics.retainOnly(ttlIndexes);
 
-                for ( vector<BSONObj>::const_iterator it = indexes.begin();
-                      it != indexes.end(); ++it ) {
+            if (work.empty()) {
+                return;
+            }
 
-                    BSONObj idx = *it;
-                    try {
-                        if ( !doTTLForIndex( &txn, db, idx ) ) {
-                            break;  // stop processing TTL indexes on this database
-                        }
-                    } catch (const DBException& dbex) {
-                        error() << "Error processing ttl index: " << idx
-                                << " -- " << dbex.toString();
-                        // continue on to the next index
-                        continue;
+            const int maxPassMillis = ttlMonitorMaxPassMillis;
+            const Date_t deadline = (maxPassMillis > 0)
+                                    ? Date_t::now() + Milliseconds(maxPassMillis)
+                                    : Date_t::max();
+
+            const int threads = std::max(1, static_cast<int>(ttlMonitorThreads));
+            if (1 == threads || 1 == work.size()) {
+                for (size_t i = 0; i < work.size(); ++i) {
+                    doTTLForDB(&txn, work[i].first, work[i].second, deadline);
+                }
+                return;
+            }
+
+            if (threads != _workerCount) {
+                // Waits for the old threads, though there is no work left for them at this point.
+                _workers.reset();
+                _workers.reset(new ThreadPool(threads, "TTLMonitor worker "));
+                _workerCount = threads;
+            }
+            for (size_t i = 0; i < work.size(); ++i) {
+                _workers->schedule(stdx::bind(&TTLMonitor::doTTLForDBOnWorker,
+                                              this,
+                                              work[i].first,
+                                              work[i].second,
+                                              deadline));
+            }
+            _workers->join();
+        }
+
+        /**
+         * Runs doTTLForDB() on one of the _workers.
+         */
+        void doTTLForDBOnWorker(const string& dbName,
+                                const vector<BSONObj>& indexes,
+                                Date_t deadline) {
+            initializeWorkerThread();
+            OperationContextImpl txn;
+            try {
+                doTTLForDB(&txn, dbName, indexes, deadline);
+            }
+            catch (const WriteConflictException& e) {
+                LOG(1) << "Got WriteConflictException in TTL thread";
+            }
+        }
+
+        /**
+         * Removes the expired documents of each of 'indexes', which are the TTL indexes of the
+         * database 'dbName'.
+         */
+        void doTTLForDB(OperationContext* txn,
+                        const string& dbName,
+                        const vector<BSONObj>& indexes,
+                        Date_t deadline) {
+            for ( vector<BSONObj>::const_iterator it = indexes.begin();
+                  it != indexes.end(); ++it ) {
+
+                BSONObj idx = *it;
+                try {
+                    if ( !doTTLForIndex( txn, dbName, idx, deadline ) ) {
+                        break;  // stop processing TTL indexes on this database
                     }
+                } catch (const DBException& dbex) {
+                    error() << "Error processing ttl index: " << idx
+                            << " -- " << dbex.toString();
+                    // continue on to the next index
+                    continue;
                 }
             }
         }
@@ -210,10 +444,18 @@ namespace mongo {
          * after a sufficient amount of time has passed according to its expiry
          * specification.
          *
+         * The documents are deleted oldest first, in batches of ttlMonitorBatchSize. The locks
+         * are given up between batches, and batches are spaced out to keep to
+         * ttlMonitorMaxDocsPerSecond. After the first batch, which every index gets so that none
+         * of them starves, no new batch is started after 'deadline'.
+         *
          * @return true if caller should continue processing TTL indexes of collections
          *         on the specified database, and false otherwise
          */
-        bool doTTLForIndex(OperationContext* txn, const string& dbName, BSONObj idx) {
+        bool doTTLForIndex(OperationContext* txn,
+                           const string& dbName,
+                           BSONObj idx,
+                           Date_t deadline) {
             const string ns = idx["ns"].String();
             if (!userAllowedWriteNS(ns).isOK()) {
                 error() << "namespace '" << ns << "' doesn't allow deletes, skipping ttl job for: "
@@ -229,86 +471,127 @@ namespace mongo {
 
             LOG(1) << "TTL -- ns: " << ns << " key: " << key;
 
+            const std::shared_ptr<TTLIndexMetrics::IndexMetrics> metrics =
+                ttlIndexMetrics.get(ns, idx["name"].str());
+
             // Read the current time outside of the while loop, so that we don't expand our index
-            // bounds after every WriteConflictException.
+            // bounds after every WriteConflictException or batch.
             const Date_t now = Date_t::now();
 
             long long numDeleted = 0;
             int attempt = 1;
-            while (1) {
-                ScopedTransaction scopedXact(txn, MODE_IX);
-                AutoGetDb autoDb(txn, dbName, MODE_IX);
-                Database* db = autoDb.getDb();
-                if (!db) {
+            bool isFirstBatch = true;
+            bool isDone = false;
+            while (!isDone) {
+                if (inShutdown()) {
                     return false;
                 }
 
-                Lock::CollectionLock collLock(txn->lockState(), ns, MODE_IX);
-
-                Collection* collection = db->getCollection(ns);
-                if (!collection) {
-                    // Collection was dropped.
-                    return true;
-                }
-
-                if (!repl::getGlobalReplicationCoordinator()->canAcceptWritesForDatabase(dbName)) {
-                    // We've stepped down since we started this function, so we should stop working
-                    // as we only do deletes on the primary.
+                if (!ttlMonitorEnabled) {
+                    LOG(1) << "TTLMonitor is disabled, leaving the rest of ns: " << ns
+                           << " key: " << key;
                     return false;
                 }
 
-                IndexDescriptor* desc = collection->getIndexCatalog()->findIndexByKeyPattern(txn,
-                                                                                             key);
-                if (!desc) {
-                    LOG(1) << "index not found (index build in progress? index dropped?), skipping "
-                           << "ttl job for: " << idx;
+                // The other TTL indexes of the database still get their first batch.
+                if (!isFirstBatch && Date_t::now() >= deadline) {
+                    LOG(1) << "TTL pass out of time, leaving the rest of ns: " << ns << " key: "
+                           << key << " to the next pass";
                     return true;
                 }
 
-                // Re-read 'idx' from the descriptor, in case the collection or index definition
-                // changed before we re-acquired the collection lock.
-                idx = desc->infoObj();
+                isFirstBatch = false;
+                const unsigned long long batchStartMicros = curTimeMicros64();
+                long long numDeletedInBatch = 0;
+                try {
+                    ScopedTransaction scopedXact(txn, MODE_IX);
+                    AutoGetDb autoDb(txn, dbName, MODE_IX);
+                    Database* db = autoDb.getDb();
+                    if (!db) {
+                        return false;
+                    }
 
-                if (IndexType::INDEX_BTREE != IndexNames::nameToType(desc->getAccessMethodName())) {
-                    error() << "special index can't be used as a ttl index, skipping ttl job for: "
-                            << idx;
-                    return true;
-                }
+                    Lock::CollectionLock collLock(txn->lockState(), ns, MODE_IX);
 
-                BSONElement secondsExpireElt = idx[secondsExpireField];
-                if (!secondsExpireElt.isNumber()) {
-                    error() << "ttl indexes require the " << secondsExpireField << " field to be "
-                            << "numeric but received a type of "
-                            << typeName(secondsExpireElt.type()) << ", skipping ttl job for: "
-                            << idx;
-                    return true;
-                }
+                    Collection* collection = db->getCollection(ns);
+                    if (!collection) {
+                        // Collection was dropped.
+                        return true;
+                    }
 
-                const Date_t kDawnOfTime =
-                    Date_t::fromMillisSinceEpoch(std::numeric_limits<long long>::min());
-                const BSONObj startKey = BSON("" << kDawnOfTime);
-                const BSONObj endKey =
-                    BSON("" << now - Seconds(secondsExpireElt.numberLong()));
-                const bool endKeyInclusive = true;
-                // The canonical check as to whether a key pattern element is "ascending" or
-                // "descending" is (elt.number() >= 0).  This is defined by the Ordering class.
-                const InternalPlanner::Direction direction =
-                    (key.firstElement().number() >= 0) ? InternalPlanner::Direction::FORWARD
-                                                       : InternalPlanner::Direction::BACKWARD;
-                unique_ptr<PlanExecutor> exec(InternalPlanner::indexScan(txn,
-                                                                         collection,
-                                                                         desc,
-                                                                         startKey,
-                                                                         endKey,
-                                                                         endKeyInclusive,
-                                                                         direction));
-                exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
+                    repl::ReplicationCoordinator* replCoord =
+                        repl::getGlobalReplicationCoordinator();
+                    if (!replCoord->canAcceptWritesForDatabase(dbName)) {
+                        // We've stepped down since we started this function, so we should stop
+                        // working as we only do deletes on the primary.
+                        return false;
+                    }
+
+                    IndexDescriptor* desc =
+                        collection->getIndexCatalog()->findIndexByKeyPattern(txn, key);
+                    if (!desc) {
+                        LOG(1) << "index not found (index build in progress? index dropped?), "
+                               << "skipping ttl job for: " << idx;
+                        return true;
+                    }
+
+                    // Re-read 'idx' from the descriptor, in case the collection or index
+                    // definition changed before we re-acquired the collection lock.
+                    idx = desc->infoObj();
+
+                    const IndexType indexType =
+                        IndexNames::nameToType(desc->getAccessMethodName());
+                    if (IndexType::INDEX_BTREE != indexType) {
+                        error() << "special index can't be used as a ttl index, skipping ttl job "
+                                << "for: " << idx;
+                        return true;
+                    }
+
+                    BSONElement secondsExpireElt = idx[secondsExpireField];
+                    if (!secondsExpireElt.isNumber()) {
+                        error() << "ttl indexes require the " << secondsExpireField
+                                << " field to be numeric but received a type of "
+                                << typeName(secondsExpireElt.type()) << ", skipping ttl job for: "
+                                << idx;
+                        return true;
+                    }
+
+                    const Date_t kDawnOfTime =
+                        Date_t::fromMillisSinceEpoch(std::numeric_limits<long long>::min());
+                    const Date_t expiry = now - Seconds(secondsExpireElt.numberLong());
+                    const BSONObj startKey = BSON("" << kDawnOfTime);
+                    const BSONObj endKey = BSON("" << expiry);
+                    const bool endKeyInclusive = true;
+                    // The canonical check as to whether a key pattern element is "ascending" or
+                    // "descending" is (elt.number() >= 0).  This is defined by the Ordering class.
+                    const InternalPlanner::Direction direction =
+                        (key.firstElement().number() >= 0) ? InternalPlanner::Direction::FORWARD
+                                                           : InternalPlanner::Direction::BACKWARD;
+                    unique_ptr<PlanExecutor> exec(InternalPlanner::indexScan(txn,
+                                                                             collection,
+                                                                             desc,
+                                                                             startKey,
+                                                                             endKey,
+                                                                             endKeyInclusive,
+                                                                             direction));
+                    exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
+
+                    const long long batchSize = (ttlMonitorBatchSize > 0)
+                                                ? ttlMonitorBatchSize
+                                                : std::numeric_limits<long long>::max();
 
-                try {
                     PlanExecutor::ExecState state;
                     BSONObj obj;
                     RecordId rid;
                     while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, &rid))) {
+                        if (numDeletedInBatch == batchSize) {
+                            // 'obj' is the index key of the oldest document left, which is for the
+                            // next batch.
+                            const Date_t oldestLeft = obj.firstElement().date();
+                            metrics->lagSecs.store(durationCount<Seconds>(expiry - oldestLeft));
+                            break;
+                        }
+
                         exec->saveState();
                         {
                             WriteUnitOfWork wunit(txn);
@@ -316,32 +599,58 @@ namespace mongo {
                             wunit.commit();
                         }
                         ++numDeleted;
+                        ++numDeletedInBatch;
                         ttlDeletedDocuments.increment();
+                        metrics->deletedDocuments.addAndFetch(1);
                         if (!exec->restoreState(txn)) {
                             return true;
                         }
                     }
-                    if (PlanExecutor::IS_EOF != state) {
+                    if (PlanExecutor::IS_EOF == state) {
+                        metrics->lagSecs.store(0);
+                        isDone = true;
+                    }
+                    else if (PlanExecutor::ADVANCED != state) {
                         if (PlanExecutor::FAILURE == state &&
                                 WorkingSetCommon::isValidStatusMemberObject(obj)) {
-                            error() << "ttl query execution for index " << idx << " failed with: "
+                            error() << "ttl query execution for index " << idx
+                                    << " failed with: "
                                     << WorkingSetCommon::getMemberObjectStatus(obj);
                             return true;
                         }
-                        error() << "ttl query execution for index " << idx << " failed with state: "
-                                << PlanExecutor::statestr(state);
+                        error() << "ttl query execution for index " << idx
+                                << " failed with state: " << PlanExecutor::statestr(state);
                         return true;
                     }
-                    break;
                 }
                 catch (const WriteConflictException& dle) {
                     WriteConflictException::logAndBackoff(attempt++, "ttl", ns);
                 }
+
+                // The locks are released, so other operations can get in between our batches.
+                const long long waitMicros = _rateLimiter.reserve(numDeletedInBatch,
+                                                                 batchStartMicros);
+                if (waitMicros > 0) {
+                    long long sleepMicros = waitMicros;
+                    if (deadline != Date_t::max()) {
+                        // No point sleeping past the end of the pass.
+                        const long long untilDeadlineMicros =
+                            durationCount<Microseconds>(deadline - Date_t::now());
+                        sleepMicros = std::max(0LL, std::min(sleepMicros, untilDeadlineMicros));
+                    }
+                    sleepBetweenBatches(sleepMicros);
+                }
             }
 
             LOG(1) << "\tTTL deleted: " << numDeleted << endl;
             return true;
         }
+
+        // Used when ttlMonitorThreads is more than 1, with _workerCount threads.
+        unique_ptr<ThreadPool> _workers;
+        int _workerCount;
+
+        DeleteRateLimiter _rateLimiter;
     };
 
     void startTTLBackgroundJob() {
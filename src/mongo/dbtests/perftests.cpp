@@ -54,7 +54,11 @@
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/json.h"
 #include "mongo/db/lasterror.h"
+#include "mongo/db/matcher/expression_compiled.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/db/storage/mmap_v1/btree/key.h"
 #include "mongo/db/storage/mmap_v1/compress.h"
 #include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
@@ -496,6 +500,102 @@ namespace PerfTests {
         }
     };
 
+    /** a mix of the key types most common in indexes. rps for the KeyString tests is keys/sec */
+    class KeyStringBase : public B {
+    public:
+        KeyStringBase() : _ord(Ordering::make(BSON("a" << 1 << "b" << -1))), _i(0) {
+            _keys.push_back(BSON("" << 12345 << "" << "a string of moderate length"));
+            _keys.push_back(BSON("" << 1234567890123LL << "" << -77));
+            _keys.push_back(BSON("" << 3.14159 << "" << 2.0));
+            _keys.push_back(BSON("" << OID("abcdefabcdefabcdefabcdef") << "" << "x"));
+            _keys.push_back(BSON("" << StringData("nul\0inside", StringData::LiteralTag())
+                                 << "" << BSONNULL));
+        }
+        virtual int howLongMillis() { return 3000; }
+        virtual bool showDurStats() { return false; }
+    protected:
+        const BSONObj& nextKey() { return _keys[_i++ % _keys.size()]; }
+        RecordId nextLoc() { return RecordId(1 + _i); }
+
+        const Ordering _ord;
+        vector<BSONObj> _keys;
+        unsigned long long _i;
+    };
+
+    class KeyStringEncode : public KeyStringBase {
+    public:
+        string name() { return "KeyString-encode"; }
+        void timed() {
+            const RecordId loc = nextLoc();
+            _ks.resetToKey(nextKey(), _ord, loc);
+            dontOptimizeOutHopefully += _ks.getSize();
+        }
+    private:
+        KeyString _ks;
+    };
+
+    class KeyStringCompare : public KeyStringBase {
+    public:
+        // keys that share a long prefix so the comparison has to scan most of the buffer
+        KeyStringCompare() :
+          _a(BSON("" << 5 << "" << "a shared prefix of some length, then a"), _ord, RecordId(1)),
+          _b(BSON("" << 5 << "" << "a shared prefix of some length, then b"), _ord, RecordId(1))
+          {}
+        string name() { return "KeyString-compare"; }
+        void timed() {
+            dontOptimizeOutHopefully += _a.compare(_b);
+        }
+    private:
+        const KeyString _a, _b;
+    };
+
+    /**
+     * a query with several predicates over one subdocument, as a collection scan would see it.
+     * rps for the Matcher tests is docs/sec
+     */
+    class MatcherBase : public B {
+    public:
+        MatcherBase() {
+            StatusWithMatchExpression parsed = MatchExpressionParser::parse(_query);
+            verify(parsed.isOK());
+            _expr.reset(parsed.getValue());
+            for (int i = 0; i < 100; i++) {
+                _docs.push_back(BSON("_id" << i << "name" << "some name"
+                                     << "info" << BSON("age" << (i % 60) << "score" << i * 1.5
+                                                       << "city" << (i % 3 ? "nyc" : "sf"))));
+            }
+        }
+        virtual int howLongMillis() { return 3000; }
+        virtual bool showDurStats() { return false; }
+    protected:
+        const BSONObj& nextDoc() { return _docs[_i++ % _docs.size()]; }
+
+        const BSONObj _query = fromjson("{'info.age': {$gte: 20, $lt: 50}, "
+                                        "'info.city': 'nyc', 'info.score': {$gt: 10.0}}");
+        boost::scoped_ptr<MatchExpression> _expr;
+        vector<BSONObj> _docs;
+        unsigned long long _i = 0;
+    };
+
+    class MatcherInterpreted : public MatcherBase {
+    public:
+        string name() { return "Matcher-interpreted"; }
+        void timed() {
+            dontOptimizeOutHopefully += _expr->matchesBSON(nextDoc());
+        }
+    };
+
+    class MatcherCompiled : public MatcherBase {
+    public:
+        MatcherCompiled() : _compiled(CompiledMatchExpression::compile(_expr.get())) {}
+        string name() { return "Matcher-compiled"; }
+        void timed() {
+            dontOptimizeOutHopefully += _compiled->matchesBSON(nextDoc());
+        }
+    private:
+        const std::unique_ptr<CompiledMatchExpression> _compiled;
+    };
+
     unsigned long long aaa;
 
     class Timer : public B {
@@ -1205,6 +1305,42 @@ namespace PerfTests {
         }
     };
 
+    /** scans 10000 documents per query through a selective filter and projection, with the
+        executor pulling results from the plan root either one work() at a time or in batches
+    */
+    template <int WorkBatchSize>
+    class CollScanFilter : public B {
+    public:
+        CollScanFilter() : _savedWorkBatchSize(internalQueryExecWorkBatchSize) {}
+        virtual string name() {
+            return WorkBatchSize <= 1 ? "collscan-filter-work" :
+                "collscan-filter-batch" + BSONObjBuilder::numStr(WorkBatchSize);
+        }
+        virtual unsigned batchSize() { return 1; }
+        void prep() {
+            for (int i = 0; i < 10000; i++) {
+                client()->insert(ns(), BSON("_id" << i << "x" << i << "y" << "filler"));
+            }
+            internalQueryExecWorkBatchSize = WorkBatchSize;
+        }
+        void timed() {
+            BSONObj fields = BSON("x" << 1);
+            std::auto_ptr<DBClientCursor> c =
+                client()->query(ns(), QUERY("x" << GTE << 9900), 0, 0, &fields);
+            int n = 0;
+            while (c->more()) {
+                c->nextSafe();
+                n++;
+            }
+            verify(n == 100);
+        }
+        void post() {
+            internalQueryExecWorkBatchSize = _savedWorkBatchSize;
+        }
+    private:
+        const int _savedWorkBatchSize;
+    };
+
     // Tests what the worst case is for the overhead of enabling a fail point. If 'fpInjected'
     // is false, then the fail point will be compiled out. If 'fpInjected' is true, then the
     // fail point will be compiled in. Since the conditioned block is more or less trivial, any
@@ -1458,6 +1594,10 @@ namespace PerfTests {
                 add< CTM >();
                 add< CTMicros >();
                 add< KeyTest >();
+                add< KeyStringEncode >();
+                add< KeyStringCompare >();
+                add< MatcherInterpreted >();
+                add< MatcherCompiled >();
                 add< Bldr >();
                 add< StkBldr >();
                 add< BSONIter >();
@@ -1471,6 +1611,8 @@ namespace PerfTests {
                 add< Update1 >();
                 add< MoreIndexes<Update1> >();
                 add< InsertBig >();
+                add< CollScanFilter<1> >();
+                add< CollScanFilter<64> >();
                 add< FailPointTest<false, false> >();
                 add< FailPointTest<true, false> >();
                 add< FailPointTest<true, true> >();
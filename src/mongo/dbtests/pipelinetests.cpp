@@ -176,6 +176,38 @@ namespace PipelineTests {
                 string mergePipeJson() { return "[]"; }
             };
 
+            namespace limitSplitSortToMergeLimit {
+                // These tests keep the merger needing whole documents so that
+                // limitFieldsSentFromShardsToMerger leaves the shard pipeline alone.
+
+                class LimitAfterProject : public Base {
+                    string inputPipeJson() {
+                        return "[{$sort: {a: 1}}, {$project: {x: '$$ROOT'}}, {$limit: 5}]";
+                    }
+                    string shardPipeJson() {
+                        return "[{$sort: {a: 1}}, {$limit: 5}]";
+                    }
+                    string mergePipeJson() {
+                        return "[{$sort: {a: 1, $mergePresorted: true}}, {$limit: 5}"
+                               ",{$project: {x: '$$ROOT'}}, {$limit: 5}]";
+                    }
+                };
+
+                class LimitAfterRedact : public Base {
+                    // $redact may drop documents, so the $limit can't bound the $sort.
+                    string inputPipeJson() {
+                        return "[{$sort: {a: 1}}, {$redact: '$$KEEP'}, {$limit: 5}]";
+                    }
+                    string shardPipeJson() {
+                        return "[{$sort: {a: 1}}]";
+                    }
+                    string mergePipeJson() {
+                        return "[{$sort: {a: 1, $mergePresorted: true}}"
+                               ",{$redact: '$$KEEP'}, {$limit: 5}]";
+                    }
+                };
+            } // namespace limitSplitSortToMergeLimit
+
             namespace moveFinalUnwindFromShardsToMerger {
 
                 class OneUnwind : public Base {
@@ -303,6 +335,8 @@ namespace PipelineTests {
             add<Optimizations::Local::RemoveMultipleEmptyMatches>();
             add<Optimizations::Local::DoNotRemoveNonEmptyMatch>();
             add<Optimizations::Sharded::Empty>();
+            add<Optimizations::Sharded::limitSplitSortToMergeLimit::LimitAfterProject>();
+            add<Optimizations::Sharded::limitSplitSortToMergeLimit::LimitAfterRedact>();
             add<Optimizations::Sharded::moveFinalUnwindFromShardsToMerger::OneUnwind>();
             add<Optimizations::Sharded::moveFinalUnwindFromShardsToMerger::TwoUnwind>();
             add<Optimizations::Sharded::moveFinalUnwindFromShardsToMerger::UnwindNotFinal>();
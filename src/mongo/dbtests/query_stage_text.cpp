@@ -0,0 +1,173 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/**
+ * This file tests db/exec/text.cpp.  The text stage reads a text index and fetches documents, so
+ * we cannot test it outside of a dbtest.
+ */
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/text.h"
+#include "mongo/db/index/fts_access_method.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/dbtests/dbtests.h"
+
+namespace QueryStageText {
+
+    using boost::scoped_ptr;
+    using std::set;
+    using std::vector;
+
+    class QueryStageTextBase {
+    public:
+        QueryStageTextBase() : _client(&_txn) {
+
+        }
+
+        virtual ~QueryStageTextBase() {
+            _client.dropCollection(ns());
+        }
+
+        void insert(const BSONObj& obj) {
+            _client.insert(ns(), obj);
+        }
+
+        void getLocs(set<RecordId>* out, Collection* coll) {
+            RecordIterator* it = coll->getIterator(&_txn);
+            while (!it->isEOF()) {
+                RecordId nextLoc = it->getNext();
+                out->insert(nextLoc);
+            }
+            delete it;
+        }
+
+        /**
+         * Returns a text stage searching the text index of 'coll' for 'search'.
+         */
+        TextStage* makeTextStage(Collection* coll,
+                                 WorkingSet* ws,
+                                 const std::string& search,
+                                 size_t limit) {
+            vector<IndexDescriptor*> idxMatches;
+            coll->getIndexCatalog()->findIndexByType(&_txn, "text", idxMatches);
+            ASSERT_EQUALS(size_t(1), idxMatches.size());
+            IndexDescriptor* index = idxMatches[0];
+            const FTSAccessMethod* fam =
+                static_cast<FTSAccessMethod*>(coll->getIndexCatalog()->getIndex(index));
+
+            TextStageParams params(fam->getSpec());
+            params.index = index;
+            params.limit = limit;
+            ASSERT_OK(params.query.parse(search,
+                                         fam->getSpec().defaultLanguage().str(),
+                                         false,
+                                         fam->getSpec().getTextIndexVersion()));
+            return new TextStage(&_txn, params, ws, NULL);
+        }
+
+        static const char* ns() { return "unittests.QueryStageText"; }
+
+    protected:
+        OperationContextImpl _txn;
+        DBDirectClient _client;
+    };
+
+    /**
+     * Invalidate every document while a text stage with a limit is reading the index. The result
+     * it already kept must be returned just once, though the scan of another term reads it again.
+     */
+    class QueryStageTextLimitInvalidation : public QueryStageTextBase {
+    public:
+        void run() {
+            OldClientWriteContext ctx(&_txn, ns());
+            Database* db = ctx.db();
+            Collection* coll = ctx.getCollection();
+            if (!coll) {
+                WriteUnitOfWork wuow(&_txn);
+                coll = db->createCollection(&_txn, ns());
+                wuow.commit();
+            }
+
+            // Document 0 has the best score for both terms.
+            insert(BSON("_id" << 0 << "a" << "apple banana"));
+            insert(BSON("_id" << 1 << "a" << "apple banana cherry"));
+            insert(BSON("_id" << 2 << "a" << "apple banana cherry date"));
+            insert(BSON("_id" << 3 << "a" << "apple banana cherry date elder"));
+            ASSERT_OK(dbtests::createIndex(&_txn, ns(), BSON("a" << "text")));
+
+            WorkingSet ws;
+            scoped_ptr<TextStage> text(makeTextStage(coll, &ws, "apple banana", 2));
+            const TextStats* stats = static_cast<const TextStats*>(text->getSpecificStats());
+
+            // Read the first key, which keeps document 0 as a result.
+            while (0 == stats->keysExamined) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                ASSERT_EQUALS(PlanStage::NEED_TIME, text->work(&id));
+            }
+
+            text->saveState();
+            set<RecordId> locs;
+            getLocs(&locs, coll);
+            for (set<RecordId>::const_iterator it = locs.begin(); it != locs.end(); ++it) {
+                text->invalidate(&_txn, *it, INVALIDATION_MUTATION);
+            }
+            text->restoreState(&_txn);
+
+            vector<int> ids;
+            while (!text->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState status = text->work(&id);
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, status);
+                if (PlanStage::ADVANCED == status) {
+                    ids.push_back(ws.get(id)->obj.value()["_id"].numberInt());
+                }
+            }
+
+            ASSERT_EQUALS(size_t(2), ids.size());
+            ASSERT_EQUALS(0, ids[0]);
+            ASSERT_EQUALS(1, ids[1]);
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "query_stage_text" ) { }
+
+        void setupTests() {
+            add<QueryStageTextLimitInvalidation>();
+        }
+    };
+
+    SuiteInstance<All> queryStageTextAll;
+
+}  // namespace QueryStageText
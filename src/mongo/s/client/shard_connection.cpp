@@ -32,8 +32,10 @@
 
 #include "mongo/s/client/shard_connection.h"
 
+#include <memory>
 #include <set>
 
+#include "mongo/db/client.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/s/chunk_manager.h"
@@ -121,7 +123,7 @@ namespace {
     } shardedPoolStatsCmd;
 
     /**
-     * holds all the actual db connections for a client to various servers 1 per thread, so
+     * holds all the actual db connections for a client to various servers 1 per client, so
      * doesn't have to be thread safe.
      */
     class ClientConnections {
@@ -367,9 +369,21 @@ namespace {
 
         // -----
 
+        // The connections of a thread with a Client are kept on the Client, so that they follow
+        // the incoming connection when a transport services it from another thread. Threads
+        // without a Client keep theirs in thread-local storage.
+        static const Client::Decoration<std::unique_ptr<ClientConnections> > forClient;
         static thread_specific_ptr<ClientConnections> _perThread;
 
         static ClientConnections* threadInstance() {
+            if (haveClient()) {
+                std::unique_ptr<ClientConnections>& clientConns = forClient(cc());
+                if (!clientConns) {
+                    clientConns.reset(new ClientConnections());
+                }
+                return clientConns.get();
+            }
+
             ClientConnections* cc = _perThread.get();
             if ( ! cc ) {
                 cc = new ClientConnections();
@@ -398,6 +412,8 @@ namespace {
         b.appendArray("threads", arr.obj());
     }
 
+    const Client::Decoration<std::unique_ptr<ClientConnections> > ClientConnections::forClient =
+        Client::declareDecoration<std::unique_ptr<ClientConnections> >();
     thread_specific_ptr<ClientConnections> ClientConnections::_perThread;
 
 } // namespace
@@ -760,6 +760,9 @@ namespace mongo {
                         else if ( str::equals( e.fieldName() , "wiredTiger" ) ) {
                             //skip this field in the rollup
                         }
+                        else if ( str::equals( e.fieldName() , "planCache" ) ) {
+                            //skip this field in the rollup
+                        }
                         else if ( str::equals( e.fieldName() , "nindexes" ) ) {
                             int myIndexes = e.numberInt();
                             
@@ -859,6 +859,14 @@ namespace mongo {
         _tl.reset();
     }
 
+    std::unique_ptr<ShardedConnectionInfo> ShardedConnectionInfo::release() {
+        return std::unique_ptr<ShardedConnectionInfo>( _tl.release() );
+    }
+
+    void ShardedConnectionInfo::set( std::unique_ptr<ShardedConnectionInfo> info ) {
+        _tl.reset( info.release() );
+    }
+
     const ChunkVersion ShardedConnectionInfo::getVersion( const string& ns ) const {
         NSVersionMap::const_iterator it = _versions.find( ns );
         if ( it != _versions.end() ) {
@@ -29,6 +29,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/s/collection_metadata.h"
 #include "mongo/s/chunk_version.h"
@@ -311,6 +313,13 @@ namespace mongo {
 
         static ShardedConnectionInfo* get( bool create );
         static void reset();
+
+        /**
+         * Detaches this thread's info, if any, so that it can follow its connection to another
+         * thread, where it is installed with set().
+         */
+        static std::unique_ptr<ShardedConnectionInfo> release();
+        static void set( std::unique_ptr<ShardedConnectionInfo> info );
         static void addHook();
 
         bool inForceVersionOkMode() const {
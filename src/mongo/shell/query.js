@@ -41,6 +41,7 @@ DBQuery.prototype.help = function () {
     print("\t.max(idxDoc)")
     print("\t.comment(comment)")
     print("\t.snapshot()")
+    print("\t.allowDiskUse() - lets a blocking sort spill to disk instead of failing")
     print("\t.readPref(mode, tagset)")
     
     print("\nCursor methods");
@@ -195,6 +196,10 @@ DBQuery.prototype._convertToCommand = function() {
         cmd["snapshot"] = this._query.$snapshot;
     }
 
+    if (this._query.$allowDiskUse) {
+        cmd["allowDiskUse"] = this._query.$allowDiskUse;
+    }
+
     if ((this._options & DBQuery.Option.tailable) != 0) {
         cmd["tailable"] = true;
     }
@@ -455,6 +460,10 @@ DBQuery.prototype.snapshot = function(){
     return this._addSpecial( "$snapshot" , true );
 }
 
+DBQuery.prototype.allowDiskUse = function(){
+    return this._addSpecial( "$allowDiskUse" , true );
+}
+
 DBQuery.prototype.pretty = function(){
     this._prettyShell = true;
     return this;
@@ -34,14 +34,30 @@
 
 #pragma once
 
+#include <memory>
+
 #include "mongo/platform/basic.h"
 
 namespace mongo {
 
+    class AbstractMessagingPort;
+    class Message;
+
     class MessageHandler {
     public:
+        /**
+         * Per-connection state which a handler normally keeps in thread local storage on the
+         * thread servicing the connection (e.g. the Client). Transports which do not dedicate a
+         * thread to each connection move this state between threads with detachSession() and
+         * attachSession().
+         */
+        class SessionState {
+        public:
+            virtual ~SessionState() {}
+        };
+
         virtual ~MessageHandler() {}
-        
+
         /**
          * called once when a socket is connected
          */
@@ -52,15 +68,48 @@ namespace mongo {
          * handler is responsible for responding to client
          */
         virtual void process(Message& m, AbstractMessagingPort* p) = 0;
+
+        /**
+         * Returns true if this handler implements detachSession() and attachSession(), which
+         * allows a connection to be serviced by a different thread for every message.
+         */
+        virtual bool supportsDetachedSessions() const { return false; }
+
+        /**
+         * Called after connected() or process() to take the connection's state off of the
+         * current thread. The returned state is passed back to attachSession() before the next
+         * call to process(), possibly on another thread. Destroying the returned state must
+         * release everything connected() set up.
+         */
+        virtual std::unique_ptr<SessionState> detachSession(AbstractMessagingPort* p) {
+            return std::unique_ptr<SessionState>();
+        }
+
+        /**
+         * Installs state previously returned by detachSession() on the current thread.
+         */
+        virtual void attachSession(AbstractMessagingPort* p, std::unique_ptr<SessionState> state) {}
     };
 
     class MessageServer {
     public:
+        enum TransportMode {
+            // Each connection is serviced by its own thread, which blocks reading from the socket.
+            kThreadPerConnection,
+            // A small number of I/O threads read messages for all connections and hand complete
+            // requests to a fixed size pool of worker threads.
+            kAsio
+        };
+
         struct Options {
             int port;                   // port to bind to
             std::string ipList;             // addresses to bind to
+            TransportMode transportMode;
+            int ioThreads;              // asio transport only, 0 means pick based on cores
+            int workerThreads;          // asio transport only, 0 means pick based on cores
 
-            Options() : port(0), ipList("") {}
+            Options() : port(0), ipList(""), transportMode(kThreadPerConnection),
+                        ioThreads(0), workerThreads(0) {}
         };
 
         virtual ~MessageServer() {}
@@ -69,6 +118,15 @@ namespace mongo {
         virtual void setupSockets() = 0;
     };
 
-    // TODO use a factory here to decide between port and asio variations
+    /**
+     * Creates a MessageServer using the transport selected by opts.transportMode. Falls back to
+     * thread per connection if the handler does not support detached sessions.
+     */
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler );
+
+    /**
+     * Creates a MessageServer which multiplexes connections over asio I/O threads and runs
+     * requests on a pool of worker threads. Requires handler->supportsDetachedSessions().
+     */
+    MessageServer * createAsioServer( const MessageServer::Options& opts, MessageHandler * handler );
 }
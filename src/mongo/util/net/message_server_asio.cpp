@@ -0,0 +1,465 @@
+// message_server_asio.cpp
+
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <asio.hpp>
+#include <memory>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/server_options.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/synchronization.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/listen.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/message_server.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+#ifdef ASIO_HAS_POSIX_STREAM_DESCRIPTOR
+
+namespace {
+
+    // First four bytes of an HTTP GET, read as a little endian message length.
+    const int kHttpGetMessageLength = 542393671;
+
+    class AsioMessageServer;
+
+    /**
+     * A client connection serviced by the asio transport.
+     *
+     * At most one operation is ever outstanding on a session: either an asynchronous read on an
+     * I/O thread, or a call into the MessageHandler on a worker thread. The session keeps itself
+     * alive through the shared_ptr bound into each pending operation and is destroyed once the
+     * connection is closed and no operation refers to it any more.
+     */
+    class AsioSession : public MessagingPort, public std::enable_shared_from_this<AsioSession> {
+    public:
+        AsioSession(AsioMessageServer* server,
+                    const boost::shared_ptr<Socket>& socket,
+                    long long connectionId);
+
+        virtual ~AsioSession();
+
+        /**
+         * Runs MessageHandler::connected() on a worker thread and starts reading messages.
+         */
+        void start();
+
+        virtual void reply(Message& received, Message& response, MSGID responseTo);
+        virtual void reply(Message& received, Message& response);
+
+    private:
+        void _connect();
+        void _readHeader();
+        void _onHeader(const asio::error_code& ec);
+        void _onBody(const asio::error_code& ec);
+        void _process();
+        void _send(const char* data, size_t len, const char* context);
+        void _end(const char* reason);
+
+        AsioMessageServer* const _server;
+        MessageHandler* const _handler;
+
+        // Borrows the file descriptor owned by the Socket, so it must be released rather than
+        // closed when the session goes away.
+        asio::posix::stream_descriptor _stream;
+
+        // Everything below is only touched by the thread running the session's single outstanding
+        // operation.
+        std::unique_ptr<MessageHandler::SessionState> _state;
+        MSGHEADER::Value _header;
+        Message _message;
+        bool _awaitingHandshake;
+        long long _bytesOut;
+        int64_t _messageCounter;
+    };
+
+    class AsioMessageServer : public MessageServer, public Listener {
+    public:
+        AsioMessageServer(const MessageServer::Options& opts, MessageHandler* handler)
+            : Listener("", opts.ipList, opts.port),
+              _handler(handler),
+              _numIoThreads(opts.ioThreads > 0 ?
+                            opts.ioThreads :
+                            std::max(1U, ProcessInfo().getNumCores() / 4)),
+              _numWorkerThreads(opts.workerThreads > 0 ?
+                                opts.workerThreads :
+                                std::max(32U, ProcessInfo().getNumCores() * 4)),
+              _work(_ioService),
+              _workers(ThreadPool::DoNotStartThreadsTag(), _numWorkerThreads, "conn-worker") {
+            transportCounters.enable("asio", _numIoThreads, _numWorkerThreads);
+        }
+
+        virtual void accepted(boost::shared_ptr<Socket> psocket, long long connectionId) {
+            if (!Listener::globalTicketHolder.tryAcquire()) {
+                log() << "connection refused because too many open connections: "
+                      << Listener::globalTicketHolder.used();
+                return;
+            }
+
+            std::shared_ptr<AsioSession> session;
+            try {
+                session = std::make_shared<AsioSession>(this, psocket, connectionId);
+            }
+            catch (const std::exception& e) {
+                Listener::globalTicketHolder.release();
+                log() << "error accepting new socket: " << e.what();
+                return;
+            }
+
+            // From here on the session owns the ticket.
+            session->start();
+        }
+
+        virtual void setAsTimeTracker() {
+            Listener::setAsTimeTracker();
+        }
+
+        virtual void setupSockets() {
+            Listener::setupSockets();
+        }
+
+        void run() {
+            log() << "using asio transport with " << _numIoThreads << " I/O threads and "
+                  << _numWorkerThreads << " worker threads";
+
+            _workers.startThreads();
+            for (int i = 0; i < _numIoThreads; i++) {
+                stdx::thread thr(stdx::bind(&AsioMessageServer::_runIoThread, this, i));
+                thr.detach();
+            }
+
+            initAndListen();
+        }
+
+        virtual bool useUnixSockets() const { return true; }
+
+        MessageHandler* getHandler() const { return _handler; }
+
+        asio::io_service& getIoService() { return _ioService; }
+
+        /**
+         * Queues "task" to run on a worker thread.
+         */
+        void schedule(const threadpool::Task& task) { _workers.schedule(task); }
+
+    private:
+        void _runIoThread(int threadNum) {
+            setThreadName(std::string(str::stream() << "conn-io" << threadNum));
+            while (!inShutdown()) {
+                try {
+                    _ioService.run();
+                    return;
+                }
+                catch (const std::exception& e) {
+                    error() << "uncaught exception in asio I/O thread: " << e.what();
+                }
+            }
+        }
+
+        // Not owned.
+        MessageHandler* const _handler;
+
+        const int _numIoThreads;
+        const int _numWorkerThreads;
+
+        asio::io_service _ioService;
+
+        // Keeps _ioService.run() from returning while there are no connections.
+        asio::io_service::work _work;
+
+        ThreadPool _workers;
+    };
+
+    AsioSession::AsioSession(AsioMessageServer* server,
+                             const boost::shared_ptr<Socket>& socket,
+                             long long connectionId)
+        : MessagingPort(socket),
+          _server(server),
+          _handler(server->getHandler()),
+          _stream(server->getIoService(), socket->rawFD()),
+          _awaitingHandshake(true),
+          _bytesOut(0),
+          _messageCounter(0) {
+        setConnectionId(connectionId);
+        psock->setLogLevel(logger::LogSeverity::Debug(1));
+    }
+
+    AsioSession::~AsioSession() {
+        // Destroy the handler's state for this connection (e.g. its Client) before the socket.
+        _state.reset();
+
+        // The Socket owns and closes the descriptor.
+        if (_stream.is_open()) {
+            _stream.release();
+        }
+
+        Listener::globalTicketHolder.release();
+    }
+
+    void AsioSession::start() {
+        _server->schedule(stdx::bind(&AsioSession::_connect, shared_from_this()));
+    }
+
+    void AsioSession::reply(Message& received, Message& response, MSGID responseTo) {
+        verify(!response.empty());
+        response.header().setId(nextMessageId());
+        response.header().setResponseTo(responseTo);
+        response.concat();
+        _send(response.header().view2ptr(), response.size(), "reply");
+    }
+
+    void AsioSession::reply(Message& received, Message& response) {
+        reply(received, response, received.header().getId());
+    }
+
+    void AsioSession::_connect() {
+        try {
+            _handler->connected(this);
+            _state = _handler->detachSession(this);
+        }
+        catch (const DBException& e) {
+            log() << "DBException setting up new connection, closing it: " << e;
+            _state = _handler->detachSession(this);
+            _end(NULL);
+            return;
+        }
+
+        _readHeader();
+    }
+
+    void AsioSession::_readHeader() {
+        asio::async_read(_stream,
+                         asio::buffer(&_header, sizeof(_header)),
+                         stdx::bind(&AsioSession::_onHeader,
+                                    shared_from_this(),
+                                    stdx::placeholders::_1));
+    }
+
+    void AsioSession::_onHeader(const asio::error_code& ec) {
+        if (ec) {
+            _end(ec == asio::error::eof ? NULL : ec.message().c_str());
+            return;
+        }
+
+        const int len = _header.constView().getMessageLength();
+
+        try {
+            if (len == kHttpGetMessageLength) {
+                std::string msg = "It looks like you are trying to access MongoDB over HTTP on "
+                                  "the native driver port.\n";
+                LOG(psock->getLogLevel()) << msg;
+                std::stringstream ss;
+                ss << "HTTP/1.0 200 OK\r\nConnection: close\r\nContent-Type: text/plain\r\n"
+                   << "Content-Length: " << msg.size() << "\r\n\r\n" << msg;
+                const std::string s = ss.str();
+                _send(s.c_str(), s.size(), "http");
+                _end(NULL);
+                return;
+            }
+            else if (len == -1) {
+                // Endian check from the client, after connecting, to see what mode the server
+                // is running in.
+                unsigned foo = 0x10203040;
+                _send(reinterpret_cast<const char*>(&foo), 4, "endian");
+                _awaitingHandshake = false;
+                _readHeader();
+                return;
+            }
+        }
+        catch (const SocketException& e) {
+            _end(e.what());
+            return;
+        }
+
+        // If responseTo is not 0 or -1 for the first packet, the client is trying to start an
+        // SSL handshake, which this transport does not support.
+        if (_awaitingHandshake
+                && _header.constView().getResponseTo() != 0
+                && _header.constView().getResponseTo() != -1) {
+            _end("SSL handshake requested, SSL is not supported by the asio transport");
+            return;
+        }
+
+        if (static_cast<size_t>(len) < sizeof(MSGHEADER::Value) ||
+                static_cast<size_t>(len) > MaxMessageSizeBytes) {
+            LOG(0) << "recv(): message len " << len << " is invalid. "
+                   << "Min " << sizeof(MSGHEADER::Value) << " Max: " << MaxMessageSizeBytes;
+            _end(NULL);
+            return;
+        }
+
+        _awaitingHandshake = false;
+
+        const int z = (len + 1023) & 0xfffffc00;
+        verify(z >= len);
+        MsgData::View md = reinterpret_cast<char*>(mongoMalloc(z));
+        memcpy(md.view2ptr(), &_header, sizeof(_header));
+        _message.setData(md.view2ptr(), true);
+
+        asio::async_read(_stream,
+                         asio::buffer(md.data(), len - sizeof(_header)),
+                         stdx::bind(&AsioSession::_onBody,
+                                    shared_from_this(),
+                                    stdx::placeholders::_1));
+    }
+
+    void AsioSession::_onBody(const asio::error_code& ec) {
+        if (ec) {
+            _message.reset();
+            _end(ec.message().c_str());
+            return;
+        }
+
+        transportCounters.gotQueued();
+        _server->schedule(stdx::bind(&AsioSession::_process, shared_from_this()));
+    }
+
+    void AsioSession::_process() {
+        transportCounters.gotStarted();
+        ON_BLOCK_EXIT(&TransportCounters::gotFinished, &transportCounters);
+
+        if (inShutdown()) {
+            _message.reset();
+            _end(NULL);
+            return;
+        }
+
+        const long long bytesIn = _message.size();
+        bool keepGoing = true;
+        try {
+            _handler->attachSession(this, std::move(_state));
+            _bytesOut = 0;
+            _handler->process(_message, this);
+            _state = _handler->detachSession(this);
+        }
+        catch (const AssertionException& e) {
+            log() << "AssertionException handling request, closing client connection: " << e;
+            keepGoing = false;
+        }
+        catch (const SocketException& e) {
+            log() << "SocketException handling request, closing client connection: " << e;
+            keepGoing = false;
+        }
+        catch (const DBException& e) {
+            // must be right above std::exception to avoid catching subclasses
+            log() << "DBException handling request, closing client connection: " << e;
+            keepGoing = false;
+        }
+        catch (const std::exception& e) {
+            error() << "Uncaught std::exception: " << e.what() << ", terminating";
+            dbexit(EXIT_UNCAUGHT);
+        }
+
+        _message.reset();
+        networkCounter.hit(bytesIn, _bytesOut);
+
+        if (!keepGoing) {
+            if (!_state) {
+                _state = _handler->detachSession(this);
+            }
+            _end(NULL);
+            return;
+        }
+
+        // Occasionally we want to see if we're using too much memory.
+        if ((_messageCounter++ & 0xf) == 0) {
+            markThreadIdle();
+        }
+
+        _readHeader();
+    }
+
+    void AsioSession::_send(const char* data, size_t len, const char* context) {
+        asio::error_code ec;
+        asio::write(_stream, asio::buffer(data, len), ec);
+        if (ec) {
+            LOG(psock->getLogLevel()) << "Socket " << context << " send() " << ec.message()
+                                      << ' ' << psock->remoteString();
+            throw SocketException(SocketException::SEND_ERROR, psock->remoteString());
+        }
+        _bytesOut += len;
+    }
+
+    void AsioSession::_end(const char* reason) {
+        if (reason) {
+            LOG(psock->getLogLevel()) << "closing connection " << psock->remoteString()
+                                      << ": " << reason;
+        }
+
+        if (!serverGlobalParams.quiet) {
+            int conns = Listener::globalTicketHolder.used() - 1;
+            const char* word = (conns == 1 ? " connection" : " connections");
+            log() << "end connection " << psock->remoteString()
+                  << " (" << conns << word << " now open)";
+        }
+
+        // Stop watching the descriptor before the socket closes it, since the descriptor number
+        // may be reused by the next accepted connection. No further operations are started, so
+        // the session is destroyed once the caller's reference goes away.
+        _stream.release();
+        shutdown();
+    }
+
+}  // namespace
+
+    MessageServer * createAsioServer( const MessageServer::Options& opts,
+                                      MessageHandler * handler ) {
+        invariant(handler->supportsDetachedSessions());
+        return new AsioMessageServer(opts, handler);
+    }
+
+#else  // ASIO_HAS_POSIX_STREAM_DESCRIPTOR
+
+    MessageServer * createAsioServer( const MessageServer::Options& opts,
+                                      MessageHandler * handler ) {
+        warning() << "the asio transport is not supported on this platform, "
+                  << "using a thread per connection";
+        MessageServer::Options portOpts = opts;
+        portOpts.transportMode = MessageServer::kThreadPerConnection;
+        return createServer(portOpts, handler);
+    }
+
+#endif  // ASIO_HAS_POSIX_STREAM_DESCRIPTOR
+
+}  // namespace mongo
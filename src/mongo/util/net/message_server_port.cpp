@@ -264,6 +264,13 @@ namespace {
 
 
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler ) {
+        if (opts.transportMode == MessageServer::kAsio) {
+            if (handler->supportsDetachedSessions()) {
+                return createAsioServer(opts, handler);
+            }
+            warning() << "the asio transport is not supported by this server, "
+                      << "using a thread per connection" << endl;
+        }
         return new PortMessageServer( opts , handler );
     }
 
@@ -81,6 +81,13 @@ namespace mongo {
             return _holder ? _holder->data() : NULL;
         }
 
+        /**
+         * Returns true if another SharedBuffer references the same memory.
+         */
+        bool isShared() const {
+            return _holder && _holder->isShared();
+        }
+
         class Holder {
         public:
             explicit Holder(AtomicUInt32::WordType initial = AtomicUInt32::WordType())
@@ -100,6 +107,10 @@ namespace mongo {
                 }
             }
 
+            bool isShared() const {
+                return _refCount.load() > 1;
+            }
+
             char* data() {
                 return reinterpret_cast<char *>(this + 1);
             }
@@ -30,6 +30,7 @@
 #include "mongo/util/time_support.h"
 
 #include <cstdio>
+#include <ctime>
 #include <string>
 #include <iostream>
 #include <boost/thread/thread.hpp>
@@ -1041,4 +1042,31 @@ namespace {
     }
 #endif
 
+#if defined(_WIN32)
+    unsigned long long curThreadCpuTimeMicros64() {
+        FILETIME creationTime, exitTime, kernelTime, userTime;
+        if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+            return 0;
+        }
+        // FILETIME is in 100ns units.
+        unsigned long long kernel = (static_cast<unsigned long long>(kernelTime.dwHighDateTime) << 32)
+                                    | kernelTime.dwLowDateTime;
+        unsigned long long user = (static_cast<unsigned long long>(userTime.dwHighDateTime) << 32)
+                                  | userTime.dwLowDateTime;
+        return (kernel + user) / 10;
+    }
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    unsigned long long curThreadCpuTimeMicros64() {
+        timespec ts;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+            return 0;
+        }
+        return (static_cast<unsigned long long>(ts.tv_sec) * 1000 * 1000) + ts.tv_nsec / 1000;
+    }
+#else
+    unsigned long long curThreadCpuTimeMicros64() {
+        return 0;
+    }
+#endif
+
 }  // namespace mongo
@@ -348,6 +348,12 @@ namespace mongo {
     unsigned long long curTimeMicros64();
     unsigned long long curTimeMillis64();
 
+    /**
+     * CPU time consumed so far by the calling thread, in microseconds.  Returns 0 on platforms
+     * without a per-thread CPU clock, so only differences between two calls are meaningful.
+     */
+    unsigned long long curThreadCpuTimeMicros64();
+
     // these are so that if you use one of them compilation will fail
     char *asctime(const struct tm *tm);
     char *ctime(const time_t *timep);